@@ -1,6 +1,8 @@
 #include "MDBench.hpp"
 #include <benchmark/benchmark.h>
 #include <sstream>
+#include <algorithm>
+#include <cmath>
 
 static void
 LineGetStateDeriv(benchmark::State& state, std::string input_file)
@@ -21,8 +23,8 @@ LineGetStateDeriv(benchmark::State& state, std::string input_file)
 
 	auto line = system.GetLines().front();
 
-	std::vector<moordyn::vec> vel{};
-	std::vector<moordyn::vec> acc{};
+	Eigen::Matrix3Xr vel(3, line->getN() - 1);
+	Eigen::Matrix3Xr acc(3, line->getN() - 1);
 	for (auto _ : state) {
 		line->getStateDeriv(vel, acc);
 	}
@@ -78,4 +80,71 @@ BENCHMARK_CAPTURE(MoordynStep, WaveKin2, "Mooring/wavekin_2/wavekin_2.txt")
 BENCHMARK_CAPTURE(MoordynStep, WaveKin7, "Mooring/wavekin_7/wavekin_7.txt")
     ->Unit(benchmark::kMicrosecond);
 
+/**
+ * @brief Benchmarks stepping the given model 0.1s, reporting the error with
+ * respect to a reference model
+ *
+ * The reference model is stepped as well, but not timed. The maximum relative
+ * difference of the fairlead forces is reported in the "MaxRelError" counter,
+ * to measure the accuracy/cost tradeoff of the water kinematics reuse
+ * @param state
+ * @param ref_file Path to the reference model file
+ * @param input_file Path to the model file
+ */
+static void
+MoordynStepError(benchmark::State& state,
+                 std::string ref_file,
+                 std::string input_file)
+{
+	moordyn::MoorDyn ref(ref_file.c_str(), MOORDYN_NO_OUTPUT);
+	moordyn::MoorDyn system(input_file.c_str(), MOORDYN_NO_OUTPUT);
+	double x[3], dx[3];
+	std::fill(x, x + 3, 0.0);
+	std::fill(dx, dx + 3, 0.0);
+	ref.Init(x, dx, true);
+	system.Init(x, dx, true);
+
+	double t = 0.0, t_ref = 0.0, dt = 0.1;
+	double f[3], f_ref[3];
+	double err = 0.0, f_max = 0.0;
+
+	for (auto _ : state) {
+		// Some surge motion, so the nodes are moving along the time step
+		x[0] = 2.0 * sin(0.5 * t);
+		dx[0] = cos(0.5 * t);
+		system.Step(x, dx, f, t, dt);
+
+		state.PauseTiming();
+		ref.Step(x, dx, f_ref, t_ref, dt);
+		for (unsigned int i = 0; i < 3; i++) {
+			err = (std::max)(err, fabs(f[i] - f_ref[i]));
+			f_max = (std::max)(f_max, fabs(f_ref[i]));
+		}
+		state.ResumeTiming();
+	}
+	state.counters["OuterTimeStep"] = dt;
+	state.counters["MaxRelError"] = f_max > 0.0 ? err / f_max : 0.0;
+}
+
+BENCHMARK_CAPTURE(MoordynStepError,
+                  WaveKin7NoCache,
+                  "Mooring/wavekin_7/wavekin_7.txt",
+                  "Mooring/wavekin_7/wavekin_7.txt")
+    ->Unit(benchmark::kMicrosecond);
+BENCHMARK_CAPTURE(MoordynStepError,
+                  WaveKin7TimeCache,
+                  "Mooring/wavekin_7/wavekin_7.txt",
+                  "Mooring/wavekin_7/wavekin_7_cache1.txt")
+    ->Unit(benchmark::kMicrosecond);
+BENCHMARK_CAPTURE(MoordynStepError,
+                  WaveKin7LinearInterp,
+                  "Mooring/wavekin_7/wavekin_7.txt",
+                  "Mooring/wavekin_7/wavekin_7_cache2.txt")
+    ->Unit(benchmark::kMicrosecond);
+BENCHMARK_CAPTURE(MoordynStepError,
+                  WaveKin7CubicInterp,
+                  "Mooring/wavekin_7/wavekin_7.txt",
+                  "Mooring/wavekin_7/wavekin_7_cache3.txt")
+    ->Unit(benchmark::kMicrosecond);
+
 BENCHMARK_MAIN();
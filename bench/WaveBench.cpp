@@ -1,6 +1,8 @@
 #include <benchmark/benchmark.h>
 #include "WaveBench.hpp"
 #include "Waves/SpectrumKin.hpp"
+#include "Waves/WaveGrid.hpp"
+#include "Util/ThreadPool.hpp"
 #include <random>
 
 moordyn::waves::SpectrumKin
@@ -104,4 +106,42 @@ BenchScalingFactor(benchmark::State& state)
 
 BENCHMARK(BenchScalingFactor);
 
+/**
+ * @brief Benchmarks the construction of a wave grid from a wave spectrum
+ *
+ * The grid has 51 x 11 x 11 points and 800 time steps. The argument is the
+ * number of threads of the pool used to fill the grid, 0 to fill it serially,
+ * without a threads pool. The real time is measured, since the work is split
+ * among the threads
+ *
+ * @param state
+ */
+static void
+BM_WaveGridConstruction(benchmark::State& state)
+{
+	auto log = moordyn::Log(MOORDYN_NO_OUTPUT, MOORDYN_NO_OUTPUT);
+	EnvCondRef env = make_shared<EnvCond>();
+	env->g = 9.8;
+	env->WtrDpth = 50;
+	env->rho_w = 1025;
+	std::unique_ptr<moordyn::ThreadPool> pool;
+	if (state.range(0))
+		pool = std::make_unique<moordyn::ThreadPool>(state.range(0));
+
+	for (auto _ : state) {
+		auto grid = moordyn::waves::constructWaveGridSpectrumData(
+		    "Mooring/wavegrid/", env, &log, pool.get());
+		benchmark::DoNotOptimize(grid);
+	}
+}
+
+BENCHMARK(BM_WaveGridConstruction)
+    ->Arg(0)
+    ->Arg(1)
+    ->Arg(2)
+    ->Arg(4)
+    ->Arg(8)
+    ->UseRealTime()
+    ->Unit(benchmark::kMillisecond);
+
 BENCHMARK_MAIN();
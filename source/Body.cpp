@@ -60,12 +60,14 @@ Body::setup(int number_in,
             vec6 CdA_in,
             vec6 Ca_in,
             EnvCondRef env_in,
-            shared_ptr<ofstream> outfile_pointer)
+            shared_ptr<OutputFile> outfile_pointer)
 {
 	env = env_in; // set pointer to environment settings object
 	number = number_in;
 	type = type_in;
 	outfile = outfile_pointer.get(); // make outfile point to the right place
+	outAnglesRequired = false;
+	outFnetRequired = false;
 
 	// We better store the body initial position in all cases so the state is
 	// correctly initialized, and MoorDyn_GetBodyState() would be successfully
@@ -214,34 +216,22 @@ Body::initialize()
 	// create output file for writing output (and write channel header and units
 	// lines) if applicable
 
-	if (outfile) // check it's not null.  Null signals no individual line output
-	             // files
-	{
+	// check it's not null.  Null signals no individual line output files.
+	// The header shall be written just once, even if the body is initialized
+	// several times
+	if (outfile && !outfile->hasHeader()) {
 		if (!outfile->is_open()) {
 			LOGERR << "Unable to write file Body" << number << ".out" << endl;
 			throw moordyn::output_file_error("Invalid line file");
 		}
-		// ------------- write channel names line --------------------
-
-		// output time
-		*outfile << "Time"
-		         << "\t ";
-
-		*outfile << "x\ty\tz\troll\tpitch\tyaw";
-
-		*outfile << "\n";
-
-		// ----------- write units line ---------------
-
-		if (env->WriteUnits > 0) {
-			// output time
-			*outfile << "(s)"
-			         << "\t ";
-
-			*outfile << "(m)\t(m)\t(m)\t(deg)\t(deg)\t(deg)";
-
-			*outfile << "\n"; // should also write units at some point!
-		}
+		// Declare the channels, and write the header
+		outfile->addChannel("x", "(m)", 4, number);
+		outfile->addChannel("y", "(m)", 4, number);
+		outfile->addChannel("z", "(m)", 4, number);
+		outfile->addChannel("roll", "(deg)", 4, number);
+		outfile->addChannel("pitch", "(deg)", 4, number);
+		outfile->addChannel("yaw", "(deg)", 4, number);
+		outfile->writeHeader(env->WriteUnits > 0);
 	}
 
 	LOGDBG << "Initialized Body " << number << endl;
@@ -389,6 +379,71 @@ Body::GetBodyOutput(OutChanProps outChan)
 	}
 }
 
+void
+Body::addOutput(const OutChanProps& outChan, OutputPlan& plan)
+{
+	switch (outChan.QType) {
+		case PosX:
+		case PosY:
+		case PosZ:
+			plan.add(&r7.pos[outChan.QType - PosX]);
+			return;
+		case RX:
+		case RY:
+		case RZ:
+			outAnglesRequired = true;
+			plan.add(&outAngles[outChan.QType - RX]);
+			plan.addUpdate(this, [this]() { updateOutput(); });
+			return;
+		case VelX:
+		case VelY:
+		case VelZ:
+			plan.add(&v6[outChan.QType - VelX]);
+			return;
+		case RVelX:
+		case RVelY:
+		case RVelZ:
+			plan.add(&v6[3 + outChan.QType - RVelX], 180.0 / pi);
+			return;
+		case AccX:
+		case AccY:
+		case AccZ:
+			plan.add(&a6[outChan.QType - AccX]);
+			return;
+		case RAccX:
+		case RAccY:
+		case RAccZ:
+			plan.add(&a6[3 + outChan.QType - RAccX], 180.0 / pi);
+			return;
+		case Ten:
+			plan.add(F6net.data(), 1.0, OutputPlan::OP_NORM);
+			return;
+		case FX:
+		case FY:
+		case FZ:
+		case MX:
+		case MY:
+		case MZ:
+			outFnetRequired = true;
+			plan.add(&outFnet[outChan.QType - FX]);
+			plan.addUpdate(this, [this]() { updateOutput(); });
+			return;
+		default:
+			break;
+	}
+	LOGWRN << "Unrecognized output channel " << outChan.QType << endl;
+	plan.addZero();
+}
+
+void
+Body::updateOutput()
+{
+	if (outAnglesRequired)
+		outAngles = rad2deg * Quat2Euler(r7.quat);
+	if (outFnetRequired)
+		outFnet = getFnet();
+}
+
 // called at the beginning of each coupling step to update the boundary
 // conditions (body kinematics) for the proceeding time steps
 void
@@ -642,14 +697,14 @@ Body::Output(real time)
 			return;
 		}
 		// output time
-		*outfile << time << "\t ";
+		outfile->begin(time);
 
 		for (int J = 0; J < 3; J++)
-			*outfile << r7.pos[J] << "\t ";
+			*outfile << r7.pos[J];
 
 		vec3 angles = rad2deg * Quat2Euler(r7.quat);
-		*outfile << angles[0] << "\t " << angles[1] << "\t " << angles[2]
-		         << "\n";
+		*outfile << angles[0] << angles[1] << angles[2];
+		outfile->end();
 	}
 	return;
 };
@@ -42,6 +42,8 @@
 #include "Misc.hpp"
 #include "IO.hpp"
 #include "Util/CFL.hpp"
+#include "Util/OutputFile.hpp"
+#include "Util/OutputPlan.hpp"
 #include <vector>
 #include <utility>
 
@@ -151,8 +153,21 @@ class Body final : public io::IO, public SuperCFL
 	/// orientation)
 	mat OrMat;
 
-	/// Pointer to moordyn::MoorDyn::outfileMain
-	ofstream* outfile;
+	/// The output file, NULL if no output is required
+	OutputFile* outfile;
+
+	/// The orientation angles printed on the main output file, in degrees
+	vec3 outAngles;
+	/// Whether moordyn::Body::outAngles shall be computed
+	bool outAnglesRequired;
+	/// The net force and moment printed on the main output file
+	vec6 outFnet;
+	/// Whether moordyn::Body::outFnet shall be computed
+	bool outFnetRequired;
+
+	/** @brief Update the quantities printed on the main output file
+	 */
+	void updateOutput();
 
 	/** @brief Types of bodies
 	 */
@@ -221,7 +236,7 @@ class Body final : public io::IO, public SuperCFL
 	           vec6 CdA,
 	           vec6 Ca,
 	           EnvCondRef env_in,
-	           shared_ptr<ofstream> outfile);
+	           shared_ptr<OutputFile> outfile);
 
 	/** @brief Attach a point to the body
 	 * @param point The point
@@ -350,6 +365,15 @@ class Body final : public io::IO, public SuperCFL
 	 */
 	real GetBodyOutput(OutChanProps outChan);
 
+	/** @brief Compile a body output channel of the main output file
+	 *
+	 * The channel is compiled into an accessor, which is giving the same
+	 * value than GetBodyOutput()
+	 * @param outChan The output channel/field
+	 * @param plan The plan where the accessor is added
+	 */
+	void addOutput(const OutChanProps& outChan, OutputPlan& plan);
+
 	/** @brief Scale the drag coefficients
 	 * @param scaler The drag coefficients scale factor
 	 */
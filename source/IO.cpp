@@ -468,6 +468,20 @@ IO::Serialize(const std::vector<mat6>& l)
 	return data;
 }
 
+std::vector<uint64_t>
+IO::Serialize(const Eigen::ArrayX3r& l)
+{
+	std::vector<uint64_t> data;
+	const uint64_t n = l.rows();
+	data.reserve(1 + 3 * n);
+	data.push_back(Serialize(n));
+	for (unsigned int i = 0; i < n; i++) {
+		auto subdata = Serialize(soa2vec(l, i));
+		data.insert(data.end(), subdata.begin(), subdata.end());
+	}
+	return data;
+}
+
 uint64_t*
 IO::Deserialize(const uint64_t* in, uint64_t& out)
 {
@@ -626,6 +640,20 @@ IO::Deserialize(const uint64_t* in, std::vector<mat6>& out)
 	return remaining;
 }
 
+uint64_t*
+IO::Deserialize(const uint64_t* in, Eigen::ArrayX3r& out)
+{
+	uint64_t n;
+	uint64_t* remaining = Deserialize(in, n);
+	out.resize(n, 3);
+	for (unsigned int i = 0; i < n; i++) {
+		vec v;
+		remaining = Deserialize(remaining, v);
+		vec2soa(v, out, i);
+	}
+	return remaining;
+}
+
 #ifdef USE_VTK
 vtkSmartPointer<vtkFloatArray>
 vtk_farray(const char* name, unsigned int dim, unsigned int len)
@@ -207,6 +207,37 @@ class IO : public LogUser
 	 */
 	std::vector<uint64_t> Serialize(const std::vector<mat6>& l);
 
+	/** @brief Pack a structure-of-arrays list of 3D vectors to make it
+	 * writable
+	 *
+	 * The packed data is the same produced for the equivalent
+	 * std::vector<vec>
+	 * @param l The list
+	 * @return The packed list
+	 */
+	std::vector<uint64_t> Serialize(const Eigen::ArrayX3r& l);
+
+	/** @brief Pack a view of a vector or a list of 3D vectors to make it
+	 * writable
+	 *
+	 * The packed data is the same produced for the equivalent owning type,
+	 * i.e. vec, vec6, moordyn::XYZQuat (for vec7) or std::vector<vec> (for
+	 * Eigen::Matrix3Xr)
+	 * @param m The view
+	 * @return The packed view
+	 */
+	template<typename T>
+	std::vector<uint64_t> Serialize(const Eigen::Map<T>& m)
+	{
+		std::vector<uint64_t> data;
+		data.reserve(m.size() + 1);
+		if constexpr (T::ColsAtCompileTime == Eigen::Dynamic)
+			data.push_back(Serialize((uint64_t)m.cols()));
+		for (unsigned int i = 0; i < m.size(); i++)
+			data.push_back(Serialize(m.data()[i]));
+		return data;
+	}
+
 	/** @brief Pack a list of lists to make it writable
 	 * This function might act recursively
 	 * @param l The list
@@ -323,6 +354,39 @@ class IO : public LogUser
 	 */
 	uint64_t* Deserialize(const uint64_t* in, std::vector<mat6>& out);
 
+	/** @brief Unpack a loaded list of 3D vectors into a structure-of-arrays
+	 * storage
+	 * @param in The pointer to the next unread value
+	 * @param out The unpacked value
+	 * @return The new pointer to the remaining data to be read
+	 */
+	uint64_t* Deserialize(const uint64_t* in, Eigen::ArrayX3r& out);
+
+	/** @brief Unpack a loaded vector or list of 3D vectors into a view
+	 * @param in The pointer to the next unread value
+	 * @param out The unpacked value
+	 * @return The new pointer to the remaining data to be read
+	 * @throw moordyn::mem_error If the number of packed 3D vectors does not
+	 * match the view size
+	 */
+	template<typename T>
+	uint64_t* Deserialize(const uint64_t* in, Eigen::Map<T>& out)
+	{
+		uint64_t* remaining = (uint64_t*)in;
+		if constexpr (T::ColsAtCompileTime == Eigen::Dynamic) {
+			uint64_t n;
+			remaining = Deserialize(remaining, n);
+			if (n != (uint64_t)out.cols()) {
+				LOGERR << n << " elements unpacked, but " << out.cols()
+				       << " were expected" << std::endl;
+				throw moordyn::mem_error("Invalid unpacked data");
+			}
+		}
+		for (unsigned int i = 0; i < out.size(); i++)
+			remaining = Deserialize(remaining, out.data()[i]);
+		return remaining;
+	}
+
 	/** @brief Unpack a loaded list of lists
 	 *
 	 * This function might works recursively
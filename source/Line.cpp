@@ -55,6 +55,7 @@ Line::Line(moordyn::Log* log, size_t lineId)
   , lineId(lineId)
   , isPb(false)
 {
+	kernel = &Line::getStateDerivKernel<0>;
 }
 
 Line::~Line() {}
@@ -127,7 +128,7 @@ Line::setup(int number_in,
             real UnstrLen_in,
             unsigned int NumSegs,
             EnvCondRef env_in,
-            shared_ptr<ofstream> outfile_pointer,
+            shared_ptr<OutputFile> outfile_pointer,
             string channels_in)
 {
 	env = env_in; // set pointer to environment settings object
@@ -151,6 +152,12 @@ Line::setup(int number_in,
 	Cdn = props->Cdn;
 	Cdt = props->Cdt;
 
+	// The fatigue is accumulated on demand, with the "F" output flag
+	fatigue.clear();
+	if (channels_in.find("F") != string::npos)
+		fatigue.assign(N,
+		               Rainflow(env->FatigueBins, props->SNm, props->SNA, A));
+
 	// copy in nonlinear stress-strain data if applicable
 	stiffXs.clear();
 	stiffYs.clear();
@@ -193,29 +200,51 @@ Line::setup(int number_in,
 
 	r.assign(N + 1, vec::Zero());     // node positions [i][x/y/z]
 	rd.assign(N + 1, vec::Zero());    // node positions [i][x/y/z]
-	q.assign(N + 1, vec::Zero());     // unit tangent vectors for each node
+	q.setZero(N + 1, 3);              // unit tangent vectors for each node
 	pvec.assign(N + 1, vec::Zero());  // unit normal vectors for each node
-	qs.assign(N, vec::Zero());        // unit tangent vectors for each segment
+	qs.setZero(N, 3);                 // unit tangent vectors for each segment
 	l.assign(N, 0.0);                 // line unstretched segment lengths
 	lstr.assign(N, 0.0);              // stretched lengths
 	ldstr.assign(N, 0.0);             // rate of stretch
 	Kurv.assign(N + 1, 0.0);          // curvatures at node points (1/m)
 
-	M.assign(N + 1, mat::Zero());     // mass matrices (3x3) for each node
+	Ma.setZero(N + 1);                // mass matrices isotropic terms
+	Mb.setZero(N + 1);                // mass matrices tangential terms
 	V.assign(N, 0.0);                 // segment volume?
 
 	// forces
-	T.assign(N, vec::Zero());        // segment tensions
-	Td.assign(N, vec::Zero());       // segment damping forces
+	T.setZero(N, 3);                 // segment tensions
+	Td.setZero(N, 3);                // segment damping forces
 	Bs.assign(N + 1, vec::Zero());   // bending stiffness forces
 	Pb.assign(N + 1, vec::Zero());   // Pressure bending forces
-	W.assign(N + 1, vec::Zero());    // node weights
-	Dp.assign(N + 1, vec::Zero());   // node drag (transverse)
-	Dq.assign(N + 1, vec::Zero());   // node drag (axial)
-	Ap.assign(N + 1, vec::Zero());   // node added mass forcing (transverse)
-	Aq.assign(N + 1, vec::Zero());   // node added mass forcing (axial)
-	B.assign(N + 1, vec::Zero());    // node bottom contact force
-	Fnet.assign(N + 1, vec::Zero()); // total force on node
+	W.setZero(N + 1, 3);             // node weights
+	Dp.setZero(N + 1, 3);            // node drag (transverse)
+	Dq.setZero(N + 1, 3);            // node drag (axial)
+	Ap.setZero(N + 1, 3);            // node added mass forcing (transverse)
+	Aq.setZero(N + 1, 3);            // node added mass forcing (axial)
+	B.setZero(N + 1, 3);             // node bottom contact force
+	Fnet.setZero(N + 1, 3);          // total force on node
+
+	// structure-of-arrays workspace
+	r_lanes.setZero(N + 1, 3);
+	rd_lanes.setZero(N + 1, 3);
+	U_lanes.setZero(N + 1, 3);
+	Ud_lanes.setZero(N + 1, 3);
+	len_lanes.setZero(N + 1);
+	sublen_lanes.setZero(N + 1);
+	depth_lanes.setZero(N + 1);
+	qq_lanes.setZero(N + 1);
+	qF_lanes.setZero(N + 1);
+	acc_lanes.setZero(N + 1, 3);
+	m_lanes.setZero(N + 1);
+	v_lanes.setZero(N + 1);
+	vi_lanes.setZero(N + 1, 3);
+	aux_lanes.setZero(N + 1);
+	vq_lanes.setZero(N + 1);
+	vp_lanes.setZero(N + 1);
+	fricmax_lanes.setZero(N + 1);
+	botvel_lanes.setZero(N + 1);
+	fric_lanes.setZero(N + 1);
 
 	// wave things
 	F.assign(N + 1, 0.0); // VOF scaler for each NODE (mean of two half adjacent
@@ -233,6 +262,9 @@ Line::setup(int number_in,
 	outfile = outfile_pointer.get(); // make outfile point to the right place
 	channels = channels_in;          // copy string of output channels to object
 
+	// pick the appropriate derivatives kernel
+	selectKernel();
+
 	LOGDBG << "   Set up Line " << number << ". " << endl;
 };
 
@@ -255,149 +287,100 @@ Line::initialize()
 	       << "    ww_l: " << ((rho - env->rho_w) * (pi / 4. * d * d)) * 9.81
 	       << endl;
 
-	if (outfile) {
+	// The lines might be initialized several times, e.g. when the time
+	// scheme is changed, but the header shall be written just once
+	if (outfile && !outfile->hasHeader()) {
 		if (!outfile->is_open()) {
 			LOGERR << "Unable to write file Line" << number << ".out" << endl;
 			throw moordyn::output_file_error("Invalid line file");
 		}
 
-		// Write the header
-		// 1st line with the fields
-
-		// output time
-		*outfile << "Time"
-		         << "\t ";
-
-		// output positions
+		// Declare the channels, and compile them, so the flags are not
+		// parsed anymore
+		outPlan.clear();
 		if (channels.find("p") != string::npos) {
 			for (unsigned int i = 0; i <= N; i++) {
-				*outfile << "Node" << i << "px \t Node" << i << "py \t Node"
-				         << i << "pz \t ";
+				outfile->addVectorChannel(
+				    "Node" + to_string(i) + "p", "(m)", 1, number, i);
+				outPlan.addVector(r[i].data());
 			}
 		}
-		// output curvatures
 		if (channels.find("K") != string::npos) {
 			for (unsigned int i = 0; i <= N; i++) {
-				*outfile << "Node" << i << "Ku \t ";
+				outfile->addChannel(
+				    "Node" + to_string(i) + "Ku", "(1/m)", 1, number, i);
+				outPlan.add(&Kurv[i]);
 			}
 		}
-		// output velocities
 		if (channels.find("v") != string::npos) {
 			for (unsigned int i = 0; i <= N; i++) {
-				*outfile << "Node" << i << "vx \t Node" << i << "vy \t Node"
-				         << i << "vz \t ";
+				outfile->addVectorChannel(
+				    "Node" + to_string(i) + "v", "(m/s)", 1, number, i);
+				outPlan.addVector(rd[i].data());
 			}
 		}
-		// output wave velocities
+		outU.clear();
 		if (channels.find("U") != string::npos) {
+			outU.assign(N + 1, vec::Zero());
 			for (unsigned int i = 0; i <= N; i++) {
-				*outfile << "Node" << i << "Ux \t Node" << i << "Uy \t Node"
-				         << i << "Uz \t ";
+				outfile->addVectorChannel(
+				    "Node" + to_string(i) + "U", "(m/s)", 1, number, i);
+				outPlan.addVector(outU[i].data());
 			}
 		}
-		// output hydro force
+		outD.resize(0, 3);
 		if (channels.find("D") != string::npos) {
+			outD = Eigen::ArrayX3r::Zero(N + 1, 3);
 			for (unsigned int i = 0; i <= N; i++) {
-				*outfile << "Node" << i << "Dx \t Node" << i << "Dy \t Node"
-				         << i << "Dz \t ";
+				outfile->addVectorChannel(
+				    "Node" + to_string(i) + "D", "(N)", 1, number, i);
+				outPlan.addVector(&outD(i, 0), N + 1);
 			}
 		}
-		// output segment tensions
 		if (channels.find("t") != string::npos) {
-			for (unsigned int i = 1; i <= N; i++) {
-				*outfile << "Seg" << i << "Te \t ";
+			for (unsigned int i = 0; i < N; i++) {
+				outfile->addChannel(
+				    "Seg" + to_string(i + 1) + "Te", "(N)", 1, number, i + 1);
+				outPlan.add(&T(i, 0), 1.0, OutputPlan::OP_NORM, N);
 			}
 		}
-		// output internal damping force
 		if (channels.find("c") != string::npos) {
-			for (unsigned int i = 1; i <= N; i++) {
-				*outfile << "Seg" << i << "cx \t Seg" << i << "cy \t Seg" << i
-				         << "cz \t ";
+			for (unsigned int i = 0; i < N; i++) {
+				outfile->addVectorChannel(
+				    "Seg" + to_string(i + 1) + "c", "(N)", 1, number, i + 1);
+				outPlan.addVector(&Td(i, 0), N);
 			}
 		}
-		// output segment strains
+		outStrain.clear();
 		if (channels.find("s") != string::npos) {
-			for (unsigned int i = 1; i <= N; i++) {
-				*outfile << "Seg" << i << "St \t ";
+			outStrain.assign(N, 0.0);
+			for (unsigned int i = 0; i < N; i++) {
+				outfile->addChannel(
+				    "Seg" + to_string(i + 1) + "St", "(-)", 1, number, i + 1);
+				outPlan.add(&outStrain[i]);
 			}
 		}
-		// output segment strain rates
+		outStrainRate.clear();
 		if (channels.find("d") != string::npos) {
-			for (unsigned int i = 1; i <= N; i++) {
-				*outfile << "Seg" << i << "dSt \t ";
+			outStrainRate.assign(N, 0.0);
+			for (unsigned int i = 0; i < N; i++) {
+				outfile->addChannel("Seg" + to_string(i + 1) + "dSt",
+				                    "(-/s)",
+				                    1,
+				                    number,
+				                    i + 1);
+				outPlan.add(&outStrainRate[i]);
 			}
 		}
-		// output seabed contact forces
 		if (channels.find("b") != string::npos) {
 			for (unsigned int i = 0; i <= N; i++) {
-				*outfile << "Node" << i << "bx \t Node" << i << "by \t Node"
-				         << i << "bz \t ";
+				outfile->addVectorChannel(
+				    "Node" + to_string(i) + "b", "(N)", 1, number, i);
+				outPlan.addVector(&B(i, 0), N + 1);
 			}
 		}
-
-		*outfile << "\n";
-
-		if (env->WriteUnits > 0) {
-			// 2nd line with the units
-
-			// output time
-			*outfile << "(s)"
-			         << "\t ";
-
-			// output positions
-			if (channels.find("p") != string::npos) {
-				for (unsigned int i = 0; i <= 3 * N + 2; i++)
-					*outfile << "(m) \t";
-			}
-			// output curvatures?
-			if (channels.find("K") != string::npos) {
-				for (unsigned int i = 0; i <= N; i++) {
-					*outfile << "(1/m) \t ";
-				}
-			}
-			// output velocities?
-			if (channels.find("v") != string::npos) {
-				for (unsigned int i = 0; i <= 3 * N + 2; i++)
-					*outfile << "(m/s) \t";
-			}
-			// output wave velocities?
-			if (channels.find("U") != string::npos) {
-				for (unsigned int i = 0; i <= 3 * N + 2; i++)
-					*outfile << "(m/s) \t";
-			}
-			// output hydro force
-			if (channels.find("D") != string::npos) {
-				for (unsigned int i = 0; i <= 3 * N + 2; i++)
-					*outfile << "(N) \t";
-			}
-			// output segment tensions?
-			if (channels.find("t") != string::npos) {
-				for (unsigned int i = 0; i < N; i++)
-					*outfile << "(N) \t";
-			}
-			// output internal damping force?
-			if (channels.find("c") != string::npos) {
-				for (unsigned int i = 0; i < 3 * N; i++)
-					*outfile << "(N) \t";
-			}
-			// output segment strains?
-			if (channels.find("s") != string::npos) {
-				for (unsigned int i = 0; i < N; i++)
-					*outfile << "(-) \t";
-			}
-			// output segment strain rates?
-			if (channels.find("d") != string::npos) {
-				for (unsigned int i = 0; i < N; i++)
-					*outfile << "(-/s) \t";
-			}
-			// output seabed contact force?
-			if (channels.find("b") != string::npos) {
-				for (unsigned int i = 0; i <= 3 * N + 2; i++)
-					*outfile << "(N) \t";
-			}
-
-			*outfile << "\n";
-		}
+		outPlan.addUpdate(this, [this]() { updateOutput(); });
+		outfile->writeHeader(env->WriteUnits > 0);
 	}
 
 	// The end node kinematics should already have been set by the
@@ -570,6 +553,62 @@ Line::GetLineOutput(OutChanProps outChan)
 	return 0.0;
 }
 
+void
+Line::addOutput(const OutChanProps& outChan, OutputPlan& plan)
+{
+	if ((outChan.NodeID < 0) || (outChan.NodeID > (int)N)) {
+		LOGERR << "Invalid output channel " << outChan.Name << ": Line "
+		       << number << " has not a node " << outChan.NodeID << endl;
+		throw moordyn::invalid_value_error("Invalid node index");
+	}
+	const unsigned int i = outChan.NodeID;
+	const unsigned int stride = N + 1;
+	switch (outChan.QType) {
+		case PosX:
+		case PosY:
+		case PosZ:
+			plan.add(&r[i][outChan.QType - PosX]);
+			return;
+		case VelX:
+		case VelY:
+		case VelZ:
+			plan.add(&rd[i][outChan.QType - VelX]);
+			return;
+		case Ten:
+			if ((i == 0) || (i == N)) {
+				plan.add(&Fnet(i, 0), 1.0, OutputPlan::OP_NORM, stride);
+				return;
+			}
+			// The internal nodes tensions shall be computed
+			if (outTen.size() != N + 1)
+				outTen.assign(N + 1, 0.0);
+			if (std::find(outTenNodes.begin(), outTenNodes.end(), i) ==
+			    outTenNodes.end())
+				outTenNodes.push_back(i);
+			plan.add(&outTen[i]);
+			plan.addUpdate(this, [this]() {
+				for (auto j : outTenNodes)
+					outTen[j] = getNodeTen(j).norm();
+			});
+			return;
+		case TenA:
+			plan.add(&Fnet(0, 0), 1.0, OutputPlan::OP_NORM, stride);
+			return;
+		case TenB:
+			plan.add(&Fnet(N, 0), 1.0, OutputPlan::OP_NORM, stride);
+			return;
+		case FX:
+		case FY:
+		case FZ:
+			plan.add(&Fnet(i, outChan.QType - FX));
+			return;
+		default:
+			break;
+	}
+	LOGWRN << "Unrecognized output channel " << outChan.QType << endl;
+	plan.addZero();
+}
+
 void
 Line::storeWaterKin(real dt,
                     std::vector<std::vector<moordyn::real>> zeta_in,
@@ -666,16 +705,68 @@ Line::setPin(std::vector<real> p)
 }
 
 void
-Line::setState(const std::vector<vec>& pos, const std::vector<vec>& vel)
+Line::setState(const Eigen::Ref<const Eigen::Matrix3Xr>& pos,
+               const Eigen::Ref<const Eigen::Matrix3Xr>& vel)
 {
-	if ((pos.size() != N - 1) || (vel.size() != N - 1)) {
+	if ((pos.cols() != N - 1) || (vel.cols() != N - 1)) {
 		LOGERR << "Invalid input size" << endl;
 		throw moordyn::invalid_value_error("Invalid input size");
 	}
 
 	// set interior node positions and velocities based on state vector
-	std::copy(pos.begin(), pos.end(), r.begin() + 1);
-	std::copy(vel.begin(), vel.end(), rd.begin() + 1);
+	for (unsigned int i = 0; i < N - 1; i++) {
+		r[i + 1] = pos.col(i);
+		rd[i + 1] = vel.col(i);
+	}
+}
+
+void
+Line::getStateDerivJacobian(real c_r, real c_u, BlockTridiagonal& jac)
+{
+	const unsigned int n = N - 1;
+	if (jac.size() != n)
+		jac.resize(n);
+	jac_r.resize(3, n);
+	jac_u.resize(3, n);
+	jac_vel.resize(3, n);
+	jac_acc0.resize(3, n);
+	jac_acc.resize(3, n);
+	for (unsigned int i = 0; i < n; i++) {
+		jac_r.col(i) = r[i + 1];
+		jac_u.col(i) = rd[i + 1];
+	}
+	getStateDeriv(jac_vel, jac_acc0);
+
+	// The perturbation is chosen so the nodes are displaced a tiny fraction
+	// of the segments length
+	const real h = std::sqrt(std::numeric_limits<real>::epsilon()) *
+	               UnstrLen / N / c_r;
+	// The nodes perturbed at once shall not share any row of the Jacobian,
+	// including the second neighbours coupled by the bending stiffness
+	const unsigned int colors = ((EI > 0) || (nEIpoints > 0)) ? 5 : 3;
+	for (unsigned int color = 0; color < colors; color++) {
+		for (unsigned int d = 0; d < 3; d++) {
+			for (unsigned int j = color; j < n; j += colors) {
+				r[j + 1][d] += c_r * h;
+				rd[j + 1][d] += c_u * h;
+			}
+			getStateDeriv(jac_vel, jac_acc);
+			for (unsigned int j = color; j < n; j += colors) {
+				r[j + 1][d] = jac_r(d, j);
+				rd[j + 1][d] = jac_u(d, j);
+				jac.diag[j].col(d) = -(jac_acc.col(j) - jac_acc0.col(j)) / h;
+				jac.diag[j](d, d) += 1.0;
+				if (j > 0) {
+					jac.upper[j - 1].col(d) =
+					    -(jac_acc.col(j - 1) - jac_acc0.col(j - 1)) / h;
+				}
+				if (j + 1 < n) {
+					jac.lower[j + 1].col(d) =
+					    -(jac_acc.col(j + 1) - jac_acc0.col(j + 1)) / h;
+				}
+			}
+		}
+	}
 }
 
 void
@@ -708,15 +799,15 @@ Line::setEndOrientation(vec qin, EndPoints end_point, EndPoints rod_end_point)
 	switch (end_point) {
 		case ENDPOINT_TOP:
 			endTypeB = CANTILEVERED; // indicate pinned
-			q[N] = qin;              // -----line----->[A==ROD==>B]
+			vec2soa(qin, q, N);      // -----line----->[A==ROD==>B]
 			if (rod_end_point == ENDPOINT_B)
-				q[N] *= -1.0; // -----line----->[B<==ROD==A]
+				q.row(N) *= -1.0; // -----line----->[B<==ROD==A]
 			break;
 		case ENDPOINT_BOTTOM:
 			endTypeA = CANTILEVERED; // indicate pinned
-			q[0] = qin;              // [A==ROD==>B]-----line----->
+			vec2soa(qin, q, 0);      // [A==ROD==>B]-----line----->
 			if (rod_end_point == ENDPOINT_A)
-				q[0] *= -1.0; // [B<==ROD==A]-----line----->
+				q.row(0) *= -1.0; // [B<==ROD==A]-----line----->
 			break;
 		default:
 			LOGERR << "Invalid end point qualifier: " << end_point << endl;
@@ -767,9 +858,56 @@ Line::getEndSegmentMoment(EndPoints end_point, EndPoints rod_end_point) const
 	return qEnd * EIEnd / dlEnd;
 }
 
+template<unsigned int... features>
+constexpr std::array<Line::StateDerivKernel, sizeof...(features)>
+Line::kernelsTable(std::integer_sequence<unsigned int, features...>)
+{
+	return { &Line::getStateDerivKernel<features>... };
+}
+
 void
-Line::getStateDeriv(std::vector<vec>& vel, std::vector<vec>& acc)
+Line::selectKernel()
 {
+	static constexpr auto kernels =
+	    kernelsTable(std::make_integer_sequence<unsigned int, KERNEL_NUM>{});
+
+	unsigned int features = 0;
+	if ((EI > 0) || (nEIpoints > 0))
+		features |= KERNEL_EI;
+	if (isPb)
+		features |= KERNEL_PB;
+	if (nEApoints)
+		features |= KERNEL_NONLINEAR_EA;
+	if (nCpoints)
+		features |= KERNEL_NONLINEAR_C;
+	if (seafloor)
+		features |= KERNEL_SEAFLOOR;
+	kernel = kernels[features];
+
+	// The kernels are not touching the forces of the disabled features, so
+	// we better clean them up now
+	if (!(features & KERNEL_EI)) {
+		for (auto& b : Bs)
+			b = vec::Zero();
+	}
+	if (!(features & KERNEL_PB)) {
+		for (auto& b : Pb)
+			b = vec::Zero();
+	}
+}
+
+template<unsigned int features>
+void
+Line::getStateDerivKernel(Eigen::Ref<Eigen::Matrix3Xr> vel,
+                          Eigen::Ref<Eigen::Matrix3Xr> acc)
+{
+	// The features considered on this instantiation
+	constexpr bool isEI = features & KERNEL_EI;
+	constexpr bool withPb = features & KERNEL_PB;
+	constexpr bool nonlinearEA = features & KERNEL_NONLINEAR_EA;
+	constexpr bool nonlinearC = features & KERNEL_NONLINEAR_C;
+	constexpr bool with3DSeafloor = features & KERNEL_SEAFLOOR;
+
 	// NOTE:
 	// Jose Luis Cercos-Pita: This is by far the most consuming function of the
 	// whole library, just because it is called every single time substep and
@@ -788,85 +926,117 @@ Line::getStateDeriv(std::vector<vec>& vel, std::vector<vec>& acc)
 		}
 	}
 
-	// dt is possibly used for stability tricks...
+	// The kernel works on a structure-of-arrays layout, i.e. each component
+	// of each quantity is stored in a contiguous lane, so the Eigen array
+	// expressions below are processing several nodes per SIMD instruction.
+	// Thus, the first thing we need is to gather the node kinematics
+	aos2soa(r, r_lanes);
+	aos2soa(rd, rd_lanes);
 
-	// -------------------- calculate various kinematic quantities
-	// ---------------------------
-	for (unsigned int i = 0; i < N; i++) {
-		// calculate current (Stretched) segment lengths and unit tangent
-		// vectors (qs) for each segment (this is used for bending calculations)
-		lstr[i] = unitvector(qs[i], r[i], r[i + 1]);
+	// Maps of the scalar per-segment quantities, which are already
+	// contiguous
+	Eigen::Map<const Eigen::ArrayXr> l_seg(l.data(), N);
+	Eigen::Map<Eigen::ArrayXr> lstr_seg(lstr.data(), N);
+	Eigen::Map<Eigen::ArrayXr> ldstr_seg(ldstr.data(), N);
 
-		ldstr[i] = qs[i].dot(rd[i + 1] - rd[i]); // strain rate of segment
+	// Tolerance used by unitvector() to detect null vectors
+	constexpr real unit_tol =
+	    ((real)50.0) * std::numeric_limits<moordyn::real>::epsilon();
 
-		// V[i] = A * l[i]; // volume attributed to segment
-
-		if (nEApoints)
-			E = getNonlinearE(lstr[i], l[i]);
+	// -------------------- calculate various kinematic quantities
+	// ---------------------------
 
-		if (lstr[i] > l[i]) {
-			T[i] = E * A * (lstr[i] - l[i]) / l[i] * qs[i];
-		} else {
-			// cable can't "push" ...
-			// or can it, if bending stiffness is nonzero? <<<<<<<<<
-			T[i] = vec::Zero();
+	// calculate current (Stretched) segment lengths and unit tangent
+	// vectors (qs) for each segment (this is used for bending calculations)
+	qs = r_lanes.bottomRows(N) - r_lanes.topRows(N);
+	lstr_seg = qs.square().rowwise().sum().sqrt();
+	// NOTE: The column-wise factors are always stored first on a workspace.
+	// Otherwise Eigen evaluates the expression on a heap allocated temporary
+	auto aux_seg = aux_lanes.head(N);
+	aux_seg = (lstr_seg > unit_tol).select(lstr_seg, 1.0);
+	qs.colwise() /= aux_seg;
+
+	// strain rate of segment
+	ldstr_seg =
+	    (qs * (rd_lanes.bottomRows(N) - rd_lanes.topRows(N))).rowwise().sum();
+
+	// tension. Cable can't "push" ...
+	// or can it, if bending stiffness is nonzero? <<<<<<<<<
+	if constexpr (nonlinearEA) {
+		for (unsigned int i = 0; i < N; i++) {
+			const real E_i = getNonlinearE(lstr[i], l[i]);
+			const real f = (lstr[i] > l[i]) ?
+				E_i * A * (lstr[i] - l[i]) / l[i] : 0.0;
+			T.row(i) = f * qs.row(i);
 		}
+	} else {
+		aux_seg =
+		    (lstr_seg > l_seg).select(E * A * (lstr_seg - l_seg) / l_seg, 0.0);
+		T = qs.colwise() * aux_seg;
+	}
 
-		// line internal damping force
-		if (nCpoints)
-			c = getNonlinearC(ldstr[i], l[i]);
-		Td[i] = c * A * ldstr[i] / l[i] * qs[i];
+	// line internal damping force
+	if constexpr (nonlinearC) {
+		for (unsigned int i = 0; i < N; i++) {
+			const real c_i = getNonlinearC(ldstr[i], l[i]);
+			Td.row(i) = (c_i * A * ldstr[i] / l[i]) * qs.row(i);
+		}
+	} else {
+		aux_seg = c * A * ldstr_seg / l_seg;
+		Td = qs.colwise() * aux_seg;
 	}
 
 	// calculate unit tangent vectors (q) for each internal node. note: I've
 	// reversed these from pointing toward 0 rather than N. Check sign of wave
 	// loads. <<<<
-	for (unsigned int i = 1; i < N; i++)
-		unitvector(
-		    q[i],
-		    r[i - 1],
-		    r[i + 1]); // compute unit vector q ... using adjacent two nodes!
+	// compute unit vector q ... using adjacent two nodes!
+	if (N > 1) {
+		auto q_int = q.middleRows(1, N - 1);
+		q_int = r_lanes.bottomRows(N - 1) - r_lanes.topRows(N - 1);
+		auto l_int = aux_lanes.head(N - 1);
+		l_int = q_int.square().rowwise().sum().sqrt();
+		l_int = (l_int > unit_tol).select(l_int, 1.0);
+		q_int.colwise() /= l_int;
+	}
 
 	// calculate unit tangent vectors for either end node if the line has no
 	// bending stiffness of if either end is pinned (otherwise it's already
 	// been set via ::setEndOrientation())
-	const bool isEI = (EI > 0) || (nEIpoints > 0);
-	if ((endTypeA == PINNED) || !isEI)
-		unitvector(q[0], r[0], r[1]);
-	if ((endTypeB == PINNED) || !isEI)
-		unitvector(q[N], r[N - 1], r[N]);
+	if (!isEI || (endTypeA == PINNED))
+		q.row(0) = qs.row(0);
+	if (!isEI || (endTypeB == PINNED))
+		q.row(N) = qs.row(N - 1);
 
 	// calculate the curvatures and normal vectors (just if needed)
-	if (isEI || isPb) {
+	if constexpr (isEI || withPb) {
+		// end node A case (only if attached to a Rod, i.e. a cantilever
+		// rather than pinned point)
+		Kurv[0] = (endTypeA == CANTILEVERED) ?
+			GetCurvature(lstr[0], soa2vec(q, 0), soa2vec(qs, 0)) :
+			0.0;
+		pvec[0] = EqualRealNos(Kurv[0], 0.0) ?
+			vec::Zero() :
+			vec(soa2vec(q, 0).cross(soa2vec(qs, 0)));
+		// internal nodes
+		for (unsigned int i = 1; i < N; i++) {
+			// curvature <<< remember to check sign, or just take abs
+			Kurv[i] = GetCurvature(
+			    lstr[i - 1] + lstr[i], soa2vec(qs, i - 1), soa2vec(qs, i));
+			pvec[i] = EqualRealNos(Kurv[i], 0.0) ?
+				vec::Zero() :
+				vec(soa2vec(qs, i - 1).cross(soa2vec(qs, i)));
+		}
+		// end node B case (only if attached to a Rod, i.e. a cantilever
+		// rather than pinned point)
+		Kurv[N] = (endTypeB == CANTILEVERED) ?
+			GetCurvature(lstr[N - 1], soa2vec(qs, N - 1), soa2vec(q, N)) :
+			0.0;
+		pvec[N] = EqualRealNos(Kurv[N], 0.0) ?
+			vec::Zero() :
+			vec(soa2vec(qs, N - 1).cross(soa2vec(q, N)));
+		// We can renormalize them for afterwards simplicity
 		for (unsigned int i = 0; i <= N; i++) {
-			if (i == 0) {
-				// end node A case (only if attached to a Rod, i.e. a
-				// cantilever rather than pinned point)
-				Kurv[i] = (endTypeA == CANTILEVERED) ?
-					GetCurvature(lstr[0], q[0], qs[0]) : 0.0;
-			} else if (i == N) {
-				// end node B case (only if attached to a Rod, i.e. a
-				// cantilever rather than pinned point)
-				Kurv[i] = (endTypeB == CANTILEVERED) ?
-					GetCurvature(lstr[i - 1], qs[i - 1], q[i]) : 0.0;
-			} else {
-				// internal node
-				// curvature <<< remember to check sign, or just take abs
-				Kurv[i] = GetCurvature(lstr[i - 1] + lstr[i], qs[i - 1], qs[i]);
-			}
-			if (EqualRealNos(Kurv[i], 0.0)) {
-				pvec[i] = vec::Zero();
-				continue;
-			}
-
-			if (i == 0)
-				pvec[i] = q[0].cross(qs[0]);
-			else if (i == N)
-				pvec[i] = qs[i - 1].cross(q[N]);
-			else
-				pvec[i] = qs[i - 1].cross(qs[i]);
 			const real l_pvec = pvec[i].norm();
-			// We can renormalize it for afterwards simplicity
 			if (!EqualRealNos(l_pvec, 0.0))
 				pvec[i] /= l_pvec;
 		}
@@ -876,6 +1046,8 @@ Line::getStateDeriv(std::vector<vec>& vel, std::vector<vec>& acc)
 	// --------------------------------- apply wave kinematics
 	// -----------------------------
 	auto [zeta, U, Ud, pdyn] = waves->getWaveKinLine(lineId);
+	aos2soa(U, U_lanes);
+	aos2soa(Ud, Ud_lanes);
 
 	// If in still water, iterate over all the segments and calculate
 	// volume of segment submerged. This is later used to calculate
@@ -894,104 +1066,59 @@ Line::getStateDeriv(std::vector<vec>& vel, std::vector<vec>& acc)
 	// ===============================
 
 	// Bending loads
-	// first zero out the forces from last run
-	for (unsigned int i = 0; i <= N; i++) {
-		Bs[i] = vec::Zero();
-		Pb[i] = vec::Zero();
-	}
+	if constexpr (isEI) {
+		// first zero out the forces from last run
+		for (unsigned int i = 0; i <= N; i++)
+			Bs[i] = vec::Zero();
+
+		// end node A case (only if attached to a Rod, i.e. a cantilever
+		// rather than pinned point)
+		if ((endTypeA == CANTILEVERED) && !EqualRealNos(Kurv[0], 0.0)) {
+			const real EI_i = nEIpoints ? getNonlinearEI(Kurv[0]) : EI;
+			// get direction of resulting force from bending to apply on node
+			// i+1
+			vec Mforce_ip1 = soa2vec(qs, 0).cross(pvec[0]);
+
+			// scale force direction vectors by desired moment force
+			// magnitudes to get resulting forces on adjacent nodes
+			Mforce_ip1 *= Kurv[0] * EI_i / lstr[0];
+
+			// set force on node i to cancel out forces on adjacent nodes
+			vec Mforce_i = -Mforce_ip1;
+
+			// apply these forces to the node forces
+			Bs[0] += Mforce_i;
+			Bs[1] += Mforce_ip1;
+		}
 
-	// and now compute them (if possible)
-	if (isEI) {
-		// loop through all nodes to calculate bending forces
-		for (unsigned int i = 0; i <= N; i++) {
+		// loop through internal nodes to calculate bending forces
+		for (unsigned int i = 1; i < N; i++) {
 			const real Kurvi = Kurv[i];
 			if (EqualRealNos(Kurvi, 0.0))
 				continue;
 
 			// calculate force on each node due to bending stiffness!
+			const real EI_i = nEIpoints ? getNonlinearEI(Kurvi) : EI;
 
-			if (i == 0) {
-				// end node A case (only if attached to a Rod, i.e. a
-				// cantilever rather than pinned point)
-				if (endTypeA == CANTILEVERED)
-				{
-					if (nEIpoints > 0)
-						EI = getNonlinearEI(Kurvi);
-
-					// get direction of resulting force from bending to apply
-					// on node i+1
-					vec Mforce_ip1 = qs[0].cross(pvec[i]);
-
-					// scale force direction vectors by desired moment force
-					// magnitudes to get resulting forces on adjacent nodes
-					Mforce_ip1 *= Kurvi * EI / lstr[i];
-
-					// set force on node i to cancel out forces on adjacent
-					// nodes
-					vec Mforce_i = -Mforce_ip1;
-
-					// apply these forces to the node forces
-					Bs[i] += Mforce_i;
-					Bs[i + 1] += Mforce_ip1;
-				}
-			}
-			// end node A case (only if attached to a Rod, i.e. a cantilever
-			// rather than pinned point)
-			else if (i == N) {
-				if (endTypeB == CANTILEVERED) // if attached to Rod i.e.
-				                              // cantilever point
-				{
-					// curvature <<< check if this approximation
-					// works for an end (assuming rod angle is node
-					// angle which is middle of if there was a
-					// segment -1/2
-					if (nEIpoints > 0)
-						EI = getNonlinearEI(Kurvi);
-
-					// get direction of resulting force from bending to apply on
-					// node i-1
-					vec Mforce_im1 = qs[i - 1].cross(pvec[i]);
-
-					// scale force direction vectors by desired moment force
-					// magnitudes to get resulting forces on adjacent nodes
-					Mforce_im1 *= Kurvi * EI / lstr[i - 1];
-
-					// set force on node i to cancel out forces on adjacent
-					// nodes
-					vec Mforce_i = -Mforce_im1;
-
-					// apply these forces to the node forces
-					Bs[i - 1] += Mforce_im1;
-					Bs[i] += Mforce_i;
-				}
-			}
-			// internal node
-			else {
-				// curvature <<< remember to check
-				// sign, or just take abs
-				if (nEIpoints > 0)
-					EI = getNonlinearEI(Kurvi);
-
-				// get direction of resulting force from bending to apply on
-				// node i-1
-				vec Mforce_im1 = qs[i - 1].cross(pvec[i]);
-				// get direction of resulting force from bending to apply on
-				// node i+1
-				vec Mforce_ip1 = qs[i].cross(pvec[i]);
-
-				// scale force direction vectors by desired moment force
-				// magnitudes to get resulting forces on adjacent nodes
-				Mforce_im1 *= Kurvi * EI / lstr[i - 1];
-				Mforce_ip1 *= Kurvi * EI / lstr[i];
-
-				// set force on node i to cancel out forces on adjacent nodes
-				vec Mforce_i = -Mforce_im1 - Mforce_ip1;
-
-				// apply these forces to the node forces
-				Bs[i - 1] += Mforce_im1;
-				Bs[i] += Mforce_i;
-				Bs[i + 1] += Mforce_ip1;
-			}
+			// get direction of resulting force from bending to apply on
+			// node i-1
+			vec Mforce_im1 = soa2vec(qs, i - 1).cross(pvec[i]);
+			// get direction of resulting force from bending to apply on
+			// node i+1
+			vec Mforce_ip1 = soa2vec(qs, i).cross(pvec[i]);
+
+			// scale force direction vectors by desired moment force
+			// magnitudes to get resulting forces on adjacent nodes
+			Mforce_im1 *= Kurvi * EI_i / lstr[i - 1];
+			Mforce_ip1 *= Kurvi * EI_i / lstr[i];
+
+			// set force on node i to cancel out forces on adjacent nodes
+			vec Mforce_i = -Mforce_im1 - Mforce_ip1;
+
+			// apply these forces to the node forces
+			Bs[i - 1] += Mforce_im1;
+			Bs[i] += Mforce_i;
+			Bs[i + 1] += Mforce_ip1;
 
 			// any damping forces for bending? I hope not...
 
@@ -1040,20 +1167,46 @@ Line::getStateDeriv(std::vector<vec>& vel, std::vector<vec>& acc)
 
 			}
 			*/
-		} // for i=0,N (looping through nodes)
-	}     // if EI > 0
+		} // for i=1,N-1 (looping through internal nodes)
+
+		// end node B case (only if attached to a Rod, i.e. a cantilever
+		// rather than pinned point)
+		if ((endTypeB == CANTILEVERED) && !EqualRealNos(Kurv[N], 0.0)) {
+			const real EI_i = nEIpoints ? getNonlinearEI(Kurv[N]) : EI;
+			// curvature <<< check if this approximation works for an end
+			// (assuming rod angle is node angle which is middle of if there
+			// was a segment -1/2
+
+			// get direction of resulting force from bending to apply on node
+			// i-1
+			vec Mforce_im1 = soa2vec(qs, N - 1).cross(pvec[N]);
+
+			// scale force direction vectors by desired moment force
+			// magnitudes to get resulting forces on adjacent nodes
+			Mforce_im1 *= Kurv[N] * EI_i / lstr[N - 1];
+
+			// set force on node i to cancel out forces on adjacent nodes
+			vec Mforce_i = -Mforce_im1;
+
+			// apply these forces to the node forces
+			Bs[N - 1] += Mforce_im1;
+			Bs[N] += Mforce_i;
+		}
+	} // if EI > 0
 
-	if (isPb) {
-		// loop through all nodes to calculate bending forces
+	if constexpr (withPb) {
+		// loop through all nodes to calculate pressure bending forces
 		for (unsigned int i = 0; i <= N; i++) {
 			const real Kurvi = Kurv[i];
-			if (EqualRealNos(Kurvi, 0.0))
+			if (EqualRealNos(Kurvi, 0.0)) {
+				Pb[i] = vec::Zero();
 				continue;
+			}
 			// The driving pressure
 			const real h = (std::max)(0.0, zeta[i] - r[i].z());
 			const real p = pin[i] - (env->rho_w * env->g * h + pdyn[i]);
 			// The direction
-			const vec nvec = q[i].cross(pvec[i]);
+			const vec nvec = soa2vec(q, i).cross(pvec[i]);
 			// So we can compute the force
 			if (i == 0)
 				Pb[i] = 0.5 * A * l[i] * p * Kurvi * nvec;
@@ -1069,123 +1222,130 @@ Line::getStateDeriv(std::vector<vec>& vel, std::vector<vec>& acc)
 	const real rho_w = env->rho_w;
 	const real g = env->g;
 
-	// loop through the nodes
-	for (unsigned int i = 0; i <= N; i++) {
-		// Nodes are considered to have a line length of half the length of the
-		// line on either side.
-		const real length_left = i == 0 ? 0.0 : l[i - 1];
-		const real length_right = i == N ? 0.0 : l[i];
-		const real length = 0.5 * (length_left + length_right);
-		const real submergence_left = i == 0 ? 0.0 : F[i - 1];
-		const real submergence_right = i == N ? 0.0 : F[i];
-		// Submerged length is half the submerged length of the neighboring
-		// segments
-		const real submerged_length = 0.5 * (length_left * submergence_left +
-		                                     length_right * submergence_right);
-
-		const real submerged_volume = submerged_length * A;
-
-		const real m_i = A * length * rho; // node mass
-		const real v_i = submerged_volume; // node submerged volume
-
-		// Make node mass matrix
-		const mat I = mat::Identity();
-		const mat Q = q[i] * q[i].transpose();
-		// calculate mass matrix
-		M[i] = m_i * I + rho_w * v_i * (Can * (I - Q) + Cat * Q);
-
-		// submerged weight (including buoyancy)
-		W[i][0] = W[i][1] = 0.0;
-		W[i][2] = -g * (m_i - v_i * rho_w);
-
-		// relative flow velocity over node
-		const vec vi = U[i] - rd[i];
-		// tangential relative flow component
-		// <<<<<<< check sign since I've reversed q
-		const real vql = vi.dot(q[i]);
-		const vec vq = vql * q[i];
-		// transverse relative flow component
-		const vec vp = vi - vq;
-
-		const real vq_mag = vq.norm();
-		const real vp_mag = vp.norm();
-
-		const real shared_part = 0.5 * rho_w * d * submerged_length;
-		// transverse drag
-		Dp[i] = vp_mag * Cdn * shared_part * vp;
-		// tangential drag
-		Dq[i] = vq_mag * Cdt * pi * shared_part * vq;
-
-		// <<<<<<< check sign since I've reversed q
-		const real aql = Ud[i].dot(q[i]);
-		const vec aq = aql * q[i];
-		// normal component of fluid acceleration
-		const vec ap = Ud[i] - aq;
-
-		// transverse Froude-Krylov force
-		Ap[i] = rho_w * (1. + Can) * submerged_volume * ap;
-		// tangential Froude-Krylov force
-		Aq[i] = rho_w * (1. + Cat) * submerged_volume * aq;
-
-		// bottom contact (stiffness and damping, vertical-only for now) -
-		// updated for general case of potentially anchor or fairlead end in
-		// contact
-		const real waterDepth = getWaterDepth(r[i][0], r[i][1]);
-		if (r[i][2] < waterDepth) {
-			B[i][2] = ((waterDepth - r[i][2]) * env->kb - rd[i][2] * env->cb) *
-			          d * (length);
-
-			// new rough-draft addition of seabed friction
-			real FrictionMax =
-			    abs(B[i][2]) *
-			    env->FrictionCoefficient; // dynamic friction force saturation
-			                              // level based on bottom contact force
-
-			// saturated damping approach to applying friction, for now
-			real BottomVel =
-			    sqrt(rd[i][0] * rd[i][0] +
-			         rd[i][1] * rd[i][1]); // velocity of node along sea bed
-			real FrictionForce =
-			    BottomVel * env->FrictionCoefficient *
-			    env->FricDamp; // some arbitrary damping scaling thing at end
-			if (FrictionForce > env->StatDynFricScale * FrictionMax)
-				FrictionForce =
-				    FrictionMax; // saturate (quickly) to static/dynamic
-				                 // friction force level
-
-			if (BottomVel == 0.0) { // check for zero velocity, in which case
-				                    // friction force is zero
-				B[i][0] = 0.0;
-				B[i][1] = 0.0;
-			} else { // otherwise, apply friction force in correct
-				     // direction(opposing direction of motion)
-				B[i][0] = -FrictionForce * rd[i][0] / BottomVel;
-				B[i][1] = -FrictionForce * rd[i][1] / BottomVel;
-			}
-		} else
-			B[i] = vec(0.0, 0.0, 0.0);
-
-		// total forces
-		if (i == 0)
-			Fnet[i] = T[i] + Td[i];
-		else if (i == N)
-			Fnet[i] = -T[i - 1] - Td[i - 1];
-		else
-			Fnet[i] = T[i] - T[i - 1] + Td[i] - Td[i - 1];
-		Fnet[i] += W[i] + (Dp[i] + Dq[i] + Ap[i] + Aq[i]) + B[i] +
-			Bs[i] + Pb[i];
-	}
-
-	// loop through internal nodes and compute the accelerations
-	vel.reserve(N - 1);
-	acc.reserve(N - 1);
-	for (unsigned int i = 1; i < N; i++) {
-		// For small systems it is usually faster to compute the inverse
-		// of the matrix. See
-		// https://eigen.tuxfamily.org/dox/group__TutorialLinearAlgebra.html
-		acc[i - 1] = M[i].inverse() * Fnet[i];
-		vel[i - 1] = rd[i];
+	// Nodes are considered to have a line length of half the length of the
+	// line on either side. Submerged length is half the submerged length of
+	// the neighboring segments
+	Eigen::Map<const Eigen::ArrayXr> F_seg(F.data(), N);
+	len_lanes.setZero();
+	len_lanes.head(N) = l_seg;
+	len_lanes.tail(N) += l_seg;
+	len_lanes *= 0.5;
+	sublen_lanes.setZero();
+	sublen_lanes.head(N) = l_seg * F_seg;
+	sublen_lanes.tail(N) += l_seg * F_seg;
+	sublen_lanes *= 0.5;
+
+	// node mass and submerged volume
+	auto& m_i = m_lanes;
+	auto& v_i = v_lanes;
+	m_i = A * len_lanes * rho;
+	v_i = sublen_lanes * A;
+
+	// submerged weight (including buoyancy)
+	W.col(0).setZero();
+	W.col(1).setZero();
+	W.col(2) = -g * (m_i - v_i * rho_w);
+
+	// relative flow velocity over node
+	auto& vi = vi_lanes;
+	vi = U_lanes - rd_lanes;
+	// tangential relative flow component
+	// <<<<<<< check sign since I've reversed q
+	auto& vql = aux_lanes;
+	vql = (vi * q).rowwise().sum();
+	// The drag forces are computed in place to avoid temporaries
+	Dq = q.colwise() * vql;
+	// transverse relative flow component
+	Dp = vi - Dq;
+
+	vq_lanes = Dq.square().rowwise().sum().sqrt();
+	vp_lanes = Dp.square().rowwise().sum().sqrt();
+
+	const real shared_part = 0.5 * rho_w * d;
+	// transverse drag
+	vp_lanes *= (Cdn * shared_part) * sublen_lanes;
+	Dp.colwise() *= vp_lanes;
+	// tangential drag
+	vq_lanes *= (Cdt * pi * shared_part) * sublen_lanes;
+	Dq.colwise() *= vq_lanes;
+
+	// <<<<<<< check sign since I've reversed q
+	auto& aql = aux_lanes;
+	aql = (Ud_lanes * q).rowwise().sum();
+	// axial and normal components of the fluid acceleration
+	Aq = q.colwise() * aql;
+	Ap = Ud_lanes - Aq;
+
+	// transverse Froude-Krylov force
+	aux_lanes = rho_w * (1. + Can) * v_i;
+	Ap.colwise() *= aux_lanes;
+	// tangential Froude-Krylov force
+	aux_lanes = rho_w * (1. + Cat) * v_i;
+	Aq.colwise() *= aux_lanes;
+
+	// bottom contact (stiffness and damping, vertical-only for now) -
+	// updated for general case of potentially anchor or fairlead end in
+	// contact
+	if constexpr (with3DSeafloor) {
+		for (unsigned int i = 0; i <= N; i++)
+			depth_lanes[i] = seafloor->getDepthAt(r[i][0], r[i][1]);
+	} else
+		depth_lanes.setConstant(-env->WtrDpth);
+	const auto contact = r_lanes.col(2) < depth_lanes;
+	B.col(2) = contact.select(((depth_lanes - r_lanes.col(2)) * env->kb -
+	                           rd_lanes.col(2) * env->cb) *
+	                              d * len_lanes,
+	                          0.0);
+	// new rough-draft addition of seabed friction
+	// dynamic friction force saturation level based on bottom contact force
+	auto& FrictionMax = fricmax_lanes;
+	FrictionMax = B.col(2).abs() * env->FrictionCoefficient;
+	// saturated damping approach to applying friction, for now
+	// velocity of node along sea bed
+	auto& BottomVel = botvel_lanes;
+	BottomVel = (rd_lanes.col(0).square() + rd_lanes.col(1).square()).sqrt();
+	// some arbitrary damping scaling thing at end
+	auto& FrictionForce = fric_lanes;
+	FrictionForce = BottomVel * env->FrictionCoefficient * env->FricDamp;
+	// saturate (quickly) to static/dynamic friction force level
+	FrictionForce = (FrictionForce > env->StatDynFricScale * FrictionMax)
+	                    .select(FrictionMax, FrictionForce);
+	// check for zero velocity, in which case friction force is zero.
+	// Otherwise, apply friction force in correct direction (opposing
+	// direction of motion)
+	const auto friction = contact && (BottomVel != 0.0);
+	B.col(0) = friction.select(
+	    -FrictionForce * rd_lanes.col(0) / BottomVel, 0.0);
+	B.col(1) = friction.select(
+	    -FrictionForce * rd_lanes.col(1) / BottomVel, 0.0);
+
+	// total forces
+	Fnet.row(0) = T.row(0) + Td.row(0);
+	Fnet.middleRows(1, N - 1) = T.bottomRows(N - 1) - T.topRows(N - 1) +
+	                            Td.bottomRows(N - 1) - Td.topRows(N - 1);
+	Fnet.row(N) = -T.row(N - 1) - Td.row(N - 1);
+	Fnet += W + (Dp + Dq + Ap + Aq) + B;
+	if constexpr (isEI || withPb) {
+		for (unsigned int i = 0; i <= N; i++)
+			Fnet.row(i) += (Bs[i] + Pb[i]).transpose().array();
 	}
+
+	// node mass matrices, M = Ma * I + Mb * q * q^T
+	Ma = m_i + rho_w * v_i * Can;
+	Mb = rho_w * v_i * (Cat - Can);
+
+	// compute the accelerations, solving M * acc = Fnet in closed form (see
+	// solveNodeMass())
+	qq_lanes = q.square().rowwise().sum();
+	qF_lanes = (q * Fnet).rowwise().sum();
+	qF_lanes *= Mb / (Ma + Mb * qq_lanes);
+	acc_lanes = Fnet - q.colwise() * qF_lanes;
+	acc_lanes.colwise() /= Ma;
+
+	// store the internal nodes velocities and accelerations
+	acc = acc_lanes.middleRows(1, N - 1).transpose().matrix();
+	for (unsigned int i = 1; i < N; i++)
+		vel.col(i - 1) = rd[i];
 };
 
 // write output file for line  (accepts time parameter since retained time value
@@ -1193,105 +1353,67 @@ Line::getStateDeriv(std::vector<vec>& vel, std::vector<vec>& acc)
 void
 Line::Output(real time)
 {
-	// run through output flags
-	// if channel is flagged for output, write to file.
-	// Flags changed to just be one character (case sensitive) per output flag.
-	// To match FASTv8 version.
-
 	if (outfile) // if not a null pointer (indicating no output)
 	{
 		if (!outfile->is_open()) {
 			LOGWRN << "Unable to write to output file " << endl;
 			return;
 		}
-		// output time
-		*outfile << time << "\t ";
+		// The channels were already compiled when the header was written
+		outfile->begin(time);
+		outPlan.write(*outfile);
+		outfile->end();
+	}
+	return;
+};
 
-		// output positions?
-		// if (find(channels.begin(), channels.end(), "position") !=
-		// channels.end())
-		if (channels.find("p") != string::npos) {
-			for (unsigned int i = 0; i <= N; i++) // loop through nodes
-			{
-				for (unsigned int J = 0; J < 3; J++)
-					*outfile << r[i][J] << "\t ";
-			}
-		}
-		// output curvatures?
-		if (channels.find("K") != string::npos) {
-			for (unsigned int i = 0; i <= N; i++) {
-				*outfile << Kurv[i] << "\t ";
-			}
-		}
-		// output velocities?
-		if (channels.find("v") != string::npos) {
-			for (unsigned int i = 0; i <= N; i++) {
-				for (int J = 0; J < 3; J++)
-					*outfile << rd[i][J] << "\t ";
-			}
-		}
-		// output wave velocities?
-		if (channels.find("U") != string::npos) {
-			auto [_z, U, _ud, _pdyn] = waves->getWaveKinLine(lineId);
-			for (unsigned int i = 0; i <= N; i++) {
-				for (int J = 0; J < 3; J++)
-					*outfile << U[i][J] << "\t ";
-			}
-		}
-		// output hydro drag force?
-		if (channels.find("D") != string::npos) {
-			for (unsigned int i = 0; i <= N; i++) {
-				for (int J = 0; J < 3; J++)
-					*outfile << Dp[i][J] + Dq[i][J] + Ap[i][J] + Aq[i][J]
-					         << "\t ";
-			}
-		}
-		// output segment tensions?
-		if (channels.find("t") != string::npos) {
-			for (unsigned int i = 0; i < N; i++) {
-				*outfile << T[i].norm() << "\t ";
-				// >>> preparation below for switching to outputs at nodes
-				// <<< note that tension of end nodes will need weight and
-				// buoyancy adjustment
-				// if (i==0)
-				//      *outfile << (T[i] + W[i]).norm() << "\t ";
-				// else if (i==N)
-				//      *outfile << (T[i] - W[i]).norm() << "\t ";
-				// else
-				//	*outfile << T[i].norm() << "\t ";
-			}
-		}
-		// output internal damping force?
-		if (channels.find("c") != string::npos) {
-			for (unsigned int i = 0; i < N; i++) {
-				for (int J = 0; J < 3; J++)
-					*outfile << Td[i][J] << "\t ";
-			}
-		}
-		// output segment strains?
-		if (channels.find("s") != string::npos) {
-			for (unsigned int i = 0; i < N; i++) {
-				*outfile << lstr[i] / l[i] - 1.0 << "\t ";
-			}
-		}
-		// output segment strain rates?
-		if (channels.find("d") != string::npos) {
-			for (unsigned int i = 0; i < N; i++) {
-				*outfile << ldstr[i] / l[i] << "\t ";
-			}
-		}
-		// output seabed contact forces?
-		if (channels.find("b") != string::npos) {
-			for (unsigned int i = 0; i <= N; i++) {
-				for (int J = 0; J < 3; J++)
-					*outfile << B[i][J] << "\t ";
-			}
+void
+Line::saveFatigue(const std::string& filepath) const
+{
+	ofstream f(filepath);
+	if (!f.is_open()) {
+		LOGERR << "Unable to write file " << filepath << endl;
+		throw moordyn::output_file_error("Invalid fatigue file");
+	}
+	const unsigned int bins = fatigue.empty() ? 0 : fatigue.front().bins();
+	f << "Seg\t Cycles\t Damage\t BinWidth\n"
+	  << "(-)\t (-)\t (-)\t (N)\n";
+	for (unsigned int i = 0; i < fatigue.size(); i++)
+		f << i + 1 << "\t " << fatigue[i].cycles() << "\t "
+		  << fatigue[i].damage() << "\t " << fatigue[i].binWidth() << "\n";
+	// The histograms, with the ranges on the rows and the means on the
+	// columns
+	std::vector<real> hist(bins * bins);
+	for (unsigned int i = 0; i < fatigue.size(); i++) {
+		fatigue[i].histogram(hist.data());
+		f << "\nSeg" << i + 1 << "\n";
+		for (unsigned int j = 0; j < bins; j++) {
+			for (unsigned int k = 0; k < bins; k++)
+				f << hist[j * bins + k] << "\t ";
+			f << "\n";
 		}
+	}
+	if (!f) {
+		LOGERR << "Failure writing the file " << filepath << endl;
+		throw moordyn::output_file_error("Failure writing the fatigue");
+	}
+}
 
-		*outfile << "\n";
+void
+Line::updateOutput()
+{
+	if (outU.size()) {
+		auto [_z, U, _ud, _pdyn] = waves->getWaveKinLine(lineId);
+		for (unsigned int i = 0; i <= N; i++)
+			outU[i] = U[i];
 	}
-	return;
-};
+	if (outD.rows())
+		outD = Dp + Dq + Ap + Aq;
+	for (unsigned int i = 0; i < outStrain.size(); i++)
+		outStrain[i] = lstr[i] / l[i] - 1.0;
+	for (unsigned int i = 0; i < outStrainRate.size(); i++)
+		outStrainRate[i] = ldstr[i] / l[i];
+}
 
 std::vector<uint64_t>
 Line::Serialize(void)
@@ -1315,6 +1437,10 @@ Line::Serialize(void)
 	data.insert(data.end(), subdata.begin(), subdata.end());
 	subdata = io::IO::Serialize(Kurv);
 	data.insert(data.end(), subdata.begin(), subdata.end());
+	std::vector<mat> M;
+	M.reserve(N + 1);
+	for (unsigned int i = 0; i <= N; i++)
+		M.push_back(getNodeM(i));
 	subdata = io::IO::Serialize(M);
 	data.insert(data.end(), subdata.begin(), subdata.end());
 	subdata = io::IO::Serialize(V);
@@ -1341,6 +1467,13 @@ Line::Serialize(void)
 	data.insert(data.end(), subdata.begin(), subdata.end());
 	subdata = io::IO::Serialize(F);
 	data.insert(data.end(), subdata.begin(), subdata.end());
+	// The fatigue counting, so it is resumed on load
+	std::vector<std::vector<real>> rf_states;
+	rf_states.reserve(fatigue.size());
+	for (const auto& rf : fatigue)
+		rf_states.push_back(rf.getState());
+	subdata = io::IO::Serialize(rf_states);
+	data.insert(data.end(), subdata.begin(), subdata.end());
 
 	return data;
 }
@@ -1358,7 +1491,25 @@ Line::Deserialize(const uint64_t* data)
 	ptr = io::IO::Deserialize(ptr, lstr);
 	ptr = io::IO::Deserialize(ptr, ldstr);
 	ptr = io::IO::Deserialize(ptr, Kurv);
+	std::vector<mat> M;
 	ptr = io::IO::Deserialize(ptr, M);
+	// Recover the scalars of M = Ma * I + Mb * q * q^T, taking into account
+	// that tr(M) = 3 * Ma + Mb * q^T * q and q^T * M * q / q^T * q = Ma + Mb *
+	// q^T * q
+	Ma.resize(M.size());
+	Mb.resize(M.size());
+	for (unsigned int i = 0; i < M.size(); i++) {
+		const vec q_i = soa2vec(q, i);
+		const real qq = q_i.squaredNorm();
+		if (EqualRealNos(qq, 0.0)) {
+			Ma[i] = M[i].trace() / 3.0;
+			Mb[i] = 0.0;
+			continue;
+		}
+		const real qMq = q_i.dot(M[i] * q_i) / qq;
+		Ma[i] = 0.5 * (M[i].trace() - qMq);
+		Mb[i] = (qMq - Ma[i]) / qq;
+	}
 	ptr = io::IO::Deserialize(ptr, V);
 	ptr = io::IO::Deserialize(ptr, T);
 	ptr = io::IO::Deserialize(ptr, Td);
@@ -1371,6 +1522,21 @@ Line::Deserialize(const uint64_t* data)
 	ptr = io::IO::Deserialize(ptr, B);
 	ptr = io::IO::Deserialize(ptr, Fnet);
 	ptr = io::IO::Deserialize(ptr, F);
+	std::vector<std::vector<real>> rf_states;
+	ptr = io::IO::Deserialize(ptr, rf_states);
+	if (rf_states.size() != fatigue.size()) {
+		if (!fatigue.empty())
+			LOGWRN << "Line " << number << " fatigue was not saved. "
+			       << "The cycles counting is restarted" << endl;
+	} else {
+		for (unsigned int i = 0; i < fatigue.size(); i++) {
+			if (fatigue[i].setState(rf_states[i]))
+				continue;
+			LOGWRN << "Line " << number << " fatigue was saved with a "
+			       << "different number of bins. The cycles counting of "
+			       << "segment " << i << " is restarted" << endl;
+		}
+	}
 
 	return ptr;
 }
@@ -1388,7 +1554,7 @@ Line::getVTK() const
 	// Node fields, i.e. r.size() number of tuples
 	auto vtk_rd = vector_to_vtk_array("rd", this->rd);
 	auto vtk_Kurv = vector_to_vtk_array("Kurv", this->Kurv);
-	auto vtk_Fnet = vector_to_vtk_array("Fnet", this->Fnet);
+	auto vtk_Fnet = io::vtk_farray("Fnet", 3, num_points);
 	auto vtk_M = io::vtk_farray("M", 9, num_points);
 	auto vtk_D = io::vtk_farray("Drag", 3, num_points);
 	auto [_z, U, _ud, _pdyn] = waves->getWaveKinLine(lineId);
@@ -1398,7 +1564,7 @@ Line::getVTK() const
 	auto vtk_lstr = vector_to_vtk_array("lstr", this->lstr);
 	auto vtk_ldstr = vector_to_vtk_array("ldstr", this->ldstr);
 	auto vtk_V = vector_to_vtk_array("V", this->V);
-	auto vtk_T = vector_to_vtk_array("T", this->T);
+	auto vtk_T = io::vtk_farray("T", 3, num_cells);
 	auto vtk_F = vector_to_vtk_array("F", this->F);
 
 	line->GetPointIds()->SetNumberOfIds(num_points);
@@ -1409,21 +1575,23 @@ Line::getVTK() const
 	for (unsigned int i = 0; i < num_points; i++) {
 		points->InsertNextPoint(r[i][0], r[i][1], r[i][2]);
 		line->GetPointIds()->SetId(i, i);
-		auto drag = Dq[i] + Dp[i];
+		const vec drag = getNodeDrag(i);
 		vtk_D->SetTuple3(i, drag[0], drag[1], drag[2]);
+		const mat M = getNodeM(i);
 		vtk_M->SetTuple9(i,
-		                 M[i](0, 0),
-		                 M[i](0, 1),
-		                 M[i](0, 2),
-		                 M[i](1, 0),
-		                 M[i](1, 1),
-		                 M[i](1, 2),
-		                 M[i](2, 0),
-		                 M[i](2, 1),
-		                 M[i](2, 2));
-		vtk_Fnet->SetTuple3(i, Fnet[i][0], Fnet[i][1], Fnet[i][2]);
+		                 M(0, 0),
+		                 M(0, 1),
+		                 M(0, 2),
+		                 M(1, 0),
+		                 M(1, 1),
+		                 M(1, 2),
+		                 M(2, 0),
+		                 M(2, 1),
+		                 M(2, 2));
+		vtk_Fnet->SetTuple3(i, Fnet(i, 0), Fnet(i, 1), Fnet(i, 2));
 		if (i == r.size() - 1)
 			continue;
+		vtk_T->SetTuple3(i, T(i, 0), T(i, 1), T(i, 2));
 
 		std::array<vtkIdType, 2> cell_points{ i, i + 1 };
 		cells->InsertNextCell(cell_points.size(), cell_points.data());
@@ -1770,6 +1938,53 @@ MoorDyn_GetLineMaxTen(MoorDynLine l, double* t)
 	return MOORDYN_SUCCESS;
 }
 
+int DECLDIR
+MoorDyn_GetLineFatigueBins(MoorDynLine l, unsigned int* n)
+{
+	CHECK_LINE(l);
+	moordyn::Line* line = (moordyn::Line*)l;
+	*n = line->hasFatigue() ? line->getSegFatigue(0).bins() : 0;
+	return MOORDYN_SUCCESS;
+}
+
+int DECLDIR
+MoorDyn_GetLineSegFatigueHist(MoorDynLine l,
+                              unsigned int i,
+                              double* w,
+                              double* hist)
+{
+	CHECK_LINE(l);
+	moordyn::error_id err = MOORDYN_SUCCESS;
+	string err_msg;
+	try {
+		const moordyn::Rainflow& rf = ((moordyn::Line*)l)->getSegFatigue(i);
+		std::vector<moordyn::real> h(rf.bins() * rf.bins());
+		rf.histogram(h.data());
+		std::copy(h.begin(), h.end(), hist);
+		*w = rf.binWidth();
+	}
+	MOORDYN_CATCHER(err, err_msg);
+	return err;
+}
+
+int DECLDIR
+MoorDyn_GetLineSegFatigueDamage(MoorDynLine l,
+                                unsigned int i,
+                                double* cycles,
+                                double* damage)
+{
+	CHECK_LINE(l);
+	moordyn::error_id err = MOORDYN_SUCCESS;
+	string err_msg;
+	try {
+		const moordyn::Rainflow& rf = ((moordyn::Line*)l)->getSegFatigue(i);
+		*cycles = rf.cycles();
+		*damage = rf.damage();
+	}
+	MOORDYN_CATCHER(err, err_msg);
+	return err;
+}
+
 int DECLDIR
 MoorDyn_SaveLineVTK(MoorDynLine l, const char* filename)
 {
@@ -457,6 +457,53 @@ extern "C"
 	 */
 	int DECLDIR MoorDyn_GetLineMaxTen(MoorDynLine l, double* t);
 
+	/** @brief Get the number of bins of each axis of the segments rainflow
+	 * histograms
+	 * @param l The Moordyn line
+	 * @param n The output number of bins, 0 if the fatigue is not computed,
+	 * i.e. the "F" output flag was not set on the line
+	 * @return MOORDYN_INVALID_VALUE if a NULL line is provided, MOORDYN_SUCCESS
+	 * otherwise
+	 */
+	int DECLDIR MoorDyn_GetLineFatigueBins(MoorDynLine l, unsigned int* n);
+
+	/** @brief Get the rainflow histogram of a segment tension
+	 *
+	 * The row i and column j of the histogram counts the tension cycles with
+	 * a range in [i w, (i + 1) w) and a mean in [j w, (j + 1) w), being w the
+	 * bin width. The residue is counted as half cycles
+	 * @param l The Moordyn line
+	 * @param i The segment index
+	 * @param w The output bin width
+	 * @param hist The output histogram, of n x n values, row-major, with n
+	 * the number of bins given by MoorDyn_GetLineFatigueBins()
+	 * @return MOORDYN_INVALID_VALUE if a NULL line is provided, if the fatigue
+	 * is not computed or if the segment index is not smaller than the number
+	 * of segments, MOORDYN_SUCCESS otherwise
+	 */
+	int DECLDIR MoorDyn_GetLineSegFatigueHist(MoorDynLine l,
+	                                          unsigned int i,
+	                                          double* w,
+	                                          double* hist);
+
+	/** @brief Get the number of tension cycles of a segment, and the
+	 * accumulated fatigue damage
+	 *
+	 * The residue is counted as half cycles
+	 * @param l The Moordyn line
+	 * @param i The segment index
+	 * @param cycles The output number of cycles
+	 * @param damage The output damage, 0 if no S-N curve was set on the line
+	 * type
+	 * @return MOORDYN_INVALID_VALUE if a NULL line is provided, if the fatigue
+	 * is not computed or if the segment index is not smaller than the number
+	 * of segments, MOORDYN_SUCCESS otherwise
+	 */
+	int DECLDIR MoorDyn_GetLineSegFatigueDamage(MoorDynLine l,
+	                                            unsigned int i,
+	                                            double* cycles,
+	                                            double* damage);
+
 	/** @brief Save the line to a VTK (.vtp) file
 	 * @param l The Moordyn line
 	 * @param filename The output maximum tension module
@@ -38,6 +38,11 @@
 #include "IO.hpp"
 #include "Seafloor.hpp"
 #include "Util/CFL.hpp"
+#include "Util/BlockTridiagonal.hpp"
+#include "Util/OutputFile.hpp"
+#include "Util/OutputPlan.hpp"
+#include "Util/Rainflow.hpp"
+#include <array>
 #include <utility>
 
 #ifdef USE_VTK
@@ -96,6 +101,66 @@ class Line final : public io::IO, public NatFreqCFL
 	 */
 	real getNonlinearC(real ld_stretched, real l_unstretched) const;
 
+	/** @brief Features of the line that the derivatives kernel shall
+	 * consider
+	 *
+	 * The kernel, moordyn::Line::getStateDerivKernel(), is instantiated at
+	 * compile time for every single combination of these flags, so the lines
+	 * are not paying for the features they are not using
+	 * @see moordyn::Line::selectKernel()
+	 */
+	typedef enum
+	{
+		/// Bending stiffness, either constant or non-linear
+		KERNEL_EI = 1 << 0,
+		/// Pressure bending
+		KERNEL_PB = 1 << 1,
+		/// Non-linear axial stiffness
+		KERNEL_NONLINEAR_EA = 1 << 2,
+		/// Non-linear internal damping
+		KERNEL_NONLINEAR_C = 1 << 3,
+		/// 3D seafloor
+		KERNEL_SEAFLOOR = 1 << 4,
+		/// Number of combinations
+		KERNEL_NUM = 1 << 5,
+	} KernelFeatures;
+
+	/// Line derivatives kernel
+	typedef void (Line::*StateDerivKernel)(Eigen::Ref<Eigen::Matrix3Xr>,
+	                                       Eigen::Ref<Eigen::Matrix3Xr>);
+
+	/** @brief Calculate forces and get the derivative of the line's states
+	 *
+	 * This is the actual implementation of moordyn::Line::getStateDeriv()
+	 * @tparam features Combination of moordyn::Line::KernelFeatures
+	 * @param vel Where to store the velocities of the internal nodes
+	 * @param acc Where to store the accelerations of the internal nodes
+	 * @throws nan_error If nan values are detected in any node position
+	 */
+	template<unsigned int features>
+	void getStateDerivKernel(Eigen::Ref<Eigen::Matrix3Xr> vel,
+	                         Eigen::Ref<Eigen::Matrix3Xr> acc);
+
+	/** @brief Select the derivatives kernel instantiation matching the line
+	 * features
+	 *
+	 * This shall be called each time any of the moordyn::Line::KernelFeatures
+	 * changes
+	 */
+	void selectKernel();
+
+	/** @brief Build the table of derivatives kernels
+	 * @param seq The sequence of moordyn::Line::KernelFeatures combinations
+	 * @return The kernels, indexed by moordyn::Line::KernelFeatures
+	 * combination
+	 */
+	template<unsigned int... features>
+	static constexpr std::array<StateDerivKernel, sizeof...(features)>
+	kernelsTable(std::integer_sequence<unsigned int, features...> seq);
+
+	/// The selected derivatives kernel, see moordyn::Line::selectKernel()
+	StateDerivKernel kernel;
+
 	/** @brief Get the non-linear bending stiffness
 	 * @param curv The curvature
 	 */
@@ -170,6 +235,9 @@ class Line final : public io::IO, public NatFreqCFL
 	moordyn::real BAin;
 	/// line cross-sectional area to pre-compute [m2]
 	moordyn::real A;
+	/// The rainflow counting of each segment tension, empty if the fatigue
+	/// is not computed
+	std::vector<Rainflow> fatigue;
 	/// number of values in stress-strain lookup table (0 for constant E)
 	unsigned int nEApoints;
 	/// x array for stress-strain lookup table
@@ -203,11 +271,11 @@ class Line final : public io::IO, public NatFreqCFL
 	/// node velocities
 	std::vector<vec> rd;
 	/// unit tangent vectors for each node
-	std::vector<vec> q;
+	Eigen::ArrayX3r q;
 	/// unit normal vectors for each node (used in bending calcs)
 	std::vector<vec> pvec;
 	/// unit tangent vectors for each segment (used in bending calcs)
-	std::vector<vec> qs;
+	Eigen::ArrayX3r qs;
 	/// unstretched line segment lengths
 	std::vector<moordyn::real> l;
 	/// stretched segment lengths
@@ -217,39 +285,116 @@ class Line final : public io::IO, public NatFreqCFL
 	/// curvatures at node points (1/m)
 	std::vector<moordyn::real> Kurv;
 
-	/// node mass + added mass matrix
-	std::vector<mat> M;
+	/** @brief node mass + added mass isotropic term
+	 *
+	 * The node mass matrix is \f$ M = M_a I + M_b q q^T \f$, so just the
+	 * scalars are stored. The 3x3 matrix can be built on demand with
+	 * getNodeM()
+	 */
+	Eigen::ArrayXr Ma;
+	/// node mass + added mass tangential term, see moordyn::Line::Ma
+	Eigen::ArrayXr Mb;
 	// line segment volumes
 	std::vector<moordyn::real> V;
 
 	// forces
 	/// segment tensions
-	std::vector<vec> T;
+	Eigen::ArrayX3r T;
 	/// segment damping forces
-	std::vector<vec> Td;
+	Eigen::ArrayX3r Td;
 	/// bending stiffness forces
 	std::vector<vec> Bs;
 	/// Pressure bending forces
 	std::vector<vec> Pb;
 	/// node weights
-	std::vector<vec> W;
+	Eigen::ArrayX3r W;
 	/// node drag (transversal)
-	std::vector<vec> Dp;
+	Eigen::ArrayX3r Dp;
 	/// node drag (axial)
-	std::vector<vec> Dq;
+	Eigen::ArrayX3r Dq;
 	/// node added mass forcing (transversal)
-	std::vector<vec> Ap;
+	Eigen::ArrayX3r Ap;
 	/// node added mass forcing (axial)
-	std::vector<vec> Aq;
+	Eigen::ArrayX3r Aq;
 	/// node bottom contact force
-	std::vector<vec> B;
+	Eigen::ArrayX3r B;
 	/// total force on node
-	std::vector<vec> Fnet;
+	Eigen::ArrayX3r Fnet;
 
 	// wave things
 	/// VOF scalar for each segment (1 = fully submerged, 0 = out of water)
 	std::vector<moordyn::real> F;
 
+	/** Structure-of-arrays workspace of moordyn::Line::getStateDeriv()
+	 *
+	 * The node kinematics are gathered here at the beginning of each
+	 * derivative computation, so the kernel can process several nodes per
+	 * SIMD instruction
+	 * @{
+	 */
+
+	/// node positions lanes
+	Eigen::ArrayX3r r_lanes;
+	/// node velocities lanes
+	Eigen::ArrayX3r rd_lanes;
+	/// flow velocity lanes
+	Eigen::ArrayX3r U_lanes;
+	/// flow acceleration lanes
+	Eigen::ArrayX3r Ud_lanes;
+	/// node lengths (half of the adjacent segments)
+	Eigen::ArrayXr len_lanes;
+	/// node submerged lengths
+	Eigen::ArrayXr sublen_lanes;
+	/// seabed depth below each node
+	Eigen::ArrayXr depth_lanes;
+	/// \f$ q^T q \f$ on each node
+	Eigen::ArrayXr qq_lanes;
+	/// \f$ q^T F_{net} \f$ on each node
+	Eigen::ArrayXr qF_lanes;
+	/// node accelerations
+	Eigen::ArrayX3r acc_lanes;
+	/// node masses
+	Eigen::ArrayXr m_lanes;
+	/// node submerged volumes
+	Eigen::ArrayXr v_lanes;
+	/// relative flow velocity over each node
+	Eigen::ArrayX3r vi_lanes;
+	/// auxiliary scalar lane, reused along the kernel
+	Eigen::ArrayXr aux_lanes;
+	/// tangential relative flow velocity magnitude, scaled to the drag
+	Eigen::ArrayXr vq_lanes;
+	/// transverse relative flow velocity magnitude, scaled to the drag
+	Eigen::ArrayXr vp_lanes;
+	/// seabed friction saturation level
+	Eigen::ArrayXr fricmax_lanes;
+	/// node velocity along the seabed
+	Eigen::ArrayXr botvel_lanes;
+	/// seabed friction force magnitude
+	Eigen::ArrayXr fric_lanes;
+
+	/**
+	 * @}
+	 */
+
+	/** Workspace of moordyn::Line::getStateDerivJacobian()
+	 * @{
+	 */
+
+	/// unperturbed internal node positions
+	Eigen::Matrix3Xr jac_r;
+	/// unperturbed internal node velocities
+	Eigen::Matrix3Xr jac_u;
+	/// internal node velocities derivatives
+	Eigen::Matrix3Xr jac_vel;
+	/// unperturbed internal node accelerations
+	Eigen::Matrix3Xr jac_acc0;
+	/// perturbed internal node accelerations
+	Eigen::Matrix3Xr jac_acc;
+
+	/**
+	 * @}
+	 */
+
 	// time
 	/// simulation time
 	moordyn::real t;
@@ -280,10 +425,28 @@ class Line final : public io::IO, public NatFreqCFL
 	vec endMomentB;
 
 	// file stuff
-	/// Pointer to moordyn::MoorDyn::outfileMain
-	ofstream* outfile;
+	/// The output file, NULL if no output is required
+	OutputFile* outfile;
 	/// A copy of moordyn::MoorDyn::outChans
 	string channels;
+	/// The channels of the output file, compiled by initialize()
+	OutputPlan outPlan;
+	/// The wave velocities printed on the output file
+	std::vector<vec> outU;
+	/// The hydrodynamic forces printed on the output file
+	Eigen::ArrayX3r outD;
+	/// The strains printed on the output file
+	std::vector<moordyn::real> outStrain;
+	/// The strain rates printed on the output file
+	std::vector<moordyn::real> outStrainRate;
+	/// The internal node tensions printed on the main output file
+	std::vector<moordyn::real> outTen;
+	/// The internal nodes with tensions printed on the main output file
+	std::vector<unsigned int> outTenNodes;
+
+	/** @brief Update the quantities printed on the line output file
+	 */
+	void updateOutput();
 
 	/** data structures for precalculated nodal water kinematics if applicable
 	 * @{
@@ -327,7 +490,7 @@ class Line final : public io::IO, public NatFreqCFL
 	           real l,
 	           unsigned int n,
 	           EnvCondRef env_in,
-	           shared_ptr<ofstream> outfile,
+	           shared_ptr<OutputFile> outfile,
 	           string channels);
 
 	/** @brief Set the environmental data
@@ -340,6 +503,7 @@ class Line final : public io::IO, public NatFreqCFL
 	{
 		waves = waves_in;
 		seafloor = seafloor_in;
+		selectKernel();
 	}
 
 	/** @brief Compute the stationary Initial Condition (IC)
@@ -496,14 +660,14 @@ class Line final : public io::IO, public NatFreqCFL
 	 * @throws invalid_value_error If the node index \p i is bigger than the
 	 * number of nodes, moordyn::Line::N + 1
 	 */
-	inline const vec& getNodeForce(unsigned int i) const
+	inline const vec getNodeForce(unsigned int i) const
 	{
 		if (i > N) {
 			LOGERR << "Asking node " << i << " of line " << number
 			       << ", which only has " << N + 1 << " nodes" << std::endl;
 			throw moordyn::invalid_value_error("Invalid node index");
 		}
-		return Fnet[i];
+		return soa2vec(Fnet, i);
 	};
 
 	/** @brief Get the tension on a node, including the internal line damping
@@ -524,11 +688,12 @@ class Line final : public io::IO, public NatFreqCFL
 			throw moordyn::invalid_value_error("Invalid node index");
 		}
 		if (i == 0)
-			return T[0] + Td[0];
+			return soa2vec(T, 0) + soa2vec(Td, 0);
 		else if (i == N)
-			return T[N - 1] + Td[N - 1];
+			return soa2vec(T, N - 1) + soa2vec(Td, N - 1);
 		// take average of tension in adjacent segments
-		return (0.5 * (T[i] + T[i - 1] + Td[i] + Td[i - 1]));
+		return 0.5 * (soa2vec(T, i) + soa2vec(T, i - 1) + soa2vec(Td, i) +
+		              soa2vec(Td, i - 1));
 	};
 
 	/** @brief Get the tension on a node, including the internal line damping
@@ -557,14 +722,14 @@ class Line final : public io::IO, public NatFreqCFL
 	 * @throws invalid_value_error If the node index \p i is bigger than the
 	 * number of nodes, moordyn::Line::N + 1
 	 */
-	inline const vec& getNodeWeight(unsigned int i) const
+	inline const vec getNodeWeight(unsigned int i) const
 	{
 		if (i > N) {
 			LOGERR << "Asking node " << i << " of line " << number
 			       << ", which only has " << N + 1 << " nodes" << std::endl;
 			throw moordyn::invalid_value_error("Invalid node index");
 		}
-		return W[i];
+		return soa2vec(W, i);
 	};
 
 	/** @brief Get the drag force acting on the node
@@ -580,7 +745,7 @@ class Line final : public io::IO, public NatFreqCFL
 			       << ", which only has " << N + 1 << " nodes" << std::endl;
 			throw moordyn::invalid_value_error("Invalid node index");
 		}
-		return Dp[i] + Dq[i];
+		return soa2vec(Dp, i) + soa2vec(Dq, i);
 	};
 
 	/** @brief Get the Froude-Krilov force acting on the node
@@ -596,7 +761,7 @@ class Line final : public io::IO, public NatFreqCFL
 			       << ", which only has " << N + 1 << " nodes" << std::endl;
 			throw moordyn::invalid_value_error("Invalid node index");
 		}
-		return Ap[i] + Aq[i];
+		return soa2vec(Ap, i) + soa2vec(Aq, i);
 	};
 
 	/** @brief Get the sea bed reaction force acting on the node
@@ -614,7 +779,7 @@ class Line final : public io::IO, public NatFreqCFL
 			       << ", which only has " << N + 1 << " nodes" << std::endl;
 			throw moordyn::invalid_value_error("Invalid node index");
 		}
-		return B[i] + Bs[i];
+		return soa2vec(B, i) + Bs[i];
 	};
 
 	/** @brief Get the line curvature at a node position
@@ -642,16 +807,57 @@ class Line final : public io::IO, public NatFreqCFL
 	 * @throws invalid_value_error If the node index \p i is bigger than the
 	 * number of nodes, moordyn::Line::N + 1
 	 */
-	inline const mat& getNodeM(unsigned int i) const
+	inline const mat getNodeM(unsigned int i) const
 	{
 		if (i > N) {
 			LOGERR << "Asking node " << i << " of line " << number
 			       << ", which only has " << N + 1 << " nodes" << std::endl;
 			throw moordyn::invalid_value_error("Invalid node index");
 		}
-		return M[i];
+		return nodeMassMatrix(Ma[i], Mb[i], soa2vec(q, i));
 	}
 
+	/** @brief Check whether the rainflow counting of the segment tensions
+	 * is carried out, i.e. the "F" output flag was set
+	 * @return true if the fatigue is computed, false otherwise
+	 */
+	inline bool hasFatigue() const { return !fatigue.empty(); }
+
+	/** @brief Get the rainflow counting of a segment tension
+	 * @param i The segment index
+	 * @return The rainflow counter
+	 * @throws invalid_value_error If the fatigue is not computed or if the
+	 * segment index \p i is bigger than the number of segments,
+	 * moordyn::Line::N
+	 */
+	inline const Rainflow& getSegFatigue(unsigned int i) const
+	{
+		if (i >= fatigue.size()) {
+			LOGERR << "Asking the fatigue of segment " << i << " of line "
+			       << number << ", which only has " << fatigue.size()
+			       << " segments with fatigue" << std::endl;
+			throw moordyn::invalid_value_error("Invalid segment index");
+		}
+		return fatigue[i];
+	}
+
+	/** @brief Add the current segment tensions to the rainflow counting
+	 *
+	 * This function shall be called once per time step, doing nothing if
+	 * the fatigue is not computed
+	 */
+	inline void updateFatigue()
+	{
+		for (unsigned int i = 0; i < fatigue.size(); i++)
+			fatigue[i].add(T.row(i).matrix().norm());
+	}
+
+	/** @brief Save the rainflow histograms and the damage of the segments
+	 * @param filepath The output file path
+	 * @throws output_file_error If the file cannot be written
+	 */
+	void saveFatigue(const std::string& filepath) const;
+
 	/** @brief Get the array of coordinates of all nodes along the line
 	 * @return The positions array
 	 */
@@ -669,10 +875,10 @@ class Line final : public io::IO, public NatFreqCFL
 	                        float* AnchHTen,
 	                        float* AnchVTen) const
 	{
-		*FairHTen = (float)(Fnet[N](Eigen::seqN(0, 2)).norm());
-		*FairVTen = (float)(Fnet[N][2] + M[N](0, 0) * (-env->g));
-		*AnchHTen = (float)(Fnet[0](Eigen::seqN(0, 2)).norm());
-		*AnchVTen = (float)(Fnet[0][2] + M[0](0, 0) * (-env->g));
+		*FairHTen = (float)(Fnet.row(N).head<2>().matrix().norm());
+		*FairVTen = (float)(Fnet(N, 2) + getNodeM(N)(0, 0) * (-env->g));
+		*AnchHTen = (float)(Fnet.row(0).head<2>().matrix().norm());
+		*AnchVTen = (float)(Fnet(0, 2) + getNodeM(0)(0, 0) * (-env->g));
 	}
 
 	/** @brief Get the force, moment and mass at the line endpoint
@@ -690,14 +896,14 @@ class Line final : public io::IO, public NatFreqCFL
 	{
 		switch (end_point) {
 			case ENDPOINT_TOP:
-				Fnet_out = Fnet[N];
+				Fnet_out = soa2vec(Fnet, N);
 				Moment_out = endMomentB;
-				M_out = M[N];
+				M_out = getNodeM(N);
 				break;
 			case ENDPOINT_BOTTOM:
-				Fnet_out = Fnet[0];
+				Fnet_out = soa2vec(Fnet, 0);
 				Moment_out = endMomentA;
-				M_out = M[0];
+				M_out = getNodeM(0);
 				break;
 			default:
 				LOGERR << "Invalid end point qualifier: " << end_point << endl;
@@ -713,6 +919,16 @@ class Line final : public io::IO, public NatFreqCFL
 	 */
 	real GetLineOutput(OutChanProps outChan);
 
+	/** @brief Compile a line output channel of the main output file
+	 *
+	 * The channel is compiled into an accessor, which is giving the same
+	 * value than GetLineOutput()
+	 * @param outChan The output channel/field
+	 * @param plan The plan where the accessor is added
+	 * @throws invalid_value_error If the node of the channel does not exist
+	 */
+	void addOutput(const OutChanProps& outChan, OutputPlan& plan);
+
 	/** @brief store wave/current kinematics time series for this line
 	 *
 	 * This is used when nodal approaches are selected, i.e.
@@ -782,11 +998,19 @@ class Line final : public io::IO, public NatFreqCFL
 	 *
 	 * If no internal pressure is provided, zeros will be considered.
 	 */
-	inline void enablePb() { isPb = true; }
+	inline void enablePb()
+	{
+		isPb = true;
+		selectKernel();
+	}
 
 	/** @brief Disable the pressure bending forces (disabled by default)
 	 */
-	inline void disablePb() { isPb = false; }
+	inline void disablePb()
+	{
+		isPb = false;
+		selectKernel();
+	}
 
 	/** @brief Check if pressure bending forces are considered
 	 * @return true if pressure bending forces are considered, false otherwise
@@ -810,13 +1034,14 @@ class Line final : public io::IO, public NatFreqCFL
 	inline void setTime(real time) { t = time; }
 
 	/** @brief Set the line state
-	 * @param r The moordyn::Line::getN() - 1 positions
-	 * @param u The moordyn::Line::getN() - 1 velocities
+	 * @param r The moordyn::Line::getN() - 1 positions, one per column
+	 * @param u The moordyn::Line::getN() - 1 velocities, one per column
 	 * @note This method is not affecting the line end points
 	 * @see moordyn::Line::setEndState
 	 * @throws invalid_value_error If either @p r or @p u have wrong sizes
 	 */
-	void setState(const std::vector<vec>& r, const std::vector<vec>& u);
+	void setState(const Eigen::Ref<const Eigen::Matrix3Xr>& r,
+	              const Eigen::Ref<const Eigen::Matrix3Xr>& u);
 
 	/** @brief Set the position and velocity of an end point
 	 * @param r Position
@@ -827,6 +1052,32 @@ class Line final : public io::IO, public NatFreqCFL
 	 */
 	void setEndKinematics(vec r, vec rd, EndPoints end_point);
 
+	/** @brief Get the position and velocity of both end points
+	 * @return The position and velocity of the end point A, followed by the
+	 * position and velocity of the end point B
+	 */
+	inline std::array<vec, 4> getEndsKinematics() const
+	{
+		return { r[0], rd[0], r[N], rd[N] };
+	}
+
+	/** @brief Set the position and velocity of both end points
+	 *
+	 * Unlike moordyn::Line::setEndKinematics(), the end points types are not
+	 * modified, so this method can be used to move the end points to
+	 * interpolated positions
+	 * @param ends The position and velocity of the end point A, followed by
+	 * the position and velocity of the end point B
+	 * @see moordyn::Line::getEndsKinematics()
+	 */
+	inline void setEndsKinematics(const std::array<vec, 4>& ends)
+	{
+		r[0] = ends[0];
+		rd[0] = ends[1];
+		r[N] = ends[2];
+		rd[N] = ends[3];
+	}
+
 	/** @brief set end node unit vector
 	 *
 	 * This method is called by an eventually attached Rod, only applicable for
@@ -856,11 +1107,42 @@ class Line final : public io::IO, public NatFreqCFL
 	vec getEndSegmentMoment(EndPoints end_point, EndPoints rod_end_point) const;
 
 	/** @brief Calculate forces and get the derivative of the line's states
-	 * @param vel Where to store the velocities of the internal nodes
-	 * @param acc Where to store the accelerations of the internal nodes
+	 * @param vel Where to store the velocities of the internal nodes, one per
+	 * column. It shall have moordyn::Line::getN() - 1 columns
+	 * @param acc Where to store the accelerations of the internal nodes, one
+	 * per column. It shall have moordyn::Line::getN() - 1 columns
+	 * @throws nan_error If nan values are detected in any node position
+	 */
+	inline void getStateDeriv(Eigen::Ref<Eigen::Matrix3Xr> vel,
+	                          Eigen::Ref<Eigen::Matrix3Xr> acc)
+	{
+		(this->*kernel)(vel, acc);
+	}
+
+	/** @brief Compute the Jacobian of the implicit time integration
+	 *
+	 * On an implicit step the internal nodes are moved to
+	 * \f$ r = r_0 + c_r a \f$ and \f$ u = u_0 + c_u a \f$, being \f$ a \f$
+	 * the unknown accelerations. This method computes the Jacobian of the
+	 * residue \f$ a - \mathcal{A}(r, u) \f$ with respect to \f$ a \f$,
+	 * i.e. \f$ I - c_r \partial \mathcal{A} / \partial r - c_u \partial
+	 * \mathcal{A} / \partial u \f$, at the current line state.
+	 *
+	 * The tension, internal damping and drag are just coupling each node with
+	 * the adjacent ones, so the Jacobian is block tridiagonal. It is computed
+	 * by finite differences, perturbing at once all the nodes which are not
+	 * sharing any row of the Jacobian, so just 9 derivatives are computed
+	 * regardless the number of nodes (15 if the line has bending stiffness).
+	 * The bending stiffness is also coupling each node with the second
+	 * neighbours, which is neglected. The line state is restored afterwards,
+	 * but the forces shall be recomputed calling
+	 * moordyn::Line::getStateDeriv()
+	 * @param c_r The positions factor, \f$ c_r > 0 \f$
+	 * @param c_u The velocities factor
+	 * @param jac The Jacobian. It is resized if needed
 	 * @throws nan_error If nan values are detected in any node position
 	 */
-	void getStateDeriv(std::vector<vec>& vel, std::vector<vec>& acc);
+	void getStateDerivJacobian(real c_r, real c_u, BlockTridiagonal& jac);
 
 	// void initiateStep(vector<double> &rFairIn, vector<double> &rdFairIn,
 	// double time);
@@ -82,8 +82,25 @@ typedef Matrix<int, 6, 6> Matrix6i;
 // It is also convenient for us to define a generic Eigen dynamic matrix class
 #ifdef MOORDYN_SINGLEPRECISSION
 typedef MatrixXf MatrixXr;
+typedef VectorXf VectorXr;
 #else
 typedef MatrixXd MatrixXr;
+typedef VectorXd VectorXr;
+#endif
+// Lists of 3D vectors, stored contiguously one after the other
+#ifdef MOORDYN_SINGLEPRECISSION
+typedef Matrix3Xf Matrix3Xr;
+#else
+typedef Matrix3Xd Matrix3Xr;
+#endif
+// Dynamic arrays, used on the structure-of-arrays storages. The (n x 3) ones
+// are column-major, i.e. the x, y and z lanes are contiguous in memory
+#ifdef MOORDYN_SINGLEPRECISSION
+typedef ArrayXf ArrayXr;
+typedef Array<float, Dynamic, 3> ArrayX3r;
+#else
+typedef ArrayXd ArrayXr;
+typedef Array<double, Dynamic, 3> ArrayX3r;
 #endif
 }
 
@@ -97,6 +114,7 @@ typedef Eigen::Vector2f vec2;
 typedef Eigen::Vector3f vec3;
 typedef Eigen::Vector4f vec4;
 typedef Eigen::Vector6f vec6;
+typedef Eigen::Vector<float, 7> vec7;
 typedef vec3 vec;
 typedef Eigen::Matrix2f mat2;
 typedef Eigen::Matrix3f mat3;
@@ -115,6 +133,8 @@ typedef Eigen::Vector3d vec3;
 typedef Eigen::Vector4d vec4;
 /// 6-D vector of real numbers
 typedef Eigen::Vector6d vec6;
+/// 7-D vector of real numbers, e.g. a position and a quaternion
+typedef Eigen::Vector<double, 7> vec7;
 /// vec3 renaming
 typedef vec3 vec;
 /// 2x2 matrix of real numbers
@@ -295,6 +315,13 @@ struct XYZQuat
 	{
 		return XYZQuat{ vec.head<3>(), Euler2Quat(vec.tail<3>()) };
 	}
+	static XYZQuat fromVec7(const vec7& vec)
+	{
+		XYZQuat out;
+		out.pos = vec.head<3>();
+		out.quat.coeffs() = vec.tail<4>();
+		return out;
+	}
 	vec6 toVec6() const
 	{
 		vec6 out;
@@ -302,9 +329,9 @@ struct XYZQuat
 		out.tail<3>() = Quat2Euler(this->quat);
 		return out;
 	}
-	Eigen::Vector<real, 7> toVec7() const
+	vec7 toVec7() const
 	{
-		Eigen::Vector<real, 7> out;
+		vec7 out;
 		out.head<3>() = pos;
 		out.tail<4>() = quat.coeffs();
 		return out;
@@ -376,6 +403,46 @@ array2vec6(const T* a, vec6& v)
 	v[5] = (moordyn::real)a[5];
 }
 
+/** @brief Extract a vector from a structure-of-arrays storage
+ * @param a The (n x 3) structure-of-arrays storage
+ * @param i The row index
+ * @return The vector
+ */
+inline vec
+soa2vec(const Eigen::ArrayX3r& a, unsigned int i)
+{
+	return vec(a(i, 0), a(i, 1), a(i, 2));
+}
+
+/** @brief Set a vector into a structure-of-arrays storage
+ * @param v The vector
+ * @param a The (n x 3) structure-of-arrays storage
+ * @param i The row index
+ */
+inline void
+vec2soa(const vec& v, Eigen::ArrayX3r& a, unsigned int i)
+{
+	a(i, 0) = v[0];
+	a(i, 1) = v[1];
+	a(i, 2) = v[2];
+}
+
+/** @brief Gather a list of vectors into a structure-of-arrays storage
+ * @param v The list of vectors
+ * @param a The (n x 3) structure-of-arrays storage, which is resized if
+ * required
+ */
+inline void
+aos2soa(const std::vector<vec>& v, Eigen::ArrayX3r& a)
+{
+	if (v.empty()) {
+		a.resize(0, 3);
+		return;
+	}
+	typedef Eigen::Array<real, Eigen::Dynamic, 3, Eigen::RowMajor> aos_t;
+	a = Eigen::Map<const aos_t>(v.front().data(), v.size(), 3);
+}
+
 /** @brief Convert a matrix to a C-ish array
  * @param v The input matrix
  * @param a The output array
@@ -837,6 +904,45 @@ getH(vec r)
 	return H;
 }
 
+/** @brief Build a line node mass matrix
+ *
+ * The line nodes mass matrices, including the added mass, have always the
+ * structure
+ * \f$ M = a I + b q q^T \f$,
+ * with \f$ a = m + \rho_w V C_{an} \f$ and
+ * \f$ b = \rho_w V (C_{at} - C_{an}) \f$
+ * @param a Isotropic (transversal) mass
+ * @param b Anisotropic (tangential minus transversal) mass
+ * @param q Tangent unit vector
+ * @return The mass matrix
+ * @see solveNodeMass()
+ */
+inline mat
+nodeMassMatrix(real a, real b, const vec& q)
+{
+	return a * mat::Identity() + b * q * q.transpose();
+}
+
+/** @brief Solve the linear system \f$ M x = f \f$ for a line node mass
+ * matrix
+ *
+ * Since the matrix is \f$ M = a I + b q q^T \f$, the Sherman-Morrison
+ * formula gives the solution in closed form,
+ * \f$ x = \frac{1}{a} \left(f - \frac{b q^T f}{a + b q^T q} q\right) \f$,
+ * which is much cheaper than inverting the 3x3 matrix
+ * @param a Isotropic (transversal) mass
+ * @param b Anisotropic (tangential minus transversal) mass
+ * @param q Tangent unit vector
+ * @param f The right hand side, i.e. the force
+ * @return The solution, i.e. the acceleration
+ * @see nodeMassMatrix()
+ */
+inline vec
+solveNodeMass(real a, real b, const vec& q, const vec& f)
+{
+	return (f - q * (b * q.dot(f) / (a + b * q.squaredNorm()))) / a;
+}
+
 /** @brief Compute the mass matrix on an offset point
  * @param r Offset
  * @param M Mass matrix
@@ -1073,6 +1179,8 @@ struct EnvCond
 	/// a global switch for whether to show the units line in the output files
 	/// (1, default), or skip it (0)
 	int WriteUnits;
+	/// number of bins of each axis of the lines rainflow histograms
+	unsigned int FatigueBins;
 	/// whether to write a log file. (0=no, 1=basic, 2=full description,
 	/// 3=ongoing output
 	int writeLog;
@@ -1110,6 +1218,8 @@ typedef struct _LineProps // (matching Line Dictionary inputs)
 	double
 	    bstiffXs[nCoef]; // x array for stress-strain lookup table (up to nCoef)
 	double bstiffYs[nCoef]; // y array for stress-strain lookup table
+	double SNm = 3.0; // S-N curve exponent, N = SNA * S^-SNm
+	double SNA = 0.0; // S-N curve constant (Pa^SNm), 0 means no damage
 } LineProps;
 
 typedef struct _RodProps // (matching Rod Dictionary inputs)
@@ -34,6 +34,7 @@
 #include "Misc.hpp"
 #include "MoorDyn2.hpp"
 #include "Rod.hpp"
+#include <thread>
 
 #ifdef LINUX
 #include <cmath>
@@ -89,6 +90,12 @@ moordyn::MoorDyn::MoorDyn(const char* infilename, int log_level)
   , dtM0((std::numeric_limits<real>::max)())
   , cfl(0.5)
   , dtOut(0.0)
+  , outFormat(OUTPUT_TEXT)
+  , outBuffer(0)
+  , outStats(false)
+  , outDecimation(1)
+  , nThreads(1)
+  , tSchemeTol(1e-4)
   , _t_integrator(NULL)
   , ICgenDynamic(false)
   , ICfile("")
@@ -133,6 +140,7 @@ moordyn::MoorDyn::MoorDyn(const char* infilename, int log_level)
 	env->cb = 3.0e5;
 	env->waterKinOptions = waves::WaterKinOptions();
 	env->WriteUnits = 1; // by default, write units line
+	env->FatigueBins = 32;
 	env->writeLog = 0;   // by default, don't write out a log file
 	env->FrictionCoefficient = 0.0;
 	env->FricDamp = 200.0;
@@ -159,11 +167,23 @@ moordyn::MoorDyn::MoorDyn(const char* infilename, int log_level)
 
 moordyn::MoorDyn::~MoorDyn()
 {
-	if (outfileMain.is_open())
-		outfileMain.close();
+	for (auto line : LineList) {
+		if (!line->hasFatigue())
+			continue;
+		try {
+			line->saveFatigue(_basepath + _basename + "_Line" +
+			                  to_string(line->number) + ".fatigue");
+		} catch (const moordyn::output_file_error&) {
+			// Already reported
+		}
+	}
+	if (outfileMain && !outfileMain->close())
+		LOGERR << "Error writing the statistics of "
+		       << outfileMain->path() << endl;
 	for (auto outfile : outfiles) // int l=0; l<nLines; l++)
-		if (outfile && outfile->is_open())
-			outfile->close();
+		if (outfile && outfile->is_open() && !outfile->close())
+			LOGERR << "Error writing the statistics of " << outfile->path()
+			       << endl;
 
 	delete _t_integrator;
 
@@ -240,7 +260,8 @@ moordyn::MoorDyn::icLegacy()
 		real dt;
 		_t_integrator->Next();
 		while ((dt = t_target) > 0.0) {
-			if (dtM0 < dt)
+			if (!_t_integrator->IsAdaptive() &&
+			    !_t_integrator->IsMultirate() && (dtM0 < dt))
 				dt = dtM0;
 			try {
 				_t_integrator->Step(dt);
@@ -352,6 +373,7 @@ moordyn::MoorDyn::icStationary()
 	LOGMSG << "Finalizing ICs using static solve" << endl;
 
 	StationaryScheme t_integrator(_log, waves);
+	t_integrator.SetThreads(nThreads);
 	t_integrator.SetGround(GroundBody);
 	for (auto obj : BodyList)
 		t_integrator.AddBody(obj);
@@ -517,6 +539,11 @@ moordyn::MoorDyn::Init(const double* x, const double* xd, bool skip_ic)
 		ix += 3;
 	}
 
+	// The adaptive time schemes are bounded by the user CFL factor, no matter
+	// the time step. The multirate ones are instead using the CFL factor
+	// resulting from the time step, so the fastest entities are integrated
+	// with such time step
+	const real cfl_max = cfl;
 	if (dtM0 < (0.9 * (std::numeric_limits<real>::max)()))
 		cfl = (std::numeric_limits<real>::max)(); // Is 90% of max sufficient tolerance for this check?
 
@@ -542,7 +569,7 @@ moordyn::MoorDyn::Init(const double* x, const double* xd, bool skip_ic)
 	LOGMSG << "dtM = " << dtM0 << " s (CFL = " << cfl << ")" << endl;
 
 	// Initialize the system state
-	_t_integrator->SetCFL(cfl);
+	_t_integrator->SetCFL(_t_integrator->IsAdaptive() ? cfl_max : cfl);
 
 	// ------------------ do IC gen --------------------
 	if (!skip_ic) {
@@ -597,30 +624,32 @@ moordyn::MoorDyn::Init(const double* x, const double* xd, bool skip_ic)
 	// -------------------------- start main output file
 	// --------------------------------
 
-	stringstream oname;
-	oname << _basepath << _basename << ".out";
-
-	outfileMain.open(oname.str());
-	if (!outfileMain.is_open()) {
-		LOGERR << "ERROR: Unable to write to main output file " << oname.str()
-		       << endl;
+	outfileMain = makeOutputFile("");
+	if (!outfileMain->is_open()) {
+		LOGERR << "ERROR: Unable to write to main output file "
+		       << outfileMain->path() << endl;
 		return MOORDYN_INVALID_OUTPUT_FILE;
 	}
+	// The main output file is flushed every time, so it can be monitored
+	// while the simulation is running
+	outfileMain->setAutoFlush(true);
 
-	// --- channel titles ---
-	outfileMain << "Time"
-	            << "\t ";
+	// --- channel titles and units ---
 	for (auto channel : outChans)
-		outfileMain << channel.Name << "\t ";
-	outfileMain << endl;
-
-	if (env->WriteUnits > 0) {
-		// --- units ---
-		outfileMain << "(s)"
-		            << "\t ";
-		for (auto channel : outChans)
-			outfileMain << channel.Units << "\t ";
-		outfileMain << "\n";
+		outfileMain->addChannel(channel.Name,
+		                        channel.Units,
+		                        channel.OType,
+		                        channel.ObjID,
+		                        channel.NodeID);
+	try {
+		compileOutputPlan();
+		outfileMain->writeHeader(env->WriteUnits > 0);
+	}
+	MOORDYN_CATCHER(err, err_msg);
+	if (err != MOORDYN_SUCCESS) {
+		LOGERR << "Error writing the main output file header: " << err_msg
+		       << endl;
+		return err;
 	}
 
 	// write t=0 output
@@ -721,9 +750,14 @@ moordyn::MoorDyn::Step(const double* x,
 	// -------------------- do time stepping -----------------------
 	real t_target = dt;
 	real dt_step;
+	waves->setCouplingStep(_t_integrator->GetTime(),
+	                       _t_integrator->GetTime() + dt);
 	_t_integrator->Next();
 	while ((dt_step = t_target) > 0.0) {
-		if (dtM0 < dt_step)
+		// The adaptive and multirate schemes are choosing the time step by
+		// themselves
+		if (!_t_integrator->IsAdaptive() && !_t_integrator->IsMultirate() &&
+		    (dtM0 < dt_step))
 			dt_step = dtM0;
 		moordyn::error_id err = MOORDYN_SUCCESS;
 		string err_msg;
@@ -731,6 +765,10 @@ moordyn::MoorDyn::Step(const double* x,
 			_t_integrator->Step(dt_step);
 			t = _t_integrator->GetTime();
 			t_target -= dt_step;
+			// The tensions are sampled on every single time step, so no
+			// cycles are lost
+			for (auto line : LineList)
+				line->updateFatigue();
 		}
 		MOORDYN_CATCHER(err, err_msg);
 		if (err != MOORDYN_SUCCESS) {
@@ -922,6 +960,11 @@ moordyn::MoorDyn::ReadInFile()
 			i++;
 		}
 	}
+	if (!outDecimation && !outStats) {
+		LOGWRN << "OutputDecimation = 0 without OutputStats would produce no "
+		       << "output at all. The time series will be written" << endl;
+		outDecimation = 1;
+	}
 
 	// make a "ground body" that will be the parent of all fixed objects
 	// (points and rods)
@@ -1185,13 +1228,14 @@ moordyn::MoorDyn::ReadInFile()
 			if ((outchannels.size() > 0) &&
 			    (strcspn(outchannels.c_str(), "pvUDctsd") <
 			     strlen(outchannels.c_str()))) {
-				// if 1+ output flag chars are given and they're valid
-				stringstream oname;
-				oname << _basepath << _basename << "_Line" << number << ".out";
-				outfiles.push_back(make_shared<ofstream>(oname.str()));
+				// if 1+ output flag chars are given and they're valid. The
+				// "F" flag is not among them, since the rainflow counting
+				// goes just to the "_LineN.fatigue" file
+				outfiles.push_back(
+				    makeOutputFile("_Line" + to_string(number)));
 				if (!outfiles.back()->is_open()) {
-					LOGERR << "Cannot create the output file '" << oname.str()
-					       << endl;
+					LOGERR << "Cannot create the output file '"
+					       << outfiles.back()->path() << endl;
 					return MOORDYN_INVALID_OUTPUT_FILE;
 				}
 			} else
@@ -1653,6 +1697,9 @@ moordyn::MoorDyn::ReadInFile()
 		}
 	}
 	LOGMSG << "Time integrator = " << _t_integrator->GetName() << endl;
+	_t_integrator->SetThreads(nThreads);
+	LOGMSG << "Threads = " << _t_integrator->GetThreads() << endl;
+	_t_integrator->SetTolerance(tSchemeTol);
 	_t_integrator->SetGround(GroundBody);
 	for (auto obj : BodyList)
 		_t_integrator->AddBody(obj);
@@ -1749,6 +1796,13 @@ moordyn::MoorDyn::readLineProps(string inputText)
 	if (!checkNumberOfEntriesInLine(entries, 10)) {
 		return nullptr;
 	}
+	// The S-N curve is optional, but both parameters are required. Some
+	// legacy files have an 11th unused column, so they are not rejected
+	if (entries.size() == 11) {
+		LOGWRN << "Line type '" << entries[0] << "' in " << _filepath
+		       << " has 11 fields. The S-N curve requires both SNm and SNA, "
+		       << "so the 11th field is ignored" << endl;
+	}
 
 	LineProps* obj = new LineProps();
 
@@ -1759,6 +1813,11 @@ moordyn::MoorDyn::readLineProps(string inputText)
 	obj->Can = atof(entries[7].c_str());
 	obj->Cdt = atof(entries[8].c_str());
 	obj->Cat = atof(entries[9].c_str());
+	// Optional S-N curve, for the fatigue damage
+	if (entries.size() >= 12) {
+		obj->SNm = atof(entries[10].c_str());
+		obj->SNA = atof(entries[11].c_str());
+	}
 
 	moordyn::error_id err;
 	err = read_curve(entries[3].c_str(),
@@ -1790,7 +1849,9 @@ moordyn::MoorDyn::readLineProps(string inputText)
 	       << "\t\tCdn : " << obj->Cdn << endl
 	       << "\t\tCan : " << obj->Can << endl
 	       << "\t\tCdt : " << obj->Cdt << endl
-	       << "\t\tCat : " << obj->Cat << endl;
+	       << "\t\tCat : " << obj->Cat << endl
+	       << "\t\tSNm : " << obj->SNm << endl
+	       << "\t\tSNA : " << obj->SNA << endl;
 	return obj;
 }
 
@@ -1956,11 +2017,10 @@ moordyn::MoorDyn::readBody(string inputText)
 		BodyStateIs.push_back(nX); // assign start index of this body's states
 		nX += 12;                  // add 12 state variables for the body
 	}
-	stringstream oname;
-	oname << _basepath << _basename << "_Body" << number << ".out";
-	outfiles.push_back(make_shared<ofstream>(oname.str()));
+	outfiles.push_back(makeOutputFile("_Body" + to_string(number)));
 	if (!outfiles.back()->is_open()) {
-		LOGERR << "Cannot create the output file '" << oname.str() << endl;
+		LOGERR << "Cannot create the output file '" << outfiles.back()->path()
+		       << endl;
 		return nullptr;
 	}
 
@@ -2079,11 +2139,10 @@ moordyn::MoorDyn::readRod(string inputText)
 	if ((outchannels.size() > 0) && (strcspn(outchannels.c_str(), "pvUDctsd") <
 	                                 strlen(outchannels.c_str()))) {
 		// if 1+ output flag chars are given and they're valid
-		stringstream oname;
-		oname << _basepath << _basename << "_Rod" << number << ".out";
-		outfiles.push_back(make_shared<ofstream>(oname.str()));
+		outfiles.push_back(makeOutputFile("_Rod" + to_string(number)));
 		if (!outfiles.back()->is_open()) {
-			LOGERR << "Cannot create the output file '" << oname.str() << endl;
+			LOGERR << "Cannot create the output file '"
+			       << outfiles.back()->path() << endl;
 			return nullptr;
 		}
 	} else
@@ -2138,6 +2197,26 @@ moordyn::MoorDyn::readOptionsLine(vector<string>& in_txt, int i)
 		dtM0 = atof(value.c_str());
 	else if (name == "cfl")
 		cfl = atof(value.c_str());
+	else if (name == "threads") {
+		const long n = atol(value.c_str());
+		if (n < 0) {
+			LOGERR << "Error in " << _filepath << ":" << i + 1 << "..."
+			       << endl
+			       << "Invalid number of threads, " << n << endl;
+			throw moordyn::invalid_value_error("Invalid number of threads");
+		}
+		// 0 means all the hardware threads, so that is the limit
+		const unsigned int n_hw =
+		    (std::max)(std::thread::hardware_concurrency(), 1u);
+		nThreads = (unsigned int)(std::min)(n, (long)n_hw);
+		if (n > (long)n_hw) {
+			LOGWRN << n << " threads were asked, but the hardware just "
+			       << "supports " << n_hw << ". " << n_hw
+			       << " threads will be used" << endl;
+		}
+	}
+	else if (name == "tschemetol")
+		tSchemeTol = atof(value.c_str());
 	else if (name == "writelog") {
 		// This was actually already did, so we do not need to do that again
 		// But we really want to have this if to avoid showing a warning for
@@ -2183,6 +2262,27 @@ moordyn::MoorDyn::readOptionsLine(vector<string>& in_txt, int i)
 			LOGWRN << "Unknown WaveKin option value " << WaveKinTemp << endl;
 	} else if (name == "dtwave")
 		env->waterKinOptions.dtWave = stof(value);
+	else if (name == "wavekincache") {
+		auto cache_mode = (waves::cache_settings)stoi(value);
+		env->waterKinOptions.cacheMode = cache_mode;
+		if ((cache_mode < waves::WAVES_CACHE_NONE) ||
+		    (cache_mode > waves::WAVES_CACHE_CUBIC))
+			LOGWRN << "Unknown WaveKinCache option value " << cache_mode
+			       << endl;
+	} else if (name == "wavephasortol")
+		env->waterKinOptions.phasorTol = atof(value.c_str());
+	else if (name == "wavephasorsync")
+		env->waterKinOptions.phasorSync = atoi(value.c_str());
+	else if (name == "watergridsingle")
+		env->waterKinOptions.singleGrid = atoi(value.c_str()) != 0;
+	else if (name == "wavegridfile")
+		env->waterKinOptions.gridFile = value;
+	else if (name == "wavegridwindow")
+		env->waterKinOptions.gridWindow = atoi(value.c_str());
+	else if (name == "wavegridtile")
+		env->waterKinOptions.gridTile = atoi(value.c_str());
+	else if (name == "wavegridtilelife")
+		env->waterKinOptions.gridTileLife = atof(value.c_str());
 	else if (name == "currents") {
 		auto current_mode = (waves::currents_settings)stoi(value);
 		env->waterKinOptions.currentMode = current_mode;
@@ -2200,6 +2300,8 @@ moordyn::MoorDyn::readOptionsLine(vector<string>& in_txt, int i)
 		}
 	} else if (name == "writeunits")
 		env->WriteUnits = atoi(value.c_str());
+	else if (name == "fatiguebins")
+		env->FatigueBins = atoi(value.c_str());
 	else if (name == "frictioncoefficient")
 		env->FrictionCoefficient = atof(value.c_str());
 	else if (name == "fricdamp")
@@ -2209,6 +2311,20 @@ moordyn::MoorDyn::readOptionsLine(vector<string>& in_txt, int i)
 	// output writing period (0 for at every call)
 	else if (name == "dtout")
 		dtOut = atof(value.c_str());
+	else if (name == "outputbuffer")
+		outBuffer = atoi(value.c_str());
+	else if (name == "outputstats")
+		outStats = atoi(value.c_str()) != 0;
+	else if (name == "outputdecimation")
+		outDecimation = atoi(value.c_str());
+	else if (name == "outputformat") {
+		outFormat = (output_format)atoi(value.c_str());
+		if ((outFormat < OUTPUT_TEXT) || (outFormat > OUTPUT_FLOAT64)) {
+			LOGWRN << "Unknown OutputFormat option value " << outFormat
+			       << ". Text output files will be written" << endl;
+			outFormat = OUTPUT_TEXT;
+		}
+	}
 	else if (name == "seafloorfile") {
 		env->SeafloorMode = seafloor_settings::SEAFLOOR_3D;
 		this->seafloor = make_shared<moordyn::Seafloor>(_log);
@@ -2324,6 +2440,47 @@ moordyn::MoorDyn::detachLines(FailProps* failure)
 	obj->setState(pos, vel);
 }
 
+void
+moordyn::MoorDyn::compileOutputPlan()
+{
+	outPlan.clear();
+	for (auto channel : outChans) {
+		size_t n;
+		switch (channel.OType) {
+			case 1:
+				n = LineList.size();
+				break;
+			case 2:
+				n = PointList.size();
+				break;
+			case 3:
+				n = RodList.size();
+				break;
+			case 4:
+				n = BodyList.size();
+				break;
+			default:
+				LOGERR << "Error: output type of " << channel.Name
+				       << " does not match a supported object type" << endl;
+				throw moordyn::invalid_value_error("Invalid object type");
+		}
+		if ((channel.ObjID < 1) || ((size_t)channel.ObjID > n)) {
+			LOGERR << "Error: output channel " << channel.Name
+			       << " refers to an entity that does not exist" << endl;
+			throw moordyn::invalid_value_error("Invalid object index");
+		}
+		const unsigned int i = channel.ObjID - 1;
+		if (channel.OType == 1)
+			LineList[i]->addOutput(channel, outPlan);
+		else if (channel.OType == 2)
+			PointList[i]->addOutput(channel, outPlan);
+		else if (channel.OType == 3)
+			RodList[i]->addOutput(channel, outPlan);
+		else
+			BodyList[i]->addOutput(channel, outPlan);
+	}
+}
+
 moordyn::error_id
 moordyn::MoorDyn::AllOutput(double t, double dt)
 {
@@ -2337,32 +2494,37 @@ moordyn::MoorDyn::AllOutput(double t, double dt)
 			return MOORDYN_SUCCESS;
 
 	// write to master output file
-	if (!outfileMain.is_open()) {
+	if (!outfileMain || !outfileMain->is_open()) {
 		LOGERR << "Error: Unable to write to main output file " << endl;
 		return MOORDYN_INVALID_OUTPUT_FILE;
 	}
-	outfileMain << t << "\t "; // output time
-	for (auto channel : outChans) {
-		moordyn::error_id err = MOORDYN_SUCCESS;
-		string err_msg;
-		try {
-			outfileMain << GetOutput(channel) << "\t ";
-		}
-		MOORDYN_CATCHER(err, err_msg);
-		if (err != MOORDYN_SUCCESS) {
-			LOGERR << "Error handling an output channel:" << err_msg << endl;
-			return err;
-		}
+	moordyn::error_id err = MOORDYN_SUCCESS;
+	string err_msg;
+	try {
+		outfileMain->begin(t);
+		outPlan.write(*outfileMain);
+		outfileMain->end();
+	}
+	MOORDYN_CATCHER(err, err_msg);
+	if (err != MOORDYN_SUCCESS) {
+		LOGERR << "Error handling an output channel:" << err_msg << endl;
+		return err;
 	}
-	outfileMain << endl;
 
 	// write individual output files
-	for (auto obj : LineList)
-		obj->Output(t);
-	for (auto obj : RodList)
-		obj->Output(t);
-	for (auto obj : BodyList)
-		obj->Output(t);
+	try {
+		for (auto obj : LineList)
+			obj->Output(t);
+		for (auto obj : RodList)
+			obj->Output(t);
+		for (auto obj : BodyList)
+			obj->Output(t);
+	}
+	MOORDYN_CATCHER(err, err_msg);
+	if (err != MOORDYN_SUCCESS) {
+		LOGERR << "Error writing the output files:" << err_msg << endl;
+		return err;
+	}
 
 	return MOORDYN_SUCCESS;
 }
@@ -2713,6 +2875,22 @@ MoorDyn_SetCFL(MoorDyn system, double cfl)
 	return MOORDYN_SUCCESS;
 }
 
+int DECLDIR
+MoorDyn_GetThreads(MoorDyn system, unsigned int* n)
+{
+	CHECK_SYSTEM(system);
+	*n = ((moordyn::MoorDyn*)system)->GetThreads();
+	return MOORDYN_SUCCESS;
+}
+
+int DECLDIR
+MoorDyn_SetThreads(MoorDyn system, unsigned int n)
+{
+	CHECK_SYSTEM(system);
+	((moordyn::MoorDyn*)system)->SetThreads(n);
+	return MOORDYN_SUCCESS;
+}
+
 int DECLDIR
 MoorDyn_GetTimeScheme(MoorDyn system, char* name, size_t* name_len)
 {
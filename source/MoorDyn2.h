@@ -447,6 +447,26 @@ extern "C"
 	 */
 	int DECLDIR MoorDyn_SetCFL(MoorDyn system, double cfl);
 
+	/** @brief Get the number of threads used to compute the derivatives
+	 * @param system The Moordyn system
+	 * @param n The output number of threads
+	 * @return MOORDYN_SUCESS if the data is correctly got, an error code
+	 * otherwise (see @ref moordyn_errors)
+	 */
+	int DECLDIR MoorDyn_GetThreads(MoorDyn system, unsigned int* n);
+
+	/** @brief Set the number of threads used to compute the derivatives
+	 *
+	 * The lines and rods are independent once their end points are set, so
+	 * their derivatives can be computed in parallel
+	 * @param system The Moordyn system
+	 * @param n The number of threads. 1 to run serially, which is the
+	 * default, and 0 to use all the hardware threads
+	 * @return MOORDYN_SUCESS if the data is correctly set, an error code
+	 * otherwise (see @ref moordyn_errors)
+	 */
+	int DECLDIR MoorDyn_SetThreads(MoorDyn system, unsigned int n);
+
 	/** @brief Get the current time scheme name
 	 * @param system The Moordyn system
 	 * @param name The output name. Can be NULL.
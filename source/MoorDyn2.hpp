@@ -367,6 +367,27 @@ class MoorDyn final : public io::IO
 			dtM0 = (std::min)(dtM0, obj->cfl2dt(cfl));
 	}
 
+	/** @brief Get the number of threads used to compute the derivatives
+	 * @return The number of threads
+	 * @see moordyn::TimeScheme::GetThreads()
+	 */
+	inline unsigned int GetThreads() const
+	{
+		return _t_integrator ? _t_integrator->GetThreads() : nThreads;
+	}
+
+	/** @brief Set the number of threads used to compute the derivatives
+	 * @param n The number of threads. 1 to run serially, and 0 to use all
+	 * the hardware threads
+	 * @see moordyn::TimeScheme::SetThreads()
+	 */
+	inline void SetThreads(unsigned int n)
+	{
+		nThreads = n;
+		if (_t_integrator)
+			_t_integrator->SetThreads(n);
+	}
+
 	/** @brief Get the current time integrator
 	 * @return The time integrator
 	 */
@@ -388,6 +409,8 @@ class MoorDyn final : public io::IO
 		for (auto obj : LineList)
 			_t_integrator->AddLine(obj);
 		_t_integrator->SetCFL(cfl);
+		_t_integrator->SetThreads(nThreads);
+		_t_integrator->SetTolerance(tSchemeTol);
 		_t_integrator->Init();
 	}
 
@@ -570,6 +593,21 @@ class MoorDyn final : public io::IO
 	/// (s) desired output interval (the default zero value provides output at
 	/// every call to MoorDyn)
 	real dtOut;
+	/// The format of the output files
+	output_format outFormat;
+	/// Number of records buffered per output file for the writer thread, 0
+	/// to write the output files synchronously
+	unsigned int outBuffer;
+	/// Whether the statistics of the output channels shall be written
+	bool outStats;
+	/// Just one of every outDecimation output records is written on the
+	/// time series, 0 to do not write them at all
+	unsigned int outDecimation;
+	/// Number of threads to compute the derivatives, 0 for all the hardware
+	/// threads
+	unsigned int nThreads;
+	/// Error tolerance of the adaptive time schemes
+	real tSchemeTol;
 
 	/// The time integration scheme
 	TimeScheme* _t_integrator;
@@ -644,14 +682,42 @@ class MoorDyn final : public io::IO
 	bool disableOutTime = false;
 
 	/// main output file
-	ofstream outfileMain;
+	shared_ptr<OutputFile> outfileMain;
+
+	/// a vector to hold output files for each body, line or rod
+	vector<shared_ptr<OutputFile>> outfiles;
 
-	/// a vector to hold ofstreams for each body, line or rod
-	vector<shared_ptr<ofstream>> outfiles;
+	/// The thread writing the output files, if outBuffer > 0
+	shared_ptr<OutputWriter> outWriter;
+
+	/** @brief Create an output file, in the format selected by the user
+	 * @param name The name appended to the input file name, e.g. "_Line1".
+	 * Empty for the main output file
+	 * @return The output file, which shall be checked with
+	 * OutputFile::is_open()
+	 */
+	inline shared_ptr<OutputFile> makeOutputFile(const string& name)
+	{
+		const string ext = (outFormat == OUTPUT_TEXT) ? ".out" : ".bin";
+		auto f = make_shared<OutputFile>(_basepath + _basename + name + ext,
+		                                 outFormat,
+		                                 outDecimation);
+		if (outStats)
+			f->setStatistics(_basepath + _basename + name + ".stats");
+		if (outBuffer) {
+			if (!outWriter)
+				outWriter = make_shared<OutputWriter>();
+			f->setWriter(outWriter, outBuffer);
+		}
+		return f;
+	}
 
 	/// list of structs describing selected output channels for main out file
 	vector<OutChanProps> outChans;
 
+	/// The channels of the main output file, compiled from outChans
+	OutputPlan outPlan;
+
 	/** @brief Create the log file if queried, close it otherwise
 	 *
 	 * Depending on the value of env.writeLog value, a Log file stream will
@@ -834,6 +900,15 @@ class MoorDyn final : public io::IO
 		return 0.0;
 	}
 
+	/** @brief Compile the output channels of the main output file
+	 *
+	 * This way the channels are resolved just once, instead of on each
+	 * printed time instant
+	 * @throws invalid_value_error If a channel is not pointing to an existing
+	 * entity
+	 */
+	void compileOutputPlan();
+
 	/** @brief Detach lines from a failed point
 	 * @param failure The failure structure
 	 */
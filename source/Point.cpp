@@ -202,6 +202,39 @@ Point::GetPointOutput(OutChanProps outChan)
 	}
 }
 
+void
+Point::addOutput(const OutChanProps& outChan, OutputPlan& plan)
+{
+	switch (outChan.QType) {
+		case PosX:
+		case PosY:
+		case PosZ:
+			plan.add(&r[outChan.QType - PosX]);
+			return;
+		case VelX:
+		case VelY:
+		case VelZ:
+			plan.add(&rd[outChan.QType - VelX]);
+			return;
+		case AccX:
+		case AccY:
+		case AccZ:
+			plan.add(&acc[outChan.QType - AccX]);
+			return;
+		case Ten:
+			plan.add(Fnet.data(), 1.0, OutputPlan::OP_NORM);
+			return;
+		case FX:
+		case FY:
+		case FZ:
+			plan.add(&Fnet[outChan.QType - FX]);
+			return;
+		default:
+			break;
+	}
+	plan.addZero();
+}
+
 void
 Point::initiateStep(vec rFairIn, vec rdFairIn)
 {
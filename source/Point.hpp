@@ -38,6 +38,7 @@
 #include "IO.hpp"
 #include "Seafloor.hpp"
 #include "Util/CFL.hpp"
+#include "Util/OutputPlan.hpp"
 #include <utility>
 
 #ifdef USE_VTK
@@ -299,6 +300,15 @@ class Point final : public io::IO, public SuperCFL
 	 */
 	real GetPointOutput(OutChanProps outChan);
 
+	/** @brief Compile a point output channel of the main output file
+	 *
+	 * The channel is compiled into an accessor, which is giving the same
+	 * value than GetPointOutput()
+	 * @param outChan The output channel/field
+	 * @param plan The plan where the accessor is added
+	 */
+	void addOutput(const OutChanProps& outChan, OutputPlan& plan);
+
 	/** @brief Set the environmental data
 	 * @param waves_in Global Waves object
 	 * @param seafloor_in Global 3D Seafloor object
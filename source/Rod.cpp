@@ -69,7 +69,7 @@ Rod::setup(int number_in,
            vec6 endCoords,
            unsigned int NumSegs,
            EnvCondRef env_in,
-           shared_ptr<ofstream> outfile_pointer,
+           shared_ptr<OutputFile> outfile_pointer,
            string channels_in)
 {
 	// ================== set up properties ===========
@@ -176,6 +176,9 @@ Rod::setup(int number_in,
 	// record output file pointer and channel key-letter list
 	outfile = outfile_pointer.get(); // make outfile point to the right place
 	channels = channels_in;          // copy string of output channels to object
+	openedoutfile = 0;
+	outFnetRequired = false;
+	outSubRequired = false;
 
 	LOGDBG << "   Set up Rod " << number << ", type '" << TypeName(type)
 	       << "'. " << endl;
@@ -233,67 +236,38 @@ Rod::removeLine(EndPoints end_point, Line* line)
 void
 Rod::openoutput()
 {
-	if (outfile) {
+	// The rods might be initialized several times, but the header shall be
+	// written just once
+	if (outfile && !outfile->hasHeader()) {
 		if (!outfile->is_open()) {
 			LOGERR << "Unable to write file Line" << number << ".out" << endl;
 			throw moordyn::output_file_error("Invalid line file");
 		}
-		// Write the header
-		// 1st line with the fields
-
-		// output time
-		*outfile << "Time"
-		         << "\t ";
-
-		// output positions
+		// Declare the channels, and compile them, so the flags are not
+		// parsed anymore
+		outPlan.clear();
 		if (channels.find("p") != string::npos) {
 			for (unsigned int i = 0; i <= N; i++) {
-				*outfile << "Node" << i << "px \t Node" << i << "py \t Node"
-				         << i << "pz \t ";
+				outfile->addVectorChannel(
+				    "Node" + to_string(i) + "p", "(m)", 3, number, i);
+				outPlan.addVector(r[i].data());
 			}
 		}
-		// output velocities
 		if (channels.find("v") != string::npos) {
 			for (unsigned int i = 0; i <= N; i++) {
-				*outfile << "Node" << i << "vx \t Node" << i << "vy \t Node"
-				         << i << "vz \t ";
+				outfile->addVectorChannel(
+				    "Node" + to_string(i) + "v", "(m/s)", 3, number, i);
+				outPlan.addVector(rd[i].data());
 			}
 		}
-		// output net node force
 		if (channels.find("f") != string::npos) {
 			for (unsigned int i = 0; i <= N; i++) {
-				*outfile << "Node" << i << "Fx \t Node" << i << "Fy \t Node"
-				         << i << "Fz \t ";
-			}
-		}
-
-		*outfile << "\n";
-
-		if (env->WriteUnits > 0) {
-			// 2nd line with the units
-
-			// output time
-			*outfile << "(s)"
-			         << "\t ";
-
-			// output positions
-			if (channels.find("p") != string::npos) {
-				for (unsigned int i = 0; i <= 3 * N + 2; i++)
-					*outfile << "(m) \t";
-			}
-			// output velocities?
-			if (channels.find("v") != string::npos) {
-				for (unsigned int i = 0; i <= 3 * N + 2; i++)
-					*outfile << "(m/s) \t";
+				outfile->addVectorChannel(
+				    "Node" + to_string(i) + "F", "(N)", 3, number, i);
+				outPlan.addVector(Fnet[i].data());
 			}
-			// output net node force?
-			if (channels.find("f") != string::npos) {
-				for (unsigned int i = 0; i <= 3 * N + 2; i++)
-					*outfile << "(N) \t";
-			}
-
-			*outfile << "\n";
 		}
+		outfile->writeHeader(env->WriteUnits > 0);
 		openedoutfile = 1;
 	}
 };
@@ -425,6 +399,98 @@ Rod::GetRodOutput(OutChanProps outChan)
 	return 0.0;
 }
 
+void
+Rod::addOutput(const OutChanProps& outChan, OutputPlan& plan)
+{
+	if (outChan.NodeID > (int)N) {
+		LOGERR << "Invalid output channel " << outChan.Name << ": Rod "
+		       << number << " has not a node " << outChan.NodeID << endl;
+		throw moordyn::invalid_value_error("Invalid node index");
+	}
+	if (outChan.NodeID >= 0) {
+		const unsigned int i = outChan.NodeID;
+		switch (outChan.QType) {
+			case PosX:
+			case PosY:
+			case PosZ:
+				plan.add(&r[i][outChan.QType - PosX]);
+				return;
+			case VelX:
+			case VelY:
+			case VelZ:
+				plan.add(&rd[i][outChan.QType - VelX]);
+				return;
+			case FX:
+			case FY:
+			case FZ:
+				plan.add(&Fnet[i][outChan.QType - FX]);
+				return;
+			default:
+				break;
+		}
+		LOGWRN << "Unrecognized output channel " << outChan.QType << endl;
+		plan.addZero();
+		return;
+	}
+
+	switch (outChan.QType) {
+		case PosX:
+		case PosY:
+		case PosZ:
+			plan.add(&r7.pos[outChan.QType - PosX]);
+			return;
+		case RX:
+			plan.add(&roll, 180.0 / pi);
+			return;
+		case RY:
+			plan.add(&pitch, 180.0 / pi);
+			return;
+		case VelX:
+		case VelY:
+		case VelZ:
+			plan.add(&v6[outChan.QType - VelX]);
+			return;
+		case RVelX:
+		case RVelY:
+			plan.add(&v6[3 + outChan.QType - RVelX], 180.0 / pi);
+			return;
+		case AccX:
+		case AccY:
+		case AccZ:
+			plan.add(&acc6[outChan.QType - AccX]);
+			return;
+		case RAccX:
+		case RAccY:
+			plan.add(&acc6[3 + outChan.QType - RAccX], 180.0 / pi);
+			return;
+		case TenA:
+			plan.add(FextA.data(), 1.0, OutputPlan::OP_NORM);
+			return;
+		case TenB:
+			plan.add(FextB.data(), 1.0, OutputPlan::OP_NORM);
+			return;
+		case FX:
+		case FY:
+		case FZ:
+		case MX:
+		case MY:
+		case MZ:
+			outFnetRequired = true;
+			plan.add(&outFnet[outChan.QType - FX]);
+			plan.addUpdate(this, [this]() { updateOutput(); });
+			return;
+		case Sub:
+			outSubRequired = true;
+			plan.add(&outSub);
+			plan.addUpdate(this, [this]() { updateOutput(); });
+			return;
+		default:
+			break;
+	}
+	LOGWRN << "Unrecognized output channel " << outChan.QType << endl;
+	plan.addZero();
+}
+
 void
 Rod::setState(XYZQuat pos, vec6 vel)
 {
@@ -1362,11 +1428,6 @@ Rod::doRHS()
 void
 Rod::Output(real time)
 {
-	// run through output flags
-	// if channel is flagged for output, write to file.
-	// Flags changed to just be one character (case sensitive) per output flag.
-	// To match FASTv8 version.
-
 	if (outfile) // if not a null pointer (indicating no output)
 	{
 		if (openedoutfile == 0) {
@@ -1379,37 +1440,27 @@ Rod::Output(real time)
 			LOGWRN << "Unable to write to output file " << endl;
 			return;
 		}
-		// output time
-		*outfile << time << "\t ";
-
-		// output positions?
-		if (channels.find("p") != string::npos) {
-			for (unsigned int i = 0; i <= N; i++) // loop through nodes
-			{
-				for (int J = 0; J < 3; J++)
-					*outfile << r[i][J] << "\t ";
-			}
-		}
-		// output velocities?
-		if (channels.find("v") != string::npos) {
-			for (unsigned int i = 0; i <= N; i++) {
-				for (int J = 0; J < 3; J++)
-					*outfile << rd[i][J] << "\t ";
-			}
-		}
-		// output net node forces?
-		if (channels.find("f") != string::npos) {
-			for (unsigned int i = 0; i <= N; i++) {
-				for (unsigned int J = 0; J < 3; J++)
-					*outfile << Fnet[i][J] << "\t ";
-			}
-		}
-
-		*outfile << "\n";
+		// The channels were already compiled when the header was written
+		outfile->begin(time);
+		outPlan.write(*outfile);
+		outfile->end();
 	}
 	return;
 }
 
+void
+Rod::updateOutput()
+{
+	if (outFnetRequired)
+		outFnet = getFnet();
+	if (outSubRequired) {
+		real VOFsum = 0.0;
+		for (unsigned int i = 0; i <= N; i++)
+			VOFsum += VOF[i];
+		outSub = VOFsum / VOF.size();
+	}
+}
+
 std::vector<uint64_t>
 Rod::Serialize(void)
 {
@@ -38,6 +38,8 @@
 #include "IO.hpp"
 #include "Seafloor.hpp"
 #include "Util/CFL.hpp"
+#include "Util/OutputFile.hpp"
+#include "Util/OutputPlan.hpp"
 #include <vector>
 #include <utility>
 
@@ -208,12 +210,26 @@ class Rod final : public io::IO, public SuperCFL
 	vec6 rdd_ves;
 
 	// file stuff
-	/// Pointer to moordyn::MoorDyn::outfileMain
-	ofstream* outfile;
+	/// The output file, NULL if no output is required
+	OutputFile* outfile;
 	/// A copy of moordyn::MoorDyn::outChans
 	string channels;
 	/// Flag for printing channels and units in rod outfile
 	int openedoutfile;
+	/// The channels of the output file, compiled by openoutput()
+	OutputPlan outPlan;
+	/// The net force and moment printed on the main output file
+	vec6 outFnet;
+	/// Whether moordyn::Rod::outFnet shall be computed
+	bool outFnetRequired;
+	/// The submerged fraction printed on the main output file
+	real outSub;
+	/// Whether moordyn::Rod::outSub shall be computed
+	bool outSubRequired;
+
+	/** @brief Update the quantities printed on the main output file
+	 */
+	void updateOutput();
 
 	/** @brief Finds the depth of the water at some (x, y) point. Either using
 	 * env->WtrDpth or the 3D seafloor if available
@@ -300,7 +316,7 @@ class Rod final : public io::IO, public SuperCFL
 	           vec6 endCoords,
 	           unsigned int n,
 	           EnvCondRef env_in,
-	           shared_ptr<ofstream> outfile,
+	           shared_ptr<OutputFile> outfile,
 	           string channels);
 
 	/** @brief Attach a line endpoint to the rod end point A
@@ -401,6 +417,16 @@ class Rod final : public io::IO, public SuperCFL
 	 */
 	real GetRodOutput(OutChanProps outChan);
 
+	/** @brief Compile a rod output channel of the main output file
+	 *
+	 * The channel is compiled into an accessor, which is giving the same
+	 * value than GetRodOutput()
+	 * @param outChan The output channel/field
+	 * @param plan The plan where the accessor is added
+	 * @throws invalid_value_error If the node of the channel does not exist
+	 */
+	void addOutput(const OutChanProps& outChan, OutputPlan& plan);
+
 	/** @brief Get the drag coefficients
 	 * @return The normal (transversal) and tangential (axial) drag coefficients
 	 */
@@ -119,6 +119,8 @@ Seafloor::setup(EnvCondRef env, const string& filepath)
 			}
 		}
 		averageDepth = depthTotal / (real)(nx * ny);
+		ax = InterpAxis(px);
+		ay = InterpAxis(py);
 
 	} else {
 		// Handle case where we specified an inappropriate flag
@@ -134,8 +136,8 @@ Seafloor::getDepthAt(real x, real y)
 {
 	real fx, fy;
 
-	auto ix = interp_factor(px, x, fx);
-	auto iy = interp_factor(py, y, fy);
+	auto ix = ax.factor(x, fx);
+	auto iy = ay.factor(y, fy);
 
 	return interp2(depthGrid, ix, iy, fx, fy);
 }
@@ -38,6 +38,7 @@
 
 #include "Misc.hpp"
 #include "Log.hpp"
+#include "Util/Interp.hpp"
 #include <vector>
 #include <map>
 
@@ -95,6 +96,10 @@ class Seafloor : LogUser
 	std::vector<real> px;
 	/// grid y coordinate arrays (indicating tick values)
 	std::vector<real> py;
+	/// grid x axis, to compute the interpolation factors
+	InterpAxis ax;
+	/// grid y axis, to compute the interpolation factors
+	InterpAxis ay;
 
 	/// Seafloor depth grid (nx by ny grid of z vals)
 	std::vector<std::vector<real>> depthGrid;
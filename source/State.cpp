@@ -30,6 +30,7 @@
 
 #include "State.hpp"
 
+using namespace std;
 using namespace std;
 
 namespace moordyn {
@@ -46,7 +47,7 @@ StateVar<vec>::AsString() const
 
 template<>
 string
-StateVar<vec6>::AsString() const
+StateVar<vec7, vec6>::AsString() const
 {
 	stringstream s;
 	s << "pos = [" << pos.transpose() << "]; ";
@@ -56,160 +57,20 @@ StateVar<vec6>::AsString() const
 
 template<>
 string
-StateVar<XYZQuat, vec6>::AsString() const
-{
-	stringstream s;
-	s << "pos = [" << pos.toVec7().transpose() << "]; ";
-	s << "vel = [" << vel.transpose() << "]" << endl;
-	return s.str();
-}
-
-template<>
-string
-StateVar<std::vector<vec>>::AsString() const
+StateVar<Eigen::Matrix3Xr>::AsString() const
 {
 	stringstream s;
 	s << "pos = [";
-	for (auto v : pos)
-		s << "[" << v.transpose() << "], ";
+	for (unsigned int i = 0; i < pos.cols(); i++)
+		s << "[" << pos.col(i).transpose() << "], ";
 	s << "]" << endl;
 	s << "vel = [";
-	for (auto v : vel)
-		s << "[" << v.transpose() << "], ";
+	for (unsigned int i = 0; i < vel.cols(); i++)
+		s << "[" << vel.col(i).transpose() << "], ";
 	s << "]" << endl;
 	return s.str();
 }
 
-template<>
-StateVar<vec>
-StateVar<vec>::operator+(const StateVar<vec>& rhs)
-{
-	StateVar<vec> out;
-	out.pos = pos + rhs.pos;
-	out.vel = vel + rhs.vel;
-	return out;
-}
-
-template<>
-StateVar<vec6>
-StateVar<vec6>::operator+(const StateVar<vec6>& rhs)
-{
-	StateVar<vec6> out;
-	out.pos = pos + rhs.pos;
-	out.vel = vel + rhs.vel;
-	return out;
-}
-
-template<>
-StateVar<XYZQuat, vec6>
-StateVar<XYZQuat, vec6>::operator+(const StateVar<XYZQuat, vec6>& rhs)
-{
-	StateVar<XYZQuat, vec6> out;
-	out.pos = pos + rhs.pos;
-	out.vel = vel + rhs.vel;
-	return out;
-}
-
-template<>
-StateVar<XYZQuat, vec6>
-StateVar<XYZQuat, vec6>::operator-(const StateVar<XYZQuat, vec6>& rhs)
-{
-	StateVar<XYZQuat, vec6> out;
-	out.pos = pos + rhs.pos;
-	out.vel = vel + rhs.vel;
-	return out;
-}
-
-template<>
-StateVar<std::vector<vec>>
-StateVar<std::vector<vec>>::operator+(const StateVar<std::vector<vec>>& rhs)
-{
-	if ((pos.size() != rhs.pos.size()) || (vel.size() != rhs.vel.size()))
-		throw moordyn::invalid_value_error("Invalid input size");
-	StateVar<std::vector<vec>> out;
-	out.pos.reserve(pos.size());
-	out.vel.reserve(vel.size());
-	// NOTE: At this point we are assuming that both pos and vel have the same
-	// length
-	for (unsigned int i = 0; i < pos.size(); i++) {
-		out.pos.push_back(pos[i] + rhs.pos[i]);
-		out.vel.push_back(vel[i] + rhs.vel[i]);
-	}
-	return out;
-}
-
-template<>
-StateVar<vec>
-StateVar<vec>::operator-(const StateVar<vec>& rhs)
-{
-	StateVar<vec> out;
-	out.pos = pos - rhs.pos;
-	out.vel = vel - rhs.vel;
-	return out;
-}
-
-template<>
-StateVar<vec6>
-StateVar<vec6>::operator-(const StateVar<vec6>& rhs)
-{
-	StateVar<vec6> out;
-	out.pos = pos - rhs.pos;
-	out.vel = vel - rhs.vel;
-	return out;
-}
-
-template<>
-StateVar<std::vector<vec>>
-StateVar<std::vector<vec>>::operator-(const StateVar<std::vector<vec>>& rhs)
-{
-	if ((pos.size() != rhs.pos.size()) || (vel.size() != rhs.vel.size()))
-		throw moordyn::invalid_value_error("Invalid input size");
-	StateVar<std::vector<vec>> out;
-	out.pos.reserve(pos.size());
-	out.vel.reserve(vel.size());
-	// NOTE: At this point we are assuming that both pos and vel have the same
-	// length
-	for (unsigned int i = 0; i < pos.size(); i++) {
-		out.pos.push_back(pos[i] - rhs.pos[i]);
-		out.vel.push_back(vel[i] - rhs.vel[i]);
-	}
-	return out;
-}
-
-template<>
-void
-StateVar<vec>::Mix(const StateVar<vec>& rhs, const real& f)
-{
-	pos = pos * (1.0 - f) + rhs.pos * f;
-	vel = vel * (1.0 - f) + rhs.vel * f;
-}
-
-template<>
-void
-StateVar<vec6>::Mix(const StateVar<vec6>& rhs, const real& f)
-{
-	pos = pos * (1.0 - f) + rhs.pos * f;
-	vel = vel * (1.0 - f) + rhs.vel * f;
-}
-
-template<>
-void
-StateVar<XYZQuat, vec6>::Mix(const StateVar<XYZQuat, vec6>& rhs, const real& f)
-{
-	pos = pos * (1.0 - f) + rhs.pos * f;
-	vel = vel * (1.0 - f) + rhs.vel * f;
-}
-
-template<>
-void
-StateVar<std::vector<vec>>::Mix(const StateVar<std::vector<vec>>& rhs, const real& f)
-{
-	for (unsigned int i = 0; i < pos.size(); i++) {
-		pos[i] = pos[i] * (1.0 - f) + rhs.pos[i] * f;
-		vel[i] = vel[i] * (1.0 - f) + rhs.vel[i] * f;
-	}
-}
-
 template<>
 string
 StateVarDeriv<vec>::AsString() const
@@ -222,7 +83,7 @@ StateVarDeriv<vec>::AsString() const
 
 template<>
 string
-StateVarDeriv<vec6>::AsString() const
+StateVarDeriv<vec7, vec6>::AsString() const
 {
 	stringstream s;
 	s << "vel = [" << vel.transpose() << "]; ";
@@ -232,174 +93,20 @@ StateVarDeriv<vec6>::AsString() const
 
 template<>
 string
-StateVarDeriv<XYZQuat, vec6>::AsString() const
-{
-	stringstream s;
-	s << "vel = [" << vel.toVec7().transpose() << "]; ";
-	s << "acc = [" << acc.transpose() << "]" << endl;
-	return s.str();
-}
-
-template<>
-string
-StateVarDeriv<std::vector<vec>>::AsString() const
+StateVarDeriv<Eigen::Matrix3Xr>::AsString() const
 {
 	stringstream s;
 	s << "vel = [";
-	for (auto v : vel)
-		s << "[" << v.transpose() << "], ";
+	for (unsigned int i = 0; i < vel.cols(); i++)
+		s << "[" << vel.col(i).transpose() << "], ";
 	s << "]" << endl;
 	s << "acc = [";
-	for (auto v : acc)
-		s << "[" << v.transpose() << "], ";
+	for (unsigned int i = 0; i < acc.cols(); i++)
+		s << "[" << acc.col(i).transpose() << "], ";
 	s << "]" << endl;
 	return s.str();
 }
 
-template<>
-StateVar<vec>
-StateVarDeriv<vec>::operator*(const real& dt)
-{
-	StateVar<vec> out;
-	out.pos = vel * dt;
-	out.vel = acc * dt;
-	return out;
-}
-
-template<>
-StateVar<vec6>
-StateVarDeriv<vec6>::operator*(const real& dt)
-{
-	StateVar<vec6> out;
-	out.pos = vel * dt;
-	out.vel = acc * dt;
-	return out;
-}
-
-template<>
-StateVar<XYZQuat, vec6>
-StateVarDeriv<XYZQuat, vec6>::operator*(const real& dt)
-{
-	StateVar<XYZQuat, vec6> out;
-	out.pos = vel * dt;
-	out.vel = acc * dt;
-	return out;
-}
-
-template<>
-StateVar<std::vector<vec>>
-StateVarDeriv<std::vector<vec>>::operator*(const real& dt)
-{
-	StateVar<std::vector<vec>> out;
-	out.pos.reserve(vel.size());
-	out.vel.reserve(acc.size());
-	// NOTE: At this point we are assuming that both vel and acc have the same
-	// length
-	for (unsigned int i = 0; i < vel.size(); i++) {
-		out.pos.push_back(vel[i] * dt);
-		out.vel.push_back(acc[i] * dt);
-	}
-	return out;
-}
-
-template<>
-StateVarDeriv<vec>
-StateVarDeriv<vec>::operator+(const StateVarDeriv<vec>& rhs)
-{
-	StateVarDeriv<vec> out;
-	out.vel = vel + rhs.vel;
-	out.acc = acc + rhs.acc;
-	return out;
-}
-
-template<>
-StateVarDeriv<vec6>
-StateVarDeriv<vec6>::operator+(const StateVarDeriv<vec6>& rhs)
-{
-	StateVarDeriv<vec6> out;
-	out.vel = vel + rhs.vel;
-	out.acc = acc + rhs.acc;
-	return out;
-}
-
-template<>
-StateVarDeriv<XYZQuat, vec6>
-StateVarDeriv<XYZQuat, vec6>::operator+(const StateVarDeriv<XYZQuat, vec6>& rhs)
-{
-	StateVarDeriv<XYZQuat, vec6> out;
-	out.vel = vel + rhs.vel;
-	out.acc = acc + rhs.acc;
-	return out;
-}
-
-template<>
-StateVarDeriv<std::vector<vec>>
-StateVarDeriv<std::vector<vec>>::operator+(
-    const StateVarDeriv<std::vector<vec>>& rhs)
-{
-	if ((vel.size() != rhs.vel.size()) || (acc.size() != rhs.acc.size()))
-		throw moordyn::invalid_value_error("Invalid input size");
-	StateVarDeriv<std::vector<vec>> out;
-	out.vel.reserve(vel.size());
-	out.acc.reserve(acc.size());
-	// NOTE: At this point we are assuming that both vel and acc have the same
-	// length
-	for (unsigned int i = 0; i < vel.size(); i++) {
-		out.vel.push_back(vel[i] + rhs.vel[i]);
-		out.acc.push_back(acc[i] + rhs.acc[i]);
-	}
-	return out;
-}
-
-template<>
-StateVarDeriv<vec>
-StateVarDeriv<vec>::operator-(const StateVarDeriv<vec>& rhs)
-{
-	StateVarDeriv<vec> out;
-	out.vel = vel - rhs.vel;
-	out.acc = acc - rhs.acc;
-	return out;
-}
-
-template<>
-StateVarDeriv<vec6>
-StateVarDeriv<vec6>::operator-(const StateVarDeriv<vec6>& rhs)
-{
-	StateVarDeriv<vec6> out;
-	out.vel = vel - rhs.vel;
-	out.acc = acc - rhs.acc;
-	return out;
-}
-
-template<>
-StateVarDeriv<XYZQuat, vec6>
-StateVarDeriv<XYZQuat, vec6>::operator-(const StateVarDeriv<XYZQuat, vec6>& rhs)
-{
-	StateVarDeriv<XYZQuat, vec6> out;
-	out.vel = vel - rhs.vel;
-	out.acc = acc - rhs.acc;
-	return out;
-}
-
-template<>
-StateVarDeriv<std::vector<vec>>
-StateVarDeriv<std::vector<vec>>::operator-(
-    const StateVarDeriv<std::vector<vec>>& rhs)
-{
-	if ((vel.size() != rhs.vel.size()) || (acc.size() != rhs.acc.size()))
-		throw moordyn::invalid_value_error("Invalid input size");
-	StateVarDeriv<std::vector<vec>> out;
-	out.vel.reserve(vel.size());
-	out.acc.reserve(acc.size());
-	// NOTE: At this point we are assuming that both vel and acc have the same
-	// length
-	for (unsigned int i = 0; i < vel.size(); i++) {
-		out.vel.push_back(vel[i] - rhs.vel[i]);
-		out.acc.push_back(acc[i] - rhs.acc[i]);
-	}
-	return out;
-}
-
 template<>
 real StateVarDeriv<vec>::MakeStationary(const real &dt)
 {
@@ -410,189 +117,113 @@ real StateVarDeriv<vec>::MakeStationary(const real &dt)
 }
 
 template<>
-real StateVarDeriv<vec6>::MakeStationary(const real &dt)
-{
-	real ret = acc.head<3>().norm();
-	vel = 0.5 * dt * acc;
-	acc = vec6::Zero();
-	return ret;
-}
-
-template<>
-real StateVarDeriv<XYZQuat, vec6>::MakeStationary(const real &dt)
+real StateVarDeriv<vec7, vec6>::MakeStationary(const real &dt)
 {
 	real ret = acc.head<3>().norm();
-	vel = XYZQuat::fromVec6(0.5 * dt * acc);
+	vel = XYZQuat::fromVec6(0.5 * dt * acc).toVec7();
 	acc = vec6::Zero();
 	return ret;
 }
 
 template<>
-real StateVarDeriv<std::vector<vec>>::MakeStationary(const real &dt)
+real StateVarDeriv<Eigen::Matrix3Xr>::MakeStationary(const real &dt)
 {
 	real ret = 0.0;
-	for (unsigned int i = 0; i < vel.size(); i++) {
-		ret += acc[i].norm();
-		vel[i] = 0.5 * dt * acc[i];
-		acc[i] = vec::Zero();
-	}
+	for (unsigned int i = 0; i < acc.cols(); i++)
+		ret += acc.col(i).norm();
+	vel = 0.5 * dt * acc;
+	acc.setZero();
 	return ret;
 }
 
 template<>
-StateVarDeriv<vec>
+void
 StateVarDeriv<vec>::Newmark(
-	const StateVarDeriv<vec>& visitor, const real& dt,
-	real gamma, real beta)
+	const StateVarDeriv<vec>& visitor, StateVarDeriv<vec>& out,
+	const real& dt, real gamma, real beta) const
 {
-	StateVarDeriv<vec> ret;
 	const vec acc_gamma = (1 - gamma) * acc + gamma * visitor.acc;
 	const vec acc_beta = (0.5 - beta) * acc + beta * visitor.acc;
-	ret.vel = vel + dt * acc_beta;
-	ret.acc = acc_gamma;
-	return ret;
-}
-
-template<>
-StateVarDeriv<vec6>
-StateVarDeriv<vec6>::Newmark(
-	const StateVarDeriv<vec6>& visitor, const real& dt,
-	real gamma, real beta)
-{
-	StateVarDeriv<vec6> ret;
-	const vec6 acc_gamma = (1 - gamma) * acc + gamma * visitor.acc;
-	const vec6 acc_beta = (0.5 - beta) * acc + beta * visitor.acc;
-	ret.vel = vel + dt * acc_beta;
-	ret.acc = acc_gamma;
-	return ret;
+	out.vel = vel + dt * acc_beta;
+	out.acc = acc_gamma;
 }
 
 template<>
-StateVarDeriv<XYZQuat, vec6>
-StateVarDeriv<XYZQuat, vec6>::Newmark(
-	const StateVarDeriv<XYZQuat, vec6>& visitor, const real& dt,
-	real gamma, real beta)
+void
+StateVarDeriv<vec7, vec6>::Newmark(
+	const StateVarDeriv<vec7, vec6>& visitor, StateVarDeriv<vec7, vec6>& out,
+	const real& dt, real gamma, real beta) const
 {
-	StateVarDeriv<XYZQuat, vec6> ret;
 	const vec6 acc_gamma = (1 - gamma) * acc + gamma * visitor.acc;
 	const vec6 acc_beta = (0.5 - beta) * acc + beta * visitor.acc;
-	ret.vel = vel + XYZQuat::fromVec6(dt * acc_beta);
-	ret.acc = acc_gamma;
-	return ret;
+	out.vel = vel + XYZQuat::fromVec6(dt * acc_beta).toVec7();
+	out.acc = acc_gamma;
 }
 
 template<>
-StateVarDeriv<std::vector<vec>>
-StateVarDeriv<std::vector<vec>>::Newmark(
-	const StateVarDeriv<std::vector<vec>>& visitor, const real& dt,
-	real gamma, real beta)
+void
+StateVarDeriv<Eigen::Matrix3Xr>::Newmark(
+	const StateVarDeriv<Eigen::Matrix3Xr>& visitor,
+	StateVarDeriv<Eigen::Matrix3Xr>& out,
+	const real& dt, real gamma, real beta) const
 {
-	StateVarDeriv<std::vector<vec>> ret;
-	ret.vel.reserve(vel.size());
-	ret.acc.reserve(acc.size());
-	for (unsigned int i = 0; i < vel.size(); i++) {
-		const vec acc_gamma = (1 - gamma) * acc[i] + gamma * visitor.acc[i];
-		const vec acc_beta = (0.5 - beta) * acc[i] + beta * visitor.acc[i];
-		ret.vel.push_back(vel[i] + dt * acc_beta);
-		ret.acc.push_back(acc_gamma);
-	}
-	return ret;
+	// The velocity shall be computed first, in case out is this same object
+	out.vel = vel + dt * ((0.5 - beta) * acc + beta * visitor.acc);
+	out.acc = (1 - gamma) * acc + gamma * visitor.acc;
 }
 
 template<>
-StateVarDeriv<vec>
+void
 StateVarDeriv<vec>::Wilson(
-	const StateVarDeriv<vec>& visitor, const real& tau, const real& dt)
+	const StateVarDeriv<vec>& visitor, StateVarDeriv<vec>& out,
+	const real& tau, const real& dt) const
 {
-	StateVarDeriv<vec> ret;
 	const real f = tau / dt;
-	ret.acc = (1 - 0.5 * f) * acc + 0.5 * f * visitor.acc;
-	ret.vel = vel + 0.5 * dt * (
-		(1 - 1.0 / 3.0 * f) * acc + 1.0 / 3.0 * f * visitor.acc);
-	return ret;
+	const vec a = acc;
+	out.acc = (1 - 0.5 * f) * a + 0.5 * f * visitor.acc;
+	out.vel = vel + 0.5 * dt * (
+		(1 - 1.0 / 3.0 * f) * a + 1.0 / 3.0 * f * visitor.acc);
 }
 
 template<>
-StateVarDeriv<vec6>
-StateVarDeriv<vec6>::Wilson(
-	const StateVarDeriv<vec6>& visitor, const real& tau, const real& dt)
-{
-	StateVarDeriv<vec6> ret;
-	const real f = tau / dt;
-	ret.acc = (1 - 0.5 * f) * acc + 0.5 * f * visitor.acc;
-	ret.vel = vel + 0.5 * dt * (
-		(1 - 1.0 / 3.0 * f) * acc + 1.0 / 3.0 * f * visitor.acc);
-	return ret;
-}
-
-template<>
-StateVarDeriv<XYZQuat, vec6>
-StateVarDeriv<XYZQuat, vec6>::Wilson(
-	const StateVarDeriv<XYZQuat, vec6>& visitor,
-	const real& tau,
-	const real& dt)
+void
+StateVarDeriv<vec7, vec6>::Wilson(
+	const StateVarDeriv<vec7, vec6>& visitor, StateVarDeriv<vec7, vec6>& out,
+	const real& tau, const real& dt) const
 {
-	StateVarDeriv<XYZQuat, vec6> ret;
 	const real f = tau / dt;
-	ret.acc = (1 - 0.5 * f) * acc + 0.5 * f * visitor.acc;
-	ret.vel = vel + XYZQuat::fromVec6(0.5 * dt * (
-		(1 - 1.0 / 3.0 * f) * acc + 1.0 / 3.0 * f * visitor.acc));
-	return ret;
+	const vec6 a = acc;
+	out.acc = (1 - 0.5 * f) * a + 0.5 * f * visitor.acc;
+	out.vel = vel + XYZQuat::fromVec6(0.5 * dt * (
+		(1 - 1.0 / 3.0 * f) * a + 1.0 / 3.0 * f * visitor.acc)).toVec7();
 }
 
 template<>
-StateVarDeriv<std::vector<vec>>
-StateVarDeriv<std::vector<vec>>::Wilson(
-	const StateVarDeriv<std::vector<vec>>& visitor,
-	const real& tau,
-	const real& dt)
+void
+StateVarDeriv<Eigen::Matrix3Xr>::Wilson(
+	const StateVarDeriv<Eigen::Matrix3Xr>& visitor,
+	StateVarDeriv<Eigen::Matrix3Xr>& out,
+	const real& tau, const real& dt) const
 {
-	StateVarDeriv<std::vector<vec>> ret;
-	ret.vel.reserve(vel.size());
-	ret.acc.reserve(acc.size());
 	const real f = tau / dt;
 	const real f2 = 0.5 * f;
 	const real f3 = 1.0 / 3.0 * f;
-	for (unsigned int i = 0; i < vel.size(); i++) {
-		ret.acc.push_back((1 - f2) * acc[i] + f2 * visitor.acc[i]);
-		ret.vel.push_back(vel[i] + 0.5 * dt * (
-			(1 - f3) * acc[i] + f3 * visitor.acc[i]));
-	}
-	return ret;
-}
-
-template<>
-void
-StateVarDeriv<vec>::Mix(const StateVarDeriv<vec>& rhs, const real& f)
-{
-	vel = vel * (1.0 - f) + rhs.vel * f;
-	acc = acc * (1.0 - f) + rhs.acc * f;
-}
-
-template<>
-void
-StateVarDeriv<vec6>::Mix(const StateVarDeriv<vec6>& rhs, const real& f)
-{
-	vel = vel * (1.0 - f) + rhs.vel * f;
-	acc = acc * (1.0 - f) + rhs.acc * f;
-}
-
-template<>
-void
-StateVarDeriv<XYZQuat, vec6>::Mix(const StateVarDeriv<XYZQuat, vec6>& rhs, const real& f)
-{
-	vel = vel * (1.0 - f) + rhs.vel * f;
-	acc = acc * (1.0 - f) + rhs.acc * f;
+	// The velocity shall be computed first, in case out is this same object
+	out.vel = vel + 0.5 * dt * ((1 - f3) * acc + f3 * visitor.acc);
+	out.acc = (1 - f2) * acc + f2 * visitor.acc;
 }
 
-template<>
-void
-StateVarDeriv<std::vector<vec>>::Mix(const StateVarDeriv<std::vector<vec>>& rhs, const real& f)
+/** @brief Check that two states have the same memory layout
+ * @param a The first state
+ * @param b The second state
+ * @throw moordyn::invalid_value_error If the layouts do not match
+ */
+template<class S1, class S2>
+inline void
+check_layout(const S1& a, const S2& b)
 {
-	for (unsigned int i = 0; i < vel.size(); i++) {
-		vel[i] = vel[i] * (1.0 - f) + rhs.vel[i] * f;
-		acc[i] = acc[i] * (1.0 - f) + rhs.acc[i] * f;
-	}
+	if (!a.SameLayout(b))
+		throw moordyn::invalid_value_error("Invalid input size");
 }
 
 string
@@ -619,98 +250,28 @@ MoorDynState::AsString() const
 	return s.str();
 }
 
-MoorDynState&
-MoorDynState::operator=(const MoorDynState& rhs)
-{
-	lines.clear();
-	lines.reserve(rhs.lines.size());
-	for (auto l : rhs.lines)
-		lines.push_back(l);
-	points.clear();
-	points.reserve(rhs.points.size());
-	for (auto l : rhs.points)
-		points.push_back(l);
-	rods.clear();
-	rods.reserve(rhs.rods.size());
-	for (auto l : rhs.rods)
-		rods.push_back(l);
-	bodies.clear();
-	bodies.reserve(rhs.bodies.size());
-	for (auto l : rhs.bodies)
-		bodies.push_back(l);
-
-	return *this;
-}
-
 MoorDynState
-MoorDynState::operator+(const MoorDynState& rhs)
+MoorDynState::operator+(const MoorDynState& rhs) const
 {
-	MoorDynState out;
-
-	if (lines.size() != rhs.lines.size())
-		throw moordyn::invalid_value_error("Invalid input size");
-	out.lines.reserve(lines.size());
-	for (unsigned int i = 0; i < lines.size(); i++)
-		out.lines.push_back(lines[i] + rhs.lines[i]);
-	if (points.size() != rhs.points.size())
-		throw moordyn::invalid_value_error("Invalid input size");
-	out.points.reserve(points.size());
-	for (unsigned int i = 0; i < points.size(); i++)
-		out.points.push_back(points[i] + rhs.points[i]);
-	if (rods.size() != rhs.rods.size())
-		throw moordyn::invalid_value_error("Invalid input size");
-	out.rods.reserve(rods.size());
-	for (unsigned int i = 0; i < rods.size(); i++)
-		out.rods.push_back(rods[i] + rhs.rods[i]);
-	if (bodies.size() != rhs.bodies.size())
-		throw moordyn::invalid_value_error("Invalid input size");
-	out.bodies.reserve(bodies.size());
-	for (unsigned int i = 0; i < bodies.size(); i++)
-		out.bodies.push_back(bodies[i] + rhs.bodies[i]);
-
+	check_layout(*this, rhs);
+	MoorDynState out(*this);
+	out._data += rhs._data;
 	return out;
 }
 
 MoorDynState
-MoorDynState::operator-(const MoorDynState& rhs)
+MoorDynState::operator-(const MoorDynState& rhs) const
 {
-	MoorDynState out;
-
-	if (lines.size() != rhs.lines.size())
-		throw moordyn::invalid_value_error("Invalid input size");
-	out.lines.reserve(lines.size());
-	for (unsigned int i = 0; i < lines.size(); i++)
-		out.lines.push_back(lines[i] - rhs.lines[i]);
-	if (points.size() != rhs.points.size())
-		throw moordyn::invalid_value_error("Invalid input size");
-	out.points.reserve(points.size());
-	for (unsigned int i = 0; i < points.size(); i++)
-		out.points.push_back(points[i] - rhs.points[i]);
-	if (rods.size() != rhs.rods.size())
-		throw moordyn::invalid_value_error("Invalid input size");
-	out.rods.reserve(rods.size());
-	for (unsigned int i = 0; i < rods.size(); i++)
-		out.rods.push_back(rods[i] - rhs.rods[i]);
-	if (bodies.size() != rhs.bodies.size())
-		throw moordyn::invalid_value_error("Invalid input size");
-	out.bodies.reserve(bodies.size());
-	for (unsigned int i = 0; i < bodies.size(); i++)
-		out.bodies.push_back(bodies[i] - rhs.bodies[i]);
-
+	check_layout(*this, rhs);
+	MoorDynState out(*this);
+	out._data -= rhs._data;
 	return out;
 }
 
 void
 MoorDynState::Mix(const MoorDynState& visitor, const real& f)
 {
-	for (unsigned int i = 0; i < lines.size(); i++)
-		lines[i].Mix(visitor.lines[i], f);
-	for (unsigned int i = 0; i < points.size(); i++)
-		points[i].Mix(visitor.points[i], f);
-	for (unsigned int i = 0; i < rods.size(); i++)
-		rods[i].Mix(visitor.rods[i], f);
-	for (unsigned int i = 0; i < bodies.size(); i++)
-		bodies[i].Mix(visitor.bodies[i], f);
+	_data = _data * (1.0 - f) + visitor._data * f;
 }
 
 string
@@ -737,105 +298,31 @@ DMoorDynStateDt::AsString() const
 	return s.str();
 }
 
-DMoorDynStateDt&
-DMoorDynStateDt::operator=(const DMoorDynStateDt& rhs)
-{
-	lines.clear();
-	lines.reserve(rhs.lines.size());
-	for (auto l : rhs.lines)
-		lines.push_back(l);
-	points.clear();
-	points.reserve(rhs.points.size());
-	for (auto l : rhs.points)
-		points.push_back(l);
-	rods.clear();
-	rods.reserve(rhs.rods.size());
-	for (auto l : rhs.rods)
-		rods.push_back(l);
-	bodies.clear();
-	bodies.reserve(rhs.bodies.size());
-	for (auto l : rhs.bodies)
-		bodies.push_back(l);
-
-	return *this;
-}
-
 MoorDynState
-DMoorDynStateDt::operator*(const real& dt)
+DMoorDynStateDt::operator*(const real& dt) const
 {
+	// The states and their derivatives share the very same memory layout
 	MoorDynState out;
-
-	out.lines.reserve(lines.size());
-	for (unsigned int i = 0; i < lines.size(); i++)
-		out.lines.push_back(lines[i] * dt);
-	out.points.reserve(points.size());
-	for (unsigned int i = 0; i < points.size(); i++)
-		out.points.push_back(points[i] * dt);
-	out.rods.reserve(rods.size());
-	for (unsigned int i = 0; i < rods.size(); i++)
-		out.rods.push_back(rods[i] * dt);
-	out.bodies.reserve(bodies.size());
-	for (unsigned int i = 0; i < bodies.size(); i++)
-		out.bodies.push_back(bodies[i] * dt);
-
+	out.Reshape(*this);
+	out.Data() = _data * dt;
 	return out;
 }
 
 DMoorDynStateDt
-DMoorDynStateDt::operator+(const DMoorDynStateDt& rhs)
+DMoorDynStateDt::operator+(const DMoorDynStateDt& rhs) const
 {
-	DMoorDynStateDt out;
-
-	if (lines.size() != rhs.lines.size())
-		throw moordyn::invalid_value_error("Invalid input size");
-	out.lines.reserve(lines.size());
-	for (unsigned int i = 0; i < lines.size(); i++)
-		out.lines.push_back(lines[i] + rhs.lines[i]);
-	if (points.size() != rhs.points.size())
-		throw moordyn::invalid_value_error("Invalid input size");
-	out.points.reserve(points.size());
-	for (unsigned int i = 0; i < points.size(); i++)
-		out.points.push_back(points[i] + rhs.points[i]);
-	if (rods.size() != rhs.rods.size())
-		throw moordyn::invalid_value_error("Invalid input size");
-	out.rods.reserve(rods.size());
-	for (unsigned int i = 0; i < rods.size(); i++)
-		out.rods.push_back(rods[i] + rhs.rods[i]);
-	if (bodies.size() != rhs.bodies.size())
-		throw moordyn::invalid_value_error("Invalid input size");
-	out.bodies.reserve(bodies.size());
-	for (unsigned int i = 0; i < bodies.size(); i++)
-		out.bodies.push_back(bodies[i] + rhs.bodies[i]);
-
+	check_layout(*this, rhs);
+	DMoorDynStateDt out(*this);
+	out._data += rhs._data;
 	return out;
 }
 
 DMoorDynStateDt
-DMoorDynStateDt::operator-(const DMoorDynStateDt& rhs)
+DMoorDynStateDt::operator-(const DMoorDynStateDt& rhs) const
 {
-	DMoorDynStateDt out;
-
-	if (lines.size() != rhs.lines.size())
-		throw moordyn::invalid_value_error("Invalid input size");
-	out.lines.reserve(lines.size());
-	for (unsigned int i = 0; i < lines.size(); i++)
-		out.lines.push_back(lines[i] - rhs.lines[i]);
-	if (points.size() != rhs.points.size())
-		throw moordyn::invalid_value_error("Invalid input size");
-	out.points.reserve(points.size());
-	for (unsigned int i = 0; i < points.size(); i++)
-		out.points.push_back(points[i] - rhs.points[i]);
-	if (rods.size() != rhs.rods.size())
-		throw moordyn::invalid_value_error("Invalid input size");
-	out.rods.reserve(rods.size());
-	for (unsigned int i = 0; i < rods.size(); i++)
-		out.rods.push_back(rods[i] - rhs.rods[i]);
-	if (bodies.size() != rhs.bodies.size())
-		throw moordyn::invalid_value_error("Invalid input size");
-	out.bodies.reserve(bodies.size());
-	for (unsigned int i = 0; i < bodies.size(); i++)
-		out.bodies.push_back(bodies[i] - rhs.bodies[i]);
-
+	check_layout(*this, rhs);
+	DMoorDynStateDt out(*this);
+	out._data -= rhs._data;
 	return out;
 }
 
@@ -856,78 +343,66 @@ DMoorDynStateDt::MakeStationary(const real &dt)
 
 DMoorDynStateDt
 DMoorDynStateDt::Newmark(const DMoorDynStateDt& rhs,
-	                     const real& dt,
-	                     real gamma,
-	                     real beta)
+                         const real& dt,
+                         real gamma,
+                         real beta) const
 {
-	DMoorDynStateDt out;
+	DMoorDynStateDt out(*this);
+	Newmark(rhs, out, dt, gamma, beta);
+	return out;
+}
 
-	if (lines.size() != rhs.lines.size())
-		throw moordyn::invalid_value_error("Invalid input size");
-	out.lines.reserve(lines.size());
+void
+DMoorDynStateDt::Newmark(const DMoorDynStateDt& rhs,
+                         DMoorDynStateDt& out,
+                         const real& dt,
+                         real gamma,
+                         real beta) const
+{
+	check_layout(*this, rhs);
+	check_layout(*this, out);
 	for (unsigned int i = 0; i < lines.size(); i++)
-		out.lines.push_back(lines[i].Newmark(rhs.lines[i], dt, gamma, beta));
-	if (points.size() != rhs.points.size())
-		throw moordyn::invalid_value_error("Invalid input size");
-	out.points.reserve(points.size());
+		lines[i].Newmark(rhs.lines[i], out.lines[i], dt, gamma, beta);
 	for (unsigned int i = 0; i < points.size(); i++)
-		out.points.push_back(points[i].Newmark(rhs.points[i], dt, gamma, beta));
-	if (rods.size() != rhs.rods.size())
-		throw moordyn::invalid_value_error("Invalid input size");
-	out.rods.reserve(rods.size());
+		points[i].Newmark(rhs.points[i], out.points[i], dt, gamma, beta);
 	for (unsigned int i = 0; i < rods.size(); i++)
-		out.rods.push_back(rods[i].Newmark(rhs.rods[i], dt, gamma, beta));
-	if (bodies.size() != rhs.bodies.size())
-		throw moordyn::invalid_value_error("Invalid input size");
-	out.bodies.reserve(bodies.size());
+		rods[i].Newmark(rhs.rods[i], out.rods[i], dt, gamma, beta);
 	for (unsigned int i = 0; i < bodies.size(); i++)
-		out.bodies.push_back(bodies[i].Newmark(rhs.bodies[i], dt, gamma, beta));
-
-	return out;
+		bodies[i].Newmark(rhs.bodies[i], out.bodies[i], dt, gamma, beta);
 }
 
 DMoorDynStateDt
 DMoorDynStateDt::Wilson(const DMoorDynStateDt& rhs,
                         const real& tau,
-                        const real& dt)
+                        const real& dt) const
 {
-	DMoorDynStateDt out;
+	DMoorDynStateDt out(*this);
+	Wilson(rhs, out, tau, dt);
+	return out;
+}
 
-	if (lines.size() != rhs.lines.size())
-		throw moordyn::invalid_value_error("Invalid input size");
-	out.lines.reserve(lines.size());
+void
+DMoorDynStateDt::Wilson(const DMoorDynStateDt& rhs,
+                        DMoorDynStateDt& out,
+                        const real& tau,
+                        const real& dt) const
+{
+	check_layout(*this, rhs);
+	check_layout(*this, out);
 	for (unsigned int i = 0; i < lines.size(); i++)
-		out.lines.push_back(lines[i].Wilson(rhs.lines[i], tau, dt));
-	if (points.size() != rhs.points.size())
-		throw moordyn::invalid_value_error("Invalid input size");
-	out.points.reserve(points.size());
+		lines[i].Wilson(rhs.lines[i], out.lines[i], tau, dt);
 	for (unsigned int i = 0; i < points.size(); i++)
-		out.points.push_back(points[i].Wilson(rhs.points[i], tau, dt));
-	if (rods.size() != rhs.rods.size())
-		throw moordyn::invalid_value_error("Invalid input size");
-	out.rods.reserve(rods.size());
+		points[i].Wilson(rhs.points[i], out.points[i], tau, dt);
 	for (unsigned int i = 0; i < rods.size(); i++)
-		out.rods.push_back(rods[i].Wilson(rhs.rods[i], tau, dt));
-	if (bodies.size() != rhs.bodies.size())
-		throw moordyn::invalid_value_error("Invalid input size");
-	out.bodies.reserve(bodies.size());
+		rods[i].Wilson(rhs.rods[i], out.rods[i], tau, dt);
 	for (unsigned int i = 0; i < bodies.size(); i++)
-		out.bodies.push_back(bodies[i].Wilson(rhs.bodies[i], tau, dt));
-
-	return out;
+		bodies[i].Wilson(rhs.bodies[i], out.bodies[i], tau, dt);
 }
 
 void
 DMoorDynStateDt::Mix(const DMoorDynStateDt& visitor, const real& f)
 {
-	for (unsigned int i = 0; i < lines.size(); i++)
-		lines[i].Mix(visitor.lines[i], f);
-	for (unsigned int i = 0; i < points.size(); i++)
-		points[i].Mix(visitor.points[i], f);
-	for (unsigned int i = 0; i < rods.size(); i++)
-		rods[i].Mix(visitor.rods[i], f);
-	for (unsigned int i = 0; i < bodies.size(); i++)
-		bodies[i].Mix(visitor.bodies[i], f);
+	_data = _data * (1.0 - f) + visitor._data * f;
 }
 
 } // ::moordyn
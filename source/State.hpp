@@ -36,24 +36,37 @@
 
 #include "Misc.hpp"
 #include <vector>
-#include <string>
-#include <sstream>
+#include <array>
+#include <utility>
 
 namespace moordyn {
 
 /** @class StateVar Time.hpp
  * @brief Generic state variables
  *
- * This is holding the position and velocities
+ * This is holding the position and velocities. The state variables are not
+ * owning their memory, but they are just views of a larger contiguous buffer,
+ * see moordyn::StateBuffer
  */
 template<typename T, typename V = T>
 class StateVar
 {
   public:
+	/** @brief Constructor
+	 * @param pos_ptr The memory where the positions are stored
+	 * @param vel_ptr The memory where the velocities are stored
+	 * @param n The number of nodes, for lines. 1 otherwise
+	 */
+	StateVar(real* pos_ptr, real* vel_ptr, unsigned int n = 1)
+	  : pos(pos_ptr, T::RowsAtCompileTime, n)
+	  , vel(vel_ptr, V::RowsAtCompileTime, n)
+	{
+	}
+
 	/// The position
-	T pos;
+	Eigen::Map<T> pos;
 	/// The velocity
-	V vel;
+	Eigen::Map<V> vel;
 
 	/** @brief Give a string representation of the state variables
 	 *
@@ -63,6 +76,8 @@ class StateVar
 	string AsString() const;
 
 	/** @brief Copy operator
+	 *
+	 * The values are copied, not the views
 	 * @param visitor The entity to copy
 	 */
 	StateVar<T, V>& operator=(const StateVar<T, V>& visitor)
@@ -71,41 +86,33 @@ class StateVar
 		vel = visitor.vel;
 		return *this;
 	}
-
-	/** @brief Sum operator
-	 * @param visitor The entity to sum
-	 */
-	StateVar<T, V> operator+(const StateVar<T, V>& visitor);
-
-	/** @brief Sum operator
-	 * @param visitor The entity to sum
-	 */
-	StateVar<T, V> operator-(const StateVar<T, V>& visitor);
-
-	/** @brief Mix this state with another one
-	 *
-	 * This can be used as a relaxation method when looking for stationary
-	 * solutions
-	 * @param visitor The other state
-	 * @param f The mix factor. If 0.0, the state is not altered at all. If 1.0
-	 * the state is completely replaced by the @p visitor
-	 */
-	void Mix(const StateVar<T, V>& visitor, const real& f);
 };
 
 /** @class StateVarDeriv Time.hpp
  * @brief Generic state variables derivative
  *
- * This is holding the velocities and accelerations
+ * This is holding the velocities and accelerations. As moordyn::StateVar,
+ * these are views of a larger contiguous buffer
  */
 template<class T, class V = T>
 class StateVarDeriv
 {
   public:
+	/** @brief Constructor
+	 * @param vel_ptr The memory where the velocities are stored
+	 * @param acc_ptr The memory where the accelerations are stored
+	 * @param n The number of nodes, for lines. 1 otherwise
+	 */
+	StateVarDeriv(real* vel_ptr, real* acc_ptr, unsigned int n = 1)
+	  : vel(vel_ptr, T::RowsAtCompileTime, n)
+	  , acc(acc_ptr, V::RowsAtCompileTime, n)
+	{
+	}
+
 	/// The velocity
-	T vel;
+	Eigen::Map<T> vel;
 	/// The acceleration
-	V acc;
+	Eigen::Map<V> acc;
 
 	/** @brief Give a string representation of the state variables
 	 *
@@ -115,6 +122,8 @@ class StateVarDeriv
 	string AsString() const;
 
 	/** @brief Copy operator
+	 *
+	 * The values are copied, not the views
 	 * @param visitor The entity to copy
 	 */
 	StateVarDeriv<T, V>& operator=(const StateVarDeriv<T, V>& visitor)
@@ -124,22 +133,6 @@ class StateVarDeriv
 		return *this;
 	}
 
-	/** @brief Integrate in time
-	 * @param dt The time step
-	 * @return The state variables increment
-	 */
-	StateVar<T, V> operator*(const real& dt);
-
-	/** @brief Sum operator
-	 * @param visitor The entity to sum
-	 */
-	StateVarDeriv<T, V> operator+(const StateVarDeriv<T, V>& visitor);
-
-	/** @brief Subtract operator
-	 * @param visitor The entity to subtract
-	 */
-	StateVarDeriv<T, V> operator-(const StateVarDeriv<T, V>& visitor);
-
 	/** @brief Transform the variation rate to a stationary case
 	 *
 	 * In MoorDyn the states variation rates are called velocity and
@@ -172,14 +165,16 @@ class StateVarDeriv
 	 *                        \gamma \dot{u(t_{n+1})}) \f]
 	 *
 	 * @param visitor The acceleration at the next time step
+	 * @param out The output. It can be this same object
 	 * @param dt Time step.
 	 * @param gamma The Newmark gamma factor.
 	 * @param beta Time Newmark beta factor.
 	 */
-	StateVarDeriv<T, V> Newmark(const StateVarDeriv<T, V>& visitor,
-	                            const real& dt,
-	                            real gamma = 0.5,
-	                            real beta = 0.25);
+	void Newmark(const StateVarDeriv<T, V>& visitor,
+	             StateVarDeriv<T, V>& out,
+	             const real& dt,
+	             real gamma = 0.5,
+	             real beta = 0.25) const;
 
 	/** @brief Carry out a Wilson step
 	 *
@@ -198,29 +193,21 @@ class StateVarDeriv
 	 * Note that \f$ \tau \f$ can be smaller than \f$ \theta \Delta t \f$.
 	 *
 	 * @param visitor The acceleration at the next time step
+	 * @param out The output. It can be this same object
 	 * @param tau Time advancing, \f$ \tau \f$.
 	 * @param dt Enlarged time step, \f$ \theta \Delta t \f$.
 	 */
-	StateVarDeriv<T, V> Wilson(const StateVarDeriv<T, V>& visitor,
-	                           const real& tau,
-	                           const real& dt);
-
-	/** @brief Mix this state variation rate with another one
-	 *
-	 * This can be used as a relaxation method when looking for stationary
-	 * solutions
-	 * @param visitor The other state variation rate
-	 * @param f The mix factor. If 0.0, the state is not altered at all. If 1.0
-	 * the state is completely replaced by the @p visitor
-	 */
-	void Mix(const StateVarDeriv<T, V>& visitor, const real& f);
+	void Wilson(const StateVarDeriv<T, V>& visitor,
+	            StateVarDeriv<T, V>& out,
+	            const real& tau,
+	            const real& dt) const;
 };
 
 /// The state variables for lines
-typedef StateVar<std::vector<vec>> LineState;
+typedef StateVar<Eigen::Matrix3Xr> LineState;
 
 /// The state variables derivative for lines
-typedef StateVarDeriv<std::vector<vec>> DLineStateDt;
+typedef StateVarDeriv<Eigen::Matrix3Xr> DLineStateDt;
 
 /// The state variables for points
 typedef StateVar<vec> PointState;
@@ -228,39 +215,354 @@ typedef StateVar<vec> PointState;
 /// The state variables derivative for points
 typedef StateVarDeriv<vec> DPointStateDt;
 
-/// The state variables for rods
-typedef StateVar<XYZQuat, vec6> RodState;
+/// The state variables for rods, where the position is the one returned by
+/// moordyn::XYZQuat::toVec7()
+typedef StateVar<vec7, vec6> RodState;
 
 /// The state variables derivative for rods
-typedef StateVarDeriv<XYZQuat, vec6> DRodStateDt;
+typedef StateVarDeriv<vec7, vec6> DRodStateDt;
 
 /// The state variables for bodies
-typedef StateVar<XYZQuat, vec6> BodyState;
+typedef StateVar<vec7, vec6> BodyState;
 
 /// The state variables derivative for bodies
-typedef StateVarDeriv<XYZQuat, vec6> DBodyStateDt;
+typedef StateVarDeriv<vec7, vec6> DBodyStateDt;
 
-/** @class MoorDynState Time.hpp
- * @brief The collection of state variables of the whole system
- * @attention New state variables will be added to implement visco-elasticity
- * and VIV on a close future. That will break the serialization and
- * deserialization (see moordyn::io::IO)
+/** @class StateBuffer State.hpp
+ * @brief Contiguous storage of the state variables of the whole system
+ *
+ * All the state variables are stored on a single buffer, so the operations
+ * involving the whole system state are just vector operations. The first
+ * half of the buffer is storing the first variable of each entity, i.e.
+ * the position or the velocity, and the second half the second variable,
+ * i.e. the velocity or the acceleration. Within each half, the lines come
+ * first, followed by the points, the rods and finally the bodies.
+ *
+ * The entities, StateBuffer::lines, StateBuffer::points, StateBuffer::rods and
+ * StateBuffer::bodies are just views of the buffer
+ * @note The buffer is reallocated when entities are added or removed, so the
+ * views shall not be kept along those operations
  */
-class MoorDynState
+template<class L, class P, class R, class B>
+class StateBuffer
 {
   public:
 	/// The states of the lines
-	std::vector<LineState> lines;
+	std::vector<L> lines;
 
 	/// The states of the points
-	std::vector<PointState> points;
+	std::vector<P> points;
 
 	/// The states of the rods
-	std::vector<RodState> rods;
+	std::vector<R> rods;
 
 	/// The states of the bodies
-	std::vector<BodyState> bodies;
+	std::vector<B> bodies;
 
+	/** @brief Default constructor
+	 */
+	StateBuffer()
+	  : _n_points(0)
+	  , _n_rods(0)
+	  , _n_bodies(0)
+	  , _n_half(0)
+	{
+	}
+
+	/** @brief Copy constructor
+	 *
+	 * The views are created for the new buffer
+	 * @param visitor The entity to copy
+	 */
+	StateBuffer(const StateBuffer<L, P, R, B>& visitor)
+	  : _lines_n(visitor._lines_n)
+	  , _n_points(visitor._n_points)
+	  , _n_rods(visitor._n_rods)
+	  , _n_bodies(visitor._n_bodies)
+	  , _n_half(visitor._n_half)
+	  , _data(visitor._data)
+	{
+		Remap();
+	}
+
+	/** @brief Copy operator
+	 *
+	 * The already allocated memory is reused, so no allocations are carried
+	 * out if the sizes of both entities already match
+	 * @param visitor The entity to copy
+	 */
+	StateBuffer<L, P, R, B>& operator=(const StateBuffer<L, P, R, B>& visitor)
+	{
+		Reshape(visitor);
+		_data = visitor._data;
+		return *this;
+	}
+
+	/** @brief Get the whole buffer
+	 * @return The buffer
+	 */
+	inline Eigen::Ref<Eigen::VectorXr> Data() { return _data; }
+
+	/** @brief Get the whole buffer
+	 * @return The buffer
+	 */
+	inline const Eigen::VectorXr& Data() const { return _data; }
+
+	/** @brief Get the first half of the buffer, i.e. the positions for the
+	 * states and the velocities for the states derivatives
+	 * @return The first half of the buffer
+	 */
+	inline auto Head() { return _data.head(_n_half); }
+
+	/** @brief Get the first half of the buffer, i.e. the positions for the
+	 * states and the velocities for the states derivatives
+	 * @return The first half of the buffer
+	 */
+	inline auto Head() const { return _data.head(_n_half); }
+
+	/** @brief Get the second half of the buffer, i.e. the velocities for the
+	 * states and the accelerations for the states derivatives
+	 * @return The second half of the buffer
+	 */
+	inline auto Tail() { return _data.tail(_data.size() - _n_half); }
+
+	/** @brief Get the second half of the buffer, i.e. the velocities for the
+	 * states and the accelerations for the states derivatives
+	 * @return The second half of the buffer
+	 */
+	inline auto Tail() const { return _data.tail(_data.size() - _n_half); }
+
+	/** @brief Get the number of nodes of each line
+	 * @return The number of nodes of each line
+	 */
+	inline const std::vector<unsigned int>& LinesN() const { return _lines_n; }
+
+	/** @brief Check whether other state has the same memory layout
+	 * @param visitor The other state
+	 * @return true if both states have the same layout, false otherwise
+	 */
+	template<class L2, class P2, class R2, class B2>
+	inline bool SameLayout(const StateBuffer<L2, P2, R2, B2>& visitor) const
+	{
+		return (_lines_n == visitor.LinesN()) &&
+		       (_n_points == visitor.points.size()) &&
+		       (_n_rods == visitor.rods.size()) &&
+		       (_n_bodies == visitor.bodies.size());
+	}
+
+	/** @brief Set the same memory layout than other state
+	 *
+	 * If the layout is changed, the values are lost
+	 * @param visitor The other state
+	 */
+	template<class L2, class P2, class R2, class B2>
+	void Reshape(const StateBuffer<L2, P2, R2, B2>& visitor)
+	{
+		if (SameLayout(visitor))
+			return;
+		_lines_n = visitor.LinesN();
+		_n_points = visitor.points.size();
+		_n_rods = visitor.rods.size();
+		_n_bodies = visitor.bodies.size();
+		Resize();
+	}
+
+	/** @brief Add a line
+	 * @param n The number of nodes
+	 */
+	void AddLine(unsigned int n)
+	{
+		Insert(_lines_n.size(), [this, n]() { _lines_n.push_back(n); });
+	}
+
+	/** @brief Add a point
+	 */
+	void AddPoint()
+	{
+		Insert(_lines_n.size() + _n_points, [this]() { _n_points++; });
+	}
+
+	/** @brief Add a rod
+	 */
+	void AddRod()
+	{
+		Insert(_lines_n.size() + _n_points + _n_rods, [this]() { _n_rods++; });
+	}
+
+	/** @brief Add a body
+	 */
+	void AddBody()
+	{
+		Insert(_lines_n.size() + _n_points + _n_rods + _n_bodies,
+		       [this]() { _n_bodies++; });
+	}
+
+	/** @brief Remove a line
+	 * @param i The index of the line
+	 */
+	void RemoveLine(unsigned int i)
+	{
+		Erase(i, [this, i]() { _lines_n.erase(_lines_n.begin() + i); });
+	}
+
+	/** @brief Remove a point
+	 * @param i The index of the point
+	 */
+	void RemovePoint(unsigned int i)
+	{
+		Erase(_lines_n.size() + i, [this]() { _n_points--; });
+	}
+
+	/** @brief Remove a rod
+	 * @param i The index of the rod
+	 */
+	void RemoveRod(unsigned int i)
+	{
+		Erase(_lines_n.size() + _n_points + i, [this]() { _n_rods--; });
+	}
+
+	/** @brief Remove a body
+	 * @param i The index of the body
+	 */
+	void RemoveBody(unsigned int i)
+	{
+		Erase(_lines_n.size() + _n_points + _n_rods + i,
+		      [this]() { _n_bodies--; });
+	}
+
+  protected:
+	/// The number of nodes of each line
+	std::vector<unsigned int> _lines_n;
+
+	/// The number of points
+	unsigned int _n_points;
+
+	/// The number of rods
+	unsigned int _n_rods;
+
+	/// The number of bodies
+	unsigned int _n_bodies;
+
+	/// The size of the first half of the buffer
+	unsigned int _n_half;
+
+	/// The buffer
+	Eigen::VectorXr _data;
+
+  private:
+	/** @brief Get the offsets of each entity on both halves of the buffer
+	 * @return The offsets on the first and second halves. The last item is
+	 * the size of each half
+	 */
+	std::pair<std::vector<unsigned int>, std::vector<unsigned int>> Offsets()
+	  const
+	{
+		std::vector<unsigned int> head(1, 0), tail(1, 0);
+		auto add = [&head, &tail](unsigned int n_head, unsigned int n_tail) {
+			head.push_back(head.back() + n_head);
+			tail.push_back(tail.back() + n_tail);
+		};
+		for (auto n : _lines_n)
+			add(3 * n, 3 * n);
+		for (unsigned int i = 0; i < _n_points; i++)
+			add(3, 3);
+		for (unsigned int i = 0; i < _n_rods + _n_bodies; i++)
+			add(7, 6);
+		return { head, tail };
+	}
+
+	/** @brief Allocate the buffer and create the views
+	 */
+	void Resize()
+	{
+		const auto [head, tail] = Offsets();
+		_n_half = head.back();
+		_data.setZero(head.back() + tail.back());
+		Remap();
+	}
+
+	/** @brief Create the views of each entity
+	 */
+	void Remap()
+	{
+		const auto [head, tail] = Offsets();
+		real* h = _data.data();
+		real* t = h + _n_half;
+		unsigned int j = 0;
+		lines.clear();
+		lines.reserve(_lines_n.size());
+		for (auto n : _lines_n) {
+			lines.emplace_back(h + head[j], t + tail[j], n);
+			j++;
+		}
+		points.clear();
+		points.reserve(_n_points);
+		for (unsigned int i = 0; i < _n_points; i++, j++)
+			points.emplace_back(h + head[j], t + tail[j]);
+		rods.clear();
+		rods.reserve(_n_rods);
+		for (unsigned int i = 0; i < _n_rods; i++, j++)
+			rods.emplace_back(h + head[j], t + tail[j]);
+		bodies.clear();
+		bodies.reserve(_n_bodies);
+		for (unsigned int i = 0; i < _n_bodies; i++, j++)
+			bodies.emplace_back(h + head[j], t + tail[j]);
+	}
+
+	/** @brief Insert an entity, preserving the values of the other ones
+	 * @param j The index of the new entity, counting all of them
+	 * @param add Function to register the new entity on the layout
+	 */
+	template<typename F>
+	void Insert(unsigned int j, F add)
+	{
+		const auto [head0, tail0] = Offsets();
+		const Eigen::VectorXr data0 = _data;
+		const unsigned int n_half0 = _n_half;
+		add();
+		Resize();
+		const auto [head, tail] = Offsets();
+		_data.head(head[j]) = data0.head(head0[j]);
+		_data.segment(head[j + 1], _n_half - head[j + 1]) =
+		    data0.segment(head0[j], n_half0 - head0[j]);
+		_data.segment(_n_half, tail[j]) = data0.segment(n_half0, tail0[j]);
+		_data.tail(tail.back() - tail[j + 1]) =
+		    data0.tail(tail0.back() - tail0[j]);
+	}
+
+	/** @brief Remove an entity, preserving the values of the other ones
+	 * @param j The index of the entity, counting all of them
+	 * @param remove Function to unregister the entity from the layout
+	 */
+	template<typename F>
+	void Erase(unsigned int j, F remove)
+	{
+		const auto [head0, tail0] = Offsets();
+		const Eigen::VectorXr data0 = _data;
+		const unsigned int n_half0 = _n_half;
+		remove();
+		Resize();
+		_data.head(head0[j]) = data0.head(head0[j]);
+		_data.segment(head0[j], _n_half - head0[j]) =
+		    data0.segment(head0[j + 1], n_half0 - head0[j + 1]);
+		_data.segment(_n_half, tail0[j]) = data0.segment(n_half0, tail0[j]);
+		_data.tail(_data.size() - _n_half - tail0[j]) =
+		    data0.tail(tail0.back() - tail0[j + 1]);
+	}
+};
+
+class DMoorDynStateDt;
+
+/** @class MoorDynState Time.hpp
+ * @brief The collection of state variables of the whole system
+ * @attention New state variables will be added to implement visco-elasticity
+ * and VIV on a close future. That will break the serialization and
+ * deserialization (see moordyn::io::IO)
+ */
+class MoorDynState
+  : public StateBuffer<LineState, PointState, RodState, BodyState>
+{
+  public:
 	/** @brief Give a string representation of the state variables
 	 *
 	 * Useful for debugging purposes
@@ -268,20 +570,27 @@ class MoorDynState
 	 */
 	string AsString() const;
 
-	/** @brief Copy operator
-	 * @param visitor The entity to copy
+	/** @brief Get the positions of all the entities
+	 * @return The positions
 	 */
-	MoorDynState& operator=(const MoorDynState& visitor);
+	inline auto Pos() { return Head(); }
 
-	/** @brief Sum operator
-	 * @param visitor The entity to sum
+	/** @brief Get the velocities of all the entities
+	 * @return The velocities
 	 */
-	MoorDynState operator+(const MoorDynState& visitor);
+	inline auto Vel() { return Tail(); }
 
 	/** @brief Sum operator
 	 * @param visitor The entity to sum
+	 * @throw moordyn::invalid_value_error If the layouts do not match
+	 */
+	MoorDynState operator+(const MoorDynState& visitor) const;
+
+	/** @brief Subtract operator
+	 * @param visitor The entity to subtract
+	 * @throw moordyn::invalid_value_error If the layouts do not match
 	 */
-	MoorDynState operator-(const MoorDynState& visitor);
+	MoorDynState operator-(const MoorDynState& visitor) const;
 
 	/** @brief Mix this state with another one
 	 *
@@ -301,20 +610,9 @@ class MoorDynState
  * deserialization (see moordyn::io::IO)
  */
 class DMoorDynStateDt
+  : public StateBuffer<DLineStateDt, DPointStateDt, DRodStateDt, DBodyStateDt>
 {
   public:
-	/// The state derivatives of the lines
-	std::vector<DLineStateDt> lines;
-
-	/// The state derivatives of the points
-	std::vector<DPointStateDt> points;
-
-	/// The state derivatives of the rods
-	std::vector<DRodStateDt> rods;
-
-	/// The state derivatives of the bodies
-	std::vector<DBodyStateDt> bodies;
-
 	/** @brief Give a string representation of the state variables
 	 *
 	 * Useful for debugging purposes
@@ -322,26 +620,38 @@ class DMoorDynStateDt
 	 */
 	string AsString() const;
 
-	/** @brief Copy operator
-	 * @param visitor The entity to copy
+	/** @brief Get the velocities of all the entities
+	 * @return The velocities
+	 */
+	inline auto Vel() { return Head(); }
+
+	/** @brief Get the accelerations of all the entities
+	 * @return The accelerations
+	 */
+	inline auto Acc() { return Tail(); }
+
+	/** @brief Get the accelerations of all the entities
+	 * @return The accelerations
 	 */
-	DMoorDynStateDt& operator=(const DMoorDynStateDt& visitor);
+	inline auto Acc() const { return Tail(); }
 
 	/** @brief Integrate in time
 	 * @param dt The time step
 	 * @return The state variables increment
 	 */
-	MoorDynState operator*(const real& dt);
+	MoorDynState operator*(const real& dt) const;
 
 	/** @brief Sum operator
 	 * @param visitor The entity to sum
+	 * @throw moordyn::invalid_value_error If the layouts do not match
 	 */
-	DMoorDynStateDt operator+(const DMoorDynStateDt& visitor);
+	DMoorDynStateDt operator+(const DMoorDynStateDt& visitor) const;
 
-	/** @brief Sum operator
-	 * @param visitor The entity to sum
+	/** @brief Subtract operator
+	 * @param visitor The entity to subtract
+	 * @throw moordyn::invalid_value_error If the layouts do not match
 	 */
-	DMoorDynStateDt operator-(const DMoorDynStateDt& visitor);
+	DMoorDynStateDt operator-(const DMoorDynStateDt& visitor) const;
 
 	/** @brief Transform the variation rate to a stationary case
 	 *
@@ -381,7 +691,25 @@ class DMoorDynStateDt
 	DMoorDynStateDt Newmark(const DMoorDynStateDt& visitor,
 	                        const real& dt,
 	                        real gamma = 0.5,
-	                        real beta = 0.25);
+	                        real beta = 0.25) const;
+
+	/** @brief Carry out a Newmark step, storing the result on an already
+	 * allocated state variables derivative
+	 *
+	 * This is the same than Newmark(), but without allocating memory, as far
+	 * as @p out has already the right sizes
+	 * @param visitor The acceleration at the next time step
+	 * @param out The output. It can be this same object
+	 * @param dt Time step.
+	 * @param gamma The Newmark gamma factor.
+	 * @param beta Time Newmark beta factor.
+	 * @throw moordyn::invalid_value_error If the sizes do not match
+	 */
+	void Newmark(const DMoorDynStateDt& visitor,
+	             DMoorDynStateDt& out,
+	             const real& dt,
+	             real gamma = 0.5,
+	             real beta = 0.25) const;
 
 	/** @brief Carry out a Wilson step
 	 *
@@ -405,7 +733,23 @@ class DMoorDynStateDt
 	 */
 	DMoorDynStateDt Wilson(const DMoorDynStateDt& visitor,
 	                       const real& tau,
-	                       const real& dt);
+	                       const real& dt) const;
+
+	/** @brief Carry out a Wilson step, storing the result on an already
+	 * allocated state variables derivative
+	 *
+	 * This is the same than Wilson(), but without allocating memory, as far
+	 * as @p out has already the right sizes
+	 * @param visitor The acceleration at the next time step
+	 * @param out The output. It can be this same object
+	 * @param tau Time advancing, \f$ \tau \f$.
+	 * @param dt Enlarged time step, \f$ \theta \Delta t \f$.
+	 * @throw moordyn::invalid_value_error If the sizes do not match
+	 */
+	void Wilson(const DMoorDynStateDt& visitor,
+	            DMoorDynStateDt& out,
+	            const real& tau,
+	            const real& dt) const;
 
 	/** @brief Mix this state variation rate with another one
 	 *
@@ -418,6 +762,27 @@ class DMoorDynStateDt
 	void Mix(const DMoorDynStateDt& visitor, const real& f);
 };
 
+namespace detail {
+
+/** @brief Implementation of moordyn::butcher_row()
+ *
+ * The derivatives are unrolled at compile time, so a single fused vector
+ * operation is carried out
+ */
+template<unsigned int N, std::size_t... I>
+inline void
+butcher_row(MoorDynState& out_state,
+            const MoorDynState& start_state,
+            const std::array<real, N>& scales,
+            const std::array<const DMoorDynStateDt* const, N>& derivs,
+            std::index_sequence<I...>)
+{
+	out_state.Data() =
+	    (start_state.Data() + ... + (scales[I] * derivs[I]->Data()));
+}
+
+} // ::detail
+
 /**
  * @brief Do the computation for a row of a Butcher Tableau for an explicit
  * integrator
@@ -426,6 +791,9 @@ class DMoorDynStateDt
  * This function essentially computes:
  * out_state = start_state + sum(scales[i] * derivs[i] for i = 1:N)
  *
+ * Since the states and their derivatives share the same memory layout, the
+ * whole system is updated at once.
+ *
  * out_state and start_state can be the same state.
  *
  * @tparam N Number of columns in the row
@@ -435,57 +803,15 @@ class DMoorDynStateDt
  * @param derivs State derivative values
  */
 template<unsigned int N>
-constexpr void
+inline void
 butcher_row(MoorDynState& out_state,
             const MoorDynState& start_state,
             const std::array<real, N>& scales,
             const std::array<const DMoorDynStateDt* const, N>& derivs)
 {
 	static_assert(N > 0, "butcher_row must have at least one state deriv");
-
-	for (unsigned int lineIdx = 0; lineIdx < out_state.lines.size();
-	     lineIdx++) {
-		auto& line = out_state.lines[lineIdx];
-		for (unsigned int i = 0; i < line.pos.size(); i++) {
-			line.pos[i] = start_state.lines[lineIdx].pos[i];
-			line.vel[i] = start_state.lines[lineIdx].vel[i];
-			for (unsigned int j = 0; j < N; j++) {
-				line.pos[i] += scales[j] * derivs[j]->lines[lineIdx].vel[i];
-				line.vel[i] += scales[j] * derivs[j]->lines[lineIdx].acc[i];
-			}
-		}
-	}
-
-	for (unsigned int pointIdx = 0; pointIdx < out_state.points.size();
-	     pointIdx++) {
-		auto& point = out_state.points[pointIdx];
-		point.pos = start_state.points[pointIdx].pos;
-		point.vel = start_state.points[pointIdx].vel;
-		for (unsigned int j = 0; j < N; j++) {
-			point.pos += scales[j] * derivs[j]->points[pointIdx].vel;
-			point.vel += scales[j] * derivs[j]->points[pointIdx].acc;
-		}
-	}
-
-	for (unsigned int rodIdx = 0; rodIdx < out_state.rods.size(); rodIdx++) {
-		auto& rod = out_state.rods[rodIdx];
-		rod.pos = start_state.rods[rodIdx].pos;
-		rod.vel = start_state.rods[rodIdx].vel;
-		for (unsigned int j = 0; j < N; j++) {
-			rod.pos = rod.pos + derivs[j]->rods[rodIdx].vel * scales[j];
-			rod.vel = rod.vel + scales[j] * derivs[j]->rods[rodIdx].acc;
-		}
-	}
-	for (unsigned int bodyIdx = 0; bodyIdx < out_state.bodies.size();
-	     bodyIdx++) {
-		auto& body = out_state.bodies[bodyIdx];
-		body.pos = start_state.bodies[bodyIdx].pos;
-		body.vel = start_state.bodies[bodyIdx].vel;
-		for (unsigned int j = 0; j < N; j++) {
-			body.pos = body.pos + derivs[j]->bodies[bodyIdx].vel * scales[j];
-			body.vel = body.vel + scales[j] * derivs[j]->bodies[bodyIdx].acc;
-		}
-	}
+	detail::butcher_row<N>(
+	    out_state, start_state, scales, derivs, std::make_index_sequence<N>{});
 }
 
 } // ::moordyn
@@ -32,6 +32,8 @@
 #include "State.hpp"
 #include "Waves.hpp"
 #include <sstream>
+#include <cmath>
+#include <limits>
 
 using namespace std;
 
@@ -39,7 +41,7 @@ namespace moordyn {
 
 template<unsigned int NSTATE, unsigned int NDERIV>
 void
-TimeSchemeBase<NSTATE, NDERIV>::Update(real t_local, unsigned int substep)
+TimeSchemeBase<NSTATE, NDERIV>::UpdateCoupled(real t_local)
 {
 	ground->updateFairlead(this->t);
 
@@ -62,11 +64,19 @@ TimeSchemeBase<NSTATE, NDERIV>::Update(real t_local, unsigned int substep)
 	for (auto obj : lines) {
 		obj->updateUnstretchedLength(t_local);
 	}
+}
+
+template<unsigned int NSTATE, unsigned int NDERIV>
+void
+TimeSchemeBase<NSTATE, NDERIV>::Update(real t_local, unsigned int substep)
+{
+	UpdateCoupled(t_local);
 
 	for (unsigned int i = 0; i < bodies.size(); i++) {
 		if ((bodies[i]->type != Body::FREE) && (bodies[i]->type != Body::CPLDPIN))
 			continue;
-		bodies[i]->setState(r[substep].bodies[i].pos, r[substep].bodies[i].vel);
+		bodies[i]->setState(XYZQuat::fromVec7(r[substep].bodies[i].pos),
+		                      r[substep].bodies[i].vel);
 	}
 
 	for (unsigned int i = 0; i < rods.size(); i++) {
@@ -74,7 +84,8 @@ TimeSchemeBase<NSTATE, NDERIV>::Update(real t_local, unsigned int substep)
 		if ((rods[i]->type != Rod::PINNED) && (rods[i]->type != Rod::CPLDPIN) &&
 		    (rods[i]->type != Rod::FREE))
 			continue;
-		rods[i]->setState(r[substep].rods[i].pos, r[substep].rods[i].vel);
+		rods[i]->setState(XYZQuat::fromVec7(r[substep].rods[i].pos),
+		                    r[substep].rods[i].vel);
 	}
 
 	for (unsigned int i = 0; i < points.size(); i++) {
@@ -95,11 +106,25 @@ TimeSchemeBase<NSTATE, NDERIV>::CalcStateDeriv(unsigned int substep)
 {
 	waves->updateWaves();
 
-	for (unsigned int i = 0; i < lines.size(); i++) {
-		if (!_calc_mask.lines[i])
-			continue;
-		lines[i]->getStateDeriv(rd[substep].lines[i].vel,
-		                        rd[substep].lines[i].acc);
+	if (pool) {
+		// The lines are independent, so we can compute them in parallel, using
+		// the number of nodes as an estimation of the cost
+		_lines_cost.resize(lines.size());
+		for (unsigned int i = 0; i < lines.size(); i++)
+			_lines_cost[i] = _calc_mask.lines[i] ? lines[i]->getN() + 1 : 0;
+		pool->Run(_lines_cost, [this, substep](unsigned int i) {
+			if (!_calc_mask.lines[i])
+				return;
+			lines[i]->getStateDeriv(rd[substep].lines[i].vel,
+			                        rd[substep].lines[i].acc);
+		});
+	} else {
+		for (unsigned int i = 0; i < lines.size(); i++) {
+			if (!_calc_mask.lines[i])
+				continue;
+			lines[i]->getStateDeriv(rd[substep].lines[i].vel,
+			                        rd[substep].lines[i].acc);
+		}
 	}
 
 	for (unsigned int i = 0; i < points.size(); i++) {
@@ -107,18 +132,29 @@ TimeSchemeBase<NSTATE, NDERIV>::CalcStateDeriv(unsigned int substep)
 			continue;
 		if (points[i]->type != Point::FREE)
 			continue;
-		std::tie(rd[substep].points[i].vel, rd[substep].points[i].acc) =
-		    points[i]->getStateDeriv();
+		const auto [vel, acc] = points[i]->getStateDeriv();
+		rd[substep].points[i].vel = vel;
+		rd[substep].points[i].acc = acc;
 	}
 
-	for (unsigned int i = 0; i < rods.size(); i++) {
+	auto rod_deriv = [this, substep](unsigned int i) {
 		if (!_calc_mask.rods[i])
-			continue;
+			return;
 		if ((rods[i]->type != Rod::PINNED) && (rods[i]->type != Rod::CPLDPIN) &&
 		    (rods[i]->type != Rod::FREE))
-			continue;
-		std::tie(rd[substep].rods[i].vel, rd[substep].rods[i].acc) =
-		    rods[i]->getStateDeriv();
+			return;
+		const auto [vel, acc] = rods[i]->getStateDeriv();
+		rd[substep].rods[i].vel = vel.toVec7();
+		rd[substep].rods[i].acc = acc;
+	};
+	if (pool) {
+		_rods_cost.resize(rods.size());
+		for (unsigned int i = 0; i < rods.size(); i++)
+			_rods_cost[i] = _calc_mask.rods[i] ? rods[i]->getN() + 1 : 0;
+		pool->Run(_rods_cost, rod_deriv);
+	} else {
+		for (unsigned int i = 0; i < rods.size(); i++)
+			rod_deriv(i);
 	}
 
 	for (unsigned int i = 0; i < bodies.size(); i++) {
@@ -126,8 +162,9 @@ TimeSchemeBase<NSTATE, NDERIV>::CalcStateDeriv(unsigned int substep)
 			continue;
 		if ((bodies[i]->type != Body::FREE) && (bodies[i]->type != Body::CPLDPIN))
 			continue;
-		std::tie(rd[substep].bodies[i].vel, rd[substep].bodies[i].acc) =
-		    bodies[i]->getStateDeriv();
+		const auto [vel, acc] = bodies[i]->getStateDeriv();
+		rd[substep].bodies[i].vel = vel.toVec7();
+		rd[substep].bodies[i].acc = acc;
 	}
 
 	for (auto obj : points) {
@@ -217,7 +254,8 @@ StationaryScheme::Step(real& dt)
 	}
 
 	r[1] = r[0];
-	r[0] = r[0] + rd[0] * new_dt;
+	// r[0] = r[0] + rd[0] * new_dt;
+	butcher_row<1>(r[0], r[0], { new_dt }, { &rd[0] });
 	t += dt;
 	Update(dt, 0);
 	TimeSchemeBase::Step(dt);
@@ -234,7 +272,8 @@ EulerScheme::Step(real& dt)
 {
 	Update(0.0, 0);
 	CalcStateDeriv(0);
-	r[0] = r[0] + rd[0] * dt;
+	// r[0] = r[0] + rd[0] * dt;
+	butcher_row<1>(r[0], r[0], { dt }, { &rd[0] });
 	t += dt;
 	Update(dt, 0);
 	TimeSchemeBase::Step(dt);
@@ -340,7 +379,8 @@ LocalEulerScheme::Step(real& dt)
 	SetCalcMask(dt);
 	Update(0.0, 0);
 	CalcStateDeriv(0);
-	r[0] = r[0] + rd[0] * dt;
+	// r[0] = r[0] + rd[0] * dt;
+	butcher_row<1>(r[0], r[0], { dt }, { &rd[0] });
 	t += dt;
 	Update(dt, 0);
 	TimeSchemeBase::Step(dt);
@@ -356,13 +396,15 @@ void
 HeunScheme::Step(real& dt)
 {
 	// Apply the latest knew derivative, as a predictor
-	r[0] = r[0] + rd[0] * dt;
+	// r[0] = r[0] + rd[0] * dt;
+	butcher_row<1>(r[0], r[0], { dt }, { &rd[0] });
 	rd[1] = rd[0];
 	// Compute the new derivative
 	Update(0.0, 0);
 	CalcStateDeriv(0);
 	// Correct the integration
-	r[0] = r[0] + (rd[0] - rd[1]) * (0.5 * dt);
+	// r[0] = r[0] + (rd[0] - rd[1]) * (0.5 * dt);
+	butcher_row<2>(r[0], r[0], { 0.5 * dt, -0.5 * dt }, { &rd[0], &rd[1] });
 
 	t += dt;
 	Update(dt, 0);
@@ -445,6 +487,528 @@ RK4Scheme::Step(real& dt)
 	TimeSchemeBase::Step(dt);
 }
 
+#ifndef ADAPTIVE_SAFETY
+#define ADAPTIVE_SAFETY 0.9
+#endif
+
+#ifndef ADAPTIVE_MAX_GROWTH
+#define ADAPTIVE_MAX_GROWTH 5.0
+#endif
+
+#ifndef ADAPTIVE_MIN_GROWTH
+#define ADAPTIVE_MIN_GROWTH 0.2
+#endif
+
+template<unsigned int NSTATE, unsigned int NDERIV>
+bool
+EmbeddedRKSchemeBase<NSTATE, NDERIV>::Accept(real& h,
+                                             const real& dt,
+                                             const real& err)
+{
+	real factor = ADAPTIVE_MAX_GROWTH;
+	if (err > 0.0)
+		factor = ADAPTIVE_SAFETY * pow(err, -1.0 / (_order + 1));
+
+	if (err <= 1.0) {
+		const real next = (std::min)(factor, ADAPTIVE_MAX_GROWTH) * h;
+		// If the step was shortened to reach the end of the outer time step,
+		// we shall not forget the time step we were able to take
+		_dt = (h >= dt) ? (std::max)(_dt, next) : next;
+		return true;
+	}
+
+	// NaN errors are rejected as well
+	h *= (std::max)(ADAPTIVE_MIN_GROWTH, (std::min)(factor, ADAPTIVE_SAFETY));
+	_dt = h;
+	if (h < (std::numeric_limits<real>::epsilon)() *
+	            (std::max)((real)1.0, std::abs(this->t))) {
+		this->LOGERR << "The time step became too small at t = " << this->t
+		             << " s (error = " << err << ")" << endl;
+		throw moordyn::unhandled_error("Time step too small");
+	}
+	return false;
+}
+
+template<unsigned int NSTATE, unsigned int NDERIV>
+void
+EmbeddedRKSchemeBase<NSTATE, NDERIV>::ComputeMaxDt()
+{
+	_dt_max = (std::numeric_limits<real>::max)();
+	for (auto obj : this->lines)
+		_dt_max = (std::min)(_dt_max, obj->cfl2dt(this->cfl));
+	for (auto obj : this->points)
+		_dt_max = (std::min)(_dt_max, obj->cfl2dt(this->cfl));
+	for (auto obj : this->rods)
+		_dt_max = (std::min)(_dt_max, obj->cfl2dt(this->cfl));
+	for (auto obj : this->bodies)
+		_dt_max = (std::min)(_dt_max, obj->cfl2dt(this->cfl));
+	_dt = 0.0;
+	_fsal = false;
+	this->LOGMSG << this->name << ": tolerance = " << this->tol
+	             << ", maximum dt = " << _dt_max << " s" << endl;
+}
+
+RK23Scheme::RK23Scheme(moordyn::Log* log, moordyn::WavesRef waves)
+  : EmbeddedRKSchemeBase(log, waves, 2)
+{
+	name = "3rd order adaptive Bogacki-Shampine Runge-Kutta";
+}
+
+void
+RK23Scheme::Step(real& dt)
+{
+	const real t0 = t;
+	real h = TrialDt(dt);
+
+	// k1
+	if (!FSAL()) {
+		Update(0.0, 0);
+		CalcStateDeriv(0);
+	}
+
+	while (true) {
+		// k2
+		t = t0 + 0.5 * h;
+		// r[1] = r[0] + rd[0] * (0.5 * h);
+		butcher_row<1>(r[1], r[0], { 0.5 * h }, { &rd[0] });
+		Update(0.5 * h, 1);
+		CalcStateDeriv(1);
+
+		// k3
+		t = t0 + 0.75 * h;
+		// r[1] = r[0] + rd[1] * (0.75 * h);
+		butcher_row<1>(r[1], r[0], { 0.75 * h }, { &rd[1] });
+		Update(0.75 * h, 1);
+		CalcStateDeriv(2);
+
+		// 3rd order solution, and k4 on top of it
+		t = t0 + h;
+		butcher_row<3>(r[1],
+		               r[0],
+		               { 2.0 / 9.0 * h, 1.0 / 3.0 * h, 4.0 / 9.0 * h },
+		               { &rd[0], &rd[1], &rd[2] });
+		Update(h, 1);
+		CalcStateDeriv(3);
+
+		// Embedded 2nd order solution
+		butcher_row<4>(r[2],
+		               r[1],
+		               { 5.0 / 72.0 * h,
+		                 -1.0 / 12.0 * h,
+		                 -1.0 / 9.0 * h,
+		                 1.0 / 8.0 * h },
+		               { &rd[0], &rd[1], &rd[2], &rd[3] });
+
+		if (Accept(h, dt, Error(r[0], r[1], r[2])))
+			break;
+	}
+
+	r[0] = r[1];
+	rd[0] = rd[3];
+	SetFSAL(true);
+	dt = h;
+	Update(dt, 0);
+	TimeSchemeBase::Step(dt);
+}
+
+RK45Scheme::RK45Scheme(moordyn::Log* log, moordyn::WavesRef waves)
+  : EmbeddedRKSchemeBase(log, waves, 4)
+{
+	name = "5th order adaptive Dormand-Prince Runge-Kutta";
+}
+
+void
+RK45Scheme::Step(real& dt)
+{
+	const real t0 = t;
+	real h = TrialDt(dt);
+
+	// k1
+	if (!FSAL()) {
+		Update(0.0, 0);
+		CalcStateDeriv(0);
+	}
+
+	while (true) {
+		// k2
+		t = t0 + 0.2 * h;
+		butcher_row<1>(r[1], r[0], { 0.2 * h }, { &rd[0] });
+		Update(0.2 * h, 1);
+		CalcStateDeriv(1);
+
+		// k3
+		t = t0 + 0.3 * h;
+		butcher_row<2>(r[1],
+		               r[0],
+		               { 3.0 / 40.0 * h, 9.0 / 40.0 * h },
+		               { &rd[0], &rd[1] });
+		Update(0.3 * h, 1);
+		CalcStateDeriv(2);
+
+		// k4
+		t = t0 + 0.8 * h;
+		butcher_row<3>(r[1],
+		               r[0],
+		               { 44.0 / 45.0 * h, -56.0 / 15.0 * h, 32.0 / 9.0 * h },
+		               { &rd[0], &rd[1], &rd[2] });
+		Update(0.8 * h, 1);
+		CalcStateDeriv(3);
+
+		// k5
+		t = t0 + 8.0 / 9.0 * h;
+		butcher_row<4>(r[1],
+		               r[0],
+		               { 19372.0 / 6561.0 * h,
+		                 -25360.0 / 2187.0 * h,
+		                 64448.0 / 6561.0 * h,
+		                 -212.0 / 729.0 * h },
+		               { &rd[0], &rd[1], &rd[2], &rd[3] });
+		Update(8.0 / 9.0 * h, 1);
+		CalcStateDeriv(4);
+
+		// k6
+		t = t0 + h;
+		butcher_row<5>(r[1],
+		               r[0],
+		               { 9017.0 / 3168.0 * h,
+		                 -355.0 / 33.0 * h,
+		                 46732.0 / 5247.0 * h,
+		                 49.0 / 176.0 * h,
+		                 -5103.0 / 18656.0 * h },
+		               { &rd[0], &rd[1], &rd[2], &rd[3], &rd[4] });
+		Update(h, 1);
+		CalcStateDeriv(5);
+
+		// 5th order solution, and k7 on top of it
+		butcher_row<5>(r[1],
+		               r[0],
+		               { 35.0 / 384.0 * h,
+		                 500.0 / 1113.0 * h,
+		                 125.0 / 192.0 * h,
+		                 -2187.0 / 6784.0 * h,
+		                 11.0 / 84.0 * h },
+		               { &rd[0], &rd[2], &rd[3], &rd[4], &rd[5] });
+		Update(h, 1);
+		CalcStateDeriv(6);
+
+		// Embedded 4th order solution
+		butcher_row<6>(r[2],
+		               r[1],
+		               { -71.0 / 57600.0 * h,
+		                 71.0 / 16695.0 * h,
+		                 -71.0 / 1920.0 * h,
+		                 17253.0 / 339200.0 * h,
+		                 -22.0 / 525.0 * h,
+		                 1.0 / 40.0 * h },
+		               { &rd[0], &rd[2], &rd[3], &rd[4], &rd[5], &rd[6] });
+
+		if (Accept(h, dt, Error(r[0], r[1], r[2])))
+			break;
+	}
+
+	r[0] = r[1];
+	rd[0] = rd[6];
+	SetFSAL(true);
+	dt = h;
+	Update(dt, 0);
+	TimeSchemeBase::Step(dt);
+}
+
+#ifndef MULTIRATE_MAX_SUBSTEPS
+#define MULTIRATE_MAX_SUBSTEPS 65536
+#endif
+
+/** @brief Get the number of substeps of an entity, which is a power of 2
+ * @param dt The time step
+ * @param dt0 The maximum time step of the entity
+ * @return The number of substeps
+ */
+inline unsigned int
+multirate_substeps(real dt, real dt0)
+{
+	unsigned int n = 1;
+	while ((n < MULTIRATE_MAX_SUBSTEPS) && (n * dt0 < dt))
+		n *= 2;
+	return n;
+}
+
+MultirateRK2Scheme::MultirateRK2Scheme(moordyn::Log* log,
+                                       moordyn::WavesRef waves)
+  : TimeSchemeBase(log, waves)
+  , _dt_max((std::numeric_limits<real>::max)())
+  , _ready(false)
+{
+	name = "2nd order Multirate Runge-Kutta";
+}
+
+void
+MultirateRK2Scheme::Init()
+{
+	TimeSchemeBase::Init();
+	ComputeDt();
+}
+
+void
+MultirateRK2Scheme::SetState(const MoorDynState& state, unsigned int i)
+{
+	TimeSchemeBase::SetState(state, i);
+	ComputeDt();
+}
+
+void
+MultirateRK2Scheme::ComputeDt()
+{
+	LOGMSG << name << ":" << endl;
+	_dt0.lines.clear();
+	_dt0.points.clear();
+	_dt0.rods.clear();
+	_dt0.bodies.clear();
+	for (auto obj : lines)
+		_dt0.lines.push_back(obj->cfl2dt(cfl));
+	for (auto obj : points)
+		_dt0.points.push_back(obj->cfl2dt(cfl));
+	for (auto obj : rods)
+		_dt0.rods.push_back(obj->cfl2dt(cfl));
+	for (auto obj : bodies)
+		_dt0.bodies.push_back(obj->cfl2dt(cfl));
+	_n.lines.resize(lines.size());
+	_n.points.resize(points.size());
+	_n.rods.resize(rods.size());
+	_n.bodies.resize(bodies.size());
+	_capped.lines.resize(lines.size(), false);
+	_capped.points.resize(points.size(), false);
+	_capped.rods.resize(rods.size(), false);
+	_capped.bodies.resize(bodies.size(), false);
+	_ends.resize(lines.size());
+
+	// The entities without a CFL definition are not limiting the time step
+	const real dt_inf = 0.9 * (std::numeric_limits<real>::max)();
+	_dt_max = 0.0;
+	for (auto v : { &_dt0.lines, &_dt0.points, &_dt0.rods, &_dt0.bodies }) {
+		for (auto dt : *v) {
+			if (dt < dt_inf)
+				_dt_max = (std::max)(_dt_max, dt);
+		}
+	}
+	if (_dt_max == 0.0)
+		_dt_max = (std::numeric_limits<real>::max)();
+
+	for (unsigned int i = 0; i < lines.size(); i++) {
+		LOGMSG << "Line " << lines[i]->number << ": dt = " << _dt0.lines[i]
+		       << " s (" << multirate_substeps(_dt_max, _dt0.lines[i])
+		       << " substeps)" << endl;
+	}
+	_ready = false;
+}
+
+unsigned int
+MultirateRK2Scheme::Substeps(real dt,
+                             real dt0,
+                             std::vector<bool>& capped,
+                             unsigned int i,
+                             const char* type,
+                             int number)
+{
+	const unsigned int n = multirate_substeps(dt, dt0);
+	if (!capped[i] && (n * dt0 < dt)) {
+		capped[i] = true;
+		LOGWRN << type << " " << number << " requires more than "
+		       << MULTIRATE_MAX_SUBSTEPS << " substeps, so it is integrated with a time step "
+		       << dt / n << " s larger than its stable one, " << dt0
+		       << " s. The simulation may diverge" << endl;
+	}
+	return n;
+}
+
+void
+MultirateRK2Scheme::StepPoint(unsigned int i, real h)
+{
+	auto& y = r[0].points[i];
+	auto& y_mid = r[1].points[i];
+	const auto [v1, a1] = points[i]->getStateDeriv();
+	y_mid.pos = y.pos + (0.5 * h) * v1;
+	y_mid.vel = y.vel + (0.5 * h) * a1;
+	points[i]->setTime(t + 0.5 * h);
+	points[i]->setState(y_mid.pos, y_mid.vel);
+	const auto [v2, a2] = points[i]->getStateDeriv();
+	y.pos += h * v2;
+	y.vel += h * a2;
+	points[i]->setTime(t + h);
+	points[i]->setState(y.pos, y.vel);
+}
+
+void
+MultirateRK2Scheme::StepRod(unsigned int i, real h)
+{
+	auto& y = r[0].rods[i];
+	auto& y_mid = r[1].rods[i];
+	const auto [v1, a1] = rods[i]->getStateDeriv();
+	y_mid.pos = y.pos + (0.5 * h) * v1.toVec7();
+	y_mid.vel = y.vel + (0.5 * h) * a1;
+	rods[i]->setTime(t + 0.5 * h);
+	rods[i]->setState(XYZQuat::fromVec7(y_mid.pos), y_mid.vel);
+	const auto [v2, a2] = rods[i]->getStateDeriv();
+	y.pos += h * v2.toVec7();
+	y.vel += h * a2;
+	rods[i]->setTime(t + h);
+	rods[i]->setState(XYZQuat::fromVec7(y.pos), y.vel);
+}
+
+void
+MultirateRK2Scheme::StepBody(unsigned int i, real h)
+{
+	auto& y = r[0].bodies[i];
+	auto& y_mid = r[1].bodies[i];
+	const auto [v1, a1] = bodies[i]->getStateDeriv();
+	y_mid.pos = y.pos + (0.5 * h) * v1.toVec7();
+	y_mid.vel = y.vel + (0.5 * h) * a1;
+	bodies[i]->setState(XYZQuat::fromVec7(y_mid.pos), y_mid.vel);
+	const auto [v2, a2] = bodies[i]->getStateDeriv();
+	y.pos += h * v2.toVec7();
+	y.vel += h * a2;
+	bodies[i]->setState(XYZQuat::fromVec7(y.pos), y.vel);
+}
+
+void
+MultirateRK2Scheme::StepLine(unsigned int i, real t0, real tau, real h)
+{
+	Line* line = lines[i];
+	auto& y = r[0].lines[i];
+	auto& y_mid = r[1].lines[i];
+	auto& k1 = rd[0].lines[i];
+	auto& k2 = rd[1].lines[i];
+
+	// The end points are at the end of the substep already, so we can
+	// interpolate them
+	const auto ends = line->getEndsKinematics();
+	std::array<vec, 4> ends_mid;
+	for (unsigned int j = 0; j < ends.size(); j++)
+		ends_mid[j] = 0.5 * (_ends[i][j] + ends[j]);
+
+	// Midpoint
+	line->setTime(t0 + tau + 0.5 * h);
+	line->updateUnstretchedLength(t_local + tau + 0.5 * h);
+	line->setEndsKinematics(ends_mid);
+	y_mid.pos = y.pos + (0.5 * h) * k1.vel;
+	y_mid.vel = y.vel + (0.5 * h) * k1.acc;
+	line->setState(y_mid.pos, y_mid.vel);
+	line->getStateDeriv(k2.vel, k2.acc);
+	y.pos += h * k2.vel;
+	y.vel += h * k2.acc;
+
+	// The derivative at the end of the substep, which is used by the
+	// attached entities on their following substeps
+	line->setTime(t0 + tau + h);
+	line->updateUnstretchedLength(t_local + tau + h);
+	line->setEndsKinematics(ends);
+	line->setState(y.pos, y.vel);
+	line->getStateDeriv(k1.vel, k1.acc);
+	_ends[i] = ends;
+}
+
+void
+MultirateRK2Scheme::Step(real& dt)
+{
+	if ((_dt0.lines.size() != lines.size()) ||
+	    (_dt0.points.size() != points.size()) ||
+	    (_dt0.rods.size() != rods.size()) ||
+	    (_dt0.bodies.size() != bodies.size()))
+		ComputeDt();
+
+	const real t0 = t;
+	dt = (std::min)(dt, _dt_max);
+	unsigned int n = 1;
+	for (unsigned int i = 0; i < lines.size(); i++) {
+		_n.lines[i] = Substeps(
+		    dt, _dt0.lines[i], _capped.lines, i, "Line", lines[i]->number);
+		n = (std::max)(n, _n.lines[i]);
+	}
+	for (unsigned int i = 0; i < points.size(); i++) {
+		_n.points[i] = Substeps(
+		    dt, _dt0.points[i], _capped.points, i, "Point", points[i]->number);
+		n = (std::max)(n, _n.points[i]);
+	}
+	for (unsigned int i = 0; i < rods.size(); i++) {
+		_n.rods[i] = Substeps(
+		    dt, _dt0.rods[i], _capped.rods, i, "Rod", rods[i]->number);
+		n = (std::max)(n, _n.rods[i]);
+	}
+	for (unsigned int i = 0; i < bodies.size(); i++) {
+		_n.bodies[i] = Substeps(
+		    dt, _dt0.bodies[i], _capped.bodies, i, "Body", bodies[i]->number);
+		n = (std::max)(n, _n.bodies[i]);
+	}
+	const real h = dt / n;
+
+	// The lines derivatives are computed at the end of each substep, so they
+	// can be reused unless the coupled entities were moved by a new outer
+	// time step
+	if (!_ready || (t_local == 0.0)) {
+		Update(0.0, 0);
+		CalcStateDeriv(0);
+		for (unsigned int i = 0; i < lines.size(); i++)
+			_ends[i] = lines[i]->getEndsKinematics();
+		_ready = true;
+	}
+
+	for (unsigned int k = 0; k < n; k++) {
+		t = t0 + k * h;
+		waves->updateWaves();
+
+		// The points, rods and bodies are at least as fast as the lines
+		// attached to them, so they go first
+		for (unsigned int i = 0; i < points.size(); i++) {
+			const unsigned int m = n / _n.points[i];
+			if ((points[i]->type != Point::FREE) || (k % m))
+				continue;
+			StepPoint(i, m * h);
+		}
+		for (unsigned int i = 0; i < rods.size(); i++) {
+			const unsigned int m = n / _n.rods[i];
+			if ((rods[i]->type != Rod::PINNED) &&
+			    (rods[i]->type != Rod::CPLDPIN) && (rods[i]->type != Rod::FREE))
+				continue;
+			if (k % m)
+				continue;
+			StepRod(i, m * h);
+		}
+		for (unsigned int i = 0; i < bodies.size(); i++) {
+			const unsigned int m = n / _n.bodies[i];
+			if ((bodies[i]->type != Body::FREE) &&
+			    (bodies[i]->type != Body::CPLDPIN))
+				continue;
+			if (k % m)
+				continue;
+			StepBody(i, m * h);
+		}
+
+		// Move the coupled entities to the end of the substep, and integrate
+		// the lines which are finishing their own substep
+		t = t0 + (k + 1) * h;
+		UpdateCoupled((k + 1) * h);
+		auto line_step = [this, t0, h, n, k](unsigned int i) {
+			const unsigned int m = n / _n.lines[i];
+			if ((k + 1) % m)
+				return;
+			StepLine(i, t0, (k + 1 - m) * h, m * h);
+		};
+		if (pool) {
+			_lines_cost.resize(lines.size());
+			for (unsigned int i = 0; i < lines.size(); i++) {
+				const unsigned int m = n / _n.lines[i];
+				_lines_cost[i] = ((k + 1) % m) ? 0 : lines[i]->getN() + 1;
+			}
+			pool->Run(_lines_cost, line_step);
+		} else {
+			for (unsigned int i = 0; i < lines.size(); i++)
+				line_step(i);
+		}
+	}
+
+	t = t0 + dt;
+	TimeSchemeBase::Step(dt);
+}
+
 template<unsigned int order, bool local>
 ABScheme<order, local>::ABScheme(moordyn::Log* log, moordyn::WavesRef waves)
   : LocalTimeSchemeBase(log, waves)
@@ -478,24 +1042,47 @@ ABScheme<order, local>::Step(real& dt)
 	// Apply different formulas depending on the number of derivatives available
 	switch (n_steps) {
 		case 0:
-			r[0] = r[0] + rd[0] * dt;
+			// r[0] = r[0] + rd[0] * dt;
+			butcher_row<1>(r[0], r[0], { dt }, { &rd[0] });
 			break;
 		case 1:
-			r[0] = r[0] + rd[0] * (dt * 1.5) - rd[1] * (dt * 0.5);
+			// r[0] = r[0] + rd[0] * (dt * 1.5) - rd[1] * (dt * 0.5);
+			butcher_row<2>(
+			    r[0], r[0], { dt * 1.5, -dt * 0.5 }, { &rd[0], &rd[1] });
 			break;
 		case 2:
-			r[0] = r[0] + rd[0] * (dt * 23.0 / 12.0) -
-			       rd[1] * (dt * 4.0 / 3.0) + rd[2] * (dt * 5.0 / 12.0);
+			// r[0] = r[0] + rd[0] * (dt * 23.0 / 12.0) -
+			//        rd[1] * (dt * 4.0 / 3.0) + rd[2] * (dt * 5.0 / 12.0);
+			butcher_row<3>(
+			    r[0],
+			    r[0],
+			    { dt * 23.0 / 12.0, -dt * 4.0 / 3.0, dt * 5.0 / 12.0 },
+			    { &rd[0], &rd[1], &rd[2] });
 			break;
 		case 3:
-			r[0] = r[0] + rd[0] * (dt * 55.0 / 24.0) -
-			       rd[1] * (dt * 59.0 / 24.0) + rd[2] * (dt * 37.0 / 24.0) -
-			       rd[3] * (dt * 3.0 / 8.0);
+			// r[0] = r[0] + rd[0] * (dt * 55.0 / 24.0) -
+			//        rd[1] * (dt * 59.0 / 24.0) + rd[2] * (dt * 37.0 / 24.0) -
+			//        rd[3] * (dt * 3.0 / 8.0);
+			butcher_row<4>(r[0],
+			               r[0],
+			               { dt * 55.0 / 24.0,
+			                 -dt * 59.0 / 24.0,
+			                 dt * 37.0 / 24.0,
+			                 -dt * 3.0 / 8.0 },
+			               { &rd[0], &rd[1], &rd[2], &rd[3] });
 			break;
 		default:
-			r[0] = r[0] + rd[0] * (dt * 1901.0 / 720.0) -
-			       rd[1] * (dt * 1387.0 / 360.0) + rd[2] * (dt * 109.0 / 30.0) -
-			       rd[3] * (dt * 637.0 / 360.0) + rd[4] * (dt * 251.0 / 720.0);
+			// r[0] = r[0] + rd[0] * (dt * 1901.0 / 720.0) -
+			//        rd[1] * (dt * 1387.0 / 360.0) + rd[2] * (dt * 109.0 / 30.0) -
+			//        rd[3] * (dt * 637.0 / 360.0) + rd[4] * (dt * 251.0 / 720.0);
+			butcher_row<5>(r[0],
+			               r[0],
+			               { dt * 1901.0 / 720.0,
+			                 -dt * 1387.0 / 360.0,
+			                 dt * 109.0 / 30.0,
+			                 -dt * 637.0 / 360.0,
+			                 dt * 251.0 / 720.0 },
+			               { &rd[0], &rd[1], &rd[2], &rd[3], &rd[4] });
 	}
 
 	n_steps = (std::min)(n_steps + 1, order);
@@ -540,7 +1127,52 @@ AndersonSchemeBase<NSTATE, NDERIV>::AndersonSchemeBase(moordyn::Log* log,
 	, _tol_rel(tol_rel)
 	, _regularization(regularization)
 	, _n(0)
+	, _cur(0)
+	, _head(0)
+	, _k(0)
+{
+}
+
+template<unsigned int NSTATE, unsigned int NDERIV>
+void
+AndersonSchemeBase<NSTATE, NDERIV>::append(unsigned int col)
 {
+	auto v = _Q.col(_k);
+	v = _G.col(col);
+	const real norm = v.norm();
+	// Modified Gram-Schmidt
+	for (unsigned int j = 0; j < _k; j++) {
+		_R(j, _k) = _Q.col(j).dot(v);
+		v -= _R(j, _k) * _Q.col(j);
+	}
+	const real r = v.norm();
+	if (!(r > _regularization * norm)) {
+		// Linearly dependent, so the slot is reused by the next variation
+		return;
+	}
+	v /= r;
+	_R(_k, _k) = r;
+	_R.col(_k).tail(_m - _k - 1).setZero();
+	_k++;
+}
+
+template<unsigned int NSTATE, unsigned int NDERIV>
+void
+AndersonSchemeBase<NSTATE, NDERIV>::downdate()
+{
+	// Removing the first column of R leaves an upper Hessenberg matrix
+	for (unsigned int j = 0; j + 1 < _k; j++)
+		_R.col(j).head(j + 2) = _R.col(j + 1).head(j + 2);
+	// Which is triangularized back with Givens rotations, also applied to Q
+	for (unsigned int j = 0; j + 1 < _k; j++) {
+		Eigen::JacobiRotation<real> rot;
+		rot.makeGivens(_R(j, j), _R(j + 1, j));
+		_R.rightCols(_m - j).applyOnTheLeft(j, j + 1, rot.adjoint());
+		_R(j + 1, j) = 0.0;
+		_Q.applyOnTheRight(j, j + 1, rot);
+	}
+	_head = (_head + 1) % _m;
+	_k--;
 }
 
 template<unsigned int NSTATE, unsigned int NDERIV>
@@ -550,18 +1182,18 @@ AndersonSchemeBase<NSTATE, NDERIV>::qr(unsigned int iter,
                                        unsigned int dst,
                                        float dt)
 {
-	// Resize the matrices on demand
-	if (_X.rows() == 0) {
+	// Allocate the workspace on demand
+	if (_X.rows() != ndof()) {
 		_n = ndof();
 		_x.resize(_n, 2);
 		_g.resize(_n, 2);
 		_X.resize(_n, _m);
 		_G.resize(_n, _m);
+		_Q.resize(_n, _m);
+		_R = Eigen::MatrixXr::Zero(_m, _m);
+		_gamma.resize(_m);
 	}
 
-	// Roll the states and fill
-	_x.col(0) = _x.col(1);
-	_g.col(0) = _g.col(1);
 	fill(org, dst);
 
 	auto [res_mean, res_max] = residue();
@@ -579,16 +1211,15 @@ AndersonSchemeBase<NSTATE, NDERIV>::qr(unsigned int iter,
 	this->rd[dst].Mix(this->rd[org], this->Relax(iter));
 	return;
 
-	// Roll the matrices and fill them
-	unsigned int m = (std::min)(iter, _m);
-	for (unsigned int col = 0; col < m - 1; col++) {
-		_X.col(_m - m + col) = _X.col(_m - m + col + 1);
-		_G.col(_m - m + col) = _G.col(_m - m + col + 1);
-	}
-	_X.col(_m - 1) = _x.col(1) - _x.col(0);
-	_G.col(_m - 1) = _g.col(1) - _g.col(0);
+	// Add the new variations to the history, forgetting the oldest ones
+	if (_k == _m)
+		downdate();
+	const unsigned int col = (_head + _k) % _m;
+	_X.col(col) = _x.col(_cur) - _x.col(1 - _cur);
+	_G.col(col) = _g.col(_cur) - _g.col(1 - _cur);
+	append(col);
 
-	if (m < _m) {
+	if (_k < _m) {
 		// Again, we cannot produce an estimation yet
 		this->rd[dst].Mix(this->rd[org], relax);
 		return;
@@ -602,48 +1233,46 @@ AndersonSchemeBase<NSTATE, NDERIV>::qr(unsigned int iter,
 		return;
 	}
 
-	Eigen::MatrixXr reg = _regularization * Eigen::MatrixXr::Identity(m, m);
-	// Solve using the Woodbury identity
-	// Eigen::MatrixXr XtG_inv = (_X.transpose() * _G + reg).inverse();
-	// Eigen::MatrixXr B = Eigen::MatrixXr::Identity(_n, _n) +
-	// 	(_X - _G) * XtG_inv * _X.transpose();
-	// Eigen::MatrixXr acc = _x.col(1) + B * _g.col(1);
-	// Solve by straight application
-	Eigen::MatrixXr Gr = _G;
-	Gr.block(_m - m, 0, m, m) += reg;
-	auto QR = Gr(Eigen::placeholders::all,
-	             Eigen::seqN(_m - m, m)).completeOrthogonalDecomposition();
-	Eigen::MatrixXr gamma = QR.solve(_g.col(1));
-	Eigen::MatrixXr acc = _x.col(1) + _g.col(1) - (_X + Gr) * gamma;
-	unsigned int n = 0;
+	// Solve the least squares problem, min |g - G gamma|
+	auto gamma = _gamma.head(_k);
+	gamma.noalias() = _Q.leftCols(_k).transpose() * _g.col(_cur);
+	_R.topLeftCorner(_k, _k)
+	    .template triangularView<Eigen::Upper>()
+	    .solveInPlace(gamma);
+	estimate(org, dst, dt);
+
+	this->rd[dst].Mix(this->rd[org], relax);
+}
+
+template<unsigned int NSTATE, unsigned int NDERIV>
+void
+AndersonSchemeBase<NSTATE, NDERIV>::estimate(unsigned int org,
+                                             unsigned int dst,
+                                             float dt)
+{
+	// The accelerations are contiguous on the state buffers
+	auto acc = this->rd[dst].Acc();
+	acc = _x.col(_cur) + _g.col(_cur);
+	for (unsigned int j = 0; j < _k; j++) {
+		const unsigned int c = (_head + j) % _m;
+		acc -= _gamma(j) * (_X.col(c) + _G.col(c));
+	}
 	for (unsigned int i = 0; i < this->lines.size(); i++) {
-		for (unsigned int j = 0; j < this->rd[org].lines[i].acc.size(); j++) {
-			this->rd[dst].lines[i].acc[j] = acc(Eigen::seqN(n, 3), 0);
-			this->rd[dst].lines[i].vel[j] = this->rd[org].lines[i].vel[j] + dt * (
-				this->rd[dst].lines[i].acc[j] - this->rd[org].lines[i].acc[j]);
-			n += 3;
-		}
+		this->rd[dst].lines[i].vel = this->rd[org].lines[i].vel + dt * (
+			this->rd[dst].lines[i].acc - this->rd[org].lines[i].acc);
 	}
 	for (unsigned int i = 0; i < this->points.size(); i++) {
-		this->rd[dst].points[i].acc =  acc(Eigen::seqN(n, 3), 0);
 		this->rd[dst].points[i].vel = this->rd[org].points[i].vel + dt * (
 			this->rd[dst].points[i].acc - this->rd[org].points[i].acc);
-		n += 3;
 	}
 	for (unsigned int i = 0; i < this->rods.size(); i++) {
-		this->rd[dst].rods[i].acc =  acc(Eigen::seqN(n, 6), 0);
 		this->rd[dst].rods[i].vel = this->rd[org].rods[i].vel + XYZQuat::fromVec6(
-			dt * (this->rd[dst].rods[i].acc - this->rd[org].rods[i].acc));
-		n += 6;
+			dt * (this->rd[dst].rods[i].acc - this->rd[org].rods[i].acc)).toVec7();
 	}
 	for (unsigned int i = 0; i < this->bodies.size(); i++) {
-		this->rd[dst].bodies[i].acc =  acc(Eigen::seqN(n, 6), 0);
 		this->rd[dst].bodies[i].vel = this->rd[org].bodies[i].vel + XYZQuat::fromVec6(
-			dt * (this->rd[dst].bodies[i].acc - this->rd[org].bodies[i].acc));
-		n += 6;
+			dt * (this->rd[dst].bodies[i].acc - this->rd[org].bodies[i].acc)).toVec7();
 	}
-
-	this->rd[dst].Mix(this->rd[org], relax);
 }
 
 ImplicitEulerScheme::ImplicitEulerScheme(moordyn::Log* log,
@@ -664,7 +1293,8 @@ ImplicitEulerScheme::Step(real& dt)
 	t += _dt_factor * dt;
 	rd[1] = rd[0];  // We use rd[1] just as a tmp storage to compute relaxation
 	for (unsigned int i = 0; i < iters(); i++) {
-		r[1] = r[0] + rd[0] * (_dt_factor * dt);
+		// r[1] = r[0] + rd[0] * (_dt_factor * dt);
+		butcher_row<1>(r[1], r[0], { _dt_factor * dt }, { &rd[0] });
 		Update(_dt_factor * dt, 1);
 		CalcStateDeriv(0);
 
@@ -677,12 +1307,215 @@ ImplicitEulerScheme::Step(real& dt)
 	}
 
 	// Apply
-	r[0] = r[0] + rd[0] * dt;
+	// r[0] = r[0] + rd[0] * dt;
+	butcher_row<1>(r[0], r[0], { dt }, { &rd[0] });
 	t += (1.0 - _dt_factor) * dt;
 	Update(dt, 0);
 	TimeSchemeBase::Step(dt);
 }
 
+NewtonEulerScheme::NewtonEulerScheme(moordyn::Log* log,
+                                     moordyn::WavesRef waves,
+                                     unsigned int iters)
+  : ImplicitSchemeBase(log, waves, iters)
+{
+	stringstream s;
+	s << "Newton implicit Euler (" << iters << " iterations)";
+	name = s.str();
+}
+
+#ifndef NEWTON_KRYLOV_DIM
+#define NEWTON_KRYLOV_DIM 5
+#endif
+
+#ifndef NEWTON_KRYLOV_TOL
+#define NEWTON_KRYLOV_TOL 0.1
+#endif
+
+void
+NewtonEulerScheme::Jacobians(real dt)
+{
+	_jac.resize(lines.size());
+	auto jacobian = [this, dt](unsigned int i) {
+		lines[i]->getStateDerivJacobian(dt * dt, dt, _jac[i]);
+		_jac[i].factorize();
+	};
+	if (pool) {
+		_lines_cost.resize(lines.size());
+		for (unsigned int i = 0; i < lines.size(); i++)
+			_lines_cost[i] = lines[i]->getN() + 1;
+		pool->Run(_lines_cost, jacobian);
+	} else {
+		for (unsigned int i = 0; i < lines.size(); i++)
+			jacobian(i);
+	}
+}
+
+void
+NewtonEulerScheme::Unknowns()
+{
+	_free = rd[0];
+	_free.Data().setZero();
+	for (unsigned int i = 0; i < lines.size(); i++)
+		_free.lines[i].acc.setOnes();
+	for (unsigned int i = 0; i < points.size(); i++) {
+		if (points[i]->type != Point::FREE)
+			continue;
+		_free.points[i].acc.setOnes();
+	}
+	for (unsigned int i = 0; i < rods.size(); i++) {
+		if ((rods[i]->type != Rod::PINNED) && (rods[i]->type != Rod::CPLDPIN) &&
+		    (rods[i]->type != Rod::FREE))
+			continue;
+		_free.rods[i].vel.setOnes();
+		_free.rods[i].acc.setOnes();
+	}
+	for (unsigned int i = 0; i < bodies.size(); i++) {
+		if ((bodies[i]->type != Body::FREE) && (bodies[i]->type != Body::CPLDPIN))
+			continue;
+		_free.bodies[i].vel.setOnes();
+		_free.bodies[i].acc.setOnes();
+	}
+}
+
+void
+NewtonEulerScheme::Velocities(DMoorDynStateDt& x, real vel0, real dt)
+{
+	for (unsigned int i = 0; i < lines.size(); i++)
+		x.lines[i].vel = vel0 * r[0].lines[i].vel + dt * x.lines[i].acc;
+	for (unsigned int i = 0; i < points.size(); i++) {
+		if (points[i]->type != Point::FREE)
+			continue;
+		x.points[i].vel = vel0 * r[0].points[i].vel + dt * x.points[i].acc;
+	}
+}
+
+void
+NewtonEulerScheme::Precondition(const Eigen::Ref<const Eigen::VectorXr>& v,
+                                Eigen::VectorXr& z,
+                                real dt)
+{
+	rd[2].Data() = v;
+	auto solve = [this](unsigned int i) { _jac[i].solve(rd[2].lines[i].acc); };
+	if (pool) {
+		pool->Run(_lines_cost, solve);
+	} else {
+		for (unsigned int i = 0; i < lines.size(); i++)
+			solve(i);
+	}
+	Velocities(rd[2], 0.0, dt);
+	z = rd[2].Data();
+}
+
+void
+NewtonEulerScheme::Krylov(real dt)
+{
+	const unsigned int m = NEWTON_KRYLOV_DIM;
+	_z.resize(_V.rows());
+	const real beta = _V.col(0).norm();
+	if (beta == 0.0) {
+		_z.setZero();
+		return;
+	}
+	_V.col(0) /= beta;
+	_H.setZero(m + 1, m);
+	_cs.resize(m);
+	_sn.resize(m);
+	_g.setZero(m + 1);
+	_g(0) = beta;
+
+	const real x_norm = rd[1].Data().norm();
+	const real eps_rel = sqrt(std::numeric_limits<real>::epsilon());
+	unsigned int k = 0;
+	while (k < m) {
+		// Jacobian-vector product by finite differences:
+		// w = z - (F(x + eps * z) - F(x)) / eps
+		Precondition(_V.col(k), _z, dt);
+		const real eps = eps_rel * (1.0 + x_norm) / _z.norm();
+		rd[2].Data() = rd[1].Data() + eps * _z;
+		butcher_row<1>(r[1], r[0], { dt }, { &rd[2] });
+		Update(dt, 1);
+		CalcStateDeriv(2);
+		auto w = _V.col(k + 1);
+		w = (_z - (rd[2].Data() - rd[0].Data()) / eps)
+		        .cwiseProduct(_free.Data());
+
+		// Arnoldi, with the modified Gram-Schmidt orthogonalization
+		for (unsigned int j = 0; j <= k; j++) {
+			_H(j, k) = w.dot(_V.col(j));
+			w -= _H(j, k) * _V.col(j);
+		}
+		_H(k + 1, k) = w.norm();
+		if (_H(k + 1, k) > 0.0)
+			w /= _H(k + 1, k);
+
+		// Givens rotations to keep the Hessenberg matrix upper triangular
+		for (unsigned int j = 0; j < k; j++) {
+			const real h = _cs(j) * _H(j, k) + _sn(j) * _H(j + 1, k);
+			_H(j + 1, k) = -_sn(j) * _H(j, k) + _cs(j) * _H(j + 1, k);
+			_H(j, k) = h;
+		}
+		const real h = std::hypot(_H(k, k), _H(k + 1, k));
+		_cs(k) = _H(k, k) / h;
+		_sn(k) = _H(k + 1, k) / h;
+		_H(k, k) = h;
+		_H(k + 1, k) = 0.0;
+		_g(k + 1) = -_sn(k) * _g(k);
+		_g(k) = _cs(k) * _g(k);
+
+		k++;
+		if (std::abs(_g(k)) <= NEWTON_KRYLOV_TOL * beta)
+			break;
+	}
+
+	auto y = _g.head(k);
+	_H.topLeftCorner(k, k).triangularView<Eigen::Upper>().solveInPlace(y);
+	_z.noalias() = _V.leftCols(k) * y;
+	Precondition(_z, _z, dt);
+}
+
+bool
+NewtonEulerScheme::Converged() const
+{
+	const auto acc = rd[1].Acc();
+	if (!acc.size())
+		return true;
+	const real res = (rd[0].Acc() - acc).cwiseAbs().maxCoeff();
+	return res <= tol * (1.0 + acc.cwiseAbs().maxCoeff());
+}
+
+void
+NewtonEulerScheme::Step(real& dt)
+{
+	t += dt;
+	Unknowns();
+	_V.resize(rd[0].Data().size(), NEWTON_KRYLOV_DIM + 1);
+	rd[1] = rd[0];  // We use rd[1] to store the assumed derivatives
+	for (unsigned int i = 0; i < iters(); i++) {
+		// r[1] = r[0] + rd[1] * dt;
+		Velocities(rd[1], 1.0, dt);
+		butcher_row<1>(r[1], r[0], { dt }, { &rd[1] });
+		Update(dt, 1);
+		if (i == 0)
+			Jacobians(dt);
+		CalcStateDeriv(0);
+
+		if ((i == iters() - 1) || Converged())
+			break;
+
+		// Newton correction
+		_V.col(0) = (rd[0].Data() - rd[1].Data()).cwiseProduct(_free.Data());
+		Krylov(dt);
+		rd[1].Data() += _z;
+	}
+
+	// Apply
+	// r[0] = r[0] + rd[0] * dt;
+	butcher_row<1>(r[0], r[0], { dt }, { &rd[0] });
+	Update(dt, 0);
+	TimeSchemeBase::Step(dt);
+}
+
 AndersonEulerScheme::AndersonEulerScheme(moordyn::Log* log,
                                          moordyn::WavesRef waves,
                                          unsigned int iters,
@@ -701,7 +1534,8 @@ AndersonEulerScheme::Step(real& dt)
 {
 	t += _dt_factor * dt;
 	for (unsigned int i = 0; i < iters(); i++) {
-		r[1] = r[0] + rd[0] * (_dt_factor * dt);
+		// r[1] = r[0] + rd[0] * (_dt_factor * dt);
+		butcher_row<1>(r[1], r[0], { _dt_factor * dt }, { &rd[0] });
 		Update(_dt_factor * dt, 1);
 		CalcStateDeriv(0);
 
@@ -715,7 +1549,8 @@ AndersonEulerScheme::Step(real& dt)
 	}
 
 	// Apply
-	r[0] = r[0] + rd[0] * dt;
+	// r[0] = r[0] + rd[0] * dt;
+	butcher_row<1>(r[0], r[0], { dt }, { &rd[0] });
 	t += (1.0 - _dt_factor) * dt;
 	Update(dt, 0);
 	TimeSchemeBase::Step(dt);
@@ -744,6 +1579,7 @@ ImplicitNewmarkScheme::Step(real& dt)
 	// Initialize the velocity and acceleration for the next time step as
 	// the ones from the current time step
 	rd[1] = rd[0];
+	_rd_tmp = rd[0];
 
 	t += dt;
 	rd[2] = rd[0];  // We use rd[2] just as a tmp storage to compute relaxation
@@ -751,7 +1587,9 @@ ImplicitNewmarkScheme::Step(real& dt)
 		// At the time of computing r acts as an input, and rd as an output.
 		// Thus we just need to apply the Newmark scheme on r[1] and store
 		// the new rates of change on rd[1]
-		r[1] = r[0] + rd[0].Newmark(rd[1], dt, _gamma, _beta) * dt;
+		// r[1] = r[0] + rd[0].Newmark(rd[1], dt, _gamma, _beta) * dt;
+		rd[0].Newmark(rd[1], _rd_tmp, dt, _gamma, _beta);
+		butcher_row<1>(r[1], r[0], { dt }, { &_rd_tmp });
 		Update(dt, 1);
 		CalcStateDeriv(1);
 
@@ -764,7 +1602,9 @@ ImplicitNewmarkScheme::Step(real& dt)
 	}
 
 	// Apply
-	r[1] = r[0] + rd[0].Newmark(rd[1], dt, _gamma, _beta) * dt;
+	// r[1] = r[0] + rd[0].Newmark(rd[1], dt, _gamma, _beta) * dt;
+	rd[0].Newmark(rd[1], _rd_tmp, dt, _gamma, _beta);
+	butcher_row<1>(r[1], r[0], { dt }, { &_rd_tmp });
 	r[0] = r[1];
 	rd[0] = rd[1];
 	Update(dt, 0);
@@ -792,11 +1632,14 @@ ImplicitWilsonScheme::Step(real& dt)
 	const real tdt = _theta * dt;
 	t += tdt;
 	rd[1] = rd[0];  // We use rd[1] just as a tmp storage to compute relaxation
+	_rd_tmp = rd[0];
 	for (unsigned int i = 0; i < iters(); i++) {
 		// At the time of computing r acts as an input, and rd as an output.
 		// Thus we just need to apply the Newmark scheme on r[1] and store
 		// the new rates of change on rd[1]
-		r[1] = r[0] + rd[0].Wilson(rd[1], tdt, tdt) * tdt;
+		// r[1] = r[0] + rd[0].Wilson(rd[1], tdt, tdt) * tdt;
+		rd[0].Wilson(rd[1], _rd_tmp, tdt, tdt);
+		butcher_row<1>(r[1], r[0], { tdt }, { &_rd_tmp });
 		Update(tdt, 1);
 		CalcStateDeriv(1);
 
@@ -810,7 +1653,9 @@ ImplicitWilsonScheme::Step(real& dt)
 
 	// Apply
 	t -= (1.f - _theta) * dt;
-	r[1] = r[0] + rd[0].Wilson(rd[1], dt, tdt) * dt;
+	// r[1] = r[0] + rd[0].Wilson(rd[1], dt, tdt) * dt;
+	rd[0].Wilson(rd[1], _rd_tmp, dt, tdt);
+	butcher_row<1>(r[1], r[0], { dt }, { &_rd_tmp });
 	r[0] = r[1];
 	rd[0] = rd[1];
 	Update(dt, 0);
@@ -833,6 +1678,12 @@ create_time_scheme(const std::string& name,
 		out = new RK2Scheme(log, waves);
 	} else if (str::lower(name) == "rk4") {
 		out = new RK4Scheme(log, waves);
+	} else if (str::lower(name) == "rk23") {
+		out = new RK23Scheme(log, waves);
+	} else if (str::lower(name) == "rk45") {
+		out = new RK45Scheme(log, waves);
+	} else if (str::lower(name) == "mrk2") {
+		out = new MultirateRK2Scheme(log, waves);
 	} else if (str::lower(name) == "ab2") {
 		out = new ABScheme<2, false>(log, waves);
 	} else if (str::lower(name) == "ab3") {
@@ -863,6 +1714,15 @@ create_time_scheme(const std::string& name,
 			s << "Invalid Midpoint name format '" << name << "'";
 			throw moordyn::invalid_value_error(s.str().c_str());
 		}
+	} else if (str::startswith(str::lower(name), "newton")) {
+		try {
+			unsigned int iters = std::stoi(name.substr(6));
+			out = new NewtonEulerScheme(log, waves, iters);
+		} catch (std::invalid_argument) {
+			stringstream s;
+			s << "Invalid Newton name format '" << name << "'";
+			throw moordyn::invalid_value_error(s.str().c_str());
+		}
 	} else if (str::startswith(str::lower(name), "anderson")) {
 		try {
 			unsigned int iters = std::stoi(name.substr(8));
@@ -41,8 +41,10 @@
 #include "Point.hpp"
 #include "Rod.hpp"
 #include "Body.hpp"
+#include "Util/ThreadPool.hpp"
 #include <vector>
 #include <string>
+#include <memory>
 
 namespace moordyn {
 
@@ -225,6 +227,70 @@ class TimeScheme : public io::IO
 	 */
 	inline void SetCFL(const real& cfl) { this->cfl = cfl; }
 
+	/** @brief Get the error tolerance of the adaptive time schemes
+	 * @return The tolerance
+	 * @see TimeScheme::IsAdaptive()
+	 */
+	inline real GetTolerance() const { return tol; }
+
+	/** @brief Set the error tolerance of the adaptive time schemes
+	 * @param tol The tolerance
+	 * @see TimeScheme::IsAdaptive()
+	 */
+	inline void SetTolerance(const real& tol) { this->tol = tol; }
+
+	/** @brief Check whether the scheme is choosing its own time step
+	 *
+	 * These schemes are not bound to the model time step, but they take on
+	 * each TimeScheme::Step() the largest time step (up to the provided one)
+	 * they can handle, e.g. the one that satisfies the
+	 * TimeScheme::GetTolerance() and the TimeScheme::GetCFL() on the
+	 * adaptive schemes
+	 * @return true if the time step is chosen by the scheme, false otherwise
+	 */
+	virtual bool IsAdaptive() const { return false; }
+
+	/** @brief Check whether the scheme is integrating each entity with its own
+	 * time step
+	 *
+	 * The multirate schemes are not bound to the model time step either, but
+	 * unlike the TimeScheme::IsAdaptive() ones, the time step of each entity
+	 * is computed from the CFL factor resulting from the model time step, so
+	 * the fastest entities are integrated with such time step
+	 * @return true if the scheme is multirate, false otherwise
+	 */
+	virtual bool IsMultirate() const { return false; }
+
+	/** @brief Get the number of threads used to compute the derivatives
+	 * @return The number of threads
+	 */
+	inline unsigned int GetThreads() const
+	{
+		return pool ? pool->GetThreads() : 1;
+	}
+
+	/** @brief Get the pool of threads used to compute the derivatives
+	 * @return The threads pool, null if running serially
+	 */
+	inline ThreadPool* GetPool() const { return pool.get(); }
+
+	/** @brief Set the number of threads used to compute the derivatives
+	 *
+	 * The lines and rods derivatives are independent once the end points
+	 * kinematics are set, so they can be computed in parallel. The tasks are
+	 * distributed among the threads by number of nodes, so very different
+	 * lines are still well balanced.
+	 * @param n The number of threads. 1 to run serially, which is the
+	 * default, and 0 to use all the hardware threads
+	 */
+	inline void SetThreads(unsigned int n)
+	{
+		if (n == 1)
+			pool.reset();
+		else
+			pool = std::make_unique<ThreadPool>(n);
+	}
+
 	/** @brief Prepare everything for the next outer time step
 	 *
 	 * Always call this method before start calling TimeScheme::Step()
@@ -295,6 +361,7 @@ class TimeScheme : public io::IO
 	  : io::IO(log)
 	  , name("None")
 	  , t(0.0)
+	  , tol(1e-4)
 	{
 	}
 
@@ -323,6 +390,12 @@ class TimeScheme : public io::IO
 
 	/// Maximum CFL factor
 	real cfl;
+
+	/// Error tolerance of the adaptive time schemes
+	real tol;
+
+	/// The threads to compute the derivatives, NULL if running serially
+	std::unique_ptr<ThreadPool> pool;
 };
 
 // Forward declare waves
@@ -353,19 +426,11 @@ class TimeSchemeBase : public TimeScheme
 			throw;
 		}
 		// Build up the states and states derivatives
-		unsigned int n = obj->getN() - 1;
-		LineState state;
-		state.pos.assign(n, vec::Zero());
-		state.vel.assign(n, vec::Zero());
-		for (unsigned int i = 0; i < r.size(); i++) {
-			r[i].lines.push_back(state);
-		}
-		DLineStateDt dstate;
-		dstate.vel.assign(n, vec::Zero());
-		dstate.acc.assign(n, vec::Zero());
-		for (unsigned int i = 0; i < rd.size(); i++) {
-			rd[i].lines.push_back(dstate);
-		}
+		const unsigned int n = obj->getN() - 1;
+		for (unsigned int i = 0; i < r.size(); i++)
+			r[i].AddLine(n);
+		for (unsigned int i = 0; i < rd.size(); i++)
+			rd[i].AddLine(n);
 		// Add the mask value
 		_calc_mask.lines.push_back(true);
 	}
@@ -384,10 +449,10 @@ class TimeSchemeBase : public TimeScheme
 		} catch (...) {
 			throw;
 		}
-		for (unsigned int i = 0; i < r.size(); i++)
-			r[i].lines.erase(r[i].lines.begin() + i);
-		for (unsigned int i = 0; i < rd.size(); i++)
-			rd[i].lines.erase(rd[i].lines.begin() + i);
+		for (unsigned int j = 0; j < r.size(); j++)
+			r[j].RemoveLine(i);
+		for (unsigned int j = 0; j < rd.size(); j++)
+			rd[j].RemoveLine(i);
 		_calc_mask.lines.erase(_calc_mask.lines.begin() + i);
 		return i;
 	}
@@ -404,18 +469,10 @@ class TimeSchemeBase : public TimeScheme
 			throw;
 		}
 		// Build up the states and states derivatives
-		PointState state;
-		state.pos = vec::Zero();
-		state.vel = vec::Zero();
-		for (unsigned int i = 0; i < r.size(); i++) {
-			r[i].points.push_back(state);
-		}
-		DPointStateDt dstate;
-		dstate.vel = vec::Zero();
-		dstate.acc = vec::Zero();
-		for (unsigned int i = 0; i < rd.size(); i++) {
-			rd[i].points.push_back(dstate);
-		}
+		for (unsigned int i = 0; i < r.size(); i++)
+			r[i].AddPoint();
+		for (unsigned int i = 0; i < rd.size(); i++)
+			rd[i].AddPoint();
 		// Add the mask value
 		_calc_mask.points.push_back(true);
 	}
@@ -434,10 +491,10 @@ class TimeSchemeBase : public TimeScheme
 		} catch (...) {
 			throw;
 		}
-		for (unsigned int i = 0; i < r.size(); i++)
-			r[i].points.erase(r[i].points.begin() + i);
-		for (unsigned int i = 0; i < rd.size(); i++)
-			rd[i].points.erase(rd[i].points.begin() + i);
+		for (unsigned int j = 0; j < r.size(); j++)
+			r[j].RemovePoint(i);
+		for (unsigned int j = 0; j < rd.size(); j++)
+			rd[j].RemovePoint(i);
 		_calc_mask.points.erase(_calc_mask.points.begin() + i);
 		return i;
 	}
@@ -453,18 +510,15 @@ class TimeSchemeBase : public TimeScheme
 		} catch (...) {
 			throw;
 		}
-		// Build up the states and states derivatives
-		RodState state;
-		state.pos = XYZQuat::Zero();
-		state.vel = vec6::Zero();
+		// Build up the states and states derivatives. The new entries are
+		// zero, which is not a valid quaternion
 		for (unsigned int i = 0; i < r.size(); i++) {
-			r[i].rods.push_back(state);
+			r[i].AddRod();
+			r[i].rods.back().pos = XYZQuat::Zero().toVec7();
 		}
-		DRodStateDt dstate;
-		dstate.vel = XYZQuat::Zero();
-		dstate.acc = vec6::Zero();
 		for (unsigned int i = 0; i < rd.size(); i++) {
-			rd[i].rods.push_back(dstate);
+			rd[i].AddRod();
+			rd[i].rods.back().vel = XYZQuat::Zero().toVec7();
 		}
 		// Add the mask value
 		_calc_mask.rods.push_back(true);
@@ -484,10 +538,10 @@ class TimeSchemeBase : public TimeScheme
 		} catch (...) {
 			throw;
 		}
-		for (unsigned int i = 0; i < r.size(); i++)
-			r[i].rods.erase(r[i].rods.begin() + i);
-		for (unsigned int i = 0; i < rd.size(); i++)
-			rd[i].rods.erase(rd[i].rods.begin() + i);
+		for (unsigned int j = 0; j < r.size(); j++)
+			r[j].RemoveRod(i);
+		for (unsigned int j = 0; j < rd.size(); j++)
+			rd[j].RemoveRod(i);
 		_calc_mask.rods.erase(_calc_mask.rods.begin() + i);
 		return i;
 	}
@@ -503,18 +557,15 @@ class TimeSchemeBase : public TimeScheme
 		} catch (...) {
 			throw;
 		}
-		// Build up the states and states derivatives
-		BodyState state;
-		state.pos = XYZQuat::Zero();
-		state.vel = vec6::Zero();
+		// Build up the states and states derivatives. The new entries are
+		// zero, which is not a valid quaternion
 		for (unsigned int i = 0; i < r.size(); i++) {
-			r[i].bodies.push_back(state);
+			r[i].AddBody();
+			r[i].bodies.back().pos = XYZQuat::Zero().toVec7();
 		}
-		DBodyStateDt dstate;
-		dstate.vel = XYZQuat::Zero();
-		dstate.acc = vec6::Zero();
 		for (unsigned int i = 0; i < rd.size(); i++) {
-			rd[i].bodies.push_back(dstate);
+			rd[i].AddBody();
+			rd[i].bodies.back().vel = XYZQuat::Zero().toVec7();
 		}
 		// Add the mask value
 		_calc_mask.bodies.push_back(true);
@@ -534,10 +585,10 @@ class TimeSchemeBase : public TimeScheme
 		} catch (...) {
 			throw;
 		}
-		for (unsigned int i = 0; i < r.size(); i++)
-			r[i].bodies.erase(r[i].bodies.begin() + i);
-		for (unsigned int i = 0; i < rd.size(); i++)
-			rd[i].bodies.erase(rd[i].bodies.begin() + i);
+		for (unsigned int j = 0; j < r.size(); j++)
+			r[j].RemoveBody(i);
+		for (unsigned int j = 0; j < rd.size(); j++)
+			rd[j].RemoveBody(i);
 		_calc_mask.bodies.erase(_calc_mask.bodies.begin() + i);
 		return i;
 	}
@@ -556,27 +607,33 @@ class TimeSchemeBase : public TimeScheme
 		for (unsigned int i = 0; i < bodies.size(); i++) {
 			if ((bodies[i]->type != Body::FREE) && (bodies[i]->type != Body::CPLDPIN)) // Only fully coupled bodies are intialized in MD2.cpp
 				continue;
-			std::tie(r[0].bodies[i].pos, r[0].bodies[i].vel) =
-			    bodies[i]->initialize();
+			const auto [pos, vel] = bodies[i]->initialize();
+			r[0].bodies[i].pos = pos.toVec7();
+			r[0].bodies[i].vel = vel;
 		}
 
 		for (unsigned int i = 0; i < rods.size(); i++) {
 			if ((rods[i]->type != Rod::FREE) && (rods[i]->type != Rod::PINNED))
 				continue;
-			std::tie(r[0].rods[i].pos, r[0].rods[i].vel) =
-			    rods[i]->initialize();
+			const auto [pos, vel] = rods[i]->initialize();
+			r[0].rods[i].pos = pos.toVec7();
+			r[0].rods[i].vel = vel;
 		}
 
 		for (unsigned int i = 0; i < points.size(); i++) {
 			if (points[i]->type != Point::FREE)
 				continue;
-			std::tie(r[0].points[i].pos, r[0].points[i].vel) =
-			    points[i]->initialize();
+			const auto [pos, vel] = points[i]->initialize();
+			r[0].points[i].pos = pos;
+			r[0].points[i].vel = vel;
 		}
 
 		for (unsigned int i = 0; i < lines.size(); i++) {
-			std::tie(r[0].lines[i].pos, r[0].lines[i].vel) =
-			    lines[i]->initialize();
+			const auto [pos, vel] = lines[i]->initialize();
+			for (unsigned int j = 0; j < pos.size(); j++) {
+				r[0].lines[i].pos.col(j) = pos[j];
+				r[0].lines[i].vel.col(j) = vel[j];
+			}
 		}
 	}
 
@@ -858,6 +915,14 @@ class TimeSchemeBase : public TimeScheme
 	 */
 	void Update(real t_local, unsigned int substep = 0);
 
+	/** @brief Update the entities which are not integrated by the scheme,
+	 * i.e. the ground and the coupled entities, as well as the lines
+	 * unstretched length
+	 * @param t_local The local time, within the inner time step (from 0 to dt)
+	 * @see TimeSchemeBase::Update()
+	 */
+	void UpdateCoupled(real t_local);
+
 	/** @brief Compute the time derivatives and store them
 	 * @param substep The index within moordyn::TimeSchemeBase::rd where the
 	 * info will be saved
@@ -890,6 +955,12 @@ class TimeSchemeBase : public TimeScheme
 
 	/// The TimeSchemeBase::CalcStateDeriv() mask
 	mask _calc_mask;
+
+	/// The cost of each line derivatives, for the threads scheduler
+	std::vector<real> _lines_cost;
+
+	/// The cost of each rod derivatives, for the threads scheduler
+	std::vector<real> _rods_cost;
 };
 
 /** @class StationaryScheme Time.hpp
@@ -934,7 +1005,7 @@ class StationaryScheme : public TimeSchemeBase<2, 1>
 	inline unsigned int NStates() const {
 		unsigned int n = bodies.size() + rods.size() + points.size();
 		for (unsigned int i = 0; i < lines.size(); i++)
-			n += r[0].lines[i].pos.size();
+			n += r[0].lines[i].pos.cols();
 		return n;
 	}
 
@@ -1161,6 +1232,360 @@ class RK4Scheme : public TimeSchemeBase<5, 4>
 	virtual void Step(real& dt);
 };
 
+/** @class EmbeddedRKSchemeBase Time.hpp
+ * @brief A generic adaptive Runge-Kutta scheme with embedded error estimation
+ *
+ * On each step two solutions of different order are computed with the same
+ * derivatives. Their difference is an estimation of the local error, which is
+ * used to reject the step or to choose the next time step, so that the error
+ * stays below TimeScheme::tol.
+ *
+ * The time step is also bounded by the TimeScheme::cfl factor, and by the
+ * time step provided to EmbeddedRKSchemeBase::Step(), so the schemes never
+ * jump beyond the outer coupling time step
+ */
+template<unsigned int NSTATE, unsigned int NDERIV>
+class EmbeddedRKSchemeBase : public TimeSchemeBase<NSTATE, NDERIV>
+{
+  public:
+	/// @brief Destructor
+	virtual ~EmbeddedRKSchemeBase() {}
+
+	/** @brief Check whether the scheme is choosing its own time step
+	 * @return true
+	 */
+	bool IsAdaptive() const { return true; }
+
+	/** @brief Create an initial state for all the entities
+	 * @note Just the first state is written. None of the following states, nor
+	 * the derivatives are initialized in any way.
+	 * @note It is assumed that the coupled entities were already initialized
+	 */
+	inline void Init()
+	{
+		TimeSchemeBase<NSTATE, NDERIV>::Init();
+		ComputeMaxDt();
+	}
+
+	/** @brief Resume the simulation from the stationary solution
+	 * @param state The stationary solution
+	 * @param i The index of the state variable to take
+	 */
+	inline void SetState(const MoorDynState& state, unsigned int i=0)
+	{
+		TimeSchemeBase<NSTATE, NDERIV>::SetState(state, i);
+		ComputeMaxDt();
+	}
+
+  protected:
+	/** @brief Costructor
+	 * @param log Logging handler
+	 * @param waves The simulation waves object, needed so that we can tell it
+	 * about substeps
+	 * @param order The order of the embedded solution, used to estimate the
+	 * next time step
+	 */
+	EmbeddedRKSchemeBase(moordyn::Log* log,
+	                     moordyn::WavesRef waves,
+	                     unsigned int order)
+	  : TimeSchemeBase<NSTATE, NDERIV>(log, waves)
+	  , _order(order)
+	  , _dt(0.0)
+	  , _dt_max((std::numeric_limits<real>::max)())
+	  , _fsal(false)
+	{
+	}
+
+	/** @brief Get the time step to try
+	 * @param dt The maximum time step
+	 * @return The time step
+	 */
+	inline real TrialDt(const real& dt) const
+	{
+		real h = (std::min)(dt, _dt_max);
+		if (_dt > 0.0)
+			h = (std::min)(h, _dt);
+		return h;
+	}
+
+	/** @brief Check whether the first derivative of the step is already
+	 * available, i.e. it is the last one of the previous step (FSAL)
+	 *
+	 * The last derivative is not reused at the beginning of each outer time
+	 * step, since the coupled entities might have been moved
+	 * @return true if the derivative can be reused, false otherwise
+	 */
+	inline bool FSAL() const { return _fsal && (this->t_local > 0.0); }
+
+	/** @brief Estimate the error of the step
+	 *
+	 * A mixed absolute and relative error is considered for each state
+	 * variable, and the largest one is returned
+	 * @param y0 The state at the beginning of the step
+	 * @param y The high order solution
+	 * @param y_low The low order solution
+	 * @return The error, relative to the tolerance. Values below 1 mean that
+	 * the step can be accepted
+	 */
+	inline real Error(const MoorDynState& y0,
+	                  const MoorDynState& y,
+	                  const MoorDynState& y_low) const
+	{
+		if (!y.Data().size())
+			return 0.0;
+		return ((y.Data() - y_low.Data()).array().abs() /
+		        (this->tol * (1.0 + y0.Data().array().abs().max(
+		                                y.Data().array().abs()))))
+		    .maxCoeff();
+	}
+
+	/** @brief Accept or reject the step, and compute the next time step
+	 * @param h The tried time step. On rejection, it is replaced by the
+	 * time step to try
+	 * @param dt The maximum time step, as provided to
+	 * EmbeddedRKSchemeBase::Step()
+	 * @param err The error returned by EmbeddedRKSchemeBase::Error()
+	 * @return true if the step is accepted, false otherwise
+	 * @throw moordyn::unhandled_error If the time step becomes too small
+	 */
+	bool Accept(real& h, const real& dt, const real& err);
+
+	/** @brief Mark the last computed derivative as valid for the next step
+	 * @param valid true if it can be reused, false otherwise
+	 */
+	inline void SetFSAL(bool valid) { _fsal = valid; }
+
+  private:
+	/** @brief Compute the maximum time step from the TimeScheme::cfl factor
+	 */
+	void ComputeMaxDt();
+
+	/// Order of the embedded solution
+	unsigned int _order;
+
+	/// The next time step to try, 0 if it is still unknown
+	real _dt;
+
+	/// The maximum time step, given by the CFL factor
+	real _dt_max;
+
+	/// Whether the last derivative can be reused on the next step
+	bool _fsal;
+};
+
+/** @class RK23Scheme Time.hpp
+ * @brief Adaptive 3rd order Bogacki-Shampine Runge-Kutta time scheme
+ *
+ * The error is estimated with an embedded 2nd order solution. The last
+ * derivative is evaluated on the new state, so it is reused as the first one
+ * of the next step (First Same As Last). Thus just 3 derivatives are
+ * computed per accepted time step
+ */
+class RK23Scheme : public EmbeddedRKSchemeBase<3, 4>
+{
+  public:
+	/** @brief Constructor
+	 * @param log Logging handler
+	 * @param waves Waves instance
+	 */
+	RK23Scheme(moordyn::Log* log, WavesRef waves);
+
+	/// @brief Destructor
+	~RK23Scheme() {}
+
+	/** @brief Run a time step
+	 *
+	 * This function is the one that must be specialized on each time scheme
+	 * @param dt Time step. On output, the time step actually taken, which
+	 * might be smaller
+	 */
+	virtual void Step(real& dt);
+};
+
+/** @class RK45Scheme Time.hpp
+ * @brief Adaptive 5th order Dormand-Prince Runge-Kutta time scheme
+ *
+ * The error is estimated with an embedded 4th order solution. The last
+ * derivative is evaluated on the new state, so it is reused as the first one
+ * of the next step (First Same As Last). Thus just 6 derivatives are
+ * computed per accepted time step
+ */
+class RK45Scheme : public EmbeddedRKSchemeBase<3, 7>
+{
+  public:
+	/** @brief Constructor
+	 * @param log Logging handler
+	 * @param waves Waves instance
+	 */
+	RK45Scheme(moordyn::Log* log, WavesRef waves);
+
+	/// @brief Destructor
+	~RK45Scheme() {}
+
+	/** @brief Run a time step
+	 *
+	 * This function is the one that must be specialized on each time scheme
+	 * @param dt Time step. On output, the time step actually taken, which
+	 * might be smaller
+	 */
+	virtual void Step(real& dt);
+};
+
+/** @class MultirateRK2Scheme Time.hpp
+ * @brief Multirate 2nd order Runge-Kutta time scheme
+ *
+ * Each entity is integrated with the midpoint method and its own time step,
+ * computed from its CFL factor. To this end the outer time step, which is
+ * given by the slowest entity, is divided in a power of 2 number of substeps
+ * for each entity, so the entities are synchronized at the end of the
+ * substeps of the slowest ones.
+ *
+ * The points, rods and bodies are always at least as fast as the lines
+ * attached to them, so they are integrated first, considering the forces of
+ * the slow lines at the beginning of their substep. Then the lines are
+ * integrated with the kinematics of their end points linearly interpolated
+ * along the substep.
+ *
+ * Thus, a few stiff lines are not forcing small time steps on the rest of
+ * the system
+ */
+class MultirateRK2Scheme : public TimeSchemeBase<2, 2>
+{
+  public:
+	/** @brief Constructor
+	 * @param log Logging handler
+	 * @param waves Waves instance
+	 */
+	MultirateRK2Scheme(moordyn::Log* log, WavesRef waves);
+
+	/// @brief Destructor
+	~MultirateRK2Scheme() {}
+
+	/** @brief Check whether the scheme is integrating each entity with its
+	 * own time step
+	 * @return true
+	 */
+	bool IsMultirate() const { return true; }
+
+	/** @brief Create an initial state for all the entities
+	 * @note Just the first state is written. None of the following states, nor
+	 * the derivatives are initialized in any way.
+	 * @note It is assumed that the coupled entities were already initialized
+	 */
+	void Init();
+
+	/** @brief Resume the simulation from the stationary solution
+	 * @param state The stationary solution
+	 * @param i The index of the state variable to take
+	 */
+	void SetState(const MoorDynState& state, unsigned int i=0);
+
+	/** @brief Run a time step
+	 *
+	 * This function is the one that must be specialized on each time scheme
+	 * @param dt Time step. On output, the time step actually taken, which
+	 * might be smaller
+	 */
+	virtual void Step(real& dt);
+
+	/** @brief Get the number of substeps a line took on the last time step
+	 * @param i The line index
+	 * @return The number of substeps
+	 */
+	inline unsigned int GetLineSubsteps(unsigned int i) const
+	{
+		return _n.lines.at(i);
+	}
+
+  private:
+	/** @brief Compute the time step of each entity
+	 *
+	 * This can be done since we know the TimeScheme::cfl factor
+	 */
+	void ComputeDt();
+
+	/** @brief Integrate a point along its substep
+	 * @param i The point index
+	 * @param h The substep
+	 */
+	void StepPoint(unsigned int i, real h);
+
+	/** @brief Integrate a rod along its substep
+	 * @param i The rod index
+	 * @param h The substep
+	 */
+	void StepRod(unsigned int i, real h);
+
+	/** @brief Integrate a body along its substep
+	 * @param i The body index
+	 * @param h The substep
+	 */
+	void StepBody(unsigned int i, real h);
+
+	/** @brief Integrate a line along its substep
+	 *
+	 * The end points are already moved to the end of the substep
+	 * @param i The line index
+	 * @param t0 The simulation time at the beginning of the time step
+	 * @param tau The local time at the beginning of the substep, relative
+	 * to @p t0
+	 * @param h The substep
+	 */
+	void StepLine(unsigned int i, real t0, real tau, real h);
+
+	/** @brief Get the number of substeps of an entity, warning if it is
+	 * capped
+	 *
+	 * The warning is just logged the first time the entity is capped
+	 * @param dt The time step
+	 * @param dt0 The maximum time step of the entity
+	 * @param capped The flags of the entities already capped
+	 * @param i The entity index
+	 * @param type The entity type, for the warning
+	 * @param number The entity number, for the warning
+	 * @return The number of substeps
+	 */
+	unsigned int Substeps(real dt,
+	                      real dt0,
+	                      std::vector<bool>& capped,
+	                      unsigned int i,
+	                      const char* type,
+	                      int number);
+
+	/** @brief A value for each entity
+	 */
+	template<typename T>
+	struct per_entity
+	{
+		/// The lines values
+		std::vector<T> lines;
+		/// The points values
+		std::vector<T> points;
+		/// The rods values
+		std::vector<T> rods;
+		/// The bodies values
+		std::vector<T> bodies;
+	};
+
+	/// The maximum time step of each entity
+	per_entity<real> _dt0;
+
+	/// The number of substeps of each entity on the current time step
+	per_entity<unsigned int> _n;
+
+	/// Whether the number of substeps of each entity was ever capped
+	per_entity<bool> _capped;
+
+	/// The end points kinematics of each line at the beginning of its substep
+	std::vector<std::array<vec, 4>> _ends;
+
+	/// The time step of the slowest entity
+	real _dt_max;
+
+	/// Whether the lines derivatives are already computed
+	bool _ready;
+};
+
 /** @class ABScheme Time.hpp
  * @brief Adam-Bashforth time schemes collection
  *
@@ -1355,6 +1780,8 @@ class AndersonSchemeBase : public ImplicitSchemeBase<NSTATE, NDERIV>
 	 * @param tol Minimum residue to consider that the solution has converged
 	 * @param tol_rel Relative residue reduction to consider that the solution
 	 * has converged
+	 * @param regularization Relative threshold to discard the new residues
+	 * variations which are linearly dependent on the previous ones
 	 */
 	AndersonSchemeBase(moordyn::Log* log,
 	                   WavesRef waves,
@@ -1390,6 +1817,11 @@ class AndersonSchemeBase : public ImplicitSchemeBase<NSTATE, NDERIV>
 	inline unsigned int iters() const { return _iters; }
 
 	/** @brief Produce a new estimation
+	 *
+	 * The least squares problem is solved with a QR factorization of the
+	 * residues variations, which is updated as the variations are added and
+	 * removed from the history, so the cost of each iteration is O(n m), with
+	 * n the number of dofs and m the history length
 	 * @param iter The current iteration
 	 * @param org The input point, x
 	 * @param dst The input eval, f(x), as well as the output
@@ -1403,7 +1835,7 @@ class AndersonSchemeBase : public ImplicitSchemeBase<NSTATE, NDERIV>
 	 */
 	inline bool converged() const
 	{
-		const real g = _g.col(1).cwiseAbs().mean();
+		const real g = _g.col(_cur).cwiseAbs().mean();
 		return (g < _tol) || (g / _g0 < _tol_rel);
 	}
 
@@ -1414,8 +1846,9 @@ class AndersonSchemeBase : public ImplicitSchemeBase<NSTATE, NDERIV>
 	 */
 	inline const std::tuple<real, real> residue(unsigned int ago=0) const
 	{
-		return { _g.col(1 - ago).cwiseAbs().mean(),
-		         _g.col(1 - ago).cwiseAbs().maxCoeff() };
+		const unsigned int col = ago ? 1 - _cur : _cur;
+		return { _g.col(col).cwiseAbs().mean(),
+		         _g.col(col).cwiseAbs().maxCoeff() };
 	}
 
   private:
@@ -1446,60 +1879,71 @@ class AndersonSchemeBase : public ImplicitSchemeBase<NSTATE, NDERIV>
 	/// The residues list
 	Eigen::Matrix<real, Eigen::Dynamic, 2> _g;
 
-	/// The evaluation points variation matrix
+	/// The column of _x and _g with the latest data
+	unsigned int _cur;
+
+	/// The evaluation points variation history, as a ring buffer
 	Eigen::MatrixXr _X;
 
-	/// The residues variation matrix
+	/// The residues variation history, as a ring buffer
 	Eigen::MatrixXr _G;
 
+	/// The ring buffers column with the oldest variation
+	unsigned int _head;
+
+	/// The number of variations in the history
+	unsigned int _k;
+
+	/// The orthonormal factor of the residues variations history
+	Eigen::MatrixXr _Q;
+
+	/// The upper triangular factor of the residues variations history
+	Eigen::MatrixXr _R;
+
+	/// The least squares solution
+	Eigen::VectorXr _gamma;
+
+	/** @brief Add the last variation to the QR factorization
+	 *
+	 * If the variation is linearly dependent on the ones already in the
+	 * history, it is discarded
+	 * @param col The ring buffers column with the variation
+	 */
+	void append(unsigned int col);
+
+	/** @brief Remove the oldest variation from the QR factorization
+	 */
+	void downdate();
+
+	/** @brief Compute the new accelerations from the latest evaluation point
+	 * and residue, and the least squares solution, integrating them as the
+	 * velocities
+	 * @param org The point, x
+	 * @param dst The output
+	 * @param dt The time step to integrate the acceleration as the velocity
+	 */
+	void estimate(unsigned int org, unsigned int dst, float dt);
+
 	/** @brief Compute the number of acceleration DOFs
 	 * @return The number of acceleration DOFs
 	 */
 	inline unsigned int ndof() const {
-		unsigned int n = 3 * this->points.size() + 6 * (this->bodies.size() + this->rods.size());
-		for (unsigned int i = 0; i < this->lines.size(); i++)
-			n += 3 * this->rd[0].lines[i].acc.size();
-		return n;
+		return this->rd[0].Acc().size();
 	}
 
-	/** @brief Fill the last column of the X matrix
+	/** @brief Fill the latest evaluation point and residue
+	 *
+	 * The oldest ones are overwritten
 	 * @param org The point, x
 	 * @param dst The eval, f(x)
 	 * @note This function is assuming that the matrix is already resized
 	 */
 	inline void fill(unsigned int org, unsigned int dst)
 	{
-		unsigned int i, j, n = 0;
-		for (i = 0; i < this->lines.size(); i++) {
-			for (j = 0; j < this->rd[org].lines[i].acc.size(); j++) {
-				const vec x = this->rd[org].lines[i].acc[j];
-				const vec fx = this->rd[dst].lines[i].acc[j];
-				_x(Eigen::seqN(n, 3), 1) = x;
-				_g(Eigen::seqN(n, 3), 1) = fx - x;
-				n += 3;
-			}
-		}
-		for (i = 0; i < this->points.size(); i++) {
-			const vec x = this->rd[org].points[i].acc;
-			const vec fx = this->rd[dst].points[i].acc;
-			_x(Eigen::seqN(n, 3), 1) = x;
-			_g(Eigen::seqN(n, 3), 1) = fx - x;
-			n += 3;
-		}
-		for (i = 0; i < this->rods.size(); i++) {
-			const vec6 x = this->rd[org].rods[i].acc;
-			const vec6 fx = this->rd[dst].rods[i].acc;
-			_x(Eigen::seqN(n, 6), 1) = x;
-			_g(Eigen::seqN(n, 6), 1) = fx - x;
-			n += 6;
-		}
-		for (i = 0; i < this->bodies.size(); i++) {
-			const vec6 x = this->rd[org].bodies[i].acc;
-			const vec6 fx = this->rd[dst].bodies[i].acc;
-			_x(Eigen::seqN(n, 6), 1) = x;
-			_g(Eigen::seqN(n, 6), 1) = fx - x;
-			n += 6;
-		}
+		// The accelerations are contiguous on the state buffers
+		_cur = 1 - _cur;
+		_x.col(_cur) = this->rd[org].Acc();
+		_g.col(_cur) = this->rd[dst].Acc() - _x.col(_cur);
 	}
 };
 
@@ -1540,6 +1984,122 @@ class ImplicitEulerScheme : public ImplicitSchemeBase<2, 2>
 	real _dt_factor;
 };
 
+/** @class NewtonEulerScheme Time.hpp
+ * @brief Implicit 1st order Euler time scheme solved with Newton iterations
+ *
+ * The same backward Euler method of moordyn::ImplicitEulerScheme, but the
+ * derivatives are found with an inexact Newton-Krylov method instead of
+ * relaxed fixed point iterations. On each Newton iteration the whole system,
+ * i.e. the lines, points, rods and bodies, is linearized and solved at once
+ * with a few GMRES iterations, where the products by the Jacobian are
+ * approximated by finite differences of the states derivatives.
+ *
+ * GMRES is preconditioned with the Jacobians of the lines, which are block
+ * tridiagonal (see moordyn::Line::getStateDerivJacobian()), so they can be
+ * factorized and solved in O(N) operations. Those Jacobians are computed on
+ * the first iteration of each time step. Thus, if the system is only made of
+ * lines, a single GMRES iteration is usually enough, and the coupling with
+ * the points, rods and bodies is resolved by the following GMRES iterations.
+ *
+ * The velocities of the lines and the free points are not unknowns, but they
+ * are computed from the accelerations. The iterations are stopped as soon as
+ * the accelerations residue falls below TimeScheme::tol
+ */
+class NewtonEulerScheme : public ImplicitSchemeBase<2, 3>
+{
+  public:
+	/** @brief Constructor
+	 * @param log Logging handler
+	 * @param waves Waves instance
+	 * @param iters The maximum number of Newton iterations
+	 */
+	NewtonEulerScheme(moordyn::Log* log,
+	                  WavesRef waves,
+	                  unsigned int iters = 10);
+
+	/// @brief Destructor
+	virtual ~NewtonEulerScheme() {}
+
+	/** @brief Run a time step
+	 *
+	 * This function is the one that must be specialized on each time scheme
+	 * @param dt Time step
+	 */
+	virtual void Step(real& dt);
+
+  private:
+	/** @brief Compute and factorize the Jacobians of the lines
+	 * @param dt Time step
+	 */
+	void Jacobians(real dt);
+
+	/** @brief Set the unknowns mask, NewtonEulerScheme::_free
+	 */
+	void Unknowns();
+
+	/** @brief Compute the velocities of the lines and free points from their
+	 * accelerations
+	 * @param x The states derivatives to modify
+	 * @param vel0 The initial velocity factor, i.e. 1.0 to add the velocities
+	 * at the beginning of the time step, 0.0 for perturbations
+	 * @param dt Time step
+	 */
+	void Velocities(DMoorDynStateDt& x, real vel0, real dt);
+
+	/** @brief Apply the preconditioner
+	 *
+	 * The lines accelerations are solved with their Jacobians, while the
+	 * rest of unknowns are left untouched. The velocities of the lines and
+	 * points are computed afterwards, see NewtonEulerScheme::Velocities()
+	 * @param v The vector to precondition
+	 * @param z The preconditioned vector
+	 * @param dt Time step
+	 */
+	void Precondition(const Eigen::Ref<const Eigen::VectorXr>& v,
+	                  Eigen::VectorXr& z,
+	                  real dt);
+
+	/** @brief Solve the Newton correction with GMRES
+	 *
+	 * The residue shall be already computed on NewtonEulerScheme::_V first
+	 * column. The correction is stored on NewtonEulerScheme::_z
+	 * @param dt Time step
+	 */
+	void Krylov(real dt);
+
+	/** @brief Check whether the accelerations have converged
+	 *
+	 * The accelerations evaluated on rd[0] are compared with the ones
+	 * assumed to compute them, on rd[1]
+	 * @return true if the residue is below TimeScheme::tol, false otherwise
+	 */
+	bool Converged() const;
+
+	/// The Jacobian of each line
+	std::vector<BlockTridiagonal> _jac;
+
+	/// The mask of the unknowns, 1 for the unknowns and 0 otherwise
+	DMoorDynStateDt _free;
+
+	/// The Krylov subspace basis
+	Eigen::MatrixXr _V;
+
+	/// The Hessenberg matrix
+	Eigen::MatrixXr _H;
+
+	/// The Givens rotations cosines
+	Eigen::VectorXr _cs;
+
+	/// The Givens rotations sines
+	Eigen::VectorXr _sn;
+
+	/// The GMRES residues
+	Eigen::VectorXr _g;
+
+	/// The preconditioned Krylov vector, and the final Newton correction
+	Eigen::VectorXr _z;
+};
+
 /** @class AndersonEulerScheme Time.hpp
  * @brief Implicit 1st order Euler time scheme
  *
@@ -1616,6 +2176,8 @@ class ImplicitNewmarkScheme : public ImplicitSchemeBase<2, 3>
 	real _gamma;
 	/// Beta factor
 	real _beta;
+	/// Storage for the Newmark rates of change, to avoid allocations
+	DMoorDynStateDt _rd_tmp;
 };
 
 /** @class ImplicitNewmarkScheme Time.hpp
@@ -1658,6 +2220,8 @@ class ImplicitWilsonScheme : public ImplicitSchemeBase<2, 3>
   private:
 	/// Theta factor
 	real _theta;
+	/// Storage for the Wilson rates of change, to avoid allocations
+	DMoorDynStateDt _rd_tmp;
 };
 
 /** @brief Create a time scheme
@@ -0,0 +1,82 @@
+/*
+ * Copyright (c) 2023, Jose Luis Cercos-Pita & Matt Hall
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ * 1. Redistributions of source code must retain the above copyright notice,
+ *    this list of conditions and the following disclaimer.
+ *
+ * 2. Redistributions in binary form must reproduce the above copyright notice,
+ *    this list of conditions and the following disclaimer in the documentation
+ *    and/or other materials provided with the distribution.
+ *
+ * 3. Neither the name of the copyright holder nor the names of its
+ *    contributors may be used to endorse or promote products derived from
+ *    this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE
+ * LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ * INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+ * CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#include "BlockTridiagonal.hpp"
+
+namespace moordyn {
+
+void
+BlockTridiagonal::resize(unsigned int n)
+{
+	lower.assign(n, mat::Zero());
+	diag.assign(n, mat::Zero());
+	upper.assign(n, mat::Zero());
+	_pivot_inv.resize(n);
+	_l.resize(n);
+}
+
+void
+BlockTridiagonal::factorize()
+{
+	const unsigned int n = size();
+	if (!n)
+		return;
+	bool invertible;
+	real det;
+	diag[0].computeInverseAndDetWithCheck(_pivot_inv[0], det, invertible);
+	if (!invertible)
+		throw moordyn::nan_error("Singular block tridiagonal matrix");
+	for (unsigned int i = 1; i < n; i++) {
+		_l[i] = lower[i] * _pivot_inv[i - 1];
+		const mat pivot = diag[i] - _l[i] * upper[i - 1];
+		pivot.computeInverseAndDetWithCheck(_pivot_inv[i], det, invertible);
+		if (!invertible)
+			throw moordyn::nan_error("Singular block tridiagonal matrix");
+	}
+}
+
+void
+BlockTridiagonal::solve(Eigen::Ref<Eigen::Matrix3Xr> b) const
+{
+	const unsigned int n = size();
+	if (b.cols() != n)
+		throw moordyn::invalid_value_error("Invalid right hand side size");
+	if (!n)
+		return;
+	// Forward substitution
+	for (unsigned int i = 1; i < n; i++)
+		b.col(i) -= _l[i] * b.col(i - 1);
+	// Backward substitution
+	b.col(n - 1) = _pivot_inv[n - 1] * b.col(n - 1);
+	for (int i = (int)n - 2; i >= 0; i--)
+		b.col(i) = _pivot_inv[i] * (b.col(i) - upper[i] * b.col(i + 1));
+}
+
+} // ::moordyn
@@ -0,0 +1,110 @@
+/*
+ * Copyright (c) 2023, Jose Luis Cercos-Pita & Matt Hall
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ * 1. Redistributions of source code must retain the above copyright notice,
+ *    this list of conditions and the following disclaimer.
+ *
+ * 2. Redistributions in binary form must reproduce the above copyright notice,
+ *    this list of conditions and the following disclaimer in the documentation
+ *    and/or other materials provided with the distribution.
+ *
+ * 3. Neither the name of the copyright holder nor the names of its
+ *    contributors may be used to endorse or promote products derived from
+ *    this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE
+ * LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ * INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+ * CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ */
+
+/** @file BlockTridiagonal.hpp
+ * Block tridiagonal linear systems, with 3x3 blocks
+ */
+
+#pragma once
+
+#include "Misc.hpp"
+#include <vector>
+
+namespace moordyn {
+
+/** @class BlockTridiagonal BlockTridiagonal.hpp
+ * @brief Block tridiagonal matrix of 3x3 blocks, with an O(n) solver
+ *
+ * This is the structure of the Jacobian of the lines, where each node is only
+ * interacting with the adjacent ones. The system is solved with the block
+ * version of the Thomas algorithm, i.e. a LU factorization without pivoting
+ * among blocks, which is stable as long as the matrix is block diagonally
+ * dominant, as it is the case of the implicit time integration Jacobians for
+ * small enough time steps
+ */
+class BlockTridiagonal
+{
+  public:
+	/** @brief Constructor
+	 * @param n The number of block rows
+	 */
+	BlockTridiagonal(unsigned int n = 0) { resize(n); }
+
+	/** @brief Destructor
+	 */
+	~BlockTridiagonal() {}
+
+	/** @brief Set the number of block rows
+	 *
+	 * All the blocks are set to zero
+	 * @param n The number of block rows
+	 */
+	void resize(unsigned int n);
+
+	/** @brief Get the number of block rows
+	 * @return The number of block rows
+	 */
+	inline unsigned int size() const { return (unsigned int)diag.size(); }
+
+	/** @brief Factorize the matrix, so the systems can be later solved
+	 *
+	 * This shall be called after setting the blocks, and before calling
+	 * moordyn::BlockTridiagonal::solve()
+	 * @throws nan_error If any of the pivot blocks is singular
+	 */
+	void factorize();
+
+	/** @brief Solve the system in place
+	 * @param b The right hand side, one block row per column. It is replaced
+	 * by the solution
+	 * @throws invalid_value_error If the number of columns of @p b does not
+	 * match the number of block rows
+	 */
+	void solve(Eigen::Ref<Eigen::Matrix3Xr> b) const;
+
+	/// The blocks below the diagonal. The first one is not used
+	std::vector<mat> lower;
+
+	/// The diagonal blocks
+	std::vector<mat> diag;
+
+	/// The blocks above the diagonal. The last one is not used
+	std::vector<mat> upper;
+
+  private:
+	/// The inverse of the pivot blocks of the factorization
+	std::vector<mat> _pivot_inv;
+
+	/// The lower blocks of the factorization, premultiplied by the inverse
+	/// of the previous pivot block
+	std::vector<mat> _l;
+};
+
+} // ::moordyn
@@ -0,0 +1,484 @@
+/*
+ * Copyright (c) 2023, Jose Luis Cercos-Pita & Matt Hall
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ * 1. Redistributions of source code must retain the above copyright notice,
+ *    this list of conditions and the following disclaimer.
+ *
+ * 2. Redistributions in binary form must reproduce the above copyright notice,
+ *    this list of conditions and the following disclaimer in the documentation
+ *    and/or other materials provided with the distribution.
+ *
+ * 3. Neither the name of the copyright holder nor the names of its
+ *    contributors may be used to endorse or promote products derived from
+ *    this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE
+ * LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ * INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+ * CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ */
+
+/** @file Grid4D.hpp
+ * Flat storage of data on 4-D rectilinear grids
+ */
+
+#pragma once
+
+#include "Misc.hpp"
+#include <vector>
+#include <memory>
+
+namespace moordyn {
+
+/** @class Grid4D Grid4D.hpp
+ * @brief Several fields stored on a 4-D rectilinear grid, (x, y, z, t)
+ *
+ * All the fields are interleaved in a single contiguous array, so each grid
+ * point is a block of N components. The blocks are aligned to their size, so
+ * with N = 8 each grid point is occupying exactly one 64 bytes cache line in
+ * double precision. The time is the fastest varying index, so the two time
+ * instants required to interpolate are consecutive in memory.
+ *
+ * The data can be optionally stored in single precision, to halve the memory
+ * footprint. It is anyway returned in moordyn::real precision.
+ *
+ * The data can be either owned by the grid or borrowed from an external
+ * memory region, like a memory-mapped file (see Grid4D::map()). The borrowed
+ * data is never modified, but copied on the first write.
+ * @tparam N Number of components per grid point. It shall be a power of 2
+ */
+template<unsigned int N>
+class Grid4D
+{
+	static_assert((N > 0) && ((N & (N - 1)) == 0),
+	              "The number of components shall be a power of 2");
+
+  public:
+	/** @brief Constructor
+	 *
+	 * The grid is empty until Grid4D::resize() is called
+	 */
+	Grid4D()
+	  : _nx(0)
+	  , _ny(0)
+	  , _nz(0)
+	  , _nt(0)
+	  , _single(false)
+	  , _r32(nullptr)
+	  , _r64(nullptr)
+	{
+	}
+
+	/** @brief Copy constructor
+	 *
+	 * The owned data is copied, while the borrowed data is shared
+	 * @param other The grid to copy
+	 */
+	Grid4D(const Grid4D& other)
+	  : _nx(other._nx)
+	  , _ny(other._ny)
+	  , _nz(other._nz)
+	  , _nt(other._nt)
+	  , _single(other._single)
+	  , _f32(other._f32)
+	  , _f64(other._f64)
+	  , _owner(other._owner)
+	{
+		point(&other);
+	}
+
+	/// Move constructor
+	Grid4D(Grid4D&&) = default;
+
+	/// Move assignment
+	Grid4D& operator=(Grid4D&&) = default;
+
+	/** @brief Copy assignment
+	 * @param other The grid to copy
+	 * @return This grid
+	 * @see Grid4D(const Grid4D&)
+	 */
+	Grid4D& operator=(const Grid4D& other)
+	{
+		_nx = other._nx;
+		_ny = other._ny;
+		_nz = other._nz;
+		_nt = other._nt;
+		_single = other._single;
+		_f32 = other._f32;
+		_f64 = other._f64;
+		_owner = other._owner;
+		point(&other);
+		return *this;
+	}
+
+	/** @brief Allocate the grid, with all the components set to zero
+	 * @param nx Number of points in the x direction
+	 * @param ny Number of points in the y direction
+	 * @param nz Number of points in the z direction
+	 * @param nt Number of points in the t direction
+	 * @param single true to store the data in single precision, false to use
+	 * double precision
+	 * @throws std::bad_alloc If the memory cannot be allocated
+	 */
+	void resize(unsigned int nx,
+	            unsigned int ny,
+	            unsigned int nz,
+	            unsigned int nt,
+	            bool single = false)
+	{
+		_nx = nx;
+		_ny = ny;
+		_nz = nz;
+		_nt = nt;
+		_single = single;
+		_owner.reset();
+		_f32.clear();
+		_f64.clear();
+		_f32.shrink_to_fit();
+		_f64.shrink_to_fit();
+		if (_single)
+			_f32.assign(size(), block<float>{});
+		else
+			_f64.assign(size(), block<double>{});
+		point();
+	}
+
+	/** @brief Borrow the data from an external memory region
+	 *
+	 * The memory shall be laid out as the one returned by Grid4D::data(),
+	 * and aligned to N times the size of the scalar
+	 * @param data The data
+	 * @param nx Number of points in the x direction
+	 * @param ny Number of points in the y direction
+	 * @param nz Number of points in the z direction
+	 * @param nt Number of points in the t direction
+	 * @param single true if the data is stored in single precision, false
+	 * otherwise
+	 * @param owner The object owning the memory region, which is kept alive
+	 * while the data is borrowed
+	 */
+	void map(const void* data,
+	         unsigned int nx,
+	         unsigned int ny,
+	         unsigned int nz,
+	         unsigned int nt,
+	         bool single,
+	         std::shared_ptr<const void> owner)
+	{
+		_nx = nx;
+		_ny = ny;
+		_nz = nz;
+		_nt = nt;
+		_single = single;
+		_f32.clear();
+		_f64.clear();
+		_f32.shrink_to_fit();
+		_f64.shrink_to_fit();
+		_owner = owner;
+		_r32 = _single ? (const block<float>*)data : nullptr;
+		_r64 = _single ? nullptr : (const block<double>*)data;
+	}
+
+	/** @brief Check whether the data is borrowed from an external region
+	 * @return true if the data is borrowed, false if it is owned
+	 */
+	inline bool mapped() const { return (bool)_owner; }
+
+	/** @brief Check whether the data is stored in single precision
+	 * @return true if the data is stored in single precision, false otherwise
+	 */
+	inline bool single() const { return _single; }
+
+	/** @brief Get the allocated memory
+	 * @return The size of the data, in bytes
+	 */
+	inline size_t bytes() const
+	{
+		return size() * (_single ? sizeof(block<float>) : sizeof(block<double>));
+	}
+
+	/** @brief Get the raw data
+	 * @return The grid points blocks, with the time as the fastest varying
+	 * index
+	 */
+	inline const void* data() const
+	{
+		return _single ? (const void*)_r32 : (const void*)_r64;
+	}
+
+	/** @brief Get a component
+	 * @param ix The x index
+	 * @param iy The y index
+	 * @param iz The z index
+	 * @param it The t index
+	 * @param c The component
+	 * @return The value
+	 */
+	inline real get(unsigned int ix,
+	                unsigned int iy,
+	                unsigned int iz,
+	                unsigned int it,
+	                unsigned int c) const
+	{
+		const size_t i = index(ix, iy, iz, it);
+		return _single ? (real)_r32[i].v[c] : (real)_r64[i].v[c];
+	}
+
+	/** @brief Set a component
+	 * @param ix The x index
+	 * @param iy The y index
+	 * @param iz The z index
+	 * @param it The t index
+	 * @param c The component
+	 * @param v The value
+	 */
+	inline void set(unsigned int ix,
+	                unsigned int iy,
+	                unsigned int iz,
+	                unsigned int it,
+	                unsigned int c,
+	                real v)
+	{
+		if (_owner)
+			detach();
+		const size_t i = index(ix, iy, iz, it);
+		if (_single)
+			_f32[i].v[c] = (float)v;
+		else
+			_f64[i].v[c] = (double)v;
+	}
+
+	/** @brief Get 3 consecutive components as a vector
+	 * @param ix The x index
+	 * @param iy The y index
+	 * @param iz The z index
+	 * @param it The t index
+	 * @param c The first component
+	 * @return The vector
+	 */
+	inline vec3 getVec(unsigned int ix,
+	                   unsigned int iy,
+	                   unsigned int iz,
+	                   unsigned int it,
+	                   unsigned int c) const
+	{
+		return vec3(get(ix, iy, iz, it, c),
+		            get(ix, iy, iz, it, c + 1),
+		            get(ix, iy, iz, it, c + 2));
+	}
+
+	/** @brief Set 3 consecutive components from a vector
+	 * @param ix The x index
+	 * @param iy The y index
+	 * @param iz The z index
+	 * @param it The t index
+	 * @param c The first component
+	 * @param v The vector
+	 */
+	inline void setVec(unsigned int ix,
+	                   unsigned int iy,
+	                   unsigned int iz,
+	                   unsigned int it,
+	                   unsigned int c,
+	                   const vec3& v)
+	{
+		for (unsigned int i = 0; i < 3; i++)
+			set(ix, iy, iz, it, c + i, v[i]);
+	}
+
+	/** @brief Quadrilinear interpolation of all the components
+	 * @param i The upper bound index in the x direction
+	 * @param j The upper bound index in the y direction
+	 * @param k The upper bound index in the z direction
+	 * @param w The upper bound index in the t direction
+	 * @param fx The linear interplation factor in the x direction
+	 * @param fy The linear interplation factor in the y direction
+	 * @param fz The linear interplation factor in the z direction
+	 * @param fw The linear interplation factor in the t direction
+	 * @param out The N interpolated components
+	 * @see interp_factor
+	 * @see interp4
+	 */
+	inline void interp(unsigned int i,
+	                   unsigned int j,
+	                   unsigned int k,
+	                   unsigned int w,
+	                   real fx,
+	                   real fy,
+	                   real fz,
+	                   real fw,
+	                   real* out) const
+	{
+		interp(i, j, k, w > 0 ? w - 1 : 0, w, fx, fy, fz, fw, out);
+	}
+
+	/** @brief Quadrilinear interpolation of all the components, between two
+	 * arbitrary time indexes
+	 *
+	 * This is useful when the time samples are stored on a ring buffer, so
+	 * the lower bound is not necessarily right before the upper bound
+	 * @param i The upper bound index in the x direction
+	 * @param j The upper bound index in the y direction
+	 * @param k The upper bound index in the z direction
+	 * @param w0 The lower bound index in the t direction
+	 * @param w1 The upper bound index in the t direction
+	 * @param fx The linear interplation factor in the x direction
+	 * @param fy The linear interplation factor in the y direction
+	 * @param fz The linear interplation factor in the z direction
+	 * @param fw The linear interplation factor in the t direction
+	 * @param out The N interpolated components
+	 */
+	inline void interp(unsigned int i,
+	                   unsigned int j,
+	                   unsigned int k,
+	                   unsigned int w0,
+	                   unsigned int w1,
+	                   real fx,
+	                   real fy,
+	                   real fz,
+	                   real fw,
+	                   real* out) const
+	{
+		if (_single)
+			interp(_r32, i, j, k, w0, w1, fx, fy, fz, fw, out);
+		else
+			interp(_r64, i, j, k, w0, w1, fx, fy, fz, fw, out);
+	}
+
+  private:
+	/** @brief The components of a grid point
+	 */
+	template<typename T>
+	struct alignas(N * sizeof(T)) block
+	{
+		/// The components
+		T v[N] = {};
+	};
+
+	/** @brief Get the flat index of a grid point
+	 * @param ix The x index
+	 * @param iy The y index
+	 * @param iz The z index
+	 * @param it The t index
+	 * @return The index of the grid point block
+	 */
+	inline size_t index(unsigned int ix,
+	                    unsigned int iy,
+	                    unsigned int iz,
+	                    unsigned int it) const
+	{
+		return (((size_t)ix * _ny + iy) * _nz + iz) * _nt + it;
+	}
+
+	/** @brief Get the number of grid points
+	 * @return The number of grid points
+	 */
+	inline size_t size() const { return (size_t)_nx * _ny * _nz * _nt; }
+
+	/** @brief Point the read pointers to the data
+	 * @param other The grid where the data was copied from, if any. If the
+	 * data is borrowed, it is shared with this grid
+	 */
+	inline void point(const Grid4D* other = nullptr)
+	{
+		if (_owner && other) {
+			_r32 = other->_r32;
+			_r64 = other->_r64;
+			return;
+		}
+		_r32 = _f32.empty() ? nullptr : _f32.data();
+		_r64 = _f64.empty() ? nullptr : _f64.data();
+	}
+
+	/** @brief Copy the borrowed data, to own it
+	 */
+	void detach()
+	{
+		if (_single) {
+			_f32.assign(_r32, _r32 + size());
+			_r32 = _f32.data();
+		} else {
+			_f64.assign(_r64, _r64 + size());
+			_r64 = _f64.data();
+		}
+		_owner.reset();
+	}
+
+	/** @brief Quadrilinear interpolation of all the components
+	 * @see Grid4D::interp()
+	 */
+	template<typename T>
+	inline void interp(const block<T>* data,
+	                   unsigned int i,
+	                   unsigned int j,
+	                   unsigned int k,
+	                   unsigned int w0,
+	                   unsigned int w1,
+	                   real fx,
+	                   real fy,
+	                   real fz,
+	                   real fw,
+	                   real* out) const
+	{
+		const unsigned int ii[2] = { i > 0 ? i - 1 : 0, i };
+		const unsigned int jj[2] = { j > 0 ? j - 1 : 0, j };
+		const unsigned int kk[2] = { k > 0 ? k - 1 : 0, k };
+		const unsigned int ww[2] = { w0, w1 };
+		const real wx[2] = { 1.0 - fx, fx };
+		const real wy[2] = { 1.0 - fy, fy };
+		const real wz[2] = { 1.0 - fz, fz };
+		const real wt[2] = { 1.0 - fw, fw };
+
+		real acc[N] = {};
+		for (unsigned int a = 0; a < 2; a++) {
+			for (unsigned int b = 0; b < 2; b++) {
+				const real wxy = wx[a] * wy[b];
+				for (unsigned int c = 0; c < 2; c++) {
+					const real wxyz = wxy * wz[c];
+					for (unsigned int d = 0; d < 2; d++) {
+						const real f = wxyz * wt[d];
+						const auto& p = data[index(ii[a], jj[b], kk[c], ww[d])];
+						for (unsigned int n = 0; n < N; n++)
+							acc[n] += f * (real)p.v[n];
+					}
+				}
+			}
+		}
+		for (unsigned int n = 0; n < N; n++)
+			out[n] = acc[n];
+	}
+
+	/// Number of points in the x direction
+	unsigned int _nx;
+	/// Number of points in the y direction
+	unsigned int _ny;
+	/// Number of points in the z direction
+	unsigned int _nz;
+	/// Number of points in the t direction
+	unsigned int _nt;
+	/// Whether the data is stored in single precision or not
+	bool _single;
+	/// The single precision data
+	std::vector<block<float>> _f32;
+	/// The double precision data
+	std::vector<block<double>> _f64;
+	/// The object owning the borrowed data, if any
+	std::shared_ptr<const void> _owner;
+	/// The single precision data to read, either owned or borrowed
+	const block<float>* _r32;
+	/// The double precision data to read, either owned or borrowed
+	const block<double>* _r64;
+};
+
+} // ::moordyn
@@ -1,6 +1,8 @@
 #pragma once
 
 #include <vector>
+#include <algorithm>
+#include <cmath>
 #include "../Misc.hpp"
 namespace moordyn {
 /** \defgroup interpolation Interpolation utilities
@@ -70,7 +72,8 @@ lerp(const T& a, const T& b, const F& factor)
 }
 /** @brief One-dimensional linear interpolation factor
  *
- * This function is equivalent to calling interp_factor(xp, 1, x, f)
+ * This function is equivalent to calling interp_factor(xp, 1, x, f), but
+ * the upper bound is looked for with a binary search
  * @param xp The points where data is available
  * @param x The evaluation point
  * @param f The interpolation factor
@@ -80,9 +83,150 @@ template<typename T>
 inline unsigned int
 interp_factor(const std::vector<T>& xp, const T& x, T& f)
 {
-	return interp_factor(xp, 1, x, f);
+	if (xp.size() == 1) {
+		f = 0.0;
+		return 0;
+	}
+	if (x <= xp.front()) {
+		f = 0.0;
+		return 1;
+	}
+	if (x >= xp.back()) {
+		f = 1.0;
+		return static_cast<unsigned int>(xp.size() - 1);
+	}
+
+	const auto i = static_cast<unsigned int>(
+	    std::distance(xp.begin(), std::lower_bound(xp.begin(), xp.end(), x)));
+	f = (x - xp[i - 1]) / (xp[i] - xp[i - 1]);
+	return i;
 }
 
+/** @class InterpAxis Interp.hpp
+ * @brief An axis of a rectilinear grid, to compute the interpolation factors
+ *
+ * The axis is checked for uniform spacing on construction, in which case the
+ * upper bound is computed with direct index arithmetic. Otherwise a binary
+ * search is carried out, which can be skipped by providing a hint, like the
+ * upper bound of the same point on the previous evaluation.
+ *
+ * In both cases the results are the same than the ones of
+ * interp_factor(xp, x, f)
+ */
+class InterpAxis
+{
+  public:
+	/** @brief Constructor
+	 * @param xp The points where data is available, sorted
+	 */
+	InterpAxis(const std::vector<real>& xp = { 0.0 })
+	  : _xp(xp)
+	  , _uniform(true)
+	  , _x0(xp.front())
+	  , _idx(0.0)
+	{
+		const auto n = xp.size();
+		if (n < 2)
+			return;
+		const real dx = (xp.back() - xp.front()) / (n - 1);
+		for (unsigned int i = 1; (i < n - 1) && _uniform; i++) {
+			if (fabs(xp[i] - (_x0 + i * dx)) > 1e-6 * fabs(dx))
+				_uniform = false;
+		}
+		if (dx != 0.0)
+			_idx = 1.0 / dx;
+		else
+			_uniform = false;
+	}
+
+	/** @brief Get the points where data is available
+	 * @return The points
+	 */
+	inline const std::vector<real>& points() const { return _xp; }
+
+	/** @brief Check if the axis is uniformly spaced
+	 * @return true if the points are equally spaced, false otherwise
+	 */
+	inline bool uniform() const { return _uniform; }
+
+	/** @brief One-dimensional linear interpolation factor
+	 * @param x The evaluation point
+	 * @param f The interpolation factor
+	 * @return The index of the upper bound
+	 */
+	inline unsigned int factor(real x, real& f) const
+	{
+		if (!_uniform)
+			return interp_factor(_xp, x, f);
+
+		const auto n = static_cast<unsigned int>(_xp.size());
+		if (n == 1) {
+			f = 0.0;
+			return 0;
+		}
+		if (x <= _xp.front()) {
+			f = 0.0;
+			return 1;
+		}
+		if (x >= _xp.back()) {
+			f = 1.0;
+			return n - 1;
+		}
+		// The round off errors might put us one cell away
+		unsigned int i = static_cast<unsigned int>(ceil((x - _x0) * _idx));
+		i = (std::min)((std::max)(i, 1u), n - 1);
+		while ((i < n - 1) && (x > _xp[i]))
+			i++;
+		while ((i > 1) && (x <= _xp[i - 1]))
+			i--;
+		f = (x - _xp[i - 1]) / (_xp[i] - _xp[i - 1]);
+		return i;
+	}
+
+	/** @brief One-dimensional linear interpolation factor
+	 *
+	 * The upper bound is firstly looked for in the hinted cell and its
+	 * neighbours, and with a binary search if it is not there
+	 * @param x The evaluation point
+	 * @param hint The hinted upper bound index, which is replaced by the
+	 * found one
+	 * @param f The interpolation factor
+	 * @return The index of the upper bound
+	 */
+	inline unsigned int factor(real x, unsigned int& hint, real& f) const
+	{
+		const auto n = static_cast<unsigned int>(_xp.size());
+		if (_uniform || (n < 3) || (hint < 1) || (hint > n - 1) ||
+		    (x <= _xp.front()) || (x >= _xp.back())) {
+			hint = factor(x, f);
+			return hint;
+		}
+		unsigned int i = hint;
+		if (x > _xp[i]) {
+			i++;
+		} else if (x <= _xp[i - 1]) {
+			i--;
+		}
+		if ((x > _xp[i - 1]) && (x <= _xp[i])) {
+			f = (x - _xp[i - 1]) / (_xp[i] - _xp[i - 1]);
+			hint = i;
+			return i;
+		}
+		hint = factor(x, f);
+		return hint;
+	}
+
+  private:
+	/// The points where data is available
+	std::vector<real> _xp;
+	/// Whether the points are equally spaced
+	bool _uniform;
+	/// The first point
+	real _x0;
+	/// The inverse of the space between points, if uniform
+	real _idx;
+};
+
 /** @brief One-dimensional linear interpolation
  *
  * For monotonically increasing sample points.
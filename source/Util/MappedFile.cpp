@@ -0,0 +1,117 @@
+/*
+ * Copyright (c) 2023, Jose Luis Cercos-Pita & Matt Hall
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ * 1. Redistributions of source code must retain the above copyright notice,
+ *    this list of conditions and the following disclaimer.
+ *
+ * 2. Redistributions in binary form must reproduce the above copyright notice,
+ *    this list of conditions and the following disclaimer in the documentation
+ *    and/or other materials provided with the distribution.
+ *
+ * 3. Neither the name of the copyright holder nor the names of its
+ *    contributors may be used to endorse or promote products derived from
+ *    this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE
+ * LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ * INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+ * CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#include "MappedFile.hpp"
+
+#ifdef _WIN32
+#include <windows.h>
+#else
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+namespace moordyn {
+
+#ifdef _WIN32
+
+MappedFile::MappedFile(const std::string& path)
+  : _data(nullptr)
+  , _size(0)
+  , _file(INVALID_HANDLE_VALUE)
+  , _map(nullptr)
+{
+	_file = CreateFileA(path.c_str(),
+	                    GENERIC_READ,
+	                    FILE_SHARE_READ | FILE_SHARE_DELETE,
+	                    NULL,
+	                    OPEN_EXISTING,
+	                    FILE_ATTRIBUTE_NORMAL,
+	                    NULL);
+	if (_file == INVALID_HANDLE_VALUE)
+		throw moordyn::input_file_error("The file cannot be opened");
+	LARGE_INTEGER size;
+	if (!GetFileSizeEx(_file, &size) || !size.QuadPart) {
+		CloseHandle(_file);
+		throw moordyn::input_file_error("The file is empty");
+	}
+	_size = (size_t)size.QuadPart;
+	_map = CreateFileMappingA(_file, NULL, PAGE_READONLY, 0, 0, NULL);
+	if (!_map) {
+		CloseHandle(_file);
+		throw moordyn::input_file_error("The file cannot be mapped");
+	}
+	_data = (const unsigned char*)MapViewOfFile(_map, FILE_MAP_READ, 0, 0, 0);
+	if (!_data) {
+		CloseHandle(_map);
+		CloseHandle(_file);
+		throw moordyn::input_file_error("The file cannot be mapped");
+	}
+}
+
+MappedFile::~MappedFile()
+{
+	UnmapViewOfFile(_data);
+	CloseHandle(_map);
+	CloseHandle(_file);
+}
+
+#else
+
+MappedFile::MappedFile(const std::string& path)
+  : _data(nullptr)
+  , _size(0)
+{
+	const int fd = open(path.c_str(), O_RDONLY);
+	if (fd < 0)
+		throw moordyn::input_file_error("The file cannot be opened");
+	struct stat st;
+	if ((fstat(fd, &st) != 0) || !st.st_size) {
+		close(fd);
+		throw moordyn::input_file_error("The file is empty");
+	}
+	_size = (size_t)st.st_size;
+	void* data = mmap(NULL, _size, PROT_READ, MAP_SHARED, fd, 0);
+	// The mapping is kept alive after closing the file descriptor
+	close(fd);
+	if (data == MAP_FAILED)
+		throw moordyn::input_file_error("The file cannot be mapped");
+	_data = (const unsigned char*)data;
+}
+
+MappedFile::~MappedFile()
+{
+	munmap((void*)_data, _size);
+}
+
+#endif
+
+} // ::moordyn
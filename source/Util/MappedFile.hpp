@@ -0,0 +1,91 @@
+/*
+ * Copyright (c) 2023, Jose Luis Cercos-Pita & Matt Hall
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ * 1. Redistributions of source code must retain the above copyright notice,
+ *    this list of conditions and the following disclaimer.
+ *
+ * 2. Redistributions in binary form must reproduce the above copyright notice,
+ *    this list of conditions and the following disclaimer in the documentation
+ *    and/or other materials provided with the distribution.
+ *
+ * 3. Neither the name of the copyright holder nor the names of its
+ *    contributors may be used to endorse or promote products derived from
+ *    this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE
+ * LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ * INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+ * CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ */
+
+/** @file MappedFile.hpp
+ * Read-only memory-mapped files
+ */
+
+#pragma once
+
+#include "Misc.hpp"
+#include <string>
+
+namespace moordyn {
+
+/** @class MappedFile MappedFile.hpp
+ * @brief A file mapped in memory for reading
+ *
+ * The file contents are not read but paged on demand by the operating
+ * system. The pages are shared among all the processes mapping the same
+ * file, so large read-only datasets are stored in memory just once.
+ *
+ * The mapping is closed on destruction.
+ */
+class MappedFile
+{
+  public:
+	/** @brief Constructor
+	 * @param path The file path
+	 * @throws moordyn::input_file_error If the file cannot be opened or
+	 * mapped
+	 */
+	MappedFile(const std::string& path);
+
+	/** @brief Destructor
+	 */
+	~MappedFile();
+
+	MappedFile(const MappedFile&) = delete;
+	MappedFile& operator=(const MappedFile&) = delete;
+
+	/** @brief Get the mapped data
+	 * @return The file contents, aligned to the memory page size
+	 */
+	inline const unsigned char* data() const { return _data; }
+
+	/** @brief Get the file size
+	 * @return The file size, in bytes
+	 */
+	inline size_t size() const { return _size; }
+
+  private:
+	/// The mapped data
+	const unsigned char* _data;
+	/// The file size
+	size_t _size;
+#ifdef _WIN32
+	/// The file handle
+	void* _file;
+	/// The mapping handle
+	void* _map;
+#endif
+};
+
+} // ::moordyn
@@ -0,0 +1,403 @@
+/*
+ * Copyright (c) 2023, Jose Luis Cercos-Pita & Matt Hall
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ * 1. Redistributions of source code must retain the above copyright notice,
+ *    this list of conditions and the following disclaimer.
+ *
+ * 2. Redistributions in binary form must reproduce the above copyright notice,
+ *    this list of conditions and the following disclaimer in the documentation
+ *    and/or other materials provided with the distribution.
+ *
+ * 3. Neither the name of the copyright holder nor the names of its
+ *    contributors may be used to endorse or promote products derived from
+ *    this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE
+ * LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ * INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+ * CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ */
+
+
+#include "OutputFile.hpp"
+#include <algorithm>
+#include <cstring>
+
+using namespace std;
+
+namespace moordyn {
+
+/** @brief Header of the binary output files
+ *
+ * The header is followed by the channels table. Each channel is described by
+ * its object type, object number and node index, as int32, the length of its
+ * name and units, as uint32, and the name and units characters, without null
+ * terminators. The records start at an offset aligned to 64 bytes, each one
+ * with a value per channel, the time being the first one
+ */
+typedef struct _output_file_header
+{
+	/// Magic string
+	char magic[8];
+	/// File format version
+	uint32_t version;
+	/// Endianness mark, the files are not portable among architectures
+	uint32_t endian;
+	/// Number of bytes of each value, 4 or 8
+	uint32_t precision;
+	/// Number of channels, including the time
+	uint32_t channels;
+	/// Offset of the first record
+	uint64_t data;
+} output_file_header;
+
+/// Magic string of the binary output files
+static const char OUTPUT_FILE_MAGIC[8] = "MDOUT";
+/// Version of the binary output files
+static const uint32_t OUTPUT_FILE_VERSION = 1;
+/// Endianness mark of the binary output files
+static const uint32_t OUTPUT_FILE_ENDIAN = 0x01020304;
+
+OutputFile::OutputFile(const std::string& path,
+                       output_format format,
+                       unsigned int decimation)
+  : _path(path)
+  , _format(format)
+  , _decimation(decimation)
+  , _records(0)
+  , _header(false)
+  , _n(0)
+  , _autoflush(false)
+  , _writer(nullptr)
+  , _capacity(0)
+  , _pushed(0)
+  , _written(0)
+  , _failed(false)
+{
+	if (_decimation) {
+		if (_format == OUTPUT_TEXT)
+			_f.open(path);
+		else
+			_f.open(path, ios::out | ios::binary);
+	}
+	addChannel("Time", "(s)");
+}
+
+OutputFile::~OutputFile()
+{
+	close();
+}
+
+void
+OutputFile::setWriter(std::shared_ptr<OutputWriter> writer,
+                      unsigned int capacity)
+{
+	if (_header)
+		throw moordyn::output_file_error(
+		    "The writer cannot be set after writing the header");
+	_writer = writer;
+	_capacity = (std::max)(capacity, 1u);
+}
+
+void
+OutputFile::setStatistics(const std::string& path)
+{
+	if (_header)
+		throw moordyn::output_file_error(
+		    "The statistics cannot be set after writing the header");
+	_fstats.open(path);
+	// The stats are built when the channels are known
+	_stats = std::make_unique<OutputStats>(0);
+}
+
+void
+OutputFile::addChannel(const std::string& name,
+                       const std::string& units,
+                       int otype,
+                       int objid,
+                       int node)
+{
+	if (_header)
+		throw moordyn::output_file_error(
+		    "Channels cannot be added after writing the header");
+	// Some units are padded with spaces to align the columns of the text
+	// files, which is useless for the self describing binary ones
+	auto trim = [](const std::string& str) {
+		const auto last = str.find_last_not_of(" \t");
+		return (last == string::npos) ? string() : str.substr(0, last + 1);
+	};
+	_channels.push_back({ trim(name), trim(units), otype, objid, node });
+}
+
+void
+OutputFile::writeHeader(bool units)
+{
+	_header = true;
+	_record.assign(_channels.size(), 0.0);
+	if (_stats)
+		_stats = std::make_unique<OutputStats>(_channels.size() - 1);
+	if (_format == OUTPUT_FLOAT32)
+		_record32.assign(_channels.size(), 0.f);
+	if (_writer) {
+		_ring.assign((size_t)_capacity * _channels.size(), 0.0);
+		_writer->attach(this);
+	}
+
+	if (!_decimation)
+		return;
+	if (_format == OUTPUT_TEXT) {
+		for (auto c : _channels)
+			_f << c.name << "\t ";
+		_f << "\n";
+		if (units) {
+			for (auto c : _channels)
+				_f << c.units << "\t ";
+			_f << "\n";
+		}
+		if (!_f)
+			throw moordyn::output_file_error("Failure writing the header");
+		return;
+	}
+
+	output_file_header header;
+	memset(&header, 0, sizeof(header));
+	memcpy(header.magic, OUTPUT_FILE_MAGIC, sizeof(header.magic));
+	header.version = OUTPUT_FILE_VERSION;
+	header.endian = OUTPUT_FILE_ENDIAN;
+	header.precision =
+	    (_format == OUTPUT_FLOAT32) ? sizeof(float) : sizeof(double);
+	header.channels = (uint32_t)_channels.size();
+	uint64_t size = sizeof(header);
+	for (auto c : _channels)
+		size += 3 * sizeof(int32_t) + 2 * sizeof(uint32_t) + c.name.size() +
+		        c.units.size();
+	header.data = (size + 63) & ~((uint64_t)63);
+
+	_f.write((const char*)&header, sizeof(header));
+	for (auto c : _channels) {
+		const int32_t ids[3] = { c.otype, c.objid, c.node };
+		const uint32_t lengths[2] = { (uint32_t)c.name.size(),
+			                          (uint32_t)c.units.size() };
+		_f.write((const char*)ids, sizeof(ids));
+		_f.write((const char*)lengths, sizeof(lengths));
+		_f.write(c.name.data(), c.name.size());
+		_f.write(c.units.data(), c.units.size());
+	}
+	const char zeros[64] = {};
+	_f.write(zeros, header.data - size);
+	if (!_f)
+		throw moordyn::output_file_error("Failure writing the header");
+}
+
+void
+OutputFile::end()
+{
+	if (_n != _channels.size())
+		throw moordyn::output_file_error(
+		    "The number of values does not match the number of channels");
+	// Without statistics the decimated records can be discarded right away
+	if (!_stats && (_records++ % _decimation))
+		return;
+	if (_writer) {
+		if (!_writer->push(this))
+			throw moordyn::output_file_error("Failure writing the records");
+		return;
+	}
+	write(_record.data());
+	if (!_f)
+		throw moordyn::output_file_error("Failure writing the records");
+}
+
+void
+OutputFile::flush()
+{
+	if (_writer)
+		_writer->drain(this);
+	_f.flush();
+}
+
+bool
+OutputFile::close()
+{
+	if (_writer) {
+		_writer->detach(this);
+		_writer = nullptr;
+	}
+	if (_f.is_open())
+		_f.close();
+	if (_fstats.is_open()) {
+		writeStatistics();
+		const bool failed = !_fstats;
+		_fstats.close();
+		return !failed;
+	}
+	return true;
+}
+
+void
+OutputFile::write(const double* record)
+{
+	if (_stats) {
+		_stats->add(record);
+		if (!_decimation || (_records++ % _decimation))
+			return;
+	}
+	const unsigned int n = channels();
+	switch (_format) {
+		case OUTPUT_TEXT:
+			for (unsigned int i = 0; i < n; i++)
+				_f << record[i] << "\t ";
+			_f << "\n";
+			break;
+		case OUTPUT_FLOAT32:
+			for (unsigned int i = 0; i < n; i++)
+				_record32[i] = (float)record[i];
+			_f.write((const char*)_record32.data(), n * sizeof(float));
+			break;
+		case OUTPUT_FLOAT64:
+			_f.write((const char*)record, n * sizeof(double));
+			break;
+	}
+	if (_autoflush)
+		_f.flush();
+}
+
+void
+OutputFile::writeStatistics()
+{
+	// The header may be missing if the simulation failed before starting
+	if (!_header)
+		return;
+	_fstats << "Channel\t Units\t OType\t ObjID\t Node\t Samples\t Mean\t "
+	           "Std\t Min\t TimeMin\t Max\t TimeMax";
+	for (auto p : _stats->probs())
+		_fstats << "\t P" << 100.0 * p;
+	_fstats << "\n";
+	for (unsigned int i = 0; i + 1 < _channels.size(); i++) {
+		const channel& c = _channels[i + 1];
+		_fstats << c.name << "\t " << (c.units.empty() ? "(-)" : c.units)
+		        << "\t " << c.otype << "\t " << c.objid << "\t " << c.node
+		        << "\t " << _stats->samples() << "\t " << _stats->mean(i)
+		        << "\t " << _stats->stddev(i) << "\t " << _stats->minValue(i)
+		        << "\t " << _stats->minTime(i) << "\t " << _stats->maxValue(i)
+		        << "\t " << _stats->maxTime(i);
+		for (unsigned int j = 0; j < _stats->probs().size(); j++)
+			_fstats << "\t " << _stats->quantile(i, j);
+		_fstats << "\n";
+	}
+}
+
+OutputWriter::OutputWriter()
+  : _stop(false)
+{
+	_thread = std::thread(&OutputWriter::loop, this);
+}
+
+OutputWriter::~OutputWriter()
+{
+	{
+		std::lock_guard<std::mutex> lock(_mtx);
+		_stop = true;
+	}
+	_cv_work.notify_all();
+	_thread.join();
+}
+
+void
+OutputWriter::attach(OutputFile* file)
+{
+	std::lock_guard<std::mutex> lock(_mtx);
+	_files.push_back(file);
+}
+
+void
+OutputWriter::detach(OutputFile* file)
+{
+	drain(file);
+	std::lock_guard<std::mutex> lock(_mtx);
+	_files.erase(std::remove(_files.begin(), _files.end(), file),
+	             _files.end());
+}
+
+bool
+OutputWriter::push(OutputFile* file)
+{
+	const size_t n = file->_record.size();
+	{
+		std::unique_lock<std::mutex> lock(_mtx);
+		// Back-pressure, we cannot get too far from the writer
+		_cv_free.wait(lock, [file] {
+			return file->_failed ||
+			       (file->_pushed - file->_written < file->_capacity);
+		});
+		if (file->_failed)
+			return false;
+		// The writer is not touching this slot until we notify it
+		const size_t slot = file->_pushed % file->_capacity;
+		std::copy(file->_record.begin(),
+		          file->_record.end(),
+		          file->_ring.begin() + slot * n);
+		file->_pushed++;
+	}
+	_cv_work.notify_one();
+	return true;
+}
+
+void
+OutputWriter::drain(OutputFile* file)
+{
+	std::unique_lock<std::mutex> lock(_mtx);
+	_cv_free.wait(lock, [file] {
+		return file->_failed || (file->_written == file->_pushed);
+	});
+}
+
+void
+OutputWriter::loop()
+{
+	unsigned int next = 0;
+	std::unique_lock<std::mutex> lock(_mtx);
+	while (true) {
+		// Look for a file with pending records, starting from the one next
+		// to the last served, so all of them are fairly served
+		OutputFile* file = nullptr;
+		for (unsigned int i = 0; !file && (i < _files.size()); i++) {
+			OutputFile* f = _files[(next + i) % _files.size()];
+			if (!f->_failed && (f->_pushed != f->_written)) {
+				file = f;
+				next = (next + i + 1) % _files.size();
+			}
+		}
+		if (!file) {
+			if (_stop)
+				return;
+			_cv_work.wait(lock);
+			continue;
+		}
+
+		// The pushed records are not modified until we mark them as written,
+		// so we can format them without blocking the simulation
+		const unsigned long first = file->_written, last = file->_pushed;
+		lock.unlock();
+		const size_t n = file->_record.size();
+		for (unsigned long i = first; i < last; i++)
+			file->write(file->_ring.data() + (i % file->_capacity) * n);
+		const bool failed = !file->_f;
+		lock.lock();
+		file->_written = last;
+		file->_failed = failed;
+		_cv_free.notify_all();
+	}
+}
+
+} // ::moordyn
@@ -0,0 +1,418 @@
+/*
+ * Copyright (c) 2023, Jose Luis Cercos-Pita & Matt Hall
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ * 1. Redistributions of source code must retain the above copyright notice,
+ *    this list of conditions and the following disclaimer.
+ *
+ * 2. Redistributions in binary form must reproduce the above copyright notice,
+ *    this list of conditions and the following disclaimer in the documentation
+ *    and/or other materials provided with the distribution.
+ *
+ * 3. Neither the name of the copyright holder nor the names of its
+ *    contributors may be used to endorse or promote products derived from
+ *    this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE
+ * LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ * INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+ * CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ */
+
+
+/** @file OutputFile.hpp
+ * Time series output files, either as text or as binary records
+ */
+
+#pragma once
+
+#include "Misc.hpp"
+#include "OutputStats.hpp"
+#include <string>
+#include <vector>
+#include <fstream>
+#include <memory>
+#include <thread>
+#include <mutex>
+#include <condition_variable>
+
+namespace moordyn {
+
+/// The format of the output files
+typedef enum
+{
+	/// Tab separated text
+	OUTPUT_TEXT = 0,
+	/// Binary records of single precision floats
+	OUTPUT_FLOAT32 = 1,
+	/// Binary records of double precision floats
+	OUTPUT_FLOAT64 = 2,
+} output_format;
+
+class OutputWriter;
+
+/** @class OutputFile OutputFile.hpp
+ * @brief A time series output file
+ *
+ * The channels are declared with OutputFile::addChannel() before writing the
+ * header with OutputFile::writeHeader(). Then each record is written by
+ * calling OutputFile::begin(), streaming every channel value and calling
+ * OutputFile::end().
+ *
+ * The binary files start with a self-describing header, with the names,
+ * units and origin of the channels, followed by fixed-width records of
+ * floats, one per output instant, so they can be mapped in memory. See
+ * docs/inputs.rst for the layout.
+ *
+ * If an OutputWriter is set, the records are just copied on a ring buffer
+ * by OutputFile::end(), and formatted and written to disk later on by the
+ * writer thread.
+ *
+ * The time series can be decimated, writing just one of every n records, or
+ * even not written at all. In that case it is useful to accumulate the
+ * statistics of the channels with OutputFile::setStatistics(), which are
+ * computed with every record and written to a summary file when the file is
+ * closed.
+ */
+class OutputFile
+{
+  public:
+	/** @brief Constructor
+	 *
+	 * The file is opened, but nothing is written yet
+	 * @param path The file path
+	 * @param format The file format
+	 * @param decimation Just one of every @p decimation records is written
+	 * on the time series. 0 to do not write the time series at all, in
+	 * which case the file is not even created
+	 */
+	OutputFile(const std::string& path,
+	           output_format format = OUTPUT_TEXT,
+	           unsigned int decimation = 1);
+
+	/** @brief Destructor
+	 */
+	~OutputFile();
+
+	OutputFile(const OutputFile&) = delete;
+	OutputFile& operator=(const OutputFile&) = delete;
+
+	/** @brief Check whether the files were successfully opened
+	 * @return true if the time series and the statistics files, if
+	 * required, are open, false otherwise
+	 */
+	inline bool is_open() const
+	{
+		return (!_decimation || _f.is_open()) &&
+		       (!_stats || _fstats.is_open());
+	}
+
+	/** @brief Get the file format
+	 * @return The file format
+	 */
+	inline output_format format() const { return _format; }
+
+	/** @brief Get the file path
+	 * @return The file path
+	 */
+	inline const std::string& path() const { return _path; }
+
+	/** @brief Check whether the header was already written
+	 * @return true if OutputFile::writeHeader() was already called, false
+	 * otherwise
+	 */
+	inline bool hasHeader() const { return _header; }
+
+	/** @brief Get the number of channels, including the time
+	 * @return The number of channels
+	 */
+	inline unsigned int channels() const
+	{
+		return (unsigned int)_channels.size();
+	}
+
+	/** @brief Write the records on a background thread
+	 *
+	 * It shall be called before writing the header
+	 * @param writer The writer thread
+	 * @param capacity The number of records that can be buffered. When the
+	 * buffer is full OutputFile::end() waits for the writer
+	 * @throws moordyn::output_file_error If the header was already written
+	 */
+	void setWriter(std::shared_ptr<OutputWriter> writer,
+	               unsigned int capacity);
+
+	/** @brief Accumulate the statistics of the channels, to be written on a
+	 * summary file when the file is closed
+	 *
+	 * It shall be called before writing the header. The summary file is
+	 * opened straight away, so it shall be checked with
+	 * OutputFile::is_open()
+	 * @param path The summary file path
+	 * @throws moordyn::output_file_error If the header was already written
+	 */
+	void setStatistics(const std::string& path);
+
+	/** @brief Set whether the file shall be flushed after each record, so it
+	 * can be monitored while the simulation is running
+	 * @param autoflush true to flush the file after each record
+	 */
+	inline void setAutoFlush(bool autoflush) { _autoflush = autoflush; }
+
+	/** @brief Declare a new channel
+	 *
+	 * The time channel is already declared on construction
+	 * @param name The channel name
+	 * @param units The units, e.g. "(m)"
+	 * @param otype The type of object, 1 = line, 2 = point, 3 = rod,
+	 * 4 = body, following OutChanProps::OType. 0 for none
+	 * @param objid The object number. 0 for none
+	 * @param node The node or segment index. -1 for none
+	 * @throws moordyn::output_file_error If the header was already written
+	 */
+	void addChannel(const std::string& name,
+	                const std::string& units,
+	                int otype = 0,
+	                int objid = 0,
+	                int node = -1);
+
+	/** @brief Declare the x, y and z components of a vector channel
+	 * @param name The channel name, to which "x", "y" and "z" are appended
+	 * @param units The units, e.g. "(m)"
+	 * @param otype The type of object. 0 for none
+	 * @param objid The object number. 0 for none
+	 * @param node The node or segment index. -1 for none
+	 * @throws moordyn::output_file_error If the header was already written
+	 * @see OutputFile::addChannel()
+	 */
+	inline void addVectorChannel(const std::string& name,
+	                             const std::string& units,
+	                             int otype = 0,
+	                             int objid = 0,
+	                             int node = -1)
+	{
+		for (auto c : { "x", "y", "z" })
+			addChannel(name + c, units, otype, objid, node);
+	}
+
+	/** @brief Write the header
+	 * @param units true if the units line shall be written on text files.
+	 * The units are always written on binary files
+	 * @throws moordyn::output_file_error If the file cannot be written
+	 */
+	void writeHeader(bool units = true);
+
+	/** @brief Start a new record
+	 * @param time The simulation time
+	 */
+	inline void begin(real time)
+	{
+		_n = 0;
+		*this << time;
+	}
+
+	/** @brief Write the next channel value of the record
+	 * @param value The value
+	 * @return The file itself, to chain the values
+	 */
+	inline OutputFile& operator<<(real value)
+	{
+		if (_n < _record.size())
+			_record[_n] = value;
+		_n++;
+		return *this;
+	}
+
+	/** @brief Finish the record
+	 * @throws moordyn::output_file_error If the number of values does not
+	 * match the number of channels, or if the writer thread failed to write
+	 * the previous records
+	 */
+	void end();
+
+	/** @brief Flush the file contents to disk
+	 *
+	 * If an OutputWriter is set, this function waits until all the buffered
+	 * records are written
+	 */
+	void flush();
+
+	/** @brief Close the file
+	 *
+	 * If an OutputWriter is set, this function waits until all the buffered
+	 * records are written. Then the statistics summary is written, if
+	 * required
+	 * @return false if the statistics summary cannot be written, true
+	 * otherwise
+	 */
+	bool close();
+
+  private:
+	friend class OutputWriter;
+
+	/** @brief Accumulate the statistics of a record, and format and write it
+	 * on the time series if it is not decimated
+	 * @param record The record values
+	 */
+	void write(const double* record);
+
+	/** @brief Write the statistics summary
+	 */
+	void writeStatistics();
+
+	/// A channel descriptor
+	typedef struct _channel
+	{
+		/// The channel name
+		std::string name;
+		/// The channel units
+		std::string units;
+		/// The object type
+		int otype;
+		/// The object number
+		int objid;
+		/// The node or segment index
+		int node;
+	} channel;
+
+	/// The file path
+	std::string _path;
+
+	/// The file format
+	output_format _format;
+
+	/// The file stream
+	std::ofstream _f;
+
+	/// Just one of every _decimation records is written, 0 for none
+	unsigned int _decimation;
+
+	/// The number of records processed so far, to decimate them
+	unsigned long _records;
+
+	/// The statistics summary file stream
+	std::ofstream _fstats;
+
+	/// The statistics of the channels, if required
+	std::unique_ptr<OutputStats> _stats;
+
+	/// The channels, starting with the time
+	std::vector<channel> _channels;
+
+	/// true once the header is written
+	bool _header;
+
+	/// Number of values written on the current record
+	unsigned int _n;
+
+	/// The values of the current record
+	std::vector<double> _record;
+
+	/// The current record in single precision
+	std::vector<float> _record32;
+
+	/// true if the file shall be flushed after each record
+	bool _autoflush;
+
+	/// The writer thread, if any
+	std::shared_ptr<OutputWriter> _writer;
+
+	/// The number of records that can be buffered for the writer thread
+	unsigned int _capacity;
+
+	/// The buffered records, waiting for the writer thread
+	std::vector<double> _ring;
+
+	/// The number of records handed to the writer thread
+	unsigned long _pushed;
+
+	/// The number of records written by the writer thread
+	unsigned long _written;
+
+	/// true if the writer thread failed to write the records
+	bool _failed;
+};
+
+/** @class OutputWriter OutputFile.hpp
+ * @brief A background thread writing the output files
+ *
+ * The records are formatted and written to disk by this thread, so the file
+ * I/O is taken out of the time integration. A single thread is serving all
+ * the files sharing the writer, and the memory is bounded by the capacity of
+ * the ring buffers of each file, see OutputFile::setWriter()
+ */
+class OutputWriter
+{
+  public:
+	/** @brief Constructor
+	 *
+	 * The writer thread is launched
+	 */
+	OutputWriter();
+
+	/** @brief Destructor
+	 *
+	 * The writer thread is stopped, after writing the pending records
+	 */
+	~OutputWriter();
+
+	OutputWriter(const OutputWriter&) = delete;
+	OutputWriter& operator=(const OutputWriter&) = delete;
+
+	/** @brief Start serving a file
+	 * @param file The file
+	 */
+	void attach(OutputFile* file);
+
+	/** @brief Stop serving a file, after writing its pending records
+	 * @param file The file
+	 */
+	void detach(OutputFile* file);
+
+	/** @brief Copy the current record of a file on its ring buffer, waiting
+	 * for the writer thread if the buffer is full
+	 * @param file The file
+	 * @return false if the writer thread failed to write the file, true
+	 * otherwise
+	 */
+	bool push(OutputFile* file);
+
+	/** @brief Wait until all the pending records of a file are written
+	 * @param file The file
+	 */
+	void drain(OutputFile* file);
+
+  private:
+	/** @brief Main loop of the writer thread
+	 */
+	void loop();
+
+	/// The served files
+	std::vector<OutputFile*> _files;
+
+	/// Mutex for the files and their ring buffers
+	std::mutex _mtx;
+
+	/// Condition to wake up the writer thread
+	std::condition_variable _cv_work;
+
+	/// Condition to notify that records were written
+	std::condition_variable _cv_free;
+
+	/// Flag to ask the writer thread to finish
+	bool _stop;
+
+	/// The writer thread
+	std::thread _thread;
+};
+
+} // ::moordyn
@@ -0,0 +1,180 @@
+/*
+ * Copyright (c) 2023, Jose Luis Cercos-Pita & Matt Hall
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ * 1. Redistributions of source code must retain the above copyright notice,
+ *    this list of conditions and the following disclaimer.
+ *
+ * 2. Redistributions in binary form must reproduce the above copyright notice,
+ *    this list of conditions and the following disclaimer in the documentation
+ *    and/or other materials provided with the distribution.
+ *
+ * 3. Neither the name of the copyright holder nor the names of its
+ *    contributors may be used to endorse or promote products derived from
+ *    this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE
+ * LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ * INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+ * CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ */
+
+
+/** @file OutputPlan.hpp
+ * Output channels compiled into direct memory accesses
+ */
+
+#pragma once
+
+#include "Misc.hpp"
+#include "OutputFile.hpp"
+#include <cmath>
+#include <functional>
+#include <vector>
+
+namespace moordyn {
+
+/** @class OutputPlan OutputPlan.hpp
+ * @brief A list of output channels, compiled into direct memory accesses
+ *
+ * The channels are parsed just once, when the plan is built, so printing
+ * them is just a matter of reading the memory pointed by each accessor and
+ * applying a simple transform. The quantities which shall be computed, like
+ * the net force on a rod, are computed on buffers by the update functions,
+ * which are called once per output instant no matter how many channels are
+ * pointing to them.
+ *
+ * The pointed memory shall not be reallocated while the plan is in use
+ */
+class OutputPlan
+{
+  public:
+	/// The transform applied to the pointed memory
+	typedef enum
+	{
+		/// The value, multiplied by the scale factor
+		OP_VALUE = 0,
+		/// The norm of a 3 components vector, multiplied by the scale factor
+		OP_NORM = 1,
+	} op;
+
+	/** @brief Remove all the channels and update functions
+	 */
+	inline void clear()
+	{
+		_accessors.clear();
+		_owners.clear();
+		_updates.clear();
+	}
+
+	/** @brief Get the number of channels
+	 * @return The number of channels
+	 */
+	inline unsigned int size() const
+	{
+		return (unsigned int)_accessors.size();
+	}
+
+	/** @brief Add a channel
+	 * @param src The memory to read the value from
+	 * @param scale The scale factor
+	 * @param transform The transform to apply
+	 * @param stride The distance between the vector components, if
+	 * @p transform is OutputPlan::OP_NORM
+	 */
+	inline void add(const real* src,
+	                real scale = 1.0,
+	                op transform = OP_VALUE,
+	                unsigned int stride = 1)
+	{
+		_accessors.push_back({ src, stride, scale, transform });
+	}
+
+	/** @brief Add the 3 components of a vector as channels
+	 * @param src The memory of the first component
+	 * @param stride The distance between the components
+	 * @param scale The scale factor
+	 */
+	inline void addVector(const real* src,
+	                      unsigned int stride = 1,
+	                      real scale = 1.0)
+	{
+		for (unsigned int i = 0; i < 3; i++)
+			add(src + i * stride, scale);
+	}
+
+	/** @brief Add a channel which is always zero
+	 */
+	inline void addZero() { add(&_zero, 0.0); }
+
+	/** @brief Add a function to update the buffers pointed by the channels
+	 *
+	 * The functions are called in the same order they are added, before
+	 * reading the channels. Each owner can add just one function, so
+	 * several channels can share the same computed quantities
+	 * @param owner The owner of the buffers, usually the entity
+	 * @param update The update function
+	 */
+	inline void addUpdate(const void* owner, std::function<void()> update)
+	{
+		for (auto o : _owners)
+			if (o == owner)
+				return;
+		_owners.push_back(owner);
+		_updates.push_back(update);
+	}
+
+	/** @brief Update the buffers and write the channels
+	 * @param f The output file, where the record is already begun
+	 */
+	inline void write(OutputFile& f) const
+	{
+		for (auto& update : _updates)
+			update();
+		for (auto& a : _accessors) {
+			if (a.transform == OP_NORM) {
+				const real x = a.src[0], y = a.src[a.stride],
+				           z = a.src[2 * a.stride];
+				f << a.scale * std::sqrt(x * x + y * y + z * z);
+			} else
+				f << a.scale * a.src[0];
+		}
+	}
+
+  private:
+	/// A compiled channel
+	typedef struct _accessor
+	{
+		/// The memory to read from
+		const real* src;
+		/// The distance between the vector components
+		unsigned int stride;
+		/// The scale factor
+		real scale;
+		/// The transform
+		op transform;
+	} accessor;
+
+	/// The channels
+	std::vector<accessor> _accessors;
+
+	/// The owners of the update functions
+	std::vector<const void*> _owners;
+
+	/// The update functions
+	std::vector<std::function<void()>> _updates;
+
+	/// A zero to point to
+	static constexpr real _zero = 0.0;
+};
+
+} // ::moordyn
@@ -0,0 +1,185 @@
+/*
+ * Copyright (c) 2023, Jose Luis Cercos-Pita & Matt Hall
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ * 1. Redistributions of source code must retain the above copyright notice,
+ *    this list of conditions and the following disclaimer.
+ *
+ * 2. Redistributions in binary form must reproduce the above copyright notice,
+ *    this list of conditions and the following disclaimer in the documentation
+ *    and/or other materials provided with the distribution.
+ *
+ * 3. Neither the name of the copyright holder nor the names of its
+ *    contributors may be used to endorse or promote products derived from
+ *    this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE
+ * LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ * INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+ * CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ */
+
+
+#include "OutputStats.hpp"
+#include <algorithm>
+#include <cmath>
+#include <limits>
+
+namespace moordyn {
+
+P2Quantile::P2Quantile(real p)
+  : _p(p)
+  , _count(0)
+{
+	for (unsigned int i = 0; i < 5; i++) {
+		_q[i] = 0.0;
+		_n[i] = i;
+	}
+	_np[0] = 0.0;
+	_np[1] = 2.0 * p;
+	_np[2] = 4.0 * p;
+	_np[3] = 2.0 + 2.0 * p;
+	_np[4] = 4.0;
+	_dn[0] = 0.0;
+	_dn[1] = 0.5 * p;
+	_dn[2] = p;
+	_dn[3] = 0.5 * (1.0 + p);
+	_dn[4] = 1.0;
+}
+
+void
+P2Quantile::add(real x)
+{
+	// The first samples are just stored as the markers heights
+	if (_count < 5) {
+		_q[_count++] = x;
+		if (_count == 5)
+			std::sort(_q, _q + 5);
+		return;
+	}
+	_count++;
+
+	// Find the cell where the sample falls, extending the extreme markers if
+	// needed
+	unsigned int k;
+	if (x < _q[0]) {
+		_q[0] = x;
+		k = 0;
+	} else if (x >= _q[4]) {
+		_q[4] = x;
+		k = 3;
+	} else {
+		k = 0;
+		while (x >= _q[k + 1])
+			k++;
+	}
+	for (unsigned int i = k + 1; i < 5; i++)
+		_n[i] += 1.0;
+	for (unsigned int i = 0; i < 5; i++)
+		_np[i] += _dn[i];
+
+	// Move the intermediate markers towards their desired positions
+	for (unsigned int i = 1; i < 4; i++) {
+		const real d = _np[i] - _n[i];
+		if (((d >= 1.0) && (_n[i + 1] - _n[i] > 1.0)) ||
+		    ((d <= -1.0) && (_n[i - 1] - _n[i] < -1.0))) {
+			const int s = (d > 0.0) ? 1 : -1;
+			const real q = parabolic(i, s);
+			if ((_q[i - 1] < q) && (q < _q[i + 1]))
+				_q[i] = q;
+			else
+				_q[i] = linear(i, s);
+			_n[i] += s;
+		}
+	}
+}
+
+real
+P2Quantile::get() const
+{
+	if (!_count)
+		return std::numeric_limits<real>::quiet_NaN();
+	if (_count >= 5)
+		return _q[2];
+	// Not enough samples yet, just pick the closest one
+	real q[5];
+	std::copy(_q, _q + _count, q);
+	std::sort(q, q + _count);
+	return q[(unsigned int)std::round(_p * (_count - 1))];
+}
+
+real
+P2Quantile::parabolic(unsigned int i, real d) const
+{
+	return _q[i] + d / (_n[i + 1] - _n[i - 1]) *
+	                   ((_n[i] - _n[i - 1] + d) * (_q[i + 1] - _q[i]) /
+	                        (_n[i + 1] - _n[i]) +
+	                    (_n[i + 1] - _n[i] - d) * (_q[i] - _q[i - 1]) /
+	                        (_n[i] - _n[i - 1]));
+}
+
+real
+P2Quantile::linear(unsigned int i, int d) const
+{
+	return _q[i] + d * (_q[i + d] - _q[i]) / (_n[i + d] - _n[i]);
+}
+
+OutputStats::OutputStats(unsigned int channels, const std::vector<real>& probs)
+  : _probs(probs)
+  , _count(0)
+{
+	channel c;
+	c.mean = 0.0;
+	c.m2 = 0.0;
+	c.min = std::numeric_limits<real>::quiet_NaN();
+	c.tmin = std::numeric_limits<real>::quiet_NaN();
+	c.max = std::numeric_limits<real>::quiet_NaN();
+	c.tmax = std::numeric_limits<real>::quiet_NaN();
+	for (auto p : probs)
+		c.quantiles.push_back(P2Quantile(p));
+	_ch.assign(channels, c);
+}
+
+void
+OutputStats::add(const double* record)
+{
+	const real t = record[0];
+	_count++;
+	for (unsigned int i = 0; i < _ch.size(); i++) {
+		const real x = record[i + 1];
+		channel& c = _ch[i];
+		// Welford's algorithm
+		const real delta = x - c.mean;
+		c.mean += delta / _count;
+		c.m2 += delta * (x - c.mean);
+		if ((_count == 1) || (x < c.min)) {
+			c.min = x;
+			c.tmin = t;
+		}
+		if ((_count == 1) || (x > c.max)) {
+			c.max = x;
+			c.tmax = t;
+		}
+		for (auto& q : c.quantiles)
+			q.add(x);
+	}
+}
+
+real
+OutputStats::stddev(unsigned int i) const
+{
+	if (_count < 2)
+		return 0.0;
+	return sqrt(_ch[i].m2 / (_count - 1));
+}
+
+} // ::moordyn
@@ -0,0 +1,212 @@
+/*
+ * Copyright (c) 2023, Jose Luis Cercos-Pita & Matt Hall
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ * 1. Redistributions of source code must retain the above copyright notice,
+ *    this list of conditions and the following disclaimer.
+ *
+ * 2. Redistributions in binary form must reproduce the above copyright notice,
+ *    this list of conditions and the following disclaimer in the documentation
+ *    and/or other materials provided with the distribution.
+ *
+ * 3. Neither the name of the copyright holder nor the names of its
+ *    contributors may be used to endorse or promote products derived from
+ *    this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE
+ * LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ * INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+ * CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ */
+
+
+/** @file OutputStats.hpp
+ * Streaming statistics of the output channels
+ */
+
+#pragma once
+
+#include "Misc.hpp"
+#include <vector>
+
+namespace moordyn {
+
+/** @class P2Quantile OutputStats.hpp
+ * @brief Streaming estimation of a quantile with the P² algorithm
+ *
+ * The quantile is estimated without storing the samples, just tracking 5
+ * markers whose heights are adjusted with a piecewise-parabolic formula, see
+ * R. Jain and I. Chlamtac, "The P² algorithm for dynamic calculation of
+ * quantiles and histograms without storing observations", Communications of
+ * the ACM, 28(10), 1985
+ */
+class P2Quantile
+{
+  public:
+	/** @brief Constructor
+	 * @param p The probability of the quantile, between 0 and 1
+	 */
+	P2Quantile(real p = 0.5);
+
+	/** @brief Add a sample
+	 * @param x The sample
+	 */
+	void add(real x);
+
+	/** @brief Get the estimated quantile
+	 * @return The quantile, NaN if there are no samples
+	 */
+	real get() const;
+
+  private:
+	/** @brief Parabolic prediction of a marker height
+	 * @param i The marker
+	 * @param d The direction of the move, -1 or 1
+	 * @return The new height
+	 */
+	real parabolic(unsigned int i, real d) const;
+
+	/** @brief Linear prediction of a marker height
+	 * @param i The marker
+	 * @param d The direction of the move, -1 or 1
+	 * @return The new height
+	 */
+	real linear(unsigned int i, int d) const;
+
+	/// The probability
+	real _p;
+	/// The number of samples
+	unsigned long _count;
+	/// The markers heights
+	real _q[5];
+	/// The markers positions
+	real _n[5];
+	/// The markers desired positions
+	real _np[5];
+	/// The increments of the desired positions
+	real _dn[5];
+};
+
+/** @class OutputStats OutputStats.hpp
+ * @brief Streaming statistics of a set of channels
+ *
+ * For each channel the mean and the standard deviation (computed with the
+ * Welford algorithm), the extreme values, with the time instants where they
+ * are reached, and some quantiles (estimated with the P² algorithm) are
+ * tracked without storing the samples
+ */
+class OutputStats
+{
+  public:
+	/** @brief Constructor
+	 * @param channels The number of channels, not including the time
+	 * @param probs The probabilities of the quantiles to estimate
+	 */
+	OutputStats(unsigned int channels,
+	            const std::vector<real>& probs = { 0.01,
+	                                               0.05,
+	                                               0.5,
+	                                               0.95,
+	                                               0.99 });
+
+	/** @brief Get the probabilities of the estimated quantiles
+	 * @return The probabilities
+	 */
+	inline const std::vector<real>& probs() const { return _probs; }
+
+	/** @brief Get the number of samples
+	 * @return The number of samples
+	 */
+	inline unsigned long samples() const { return _count; }
+
+	/** @brief Add a record
+	 * @param record The time followed by the value of each channel
+	 */
+	void add(const double* record);
+
+	/** @brief Get the mean of a channel
+	 * @param i The channel index, not including the time
+	 * @return The mean
+	 */
+	inline real mean(unsigned int i) const { return _ch[i].mean; }
+
+	/** @brief Get the sample standard deviation of a channel
+	 * @param i The channel index, not including the time
+	 * @return The standard deviation, 0 if there are less than 2 samples
+	 */
+	real stddev(unsigned int i) const;
+
+	/** @brief Get the minimum value of a channel
+	 * @param i The channel index, not including the time
+	 * @return The minimum value
+	 */
+	inline real minValue(unsigned int i) const { return _ch[i].min; }
+
+	/** @brief Get the time instant where the minimum value was reached
+	 * @param i The channel index, not including the time
+	 * @return The time instant
+	 */
+	inline real minTime(unsigned int i) const { return _ch[i].tmin; }
+
+	/** @brief Get the maximum value of a channel
+	 * @param i The channel index, not including the time
+	 * @return The maximum value
+	 */
+	inline real maxValue(unsigned int i) const { return _ch[i].max; }
+
+	/** @brief Get the time instant where the maximum value was reached
+	 * @param i The channel index, not including the time
+	 * @return The time instant
+	 */
+	inline real maxTime(unsigned int i) const { return _ch[i].tmax; }
+
+	/** @brief Get an estimated quantile of a channel
+	 * @param i The channel index, not including the time
+	 * @param j The quantile index, see OutputStats::probs()
+	 * @return The quantile
+	 */
+	inline real quantile(unsigned int i, unsigned int j) const
+	{
+		return _ch[i].quantiles[j].get();
+	}
+
+  private:
+	/// The statistics of a channel
+	typedef struct _channel
+	{
+		/// The mean
+		real mean;
+		/// The sum of the squared differences with the mean
+		real m2;
+		/// The minimum value
+		real min;
+		/// The time of the minimum value
+		real tmin;
+		/// The maximum value
+		real max;
+		/// The time of the maximum value
+		real tmax;
+		/// The quantiles estimators
+		std::vector<P2Quantile> quantiles;
+	} channel;
+
+	/// The probabilities of the quantiles
+	std::vector<real> _probs;
+
+	/// The number of samples
+	unsigned long _count;
+
+	/// The channels statistics
+	std::vector<channel> _ch;
+};
+
+} // ::moordyn
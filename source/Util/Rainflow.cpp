@@ -0,0 +1,201 @@
+/*
+ * Copyright (c) 2023, Jose Luis Cercos-Pita & Matt Hall
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ * 1. Redistributions of source code must retain the above copyright notice,
+ *    this list of conditions and the following disclaimer.
+ *
+ * 2. Redistributions in binary form must reproduce the above copyright notice,
+ *    this list of conditions and the following disclaimer in the documentation
+ *    and/or other materials provided with the distribution.
+ *
+ * 3. Neither the name of the copyright holder nor the names of its
+ *    contributors may be used to endorse or promote products derived from
+ *    this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE
+ * LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ * INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+ * CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ */
+
+
+#include "Rainflow.hpp"
+#include <algorithm>
+#include <cmath>
+
+namespace moordyn {
+
+Rainflow::Rainflow(unsigned int bins, real sn_m, real sn_a, real area)
+  : _bins((std::max)(bins, 1u))
+  , _m(sn_m)
+  , _a(sn_a)
+  , _area(area)
+  , _width(0.0)
+  , _cycles(0.0)
+  , _damage(0.0)
+  , _last(0.0)
+  , _dir(0)
+  , _started(false)
+{
+	_hist.assign(_bins * _bins, 0.0);
+	_tmp.assign(_bins * _bins, 0.0);
+	// The residue is usually short, so this is hopefully the last allocation
+	_residue.reserve(64);
+}
+
+void
+Rainflow::add(real x)
+{
+	fit(x);
+	if (!_started) {
+		_started = true;
+		_last = x;
+		// The first sample is always a reversal
+		reversal(x);
+		return;
+	}
+	if (x == _last)
+		return;
+	const int dir = (x > _last) ? 1 : -1;
+	if (_dir && (dir != _dir))
+		reversal(_last);
+	_dir = dir;
+	_last = x;
+}
+
+void
+Rainflow::histogram(real* hist) const
+{
+	std::copy(_hist.begin(), _hist.end(), hist);
+	real dmg = 0.0;
+	for (unsigned int i = 1; i < _residue.size(); i++)
+		count(_residue[i - 1], _residue[i], 0.5, hist, dmg);
+	if (_dir)
+		count(_residue.back(), _last, 0.5, hist, dmg);
+}
+
+real
+Rainflow::cycles() const
+{
+	if (_residue.empty())
+		return _cycles;
+	return _cycles + 0.5 * (_residue.size() - 1) + (_dir ? 0.5 : 0.0);
+}
+
+real
+Rainflow::damage() const
+{
+	real dmg = _damage;
+	for (unsigned int i = 1; i < _residue.size(); i++)
+		count(_residue[i - 1], _residue[i], 0.5, nullptr, dmg);
+	if (_dir)
+		count(_residue.back(), _last, 0.5, nullptr, dmg);
+	return dmg;
+}
+
+std::vector<real>
+Rainflow::getState() const
+{
+	// The bins, to check the consistency on setState(), the scalars, the
+	// histogram and the residue
+	std::vector<real> state;
+	state.reserve(7 + _hist.size() + _residue.size());
+	state.push_back(_bins);
+	state.push_back(_width);
+	state.push_back(_cycles);
+	state.push_back(_damage);
+	state.push_back(_last);
+	state.push_back(_dir);
+	state.push_back(_started ? 1.0 : 0.0);
+	state.insert(state.end(), _hist.begin(), _hist.end());
+	state.insert(state.end(), _residue.begin(), _residue.end());
+	return state;
+}
+
+bool
+Rainflow::setState(const std::vector<real>& state)
+{
+	if ((state.size() < 7 + _hist.size()) || (state[0] != _bins))
+		return false;
+	_width = state[1];
+	_cycles = state[2];
+	_damage = state[3];
+	_last = state[4];
+	_dir = (int)state[5];
+	_started = state[6] != 0.0;
+	auto it = state.begin() + 7;
+	std::copy(it, it + _hist.size(), _hist.begin());
+	_residue.assign(it + _hist.size(), state.end());
+	return true;
+}
+
+void
+Rainflow::reversal(real x)
+{
+	_residue.push_back(x);
+	// 4-point rule: the inner range is a closed cycle if it is not larger
+	// than the outer ones
+	while (_residue.size() >= 4) {
+		const size_t n = _residue.size();
+		const real x1 = _residue[n - 4], x2 = _residue[n - 3],
+		           x3 = _residue[n - 2], x4 = _residue[n - 1];
+		const real inner = std::abs(x3 - x2);
+		if ((inner > std::abs(x2 - x1)) || (inner > std::abs(x4 - x3)))
+			break;
+		count(x2, x3, 1.0, _hist.data(), _damage);
+		_cycles += 1.0;
+		_residue.resize(n - 3);
+		_residue.back() = x1;
+		_residue.push_back(x4);
+	}
+}
+
+void
+Rainflow::count(real a, real b, real n, real* hist, real& dmg) const
+{
+	const real range = std::abs(b - a);
+	if (hist && (_width > 0.0)) {
+		const real mean = 0.5 * (a + b);
+		const unsigned int last = _bins - 1;
+		const unsigned int i =
+		    (std::min)((unsigned int)(range / _width), last);
+		const unsigned int j =
+		    (std::min)((unsigned int)((std::max)(mean, 0.0) / _width), last);
+		hist[i * _bins + j] += n;
+	}
+	if (_a > 0.0)
+		dmg += n * pow(range / _area, _m) / _a;
+}
+
+void
+Rainflow::fit(real x)
+{
+	x = std::abs(x);
+	if (x == 0.0)
+		return;
+	if (_width == 0.0) {
+		// The smallest power of 2 fitting the sample
+		_width = pow(2.0, floor(log2(x / _bins)) + 1.0);
+		return;
+	}
+	while (x >= _bins * _width) {
+		std::fill(_tmp.begin(), _tmp.end(), 0.0);
+		for (unsigned int i = 0; i < _bins; i++)
+			for (unsigned int j = 0; j < _bins; j++)
+				_tmp[(i / 2) * _bins + j / 2] += _hist[i * _bins + j];
+		std::swap(_hist, _tmp);
+		_width *= 2.0;
+	}
+}
+
+} // ::moordyn
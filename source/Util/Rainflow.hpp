@@ -0,0 +1,189 @@
+/*
+ * Copyright (c) 2023, Jose Luis Cercos-Pita & Matt Hall
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ * 1. Redistributions of source code must retain the above copyright notice,
+ *    this list of conditions and the following disclaimer.
+ *
+ * 2. Redistributions in binary form must reproduce the above copyright notice,
+ *    this list of conditions and the following disclaimer in the documentation
+ *    and/or other materials provided with the distribution.
+ *
+ * 3. Neither the name of the copyright holder nor the names of its
+ *    contributors may be used to endorse or promote products derived from
+ *    this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE
+ * LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ * INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+ * CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ */
+
+
+/** @file Rainflow.hpp
+ * Streaming rainflow cycles counting, for fatigue analysis
+ */
+
+#pragma once
+
+#include "Misc.hpp"
+#include <vector>
+
+namespace moordyn {
+
+/** @class Rainflow Rainflow.hpp
+ * @brief Streaming rainflow counting of a non-negative signal, like a
+ * tension
+ *
+ * The samples are reduced to the sequence of reversals (peaks and valleys)
+ * on the fly, and the closed cycles are extracted with the 4-point rule as
+ * soon as they appear, so just the reversals which are not yet part of a
+ * closed cycle, the residue, are stored. The residue is counted as half
+ * cycles when the results are queried.
+ *
+ * The cycles are collected in a square histogram of ranges and means, with
+ * the same bin width on both axes. The width is a power of 2, which is
+ * doubled, merging the bins, whenever a sample does not fit, so the memory
+ * is bounded and the histogram covers the whole signal range.
+ *
+ * If an S-N curve, \f$N = A S^{-m}\f$, is provided, the Palmgren-Miner
+ * damage is accumulated as well, with the exact range of each cycle. The
+ * stress range \f$S\f$ is the signal range divided by the area
+ */
+class Rainflow
+{
+  public:
+	/** @brief Constructor
+	 * @param bins The number of bins of each axis of the histogram
+	 * @param sn_m The S-N curve exponent
+	 * @param sn_a The S-N curve constant. 0 to do not compute the damage
+	 * @param area The area, to get the stress from the signal
+	 */
+	Rainflow(unsigned int bins = 32,
+	         real sn_m = 3.0,
+	         real sn_a = 0.0,
+	         real area = 1.0);
+
+	/** @brief Add a sample
+	 * @param x The sample
+	 */
+	void add(real x);
+
+	/** @brief Get the number of bins of each axis of the histogram
+	 * @return The number of bins
+	 */
+	inline unsigned int bins() const { return _bins; }
+
+	/** @brief Get the bin width
+	 * @return The width, 0 if no positive samples were added yet
+	 */
+	inline real binWidth() const { return _width; }
+
+	/** @brief Get the histogram of cycles, including the residue half
+	 * cycles
+	 *
+	 * The row i and column j of the histogram counts the cycles with a range
+	 * in [i w, (i + 1) w) and a mean in [j w, (j + 1) w), with w the bin
+	 * width
+	 * @param hist The output histogram, of Rainflow::bins() x
+	 * Rainflow::bins() values, row-major
+	 */
+	void histogram(real* hist) const;
+
+	/** @brief Get the number of cycles, including the residue half cycles
+	 * @return The number of cycles
+	 */
+	real cycles() const;
+
+	/** @brief Get the accumulated damage, including the residue half cycles
+	 * @return The damage, 0 if no S-N curve was provided
+	 */
+	real damage() const;
+
+	/** @brief Pack the counting state, i.e. everything but the
+	 * configuration passed to the constructor
+	 *
+	 * It is meant to save the counting, so it can be resumed afterwards
+	 * with Rainflow::setState()
+	 * @return The packed state
+	 */
+	std::vector<real> getState() const;
+
+	/** @brief Restore a counting state packed with Rainflow::getState()
+	 * @param state The packed state
+	 * @return true if the state was restored, false if it was not packed
+	 * by a Rainflow counter with the same number of bins, in which case the
+	 * counting is not modified
+	 */
+	bool setState(const std::vector<real>& state);
+
+  private:
+	/** @brief Add a reversal, extracting the closed cycles
+	 * @param x The reversal
+	 */
+	void reversal(real x);
+
+	/** @brief Count a cycle
+	 * @param a The first reversal
+	 * @param b The second reversal
+	 * @param n 1 for a full cycle, 0.5 for a half cycle
+	 * @param hist The histogram
+	 * @param dmg The damage
+	 */
+	void count(real a, real b, real n, real* hist, real& dmg) const;
+
+	/** @brief Double the bin width until a value fits in the histogram
+	 * @param x The value
+	 */
+	void fit(real x);
+
+	/// The number of bins of each axis
+	unsigned int _bins;
+
+	/// The S-N curve exponent
+	real _m;
+
+	/// The S-N curve constant
+	real _a;
+
+	/// The area
+	real _area;
+
+	/// The bin width
+	real _width;
+
+	/// The histogram of closed cycles
+	std::vector<real> _hist;
+
+	/// A scratch histogram, to merge the bins
+	std::vector<real> _tmp;
+
+	/// The number of closed cycles
+	real _cycles;
+
+	/// The damage of the closed cycles
+	real _damage;
+
+	/// The reversals which are not yet part of a closed cycle
+	std::vector<real> _residue;
+
+	/// The last sample
+	real _last;
+
+	/// The direction of the signal, -1 descending, 1 ascending, 0 unknown
+	int _dir;
+
+	/// Whether some sample was added
+	bool _started;
+};
+
+} // ::moordyn
@@ -0,0 +1,244 @@
+/*
+ * Copyright (c) 2023, Jose Luis Cercos-Pita & Matt Hall
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ * 1. Redistributions of source code must retain the above copyright notice,
+ *    this list of conditions and the following disclaimer.
+ *
+ * 2. Redistributions in binary form must reproduce the above copyright notice,
+ *    this list of conditions and the following disclaimer in the documentation
+ *    and/or other materials provided with the distribution.
+ *
+ * 3. Neither the name of the copyright holder nor the names of its
+ *    contributors may be used to endorse or promote products derived from
+ *    this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE
+ * LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ * INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+ * CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#include "ThreadPool.hpp"
+#include <algorithm>
+#include <numeric>
+
+namespace moordyn {
+
+/// The index of the thread in the pool running it
+static thread_local unsigned int _thread_index = 0;
+
+ThreadPool::ThreadPool(unsigned int n)
+  : _task(nullptr)
+  , _generation(0)
+  , _busy(0)
+  , _stop(false)
+  , _error(nullptr)
+{
+	if (!n)
+		n = (std::max)(std::thread::hardware_concurrency(), 1u);
+	for (unsigned int i = 0; i < n; i++)
+		_queues.push_back(std::make_unique<queue>());
+	_schedules.reserve(MAX_SCHEDULES);
+	for (unsigned int i = 1; i < n; i++)
+		_threads.emplace_back(&ThreadPool::Loop, this, i);
+}
+
+ThreadPool::~ThreadPool()
+{
+	{
+		std::lock_guard<std::mutex> lock(_mtx);
+		_stop = true;
+	}
+	_cv_start.notify_all();
+	for (auto& thread : _threads)
+		thread.join();
+}
+
+void
+ThreadPool::Run(const std::vector<real>& costs,
+                const std::function<void(unsigned int)>& task)
+{
+	if (_threads.empty()) {
+		_thread_index = 0;
+		for (unsigned int i = 0; i < costs.size(); i++)
+			task(i);
+		return;
+	}
+
+	const auto& plan = Schedule(costs);
+	for (unsigned int i = 0; i < _queues.size(); i++) {
+		_queues[i]->tasks.assign(plan[i].begin(), plan[i].end());
+		_queues[i]->first = 0;
+		_queues[i]->last = (unsigned int)plan[i].size();
+	}
+	_error = nullptr;
+
+	{
+		std::lock_guard<std::mutex> lock(_mtx);
+		_task = &task;
+		_busy = (unsigned int)_threads.size();
+		_generation++;
+	}
+	_cv_start.notify_all();
+
+	Work(0);
+
+	{
+		std::unique_lock<std::mutex> lock(_mtx);
+		_cv_done.wait(lock, [this] { return _busy == 0; });
+		_task = nullptr;
+	}
+
+	if (_error)
+		std::rethrow_exception(_error);
+}
+
+void
+ThreadPool::RunChunks(unsigned int n,
+                      const std::function<void(unsigned int, unsigned int)>& task,
+                      unsigned int min_chunk)
+{
+	if (!n)
+		return;
+	min_chunk = (std::max)(min_chunk, 1u);
+	const unsigned int max_chunks = 4 * GetThreads();
+	const unsigned int chunk = (std::max)(
+	    min_chunk, (n + max_chunks - 1) / max_chunks);
+	const unsigned int n_chunks = (n + chunk - 1) / chunk;
+	if (n_chunks == 1) {
+		_thread_index = 0;
+		task(0, n);
+		return;
+	}
+	// Reuse the costs vector, so the scheduling is reused as well
+	if (_chunks_costs.size() != n_chunks)
+		_chunks_costs.assign(n_chunks, 1.0);
+	Run(_chunks_costs, [&task, chunk, n](unsigned int i) {
+		task(i * chunk, (std::min)((i + 1) * chunk, n));
+	});
+}
+
+unsigned int
+ThreadPool::GetThreadIndex()
+{
+	return _thread_index;
+}
+
+void
+ThreadPool::Loop(unsigned int id)
+{
+	unsigned long generation = 0;
+	while (true) {
+		{
+			std::unique_lock<std::mutex> lock(_mtx);
+			_cv_start.wait(lock, [this, generation] {
+				return _stop || (_generation != generation);
+			});
+			if (_stop)
+				return;
+			generation = _generation;
+		}
+
+		Work(id);
+
+		{
+			std::lock_guard<std::mutex> lock(_mtx);
+			_busy--;
+		}
+		_cv_done.notify_one();
+	}
+}
+
+void
+ThreadPool::Work(unsigned int id)
+{
+	const unsigned int n = (unsigned int)_queues.size();
+	_thread_index = id;
+	while (true) {
+		unsigned int task;
+		bool found = false;
+		// Pick the most expensive task of our own queue
+		{
+			queue* q = _queues[id].get();
+			std::lock_guard<std::mutex> lock(q->mtx);
+			if (q->first < q->last) {
+				task = q->tasks[q->first++];
+				found = true;
+			}
+		}
+		// Or steal the cheapest task from the others
+		for (unsigned int i = 1; !found && (i < n); i++) {
+			queue* q = _queues[(id + i) % n].get();
+			std::lock_guard<std::mutex> lock(q->mtx);
+			if (q->first < q->last) {
+				task = q->tasks[--q->last];
+				found = true;
+			}
+		}
+		// No tasks are added while running, so we are done
+		if (!found)
+			return;
+
+		try {
+			(*_task)(task);
+		} catch (...) {
+			std::lock_guard<std::mutex> lock(_error_mtx);
+			if (!_error)
+				_error = std::current_exception();
+		}
+	}
+}
+
+const std::vector<std::vector<unsigned int>>&
+ThreadPool::Schedule(const std::vector<real>& costs)
+{
+	// The callers are usually alternating a few sets of tasks with the same
+	// costs, e.g. the lines and the rods, so we keep a distribution for each
+	// of them. Otherwise the least recently used one is replaced
+	schedule* s = nullptr;
+	for (auto& cached : _schedules) {
+		if (cached.costs == costs) {
+			cached.used = _generation;
+			return cached.plan;
+		}
+		if (!s || (cached.used < s->used))
+			s = &cached;
+	}
+	if (_schedules.size() < MAX_SCHEDULES) {
+		_schedules.emplace_back();
+		s = &_schedules.back();
+		s->plan.resize(_queues.size());
+	}
+	s->costs = costs;
+	s->used = _generation;
+
+	_sorted.resize(costs.size());
+	std::iota(_sorted.begin(), _sorted.end(), 0);
+	std::sort(_sorted.begin(), _sorted.end(), [&costs](auto a, auto b) {
+		return (costs[a] > costs[b]) || ((costs[a] == costs[b]) && (a < b));
+	});
+
+	_loads.assign(s->plan.size(), 0.0);
+	for (auto& p : s->plan)
+		p.clear();
+	for (auto task : _sorted) {
+		const unsigned int i = (unsigned int)std::distance(
+		    _loads.begin(), std::min_element(_loads.begin(), _loads.end()));
+		s->plan[i].push_back(task);
+		_loads[i] += costs[task];
+	}
+
+	return s->plan;
+}
+
+} // ::moordyn
@@ -0,0 +1,220 @@
+/*
+ * Copyright (c) 2023, Jose Luis Cercos-Pita & Matt Hall
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ * 1. Redistributions of source code must retain the above copyright notice,
+ *    this list of conditions and the following disclaimer.
+ *
+ * 2. Redistributions in binary form must reproduce the above copyright notice,
+ *    this list of conditions and the following disclaimer in the documentation
+ *    and/or other materials provided with the distribution.
+ *
+ * 3. Neither the name of the copyright holder nor the names of its
+ *    contributors may be used to endorse or promote products derived from
+ *    this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE
+ * LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ * INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+ * CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ */
+
+/** @file ThreadPool.hpp
+ * Persistent pool of threads to run the independent entities in parallel
+ */
+
+#pragma once
+
+#include "Misc.hpp"
+#include <vector>
+#include <thread>
+#include <mutex>
+#include <condition_variable>
+#include <functional>
+#include <exception>
+#include <memory>
+
+namespace moordyn {
+
+/** @class ThreadPool ThreadPool.hpp
+ * @brief Pool of worker threads with a cost-aware work-stealing scheduler
+ *
+ * The threads are created just once, and they are sleeping until
+ * ThreadPool::Run() is called. Then the tasks are sorted by cost, and
+ * distributed among the threads following the Longest Processing Time rule,
+ * i.e. each task is given to the least loaded thread. Each thread starts
+ * processing the most expensive tasks in its own queue, and when it runs out
+ * of work it steals the cheapest tasks remaining in the queues of the other
+ * threads. This way the load is balanced even if the entities have very
+ * different sizes, or if the costs are just a rough estimation.
+ *
+ * The calling thread is also working, so a pool of n threads is just
+ * spawning n - 1 additional threads.
+ */
+class ThreadPool
+{
+  public:
+	/** @brief Constructor
+	 * @param n The number of threads, including the calling one. If 0 is
+	 * provided, the number of hardware threads is considered.
+	 */
+	ThreadPool(unsigned int n);
+
+	/** @brief Destructor
+	 */
+	~ThreadPool();
+
+	/** @brief Get the number of threads, including the calling one
+	 * @return The number of threads
+	 */
+	inline unsigned int GetThreads() const
+	{
+		return (unsigned int)_threads.size() + 1;
+	}
+
+	/** @brief Run a set of tasks in parallel
+	 *
+	 * This function is not returning until all the tasks are done
+	 * @param costs The estimated cost of each task. The number of tasks is
+	 * taken from the length of this vector
+	 * @param task The task to run, which receives the task index
+	 * @throws The first exception thrown by any of the tasks, after all the
+	 * tasks are finished
+	 */
+	void Run(const std::vector<real>& costs,
+	         const std::function<void(unsigned int)>& task);
+
+	/** @brief Run a loop in parallel, split in chunks of consecutive
+	 * iterations
+	 *
+	 * The iterations shall have similar costs. A few chunks per thread are
+	 * created, to let the threads balance the load, but not smaller than
+	 * @p min_chunk iterations, to keep the scheduling overhead bounded.
+	 * This function is not returning until all the iterations are done
+	 * @param n The number of iterations
+	 * @param task The task to run, which receives the first and the
+	 * past-the-end iterations of the chunk
+	 * @param min_chunk The minimum number of iterations per chunk
+	 * @throws The first exception thrown by any of the chunks, after all the
+	 * chunks are finished
+	 */
+	void RunChunks(unsigned int n,
+	               const std::function<void(unsigned int, unsigned int)>& task,
+	               unsigned int min_chunk = 16);
+
+	/** @brief Get the index of the thread running the current task
+	 *
+	 * It can be used by the tasks to pick per-thread resources, like
+	 * workspaces
+	 * @return The thread index, between 0 and ThreadPool::GetThreads() - 1.
+	 * The calling thread of ThreadPool::Run() has the index 0
+	 */
+	static unsigned int GetThreadIndex();
+
+  private:
+	/** @brief The tasks queue of each thread
+	 */
+	typedef struct _queue
+	{
+		/// Mutex to pop or steal tasks
+		std::mutex mtx;
+		/// The task indexes, sorted from the most to the least expensive
+		std::vector<unsigned int> tasks;
+		/// The first task not popped yet
+		unsigned int first;
+		/// The past-the-end task not stolen yet
+		unsigned int last;
+	} queue;
+
+	/** @brief Main loop of the spawned threads
+	 * @param id The thread index
+	 */
+	void Loop(unsigned int id);
+
+	/** @brief Process the tasks until there is nothing left to do, stealing
+	 * the work of the other threads when the own queue is empty
+	 * @param id The thread index
+	 */
+	void Work(unsigned int id);
+
+	/** @brief A distribution of the tasks among the threads
+	 */
+	typedef struct _schedule
+	{
+		/// The estimated cost of each task
+		std::vector<real> costs;
+		/// The task indexes given to each thread
+		std::vector<std::vector<unsigned int>> plan;
+		/// The last ThreadPool::Run() call using this distribution
+		unsigned long used;
+	} schedule;
+
+	/// The maximum number of cached distributions
+	static constexpr unsigned int MAX_SCHEDULES = 8;
+
+	/** @brief Distribute the tasks among the threads queues
+	 *
+	 * The distributions are cached, so calling this function with costs
+	 * already seen is not rescheduling anything
+	 * @param costs The estimated cost of each task
+	 * @return The task indexes given to each thread
+	 */
+	const std::vector<std::vector<unsigned int>>& Schedule(
+	    const std::vector<real>& costs);
+
+	/// The spawned threads
+	std::vector<std::thread> _threads;
+
+	/// The queues of tasks, one per thread
+	std::vector<std::unique_ptr<queue>> _queues;
+
+	/// The costs of the chunks on ThreadPool::RunChunks()
+	std::vector<real> _chunks_costs;
+
+	/// The cached distributions of the tasks, one per set of costs
+	std::vector<schedule> _schedules;
+
+	/// Workspace to sort the tasks on ThreadPool::Schedule()
+	std::vector<unsigned int> _sorted;
+
+	/// Workspace for the threads loads on ThreadPool::Schedule()
+	std::vector<real> _loads;
+
+	/// The task being run
+	const std::function<void(unsigned int)>* _task;
+
+	/// Mutex for the pool state
+	std::mutex _mtx;
+
+	/// Condition to wake up the spawned threads
+	std::condition_variable _cv_start;
+
+	/// Condition to notify that the spawned threads finished
+	std::condition_variable _cv_done;
+
+	/// Counter of the number of ThreadPool::Run() calls
+	unsigned long _generation;
+
+	/// Number of spawned threads still working
+	unsigned int _busy;
+
+	/// Flag to ask the spawned threads to finish
+	bool _stop;
+
+	/// Mutex for moordyn::ThreadPool::_error
+	std::mutex _error_mtx;
+
+	/// The first exception thrown by the tasks
+	std::exception_ptr _error;
+};
+
+} // ::moordyn
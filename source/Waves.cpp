@@ -34,7 +34,12 @@
 #include "Seafloor.hpp"
 #include "Waves/WaveGrid.hpp"
 #include "Util/Interp.hpp"
+#include "Util/MappedFile.hpp"
+#include "Util/ThreadPool.hpp"
+#include <algorithm>
 #include <filesystem>
+#include <fstream>
+#include <cstring>
 
 #if defined WIN32 && defined max
 // We must avoid max messes up with std::numeric_limits<>::max()
@@ -101,7 +106,7 @@ gridAxisCoords(Waves::coordtypes coordtype, vector<string>& entries)
 }
 
 void
-WaveGrid::allocateKinematicArrays()
+WaveGrid::allocateKinematicArrays(bool single)
 {
 	if (!nx || !ny || !nz) {
 		LOGERR << "The grid has not been initialized..." << endl;
@@ -112,12 +117,336 @@ WaveGrid::allocateKinematicArrays()
 		throw moordyn::invalid_value_error("Uninitialized values");
 	}
 
-	zetas = init3DArray(nx, ny, nt);
-	pDyn = init4DArray(nx, ny, nz, nt);
-	wave_vel = init4DArrayVec(nx, ny, nz, nt);
-	wave_acc = init4DArrayVec(nx, ny, nz, nt);
+	try {
+		zetas.resize(nx, ny, 1, nt, single);
+		kin.resize(nx, ny, nz, nt, single);
+	} catch (const std::bad_alloc& e) {
+		LOGERR << "Failure allocating the waves data grid: " << e.what()
+		       << endl;
+		throw moordyn::mem_error("Allocation error");
+	}
+
+	LOGDBG << "Allocated the waves data grid, "
+	       << (zetas.bytes() + kin.bytes()) / (1024 * 1024) << " MB" << endl;
+}
+
+/** @brief Header of the wave grid files
+ *
+ * The header is followed by the x, y and z axes, as doubles, the wave
+ * elevation blocks and the kinematics blocks. Each section starts at an
+ * offset aligned to 64 bytes, so the blocks are properly aligned when the
+ * file is mapped
+ */
+typedef struct _wave_grid_header
+{
+	/// Magic string
+	char magic[8];
+	/// File format version
+	uint32_t version;
+	/// Endianness mark, the files are not portable among architectures
+	uint32_t endian;
+	/// Number of points in the x direction
+	uint32_t nx;
+	/// Number of points in the y direction
+	uint32_t ny;
+	/// Number of points in the z direction
+	uint32_t nz;
+	/// Number of time instants
+	uint32_t nt;
+	/// 1 if the kinematics are in single precision, 0 otherwise
+	uint32_t single;
+	/// Unused, just padding
+	uint32_t reserved;
+	/// Time step
+	double dt;
+	/// Hash of the inputs used to generate the grid
+	uint64_t hash;
+	/// Offset of the axes
+	uint64_t axes;
+	/// Offset of the wave elevation blocks
+	uint64_t zetas;
+	/// Offset of the kinematics blocks
+	uint64_t kin;
+	/// Total size of the file
+	uint64_t size;
+} wave_grid_header;
+
+/// Magic string of the wave grid files
+static const char WAVE_GRID_MAGIC[8] = "MDWGRID";
+/// Version of the wave grid files
+static const uint32_t WAVE_GRID_VERSION = 1;
+/// Endianness mark of the wave grid files
+static const uint32_t WAVE_GRID_ENDIAN = 0x01020304;
+
+/** @brief Round up an offset to the next cache line boundary
+ * @param offset The offset
+ * @return The aligned offset
+ */
+static inline uint64_t
+align64(uint64_t offset)
+{
+	return (offset + 63) & ~((uint64_t)63);
+}
+
+void
+WaveGrid::save(const std::string& path, uint64_t hash) const
+{
+	wave_grid_header header;
+	memset(&header, 0, sizeof(header));
+	memcpy(header.magic, WAVE_GRID_MAGIC, sizeof(header.magic));
+	header.version = WAVE_GRID_VERSION;
+	header.endian = WAVE_GRID_ENDIAN;
+	header.nx = nx;
+	header.ny = ny;
+	header.nz = nz;
+	header.nt = nt;
+	header.single = kin.single() ? 1 : 0;
+	header.dt = dtWave;
+	header.hash = hash;
+	header.axes = align64(sizeof(header));
+	header.zetas = align64(header.axes + (nx + ny + nz) * sizeof(double));
+	header.kin = align64(header.zetas + zetas.bytes());
+	header.size = header.kin + kin.bytes();
+
+	ofstream f(path, ios::out | ios::binary);
+	if (!f) {
+		LOGERR << "The file '" << path << "' cannot be written" << endl;
+		throw moordyn::output_file_error("Invalid file");
+	}
+	const char zeros[64] = {};
+	auto pad = [&f, &zeros](uint64_t offset) {
+		f.write(zeros, offset - (uint64_t)f.tellp());
+	};
+	f.write((const char*)&header, sizeof(header));
+	pad(header.axes);
+	for (auto axis : { &px, &py, &pz }) {
+		for (auto v : *axis) {
+			const double d = v;
+			f.write((const char*)&d, sizeof(double));
+		}
+	}
+	pad(header.zetas);
+	f.write((const char*)zetas.data(), zetas.bytes());
+	pad(header.kin);
+	f.write((const char*)kin.data(), kin.bytes());
+	if (!f) {
+		LOGERR << "Failure writing the file '" << path << "'" << endl;
+		throw moordyn::output_file_error("Invalid file");
+	}
+	f.close();
+}
+
+std::unique_ptr<WaveGrid>
+WaveGrid::load(moordyn::Log* _log, const std::string& path, uint64_t hash)
+{
+	if (!filesystem::exists(path))
+		return nullptr;
+
+	std::shared_ptr<MappedFile> file;
+	try {
+		file = std::make_shared<MappedFile>(path);
+	} catch (const moordyn::input_file_error& e) {
+		LOGWRN << "The wave grid file '" << path
+		       << "' cannot be mapped: " << e.what() << endl;
+		return nullptr;
+	}
+
+	wave_grid_header header;
+	if (file->size() < sizeof(header)) {
+		LOGWRN << "The file '" << path << "' is not a wave grid file" << endl;
+		return nullptr;
+	}
+	memcpy(&header, file->data(), sizeof(header));
+	if (memcmp(header.magic, WAVE_GRID_MAGIC, sizeof(header.magic)) ||
+	    (header.version != WAVE_GRID_VERSION) ||
+	    (header.endian != WAVE_GRID_ENDIAN) || (header.size != file->size())) {
+		LOGWRN << "The file '" << path
+		       << "' is not a valid wave grid file for this MoorDyn build"
+		       << endl;
+		return nullptr;
+	}
+	const uint64_t scalar = header.single ? sizeof(float) : sizeof(double);
+	const uint64_t npoints = (uint64_t)header.nx * header.ny * header.nt;
+	if (!header.nx || !header.ny || !header.nz || !header.nt ||
+	    (header.axes < sizeof(header)) ||
+	    (header.zetas < header.axes + (header.nx + header.ny + header.nz) *
+	                                      sizeof(double)) ||
+	    (header.kin < header.zetas + npoints * scalar) ||
+	    (header.size != header.kin + npoints * header.nz * 8 * scalar) ||
+	    (header.zetas % 64) || (header.kin % 64)) {
+		LOGWRN << "The wave grid file '" << path << "' is corrupted" << endl;
+		return nullptr;
+	}
+	if (header.hash != hash) {
+		LOGMSG << "The wave grid file '" << path
+		       << "' was generated with different inputs" << endl;
+		return nullptr;
+	}
+
+	std::vector<real> axes[3];
+	const unsigned int n[3] = { header.nx, header.ny, header.nz };
+	const double* src = (const double*)(file->data() + header.axes);
+	for (unsigned int i = 0; i < 3; i++) {
+		axes[i].assign(src, src + n[i]);
+		src += n[i];
+	}
 
-	LOGDBG << "Allocated the waves data grid";
+	auto grid = std::make_unique<WaveGrid>(
+	    _log, axes[0], axes[1], axes[2], header.nt, header.dt);
+	const bool single = header.single != 0;
+	grid->zetas.map(file->data() + header.zetas,
+	                header.nx,
+	                header.ny,
+	                1,
+	                header.nt,
+	                single,
+	                file);
+	grid->kin.map(file->data() + header.kin,
+	              header.nx,
+	              header.ny,
+	              header.nz,
+	              header.nt,
+	              single,
+	              file);
+	LOGMSG << "Mapped the wave grid file '" << path << "', "
+	       << file->size() / (1024 * 1024) << " MB" << endl;
+	return grid;
+}
+
+WaveGrid::~WaveGrid()
+{
+	if (!_worker.joinable())
+		return;
+	{
+		std::lock_guard<std::mutex> lock(_window_mtx);
+		_stop = true;
+	}
+	_cv_free.notify_all();
+	_worker.join();
+}
+
+void
+WaveGrid::setupWindow(unsigned int n, SliceGenerator generator, bool single)
+{
+	if (!nx || !ny || !nz) {
+		LOGERR << "The grid has not been initialized..." << endl;
+		throw moordyn::invalid_value_error("Uninitialized values");
+	}
+	// The window shall hold the slice behind the current one and the two
+	// slices bounding the current time
+	if (n < 4) {
+		LOGERR << "The sliding time window shall have at least 4 slices, but "
+		       << n << " were asked" << endl;
+		throw moordyn::invalid_value_error("Too small window");
+	}
+
+	try {
+		zetas.resize(nx, ny, 1, n, single);
+		kin.resize(nx, ny, nz, n, single);
+	} catch (const std::bad_alloc& e) {
+		LOGERR << "Failure allocating the waves data window: " << e.what()
+		       << endl;
+		throw moordyn::mem_error("Allocation error");
+	}
+
+	LOGMSG << "Allocated the waves data sliding window of " << n
+	       << " time slices, " << (zetas.bytes() + kin.bytes()) / (1024 * 1024)
+	       << " MB" << endl;
+
+	_window = n;
+	_generator = generator;
+	_first = 0;
+	_count = 0;
+	_worker = std::thread(&WaveGrid::windowLoop, this);
+}
+
+void
+WaveGrid::setupTiles(unsigned int n,
+                     real life,
+                     TileGenerator generator,
+                     bool single)
+{
+	if (!nx || !ny || !nz) {
+		LOGERR << "The grid has not been initialized..." << endl;
+		throw moordyn::invalid_value_error("Uninitialized values");
+	}
+	if (!nt) {
+		LOGERR << "The time series has null size" << endl;
+		throw moordyn::invalid_value_error("Uninitialized values");
+	}
+	if (!n) {
+		LOGERR << "The tiles shall have at least 1 cell" << endl;
+		throw moordyn::invalid_value_error("Too small tiles");
+	}
+
+	_tile = n;
+	_tile_life = life;
+	_tile_generator = generator;
+	_tile_single = single;
+	// The tiles are sharing the points on their boundaries, so the cells
+	// are always interpolated within a single tile
+	_ntx = (std::max)((nx - 1 + n - 1) / n, 1u);
+	_nty = (std::max)((ny - 1 + n - 1) / n, 1u);
+	_tiles.clear();
+	_tiles.resize(_ntx * _nty);
+	_tile_used.assign(_ntx * _nty, 0.0);
+	_last_sweep = 0.0;
+
+	LOGMSG << "The waves grid is split in " << _ntx << " x " << _nty
+	       << " tiles, which are generated on demand" << endl;
+}
+
+unsigned int
+WaveGrid::allocatedTiles() const
+{
+	return (unsigned int)std::count_if(
+	    _tiles.begin(), _tiles.end(), [](const auto& t) { return (bool)t; });
+}
+
+const WaveGrid*
+WaveGrid::tile(unsigned int& ix, unsigned int& iy)
+{
+	const unsigned int tx = ix ? (ix - 1) / _tile : 0;
+	const unsigned int ty = iy ? (iy - 1) / _tile : 0;
+	const unsigned int ox = tx * _tile;
+	const unsigned int oy = ty * _tile;
+	ix -= ox;
+	iy -= oy;
+
+	const unsigned int t = tx * _nty + ty;
+	_tile_used[t] = _now;
+	if (_tiles[t])
+		return _tiles[t].get();
+
+	const unsigned int ex = (std::min)(ox + _tile, nx - 1);
+	const unsigned int ey = (std::min)(oy + _tile, ny - 1);
+	std::vector<real> tpx(px.begin() + ox, px.begin() + ex + 1);
+	std::vector<real> tpy(py.begin() + oy, py.begin() + ey + 1);
+	auto grid = std::make_unique<WaveGrid>(_log, tpx, tpy, pz, nt, dtWave);
+	grid->allocateKinematicArrays(_tile_single);
+	_tiles[t] = _tile_generator(std::move(grid));
+	LOGDBG << "Generated the waves grid tile (" << tx << ", " << ty
+	       << ") at t = " << _now << " s" << endl;
+	return _tiles[t].get();
+}
+
+void
+WaveGrid::evictTiles(real time)
+{
+	if (_tile_life <= 0.0)
+		return;
+	if (time < _last_sweep)
+		_last_sweep = time;
+	if (time - _last_sweep < _tile_life)
+		return;
+	_last_sweep = time;
+	for (unsigned int t = 0; t < _tiles.size(); t++) {
+		if (_tiles[t] && (_tile_used[t] < time - _tile_life)) {
+			_tiles[t].reset();
+			LOGDBG << "Dropped the waves grid tile (" << t / _nty << ", "
+			       << t % _nty << ") at t = " << time << " s" << endl;
+		}
+	}
 }
 
 void
@@ -129,24 +458,161 @@ WaveGrid::getWaveKin(const vec3& pos,
                      vec3* acc,
                      real* pdyn)
 {
-	real fx, fy, fz;
+	unsigned int it0, it1;
+	real ft;
+	timeIndexes(time, it0, it1, ft);
+	getWaveKin(pos, it0, it1, ft, seafloor, nullptr, zeta, vel, acc, pdyn);
+	if (tiled())
+		evictTiles(time);
+}
 
-	auto ix = interp_factor(px, pos.x(), fx);
-	auto iy = interp_factor(py, pos.y(), fy);
+void
+WaveGrid::getWaveKin(const Eigen::Ref<const Eigen::Matrix3Xr>& pos,
+                     real time,
+                     const SeafloorProvider& seafloor,
+                     Eigen::Ref<Eigen::ArrayXr> zeta,
+                     Eigen::Ref<Eigen::Matrix3Xr> vel,
+                     Eigen::Ref<Eigen::Matrix3Xr> acc,
+                     Eigen::Ref<Eigen::ArrayXr> pdyn,
+                     ThreadPool* pool)
+{
+	// A null hint is forcing a regular search
+	if (hints.size() != (size_t)(3 * pos.cols()))
+		hints.assign(3 * pos.cols(), 0);
+	unsigned int it0, it1;
+	real ft;
+	timeIndexes(time, it0, it1, ft);
+	// Each position has its own hint, so they can be computed in parallel,
+	// unless the tiles shall be generated on demand
+	auto task = [&](unsigned int i0, unsigned int i1) {
+		for (unsigned int i = i0; i < i1; i++) {
+			vec3 u, ud;
+			getWaveKin(pos.col(i),
+			           it0,
+			           it1,
+			           ft,
+			           seafloor,
+			           hints.data() + 3 * i,
+			           &zeta[i],
+			           &u,
+			           &ud,
+			           &pdyn[i]);
+			vel.col(i) = u;
+			acc.col(i) = ud;
+		}
+	};
+	const unsigned int n = (unsigned int)pos.cols();
+	if (pool && !tiled())
+		pool->RunChunks(n, task);
+	else
+		task(0, n);
+	if (tiled())
+		evictTiles(time);
+}
 
-	unsigned int it = 0;
-	real ft = 0.0;
+void
+WaveGrid::timeIndexes(real time, unsigned int& it0, unsigned int& it1, real& ft)
+{
+	_now = time;
+	it0 = it1 = 0;
+	ft = 0.0;
+	if (windowed()) {
+		const real quot = (std::max)(time / dtWave, 0.0);
+		const unsigned long it = (unsigned long)floor(quot);
+		ft = quot - it;
+		slide(it);
+		it0 = it % _window;
+		it1 = (it + 1) % _window;
+		return;
+	}
 	if (nt > 1) {
 		real quot = time / dtWave;
-		it = floor(quot);
-		ft = quot - it;
-		it++; // We use the upper bound
-		while (it > nt - 1)
-			it -= nt;
+		it1 = floor(quot);
+		ft = quot - it1;
+		it1++; // We use the upper bound
+		while (it1 > nt - 1)
+			it1 -= nt;
+		it0 = it1 > 0 ? it1 - 1 : 0;
 	}
+}
+
+void
+WaveGrid::slide(unsigned long it)
+{
+	std::unique_lock<std::mutex> lock(_window_mtx);
+	// We keep a slice behind, since the time integrators might look a bit
+	// back in time
+	const unsigned long first = it ? it - 1 : 0;
+	if ((first < _first) || (first >= _first + _count)) {
+		// Out of the generated slices, restart the window from scratch
+		_first = first;
+		_count = 0;
+	} else {
+		_count -= first - _first;
+		_first = first;
+	}
+	_cv_free.notify_one();
+	_cv_ready.wait(lock, [this, it] {
+		return _window_error || (_first + _count > it + 1);
+	});
+	if (_window_error)
+		std::rethrow_exception(_window_error);
+}
+
+void
+WaveGrid::windowLoop()
+{
+	std::unique_lock<std::mutex> lock(_window_mtx);
+	while (true) {
+		_cv_free.wait(lock, [this] {
+			return _stop || (!_window_error && (_count < _window));
+		});
+		if (_stop)
+			return;
+		// The slot of this slice is not read until it is marked as
+		// generated, so it can be written without locking
+		const unsigned long it = _first + _count;
+		lock.unlock();
+		std::exception_ptr error;
+		try {
+			_generator(*this, it, it % _window);
+		} catch (...) {
+			error = std::current_exception();
+		}
+		lock.lock();
+		if (error)
+			_window_error = error;
+		else if (it == _first + _count) {
+			// Otherwise the window has been restarted while we were working
+			_count++;
+		}
+		_cv_ready.notify_all();
+	}
+}
+
+void
+WaveGrid::getWaveKin(const vec3& pos,
+                     unsigned int it0,
+                     unsigned int it1,
+                     real ft,
+                     const SeafloorProvider& seafloor,
+                     unsigned int* hint,
+                     real* zeta,
+                     vec3* vel,
+                     vec3* acc,
+                     real* pdyn)
+{
+	real fx, fy, fz;
+
+	auto ix = hint ? ax.factor(pos.x(), hint[0], fx) : ax.factor(pos.x(), fx);
+	auto iy = hint ? ay.factor(pos.y(), hint[1], fy) : ay.factor(pos.y(), fy);
+
+	// On sparse grids the data is taken from the tile, with local indexes
+	const WaveGrid* grid = tiled() ? tile(ix, iy) : this;
 
 	// wave elevation
-	auto wave_elev = interp3(zetas, ix, iy, it, fx, fy, ft);
+	real wave_elev;
+	grid->zetas.interp(ix, iy, 0, it0, it1, fx, fy, 0.0, ft, &wave_elev);
 
 	if (zeta) {
 		*zeta = wave_elev;
@@ -169,21 +635,24 @@ WaveGrid::getWaveKin(const vec3& pos,
 	}
 	// LOGMSG << "WaveGrid::getWaveKin - stretched_z = " << stretched_z << endl;
 
-	auto iz = interp_factor(pz, stretched_z, fz);
+	auto iz = hint ? az.factor(stretched_z, hint[2], fz)
+	               : az.factor(stretched_z, fz);
 
+	real k[8];
+	grid->kin.interp(ix, iy, iz, it0, it1, fx, fy, fz, ft, k);
 	if (vel) {
-		*vel = interp4Vec(wave_vel, ix, iy, iz, it, fx, fy, fz, ft);
+		*vel = vec3(k[KIN_VEL], k[KIN_VEL + 1], k[KIN_VEL + 2]);
 	}
 	if (acc) {
-		*acc = interp4Vec(wave_acc, ix, iy, iz, it, fx, fy, fz, ft);
+		*acc = vec3(k[KIN_ACC], k[KIN_ACC + 1], k[KIN_ACC + 2]);
 	}
 	if (pdyn) {
-		*pdyn = interp4(pDyn, ix, iy, iz, it, fx, fy, fz, ft);
+		*pdyn = k[KIN_PDYN];
 	}
 }
 
 void
-CurrentGrid::allocateKinematicArrays()
+CurrentGrid::allocateKinematicArrays(bool single)
 {
 	if (!nx || !ny || !nz) {
 		LOGERR << "The grid has not been initialized..." << endl;
@@ -194,10 +663,16 @@ CurrentGrid::allocateKinematicArrays()
 		throw moordyn::invalid_value_error("Uninitialized values");
 	}
 
-	current_vel = init4DArrayVec(nx, ny, nz, nt);
-	current_acc = init4DArrayVec(nx, ny, nz, nt);
+	try {
+		kin.resize(nx, ny, nz, nt, single);
+	} catch (const std::bad_alloc& e) {
+		LOGERR << "Failure allocating the current data grid: " << e.what()
+		       << endl;
+		throw moordyn::mem_error("Allocation error");
+	}
 
-	LOGDBG << "Allocated the current data grid";
+	LOGDBG << "Allocated the current data grid, " << kin.bytes() / (1024 * 1024)
+	       << " MB" << endl;
 }
 
 void
@@ -207,13 +682,47 @@ CurrentGrid::getCurrentKin(const vec3& pos,
                            vec3* vel,
                            vec3* acc)
 {
-	real fx, fy, fz;
+	unsigned int it;
+	real ft;
+	timeIndex(time, it, ft);
+	getCurrentKin(pos, it, ft, nullptr, vel, acc);
+}
 
-	auto ix = interp_factor(px, pos.x(), fx);
-	auto iy = interp_factor(py, pos.y(), fy);
+void
+CurrentGrid::getCurrentKin(const Eigen::Ref<const Eigen::Matrix3Xr>& pos,
+                           real time,
+                           [[maybe_unused]] const SeafloorProvider& seafloor,
+                           Eigen::Ref<Eigen::Matrix3Xr> vel,
+                           Eigen::Ref<Eigen::Matrix3Xr> acc,
+                           ThreadPool* pool)
+{
+	// A null hint is forcing a regular search
+	if (hints.size() != (size_t)(3 * pos.cols()))
+		hints.assign(3 * pos.cols(), 0);
+	unsigned int it;
+	real ft;
+	timeIndex(time, it, ft);
+	// Each position has its own hint, so they can be computed in parallel
+	auto task = [&](unsigned int i0, unsigned int i1) {
+		for (unsigned int i = i0; i < i1; i++) {
+			vec3 u, ud;
+			getCurrentKin(pos.col(i), it, ft, hints.data() + 3 * i, &u, &ud);
+			vel.col(i) = u;
+			acc.col(i) = ud;
+		}
+	};
+	const unsigned int n = (unsigned int)pos.cols();
+	if (pool)
+		pool->RunChunks(n, task);
+	else
+		task(0, n);
+}
 
-	unsigned int it = 0;
-	real ft = 0.0;
+void
+CurrentGrid::timeIndex(real time, unsigned int& it, real& ft) const
+{
+	it = 0;
+	ft = 0.0;
 	if (nt > 1) {
 		real quot = time / dtWave;
 		it = floor(quot);
@@ -222,6 +731,20 @@ CurrentGrid::getCurrentKin(const vec3& pos,
 		while (it > nt - 1)
 			it -= nt;
 	}
+}
+
+void
+CurrentGrid::getCurrentKin(const vec3& pos,
+                           unsigned int it,
+                           real ft,
+                           unsigned int* hint,
+                           vec3* vel,
+                           vec3* acc) const
+{
+	real fx, fy, fz;
+
+	auto ix = hint ? ax.factor(pos.x(), hint[0], fx) : ax.factor(pos.x(), fx);
+	auto iy = hint ? ay.factor(pos.y(), hint[1], fy) : ay.factor(pos.y(), fy);
 
 	// real stretched_z = 0.0;
 	// const real bottom = seafloor.getDepth(vec2(pos.x(), pos.y()));
@@ -234,13 +757,15 @@ CurrentGrid::getCurrentKin(const vec3& pos,
 	// LOGMSG << "WaveGrid::getWaveKin - stretched_z = " << stretched_z << endl;
 
 	// TODO - current stretching?
-	auto iz = interp_factor(pz, pos.z(), fz);
+	auto iz = hint ? az.factor(pos.z(), hint[2], fz) : az.factor(pos.z(), fz);
 
+	real k[8];
+	kin.interp(ix, iy, iz, it, fx, fy, fz, ft, k);
 	if (vel) {
-		*vel = interp4Vec(current_vel, ix, iy, iz, it, fx, fy, fz, ft);
+		*vel = vec3(k[KIN_VEL], k[KIN_VEL + 1], k[KIN_VEL + 2]);
 	}
 	if (acc) {
-		*acc = interp4Vec(current_acc, ix, iy, iz, it, fx, fy, fz, ft);
+		*acc = vec3(k[KIN_ACC], k[KIN_ACC + 1], k[KIN_ACC + 2]);
 	}
 }
 
@@ -263,6 +788,8 @@ Waves::setup(EnvCondRef env_in,
 	// (like before dynamic relaxation and then before the main simulation)
 	waveKinematics.reset();
 	currentKinematics.reset();
+	nSamples = 0;
+	cacheTime = std::numeric_limits<real>::quiet_NaN();
 	this->env = env_in;
 	this->seafloor = seafloor;
 	rho_w = env->rho_w;
@@ -360,6 +887,8 @@ Waves::setup(EnvCondRef env_in,
 
 	// NOTE: nodal settings should use storeWaterKin in objects
 	// now go through each applicable WaveKin option
+	// The grids are computed with the same threads used for the derivatives
+	ThreadPool* pool = _t_integrator ? _t_integrator->GetPool() : nullptr;
 	if (wave_mode == waves::WAVES_SUM_COMPONENTS_NODE) {
 		const string WaveFilename = (string)folder + "wave_frequencies.txt";
 		LOGMSG << "Reading waves spectrum frequencies from '" << WaveFilename
@@ -377,11 +906,23 @@ Waves::setup(EnvCondRef env_in,
 		waveKinematics =
 		    std::make_unique<SpectrumKinWrapper>(std::move(spectrumKin));
 	} else if (wave_mode == waves::WAVES_FFT_GRID) {
-		waveGrid = constructWaveGridSpectrumData((string)folder, env, _log);
+		waveGrid =
+		    constructWaveGridSpectrumData((string)folder, env, _log, pool);
 	} else if (wave_mode == waves::WAVES_GRID) {
 		// load wave elevation time series from file (similar to what's done in
 		// GenerateWaveExtnFile.py, and was previously in misc2.cpp)
-		waveGrid = constructWaveGridElevationData((string)folder, env, _log);
+		waveGrid =
+		    constructWaveGridElevationData((string)folder, env, _log, pool);
+	}
+
+	// The slices of a sliding window and the tiles of a sparse grid are
+	// generated on the fly, so the currents cannot be added to them
+	bool unify = env->waterKinOptions.unifyCurrentGrid;
+	if (unify && waveGrid && (waveGrid->windowed() || waveGrid->tiled()) &&
+	    is_currents_grid(current_mode)) {
+		LOGMSG << "The currents grid is not unified with a waves grid "
+		       << "generated on the fly" << endl;
+		unify = false;
 	}
 
 	// Now add in current velocities (add to unsteady wave kinematics)
@@ -390,7 +931,7 @@ Waves::setup(EnvCondRef env_in,
 
 		// if there is an existing wave grid an we are set to unify the wave
 		// and current grids
-		if (waveGrid && env->waterKinOptions.unifyCurrentGrid) {
+		if (waveGrid && unify) {
 			SeafloorProvider floorProvider{ -env->WtrDpth, seafloor };
 			for (unsigned int iz = 0; iz < waveGrid->nz; iz++) {
 				auto z = waveGrid->Pz()[iz];
@@ -401,8 +942,18 @@ Waves::setup(EnvCondRef env_in,
 				for (unsigned int ix = 0; ix < waveGrid->nx; ix++) {
 					for (unsigned int iy = 0; iy < waveGrid->ny; iy++) {
 						for (unsigned int it = 0; it < waveGrid->nt; it++) {
-							waveGrid->WaveVel()[ix][iy][iz][it] += curr_vel;
-							waveGrid->WaveAcc()[ix][iy][iz][it] += curr_acc;
+							waveGrid->setVel(
+							    ix,
+							    iy,
+							    iz,
+							    it,
+							    waveGrid->getVel(ix, iy, iz, it) + curr_vel);
+							waveGrid->setAcc(
+							    ix,
+							    iy,
+							    iz,
+							    it,
+							    waveGrid->getAcc(ix, iy, iz, it) + curr_acc);
 						}
 					}
 				}
@@ -413,7 +964,7 @@ Waves::setup(EnvCondRef env_in,
 	} else if (current_mode == CURRENTS_DYNAMIC_GRID) {
 		auto currentGrid = constructDynamicCurrentGrid(folder, env, _log);
 
-		if (waveGrid && env->waterKinOptions.unifyCurrentGrid) {
+		if (waveGrid && unify) {
 			// interpolate currents on to wave existing wave grid
 			SeafloorProvider floorProvider{ -env->WtrDpth, seafloor };
 			for (unsigned int iz = 0; iz < waveGrid->nz; iz++) {
@@ -427,8 +978,18 @@ Waves::setup(EnvCondRef env_in,
 					                           &currentAcc);
 					for (unsigned int ix = 0; ix < waveGrid->nx; ix++) {
 						for (unsigned int iy = 0; iy < waveGrid->ny; iy++) {
-							waveGrid->WaveVel()[ix][iy][iz][it] += currentVel;
-							waveGrid->WaveVel()[ix][iy][iz][it] += currentAcc;
+							waveGrid->setVel(
+							    ix,
+							    iy,
+							    iz,
+							    it,
+							    waveGrid->getVel(ix, iy, iz, it) + currentVel);
+							waveGrid->setAcc(
+							    ix,
+							    iy,
+							    iz,
+							    it,
+							    waveGrid->getAcc(ix, iy, iz, it) + currentAcc);
 						}
 					}
 				}
@@ -438,7 +999,7 @@ Waves::setup(EnvCondRef env_in,
 		}
 	} else if (current_mode == CURRENTS_4D) {
 		auto currentGrid = construct4DCurrentGrid(folder, env, _log);
-		if (waveGrid && env->waterKinOptions.unifyCurrentGrid) {
+		if (waveGrid && unify) {
 			// interpolate read in data and add to existing grid
 			// (dtWave, px, etc are already set in the grid)
 			// LOGMSG << "interpolating 4d current grid onto wave grid" << endl;
@@ -467,8 +1028,18 @@ Waves::setup(EnvCondRef env_in,
 							                           floorProvider,
 							                           &currentVel,
 							                           &currentAcc);
-							waveGrid->WaveVel()[ix][iy][iz][it] += currentVel;
-							waveGrid->WaveAcc()[ix][iy][iz][it] += currentAcc;
+							waveGrid->setVel(
+							    ix,
+							    iy,
+							    iz,
+							    it,
+							    waveGrid->getVel(ix, iy, iz, it) + currentVel);
+							waveGrid->setAcc(
+							    ix,
+							    iy,
+							    iz,
+							    it,
+							    waveGrid->getAcc(ix, iy, iz, it) + currentAcc);
 						}
 					}
 				}
@@ -683,6 +1254,8 @@ Waves::setWaveKinematics(std::vector<vec> const& U_in,
 		throw moordyn::invalid_value_error(
 		    "Waves::setWaveKinematics U and Ud must have the same size");
 	}
+	// The new kinematics shall be considered even if the time has not changed
+	cacheTime = std::numeric_limits<real>::quiet_NaN();
 	AllNodesKin& kinematics = currentKinematics ? waveKin : nodeKin;
 	kinematicsForAllNodes(
 	    kinematics, [&](vec _pos, vec& U, vec& Ud, real& _zeta, real& _pdyn) {
@@ -748,125 +1321,259 @@ Waves::kinematicsForAllNodes(AllNodesKin& nodeKinematics, F f)
 	}
 }
 
+void
+Waves::gatherPositions()
+{
+	unsigned int n = 0;
+	kinematicsForAllNodes(
+	    nodeKin,
+	    [&](vec _pos, vec& _U, vec& _Ud, real& _zeta, real& _pdyn) { n++; });
+	if (batchPos.cols() != n) {
+		batchPos.resize(Eigen::NoChange, n);
+		batchU.resize(Eigen::NoChange, n);
+		batchUd.resize(Eigen::NoChange, n);
+		batchZeta.resize(n);
+		batchPdyn.resize(n);
+		batchCU.resize(Eigen::NoChange, n);
+		batchCUd.resize(Eigen::NoChange, n);
+	}
+
+	unsigned int i = 0;
+	kinematicsForAllNodes(
+	    nodeKin, [&](vec pos, vec& _U, vec& _Ud, real& _zeta, real& _pdyn) {
+		    batchPos.col(i++) = pos;
+	    });
+}
+
 void
 Waves::updateWaves()
 {
-	SeafloorProvider floorProvider{ -env->WtrDpth, seafloor };
-	if (env->waterKinOptions.waveMode == waves::WAVES_EXTERNAL &&
-	    currentKinematics) {
-		// if we have external waves and currents, then we go through and add
-		// together the externally defined wave kinematics with the calculated
-		// current kinematics
-		auto& lines = nodeKin.lines;
-		for (const auto& line : lines.structures) {
-			for (unsigned int i = 0; i <= line->getN(); i++) {
-				const vec pos = line->getNodePos(i);
-				const auto id = line->lineId;
-
-				vec3 curr_U{}, curr_Ud{};
-				currentKinematics->getCurrentKin(pos,
-				                                 _t_integrator->GetTime(),
-				                                 floorProvider,
-				                                 &curr_U,
-				                                 &curr_Ud);
-				lines.U[id][i] = waveKin.lines.U[id][i] + curr_U;
-				lines.Ud[id][i] = waveKin.lines.Ud[id][i] + curr_Ud;
-			}
-		}
+	const real t = _t_integrator->GetTime();
+	switch (env->waterKinOptions.cacheMode) {
+		case waves::WAVES_CACHE_TIME:
+			if (t == cacheTime)
+				return;
+			cacheTime = t;
+			break;
+		case waves::WAVES_CACHE_LINEAR:
+		case waves::WAVES_CACHE_CUBIC:
+			if (interpolateWaves(t))
+				return;
+			break;
+		default:
+			break;
+	}
+	evaluateWaves(t);
+}
 
-		auto& rods = nodeKin.rods;
-		for (const auto& rod : rods.structures) {
-			for (unsigned int i = 0; i <= rod->getN(); i++) {
-				const vec pos = rod->getNodePos(i);
-				const auto id = rod->rodId;
-				vec3 curr_U{}, curr_Ud{};
-				currentKinematics->getCurrentKin(pos,
-				                                 _t_integrator->GetTime(),
-				                                 floorProvider,
-				                                 &curr_U,
-				                                 &curr_Ud);
-				rods.U[id][i] = waveKin.rods.U[id][i] + curr_U;
-				rods.Ud[id][i] = waveKin.rods.Ud[id][i] + curr_Ud;
-			}
-		}
+void
+Waves::setCouplingStep(real t0, real t1)
+{
+	const auto mode = env ? env->waterKinOptions.cacheMode
+	                      : waves::WAVES_CACHE_NONE;
+	if ((mode != waves::WAVES_CACHE_LINEAR) &&
+	    (mode != waves::WAVES_CACHE_CUBIC))
+		return;
+	// The external waves cannot be evaluated at any time
+	if (!waveKinematics ||
+	    (env->waterKinOptions.waveMode == waves::WAVES_EXTERNAL))
+		return;
 
-		auto& points = nodeKin.points;
-		for (const auto& point : points.structures) {
-			const vec& pos = point->getPosition();
-			const auto id = point->pointId;
-
-			vec3 curr_U{}, curr_Ud{};
-			currentKinematics->getCurrentKin(pos,
-			                                 _t_integrator->GetTime(),
-			                                 floorProvider,
-			                                 &curr_U,
-			                                 &curr_Ud);
-			points.U[id][0] = waveKin.points.U[id][0] + curr_U;
-			points.Ud[id][0] = waveKin.points.Ud[id][0] + curr_Ud;
-		}
+	// The samples times, from the first to the last one
+	const real h = t1 - t0;
+	real times[4] = { t0, t1, 0.0, 0.0 };
+	unsigned int n = 2;
+	if (mode == waves::WAVES_CACHE_CUBIC) {
+		times[0] = t0 - h;
+		times[1] = t0;
+		times[2] = t1;
+		times[3] = t1 + h;
+		n = 4;
+	}
+	if (samples.size() != n)
+		samples.resize(n);
+
+	// On a regular simulation the new coupling time step starts where the
+	// previous one ended, so all the samples but the last one can be reused.
+	// The times are compared with a tolerance, since the integrator time is
+	// accumulated from the substeps
+	const real eps = 1e-6 * h;
+	bool reuse = (nSamples == n);
+	for (unsigned int i = 0; reuse && (i + 1 < n); i++)
+		reuse = std::abs(samples[i + 1].t - times[i]) <= eps;
+	if (reuse) {
+		std::rotate(samples.begin(), samples.begin() + 1, samples.end());
+		for (unsigned int i = 0; i + 1 < n; i++)
+			samples[i].t = times[i];
+		sampleWaves(samples[n - 1], times[n - 1]);
+		return;
+	}
+	for (unsigned int i = 0; i < n; i++)
+		sampleWaves(samples[i], times[i]);
+	nSamples = n;
+}
 
-		auto& bodies = nodeKin.bodies;
-		for (const auto& body : bodies.structures) {
-			const vec pos = body->getPosition();
-			const auto id = body->bodyId;
-
-			vec3 curr_U{}, curr_Ud{};
-			currentKinematics->getCurrentKin(pos,
-			                                 _t_integrator->GetTime(),
-			                                 floorProvider,
-			                                 &curr_U,
-			                                 &curr_Ud);
-			bodies.U[id][0] = waveKin.bodies.U[id][0] + curr_U;
-			bodies.Ud[id][0] = waveKin.bodies.Ud[id][0] + curr_Ud;
-		}
+void
+Waves::sampleWaves(kinSample& sample, real t)
+{
+	evaluateWaves(t);
+	unsigned int n = 0;
+	kinematicsForAllNodes(
+	    nodeKin,
+	    [&](vec _pos, vec& _U, vec& _Ud, real& _zeta, real& _pdyn) { n++; });
+	if (sample.zeta.size() != n) {
+		sample.U.resize(Eigen::NoChange, n);
+		sample.Ud.resize(Eigen::NoChange, n);
+		sample.zeta.resize(n);
+		sample.pdyn.resize(n);
+	}
+
+	sample.t = t;
+	unsigned int i = 0;
+	kinematicsForAllNodes(
+	    nodeKin, [&](vec _pos, vec& U, vec& Ud, real& zeta, real& pdyn) {
+		    sample.U.col(i) = U;
+		    sample.Ud.col(i) = Ud;
+		    sample.zeta[i] = zeta;
+		    sample.pdyn[i] = pdyn;
+		    i++;
+	    });
+}
+
+bool
+Waves::interpolateWaves(real t)
+{
+	if (!nSamples)
+		return false;
+
+	// The interpolated coupling time step
+	const unsigned int i0 = (nSamples == 4) ? 1 : 0;
+	const real t0 = samples[i0].t;
+	const real t1 = samples[i0 + 1].t;
+	const real h = t1 - t0;
+	const real eps = 1e-6 * h;
+	if ((t < t0 - eps) || (t > t1 + eps))
+		return false;
+	const real u = (t - t0) / h;
+
+	// The weights of each sample
+	real w[4];
+	if (nSamples == 2) {
+		w[0] = 1.0 - u;
+		w[1] = u;
+	} else {
+		// Cubic Hermite, with the slopes estimated by central differences
+		const real h00 = (2.0 * u - 3.0) * u * u + 1.0;
+		const real h10 = ((u - 2.0) * u + 1.0) * u;
+		const real h01 = (-2.0 * u + 3.0) * u * u;
+		const real h11 = (u - 1.0) * u * u;
+		const real m0 = h / (samples[2].t - samples[0].t);
+		const real m1 = h / (samples[3].t - samples[1].t);
+		w[0] = -h10 * m0;
+		w[1] = h00 - h11 * m1;
+		w[2] = h01 + h10 * m0;
+		w[3] = h11 * m1;
+	}
+
+	unsigned int i = 0;
+	kinematicsForAllNodes(
+	    nodeKin, [&](vec _pos, vec& U, vec& Ud, real& zeta, real& pdyn) {
+		    U = w[0] * samples[0].U.col(i);
+		    Ud = w[0] * samples[0].Ud.col(i);
+		    zeta = w[0] * samples[0].zeta[i];
+		    pdyn = w[0] * samples[0].pdyn[i];
+		    for (unsigned int j = 1; j < nSamples; j++) {
+			    U += w[j] * samples[j].U.col(i);
+			    Ud += w[j] * samples[j].Ud.col(i);
+			    zeta += w[j] * samples[j].zeta[i];
+			    pdyn += w[j] * samples[j].pdyn[i];
+		    }
+		    i++;
+	    });
+	return true;
+}
+
+void
+Waves::evaluateWaves(real t)
+{
+	const bool external =
+	    env->waterKinOptions.waveMode == waves::WAVES_EXTERNAL;
+	const bool waves = waveKinematics && !external;
+	if (!waves && !currentKinematics)
 		return;
+	nEvaluations++;
+
+	// The positions are gathered just once, and then each provider computes
+	// all the nodes at once
+	SeafloorProvider floorProvider{ -env->WtrDpth, seafloor };
+	ThreadPool* pool = _t_integrator ? _t_integrator->GetPool() : nullptr;
+	gatherPositions();
+	if (waves) {
+		waveKinematics->getWaveKin(batchPos,
+		                           t,
+		                           floorProvider,
+		                           batchZeta,
+		                           batchU,
+		                           batchUd,
+		                           batchPdyn,
+		                           pool);
 	}
-	// if there are both waves and currents, then we calculate and sum
-	if (waveKinematics && currentKinematics) {
+	if (currentKinematics) {
+		currentKinematics->getCurrentKin(
+		    batchPos, t, floorProvider, batchCU, batchCUd, pool);
+	}
+
+	unsigned int i = 0;
+	if (external) {
+		// if we have external waves and currents, then we go through and add
+		// together the externally defined wave kinematics with the calculated
+		// current kinematics
+		kinematicsForAllNodes(
+		    waveKin, [&](vec _pos, vec& U, vec& Ud, real& _zeta, real& _pdyn) {
+			    batchU.col(i) = U;
+			    batchUd.col(i) = Ud;
+			    i++;
+		    });
+		i = 0;
 		kinematicsForAllNodes(
-		    nodeKin, [&](vec pos, vec& U, vec& Ud, real& zeta, real& pdyn) {
-			    vec3 wave_U{}, wave_Ud{};
-			    waveKinematics->getWaveKin(pos,
-			                               _t_integrator->GetTime(),
-			                               floorProvider,
-			                               &zeta,
-			                               &wave_U,
-			                               &wave_Ud,
-			                               &pdyn);
-			    vec3 curr_U{}, curr_Ud{};
-			    currentKinematics->getCurrentKin(pos,
-			                                     _t_integrator->GetTime(),
-			                                     floorProvider,
-			                                     &curr_U,
-			                                     &curr_Ud);
-			    U = wave_U + curr_U;
-			    Ud = wave_Ud + curr_Ud;
+		    nodeKin, [&](vec _pos, vec& U, vec& Ud, real& _zeta, real& _pdyn) {
+			    U = batchU.col(i) + batchCU.col(i);
+			    Ud = batchUd.col(i) + batchCUd.col(i);
+			    i++;
 		    });
 		return;
 	}
-	// if there are just waves then we just do wave calculations
-	if (waveKinematics) {
+	// if there are both waves and currents, then we calculate and sum
+	if (waves && currentKinematics) {
 		kinematicsForAllNodes(
-		    nodeKin, [&](vec pos, vec& U, vec& Ud, real& zeta, real& pdyn) {
-			    waveKinematics->getWaveKin(pos,
-			                               _t_integrator->GetTime(),
-			                               floorProvider,
-			                               &zeta,
-			                               &U,
-			                               &Ud,
-			                               &pdyn);
+		    nodeKin, [&](vec _pos, vec& U, vec& Ud, real& zeta, real& pdyn) {
+			    U = batchU.col(i) + batchCU.col(i);
+			    Ud = batchUd.col(i) + batchCUd.col(i);
+			    zeta = batchZeta[i];
+			    pdyn = batchPdyn[i];
+			    i++;
 		    });
 		return;
 	}
-	// if there are just currents then we just do current calculations
-	if (currentKinematics) {
+	// if there are just waves then we just do wave calculations
+	if (waves) {
 		kinematicsForAllNodes(
-		    nodeKin, [&](vec pos, vec& U, vec& Ud, real& zeta, real& pdyn) {
-			    currentKinematics->getCurrentKin(
-			        pos, _t_integrator->GetTime(), floorProvider, &U, &Ud);
+		    nodeKin, [&](vec _pos, vec& U, vec& Ud, real& zeta, real& pdyn) {
+			    U = batchU.col(i);
+			    Ud = batchUd.col(i);
+			    zeta = batchZeta[i];
+			    pdyn = batchPdyn[i];
+			    i++;
 		    });
 		return;
 	}
+	// if there are just currents then we just do current calculations
+	kinematicsForAllNodes(
+	    nodeKin, [&](vec _pos, vec& U, vec& Ud, real& _zeta, real& _pdyn) {
+		    U = batchCU.col(i);
+		    Ud = batchCUd.col(i);
+		    i++;
+	    });
 }
 
 } // ::moordyn
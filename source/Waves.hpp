@@ -41,12 +41,21 @@
 #include "Body.hpp"
 #include "Rod.hpp"
 #include "Waves/SpectrumKin.hpp"
+#include "Util/Interp.hpp"
+#include "Util/Grid4D.hpp"
 #include <vector>
+#include <limits>
+#include <functional>
+#include <thread>
+#include <mutex>
+#include <condition_variable>
+#include <exception>
 
 namespace moordyn {
 
 class TimeScheme;
 class Seafloor;
+class ThreadPool;
 typedef std::shared_ptr<Seafloor> SeafloorRef;
 
 /// STL std::vector of 2 dimensions
@@ -82,22 +91,6 @@ init3DArray(unsigned int nx, unsigned int ny, unsigned int nz)
 	return Vec3D<real>(nx, init2DArray(ny, nz));
 }
 
-/** @brief Make a 4-D data grid
- * @param nx Number of components in the first dimension
- * @param ny Number of components in the second dimension
- * @param nz Number of components in the third dimension
- * @param nw Number of components in the third dimension
- */
-static inline Vec4D<vec3>
-init4DArrayVec(unsigned int nx,
-               unsigned int ny,
-               unsigned int nz,
-               unsigned int nw)
-{
-	return Vec4D<vec3>(
-	    nx,
-	    Vec3D<vec3>(ny, Vec2D<vec3>(nz, std::vector<vec3>(nw, vec3::Zero()))));
-}
 /** @brief Make a 4-D data grid
  * @param nx Number of components in the first dimension
  * @param ny Number of components in the second dimension
@@ -142,6 +135,35 @@ class AbstractCurrentKin
 	                           const SeafloorProvider& seafloor,
 	                           vec3* vel,
 	                           vec3* acc) = 0;
+
+	/** @brief Get the velocity and acceleration at a set of positions at a
+	 * specific time
+	 *
+	 * The default implementation is just serially calling getCurrentKin() on
+	 * each position, but the providers can override it to share the work
+	 * among all the positions, and to split the positions among the threads
+	 * @param pos The locations, one per column
+	 * @param time The time
+	 * @param seafloor A SeafloorProvider, could be used for kinematic
+	 * stretching
+	 * @param vel The output velocities, one per column
+	 * @param acc The output accelerations, one per column
+	 * @param pool The threads pool, null to compute the positions serially
+	 */
+	virtual void getCurrentKin(const Eigen::Ref<const Eigen::Matrix3Xr>& pos,
+	                           real time,
+	                           const SeafloorProvider& seafloor,
+	                           Eigen::Ref<Eigen::Matrix3Xr> vel,
+	                           Eigen::Ref<Eigen::Matrix3Xr> acc,
+	                           [[maybe_unused]] ThreadPool* pool)
+	{
+		for (unsigned int i = 0; i < pos.cols(); i++) {
+			vec3 u, ud;
+			getCurrentKin(pos.col(i), time, seafloor, &u, &ud);
+			vel.col(i) = u;
+			acc.col(i) = ud;
+		}
+	}
 };
 
 /**
@@ -170,6 +192,39 @@ class AbstractWaveKin
 	                        vec3* vel,
 	                        vec3* acc,
 	                        real* pdyn) = 0;
+
+	/** @brief Get the velocity, acceleration, wave height and dynamic pressure
+	 * at a set of positions at a specific time
+	 *
+	 * The default implementation is just serially calling getWaveKin() on
+	 * each position, but the providers can override it to share the work
+	 * among all the positions, and to split the positions among the threads
+	 * @param pos The locations, one per column
+	 * @param time The time
+	 * @param seafloor A SeafloorProvider used for kinematic stretching
+	 * @param zeta The output wave heights
+	 * @param vel The output velocities, one per column
+	 * @param acc The output accelerations, one per column
+	 * @param pdyn The output dynamic pressures
+	 * @param pool The threads pool, null to compute the positions serially
+	 */
+	virtual void getWaveKin(const Eigen::Ref<const Eigen::Matrix3Xr>& pos,
+	                        real time,
+	                        const SeafloorProvider& seafloor,
+	                        Eigen::Ref<Eigen::ArrayXr> zeta,
+	                        Eigen::Ref<Eigen::Matrix3Xr> vel,
+	                        Eigen::Ref<Eigen::Matrix3Xr> acc,
+	                        Eigen::Ref<Eigen::ArrayXr> pdyn,
+	                        [[maybe_unused]] ThreadPool* pool)
+	{
+		for (unsigned int i = 0; i < pos.cols(); i++) {
+			vec3 u, ud;
+			getWaveKin(
+			    pos.col(i), time, seafloor, &zeta[i], &u, &ud, &pdyn[i]);
+			vel.col(i) = u;
+			acc.col(i) = ud;
+		}
+	}
 };
 
 /**
@@ -217,6 +272,34 @@ class SpectrumKinWrapper : public AbstractWaveKin
 		spectrumKin.getWaveKin(
 		    pos, time, avgDepth, actualDepth, zeta, vel, acc);
 	}
+
+	void getWaveKin(const Eigen::Ref<const Eigen::Matrix3Xr>& pos,
+	                real time,
+	                const SeafloorProvider& seafloor,
+	                Eigen::Ref<Eigen::ArrayXr> zeta,
+	                Eigen::Ref<Eigen::Matrix3Xr> vel,
+	                Eigen::Ref<Eigen::Matrix3Xr> acc,
+	                Eigen::Ref<Eigen::ArrayXr> pdyn,
+	                ThreadPool* pool) override
+	{
+		pdyn.setZero();
+		if (actualDepth.size() != pos.cols())
+			actualDepth.resize(pos.cols());
+		for (unsigned int i = 0; i < pos.cols(); i++)
+			actualDepth[i] = seafloor.getDepth(pos.block<2, 1>(0, i));
+		spectrumKin.getWaveKin(pos,
+		                       time,
+		                       seafloor.getAverageDepth(),
+		                       actualDepth,
+		                       zeta,
+		                       vel,
+		                       acc,
+		                       pool);
+	}
+
+  private:
+	/// The seafloor depth at each position of the batch
+	Eigen::ArrayXr actualDepth;
 };
 /**
  * @brief A rectilinear grid with x, y, z, and t axes.
@@ -242,6 +325,9 @@ class GridXYZT
 	  , px(px)
 	  , py(py)
 	  , pz(pz)
+	  , ax(px)
+	  , ay(py)
+	  , az(pz)
 	{
 	}
 	/// number of grid points in x direction
@@ -262,6 +348,12 @@ class GridXYZT
 	std::vector<real> py;
 	/// grid z coordinate arrays
 	std::vector<real> pz;
+	/// grid x axis, to compute the interpolation factors
+	InterpAxis ax;
+	/// grid y axis, to compute the interpolation factors
+	InterpAxis ay;
+	/// grid z axis, to compute the interpolation factors
+	InterpAxis az;
 };
 
 /**
@@ -284,11 +376,136 @@ class WaveGrid
 	         real dt)
 	  : GridXYZT(px, py, pz, nt, dt)
 	  , LogUser(log)
+	  , _window(0)
+	  , _first(0)
+	  , _count(0)
+	  , _stop(false)
+	  , _tile(0)
+	  , _tile_life(0.0)
+	  , _tile_single(false)
+	  , _ntx(0)
+	  , _nty(0)
+	  , _now(0.0)
+	  , _last_sweep(0.0)
 	{
 	}
-	~WaveGrid() override = default;
 
-	void allocateKinematicArrays();
+	/** @brief Destructor
+	 *
+	 * The thread generating the time slices of the sliding window, if any,
+	 * is stopped
+	 */
+	~WaveGrid() override;
+
+	/** @brief Allocate the kinematics on the grid points
+	 * @param single true to store the data in single precision, false to use
+	 * double precision
+	 * @throws moordyn::invalid_value_error If the grid is not initialized
+	 * @throws moordyn::mem_error If the memory cannot be allocated
+	 */
+	void allocateKinematicArrays(bool single = false);
+
+	/** @brief Function filling a time slice of the sliding window
+	 *
+	 * It receives the grid, the time step index, i.e. the slice shall
+	 * contain the kinematics at the time index * dtWave, and the slot of
+	 * the window where the slice shall be written, to be passed as the time
+	 * index to WaveGrid::setZeta(), WaveGrid::setVel() and so on. It is
+	 * called from a background thread.
+	 */
+	typedef std::function<void(WaveGrid&, unsigned long, unsigned int)>
+	    SliceGenerator;
+
+	/** @brief Keep just a sliding window of time slices in memory
+	 *
+	 * Instead of storing the whole time series, the grid holds just @p n
+	 * time slices around the last queried time. The next slices are
+	 * generated ahead on a background thread, while the ones left behind
+	 * are dropped. This way the memory footprint does not depend on the
+	 * length of the time series. The time series is still considered
+	 * periodic, with a period of nt * dtWave
+	 * @param n The number of time slices in the window
+	 * @param generator The function to fill the time slices
+	 * @param single true to store the data in single precision, false to use
+	 * double precision
+	 * @throws moordyn::invalid_value_error If the grid is not initialized,
+	 * or if the window has less than 4 slices
+	 * @throws moordyn::mem_error If the memory cannot be allocated
+	 */
+	void setupWindow(unsigned int n, SliceGenerator generator, bool single);
+
+	/** @brief Check whether the grid holds just a sliding time window
+	 * @return true if a sliding window is used, false if the whole time
+	 * series is stored
+	 * @see WaveGrid::setupWindow()
+	 */
+	inline bool windowed() const { return _window > 0; }
+
+	/** @brief Function filling a tile of a sparse grid
+	 *
+	 * It receives a grid with the axes of the tile, with the kinematics
+	 * already allocated, and shall return it filled
+	 */
+	typedef std::function<std::unique_ptr<WaveGrid>(std::unique_ptr<WaveGrid>)>
+	    TileGenerator;
+
+	/** @brief Split the grid in tiles which are allocated and filled on
+	 * demand
+	 *
+	 * The grid is horizontally split in tiles of @p n x @p n cells, with
+	 * the whole vertical and time series. The tiles are not generated until
+	 * a position inside them is queried, so just the regions visited by
+	 * the nodes take memory. The tiles not visited in @p life seconds are
+	 * dropped
+	 * @param n The number of cells on each side of the tiles
+	 * @param life The time without being visited before a tile is dropped,
+	 * in seconds. 0 to never drop the tiles
+	 * @param generator The function to fill the tiles
+	 * @param single true to store the data in single precision, false to use
+	 * double precision
+	 * @throws moordyn::invalid_value_error If the grid is not initialized
+	 * @note Unlike the dense grids, the sparse grids are not thread safe
+	 */
+	void setupTiles(unsigned int n,
+	                real life,
+	                TileGenerator generator,
+	                bool single);
+
+	/** @brief Check whether the grid is split in tiles allocated on demand
+	 * @return true if the grid is sparse, false otherwise
+	 * @see WaveGrid::setupTiles()
+	 */
+	inline bool tiled() const { return _tile > 0; }
+
+	/** @brief Get the number of tiles currently allocated
+	 * @return The number of tiles
+	 * @see WaveGrid::setupTiles()
+	 */
+	unsigned int allocatedTiles() const;
+
+	/** @brief Save the grid in a binary file that can be memory-mapped
+	 * @param path The file path
+	 * @param hash The hash of the inputs used to generate the grid
+	 * @throws moordyn::output_file_error If the file cannot be written
+	 * @see WaveGrid::load()
+	 */
+	void save(const std::string& path, uint64_t hash) const;
+
+	/** @brief Map a grid saved with WaveGrid::save()
+	 *
+	 * The kinematics are not read, but mapped in memory, so they are loaded
+	 * on demand and shared with the rest of processes mapping the same file
+	 * @param log The log handler
+	 * @param path The file path
+	 * @param hash The hash of the inputs used to generate the grid
+	 * @return The grid, null if the file does not exist, it is not a valid
+	 * grid file or it was generated from different inputs
+	 */
+	static std::unique_ptr<WaveGrid> load(moordyn::Log* log,
+	                                      const std::string& path,
+	                                      uint64_t hash);
+
+	using AbstractWaveKin::getWaveKin;
 
 	void getWaveKin(const vec3& pos,
 	                real time,
@@ -298,31 +515,269 @@ class WaveGrid
 	                vec3* acc,
 	                real* pdyn) override;
 
-	inline Vec3D<real>& Zetas() { return zetas; }
-	inline const Vec3D<real>& getZetas() const { return zetas; }
+	/** @brief Get the wave kinematics at a set of positions
+	 *
+	 * The grid cells of each position are stored, to be used as a hint on
+	 * the next call, since the nodes are usually moving way less than a cell.
+	 * The positions are split among the threads, unless the grid is tiled
+	 * @see AbstractWaveKin::getWaveKin
+	 */
+	void getWaveKin(const Eigen::Ref<const Eigen::Matrix3Xr>& pos,
+	                real time,
+	                const SeafloorProvider& seafloor,
+	                Eigen::Ref<Eigen::ArrayXr> zeta,
+	                Eigen::Ref<Eigen::Matrix3Xr> vel,
+	                Eigen::Ref<Eigen::Matrix3Xr> acc,
+	                Eigen::Ref<Eigen::ArrayXr> pdyn,
+	                ThreadPool* pool) override;
+
+	/** @brief Get the wave elevation at a grid point
+	 * @param ix The x index
+	 * @param iy The y index
+	 * @param it The t index
+	 * @return The wave elevation
+	 */
+	inline real getZeta(unsigned int ix, unsigned int iy, unsigned int it) const
+	{
+		return zetas.get(ix, iy, 0, it, 0);
+	}
+
+	/** @brief Set the wave elevation at a grid point
+	 * @param ix The x index
+	 * @param iy The y index
+	 * @param it The t index
+	 * @param v The wave elevation
+	 */
+	inline void setZeta(unsigned int ix,
+	                    unsigned int iy,
+	                    unsigned int it,
+	                    real v)
+	{
+		zetas.set(ix, iy, 0, it, 0, v);
+	}
+
+	/** @brief Get the wave velocity at a grid point
+	 * @param ix The x index
+	 * @param iy The y index
+	 * @param iz The z index
+	 * @param it The t index
+	 * @return The velocity
+	 */
+	inline vec3 getVel(unsigned int ix,
+	                   unsigned int iy,
+	                   unsigned int iz,
+	                   unsigned int it) const
+	{
+		return kin.getVec(ix, iy, iz, it, KIN_VEL);
+	}
+
+	/** @brief Set the wave velocity at a grid point
+	 * @param ix The x index
+	 * @param iy The y index
+	 * @param iz The z index
+	 * @param it The t index
+	 * @param v The velocity
+	 */
+	inline void setVel(unsigned int ix,
+	                   unsigned int iy,
+	                   unsigned int iz,
+	                   unsigned int it,
+	                   const vec3& v)
+	{
+		kin.setVec(ix, iy, iz, it, KIN_VEL, v);
+	}
 
-	inline Vec4D<real>& PDyn() { return pDyn; }
-	inline const Vec4D<real>& getPDyn() const { return pDyn; }
+	/** @brief Get the wave acceleration at a grid point
+	 * @param ix The x index
+	 * @param iy The y index
+	 * @param iz The z index
+	 * @param it The t index
+	 * @return The acceleration
+	 */
+	inline vec3 getAcc(unsigned int ix,
+	                   unsigned int iy,
+	                   unsigned int iz,
+	                   unsigned int it) const
+	{
+		return kin.getVec(ix, iy, iz, it, KIN_ACC);
+	}
 
-	inline Vec4D<vec3>& WaveVel() { return wave_vel; }
-	inline const Vec4D<vec3>& getWaveVel() const { return wave_vel; }
+	/** @brief Set the wave acceleration at a grid point
+	 * @param ix The x index
+	 * @param iy The y index
+	 * @param iz The z index
+	 * @param it The t index
+	 * @param v The acceleration
+	 */
+	inline void setAcc(unsigned int ix,
+	                   unsigned int iy,
+	                   unsigned int iz,
+	                   unsigned int it,
+	                   const vec3& v)
+	{
+		kin.setVec(ix, iy, iz, it, KIN_ACC, v);
+	}
+
+	/** @brief Get the dynamic pressure at a grid point
+	 * @param ix The x index
+	 * @param iy The y index
+	 * @param iz The z index
+	 * @param it The t index
+	 * @return The dynamic pressure
+	 */
+	inline real getPDyn(unsigned int ix,
+	                    unsigned int iy,
+	                    unsigned int iz,
+	                    unsigned int it) const
+	{
+		return kin.get(ix, iy, iz, it, KIN_PDYN);
+	}
 
-	inline Vec4D<vec3>& WaveAcc() { return wave_acc; }
-	inline const Vec4D<vec3>& getWaveAcc() const { return wave_acc; }
+	/** @brief Set the dynamic pressure at a grid point
+	 * @param ix The x index
+	 * @param iy The y index
+	 * @param iz The z index
+	 * @param it The t index
+	 * @param v The dynamic pressure
+	 */
+	inline void setPDyn(unsigned int ix,
+	                    unsigned int iy,
+	                    unsigned int iz,
+	                    unsigned int it,
+	                    real v)
+	{
+		kin.set(ix, iy, iz, it, KIN_PDYN, v);
+	}
 
 	inline const std::vector<real>& Px() const { return px; }
 	inline const std::vector<real>& Py() const { return py; }
 	inline const std::vector<real>& Pz() const { return pz; }
 
   private:
-	/// wave elevation [x,y,t]
-	Vec3D<real> zetas;
-	/// dynamic pressure [x,y,z,t]
-	Vec4D<real> pDyn;
-	/// Wave velocity [x, y, z, t]
-	Vec4D<vec3> wave_vel;
-	/// Wave acceleration [x, y, z, t]
-	Vec4D<vec3> wave_acc;
+	/**
+	 * @brief Get the wave kinematics at a position
+	 * @param pos The location
+	 * @param it0 The lower bound time index
+	 * @param it1 The upper bound time index
+	 * @param ft The time interpolation factor
+	 * @param seafloor A SeafloorProvider used for kinematic stretching
+	 * @param hint The x, y and z upper bound indexes of the previous call,
+	 * which are replaced by the new ones. Can be null
+	 * @param zeta The output wave height, not set if null
+	 * @param vel The output velocity, not set if null
+	 * @param acc The output acceleration, not set if null
+	 * @param pdyn The output dynamic pressure, not set if null
+	 * @see WaveGrid::timeIndexes()
+	 */
+	void getWaveKin(const vec3& pos,
+	                unsigned int it0,
+	                unsigned int it1,
+	                real ft,
+	                const SeafloorProvider& seafloor,
+	                unsigned int* hint,
+	                real* zeta,
+	                vec3* vel,
+	                vec3* acc,
+	                real* pdyn);
+
+	/** @brief Get the time indexes and the interpolation factor
+	 *
+	 * On sliding window mode, this function is blocking until the required
+	 * time slices are available
+	 * @param time The time
+	 * @param it0 The lower bound time index
+	 * @param it1 The upper bound time index
+	 * @param ft The time interpolation factor
+	 */
+	void timeIndexes(real time, unsigned int& it0, unsigned int& it1, real& ft);
+
+	/** @brief Slide the window to make the time steps @p it and @p it + 1
+	 * available
+	 *
+	 * The time slices before @p it - 1 are dropped
+	 * @param it The time step index
+	 * @throws The exception thrown by the slices generator, if any
+	 */
+	void slide(unsigned long it);
+
+	/** @brief Main loop of the thread generating the time slices
+	 */
+	void windowLoop();
+
+	/** @brief Get the tile containing a cell, generating it if needed
+	 * @param ix The x upper bound index, which is replaced by the index on
+	 * the tile
+	 * @param iy The y upper bound index, which is replaced by the index on
+	 * the tile
+	 * @return The tile
+	 */
+	const WaveGrid* tile(unsigned int& ix, unsigned int& iy);
+
+	/** @brief Drop the tiles which have not been visited for a while
+	 * @param time The current time
+	 */
+	void evictTiles(real time);
+
+	/// The upper bound indexes of the positions on the last batch call
+	std::vector<unsigned int> hints;
+
+	/// Number of time slices on the sliding window, 0 if it is not used
+	unsigned int _window;
+	/// The function to generate the time slices
+	SliceGenerator _generator;
+	/// The thread generating the time slices
+	std::thread _worker;
+	/// Mutex for the sliding window state
+	std::mutex _window_mtx;
+	/// Condition to notify that a new time slice is available
+	std::condition_variable _cv_ready;
+	/// Condition to notify that there are free slots on the window
+	std::condition_variable _cv_free;
+	/// The first time step index on the window
+	unsigned long _first;
+	/// The number of time slices already generated on the window
+	unsigned long _count;
+	/// Flag to ask the generator thread to finish
+	bool _stop;
+	/// The exception thrown by the slices generator
+	std::exception_ptr _window_error;
+
+	/// Number of cells on each side of the tiles, 0 for dense grids
+	unsigned int _tile;
+	/// Time without being visited before a tile is dropped
+	real _tile_life;
+	/// The function to generate the tiles
+	TileGenerator _tile_generator;
+	/// Whether the tiles are stored in single precision or not
+	bool _tile_single;
+	/// Number of tiles in the x direction
+	unsigned int _ntx;
+	/// Number of tiles in the y direction
+	unsigned int _nty;
+	/// The tiles, null until they are visited
+	std::vector<std::unique_ptr<WaveGrid>> _tiles;
+	/// The last time each tile was visited
+	std::vector<real> _tile_used;
+	/// The time of the current query
+	real _now;
+	/// The last time the unvisited tiles were looked for
+	real _last_sweep;
+
+	/// The components of the kinematics on each grid point
+	enum
+	{
+		/// Velocity
+		KIN_VEL = 0,
+		/// Acceleration
+		KIN_ACC = 3,
+		/// Dynamic pressure
+		KIN_PDYN = 6,
+	};
+
+	/// wave elevation [x, y, 1, t]
+	Grid4D<1> zetas;
+	/// velocity, acceleration and dynamic pressure [x, y, z, t]
+	Grid4D<8> kin;
 };
 
 /**
@@ -349,7 +804,13 @@ class CurrentGrid
 
 	~CurrentGrid() override = default;
 
-	void allocateKinematicArrays();
+	/** @brief Allocate the kinematics on the grid points
+	 * @param single true to store the data in single precision, false to use
+	 * double precision
+	 * @throws moordyn::invalid_value_error If the grid is not initialized
+	 * @throws moordyn::mem_error If the memory cannot be allocated
+	 */
+	void allocateKinematicArrays(bool single = false);
 
 	void getCurrentKin(const vec3& pos,
 	                   real time,
@@ -357,21 +818,125 @@ class CurrentGrid
 	                   vec3* vel,
 	                   vec3* acc) override;
 
-	inline Vec4D<vec3>& CurrentVel() { return current_vel; }
-	inline const Vec4D<vec3>& getCurrentVel() const { return current_vel; }
+	/** @brief Get the current kinematics at a set of positions
+	 *
+	 * The grid cells of each position are stored, to be used as a hint on
+	 * the next call, since the nodes are usually moving way less than a cell.
+	 * The positions are split among the threads
+	 * @see AbstractCurrentKin::getCurrentKin
+	 */
+	void getCurrentKin(const Eigen::Ref<const Eigen::Matrix3Xr>& pos,
+	                   real time,
+	                   const SeafloorProvider& seafloor,
+	                   Eigen::Ref<Eigen::Matrix3Xr> vel,
+	                   Eigen::Ref<Eigen::Matrix3Xr> acc,
+	                   ThreadPool* pool) override;
+
+	/** @brief Get the current velocity at a grid point
+	 * @param ix The x index
+	 * @param iy The y index
+	 * @param iz The z index
+	 * @param it The t index
+	 * @return The velocity
+	 */
+	inline vec3 getVel(unsigned int ix,
+	                   unsigned int iy,
+	                   unsigned int iz,
+	                   unsigned int it) const
+	{
+		return kin.getVec(ix, iy, iz, it, KIN_VEL);
+	}
 
-	inline Vec4D<vec3>& CurrentAcc() { return current_acc; }
-	inline const Vec4D<vec3>& getCurrentAcc() const { return current_acc; }
+	/** @brief Set the current velocity at a grid point
+	 * @param ix The x index
+	 * @param iy The y index
+	 * @param iz The z index
+	 * @param it The t index
+	 * @param v The velocity
+	 */
+	inline void setVel(unsigned int ix,
+	                   unsigned int iy,
+	                   unsigned int iz,
+	                   unsigned int it,
+	                   const vec3& v)
+	{
+		kin.setVec(ix, iy, iz, it, KIN_VEL, v);
+	}
+
+	/** @brief Get the current acceleration at a grid point
+	 * @param ix The x index
+	 * @param iy The y index
+	 * @param iz The z index
+	 * @param it The t index
+	 * @return The acceleration
+	 */
+	inline vec3 getAcc(unsigned int ix,
+	                   unsigned int iy,
+	                   unsigned int iz,
+	                   unsigned int it) const
+	{
+		return kin.getVec(ix, iy, iz, it, KIN_ACC);
+	}
+
+	/** @brief Set the current acceleration at a grid point
+	 * @param ix The x index
+	 * @param iy The y index
+	 * @param iz The z index
+	 * @param it The t index
+	 * @param v The acceleration
+	 */
+	inline void setAcc(unsigned int ix,
+	                   unsigned int iy,
+	                   unsigned int iz,
+	                   unsigned int it,
+	                   const vec3& v)
+	{
+		kin.setVec(ix, iy, iz, it, KIN_ACC, v);
+	}
 
 	inline const std::vector<real>& Px() const { return px; }
 	inline const std::vector<real>& Py() const { return py; }
 	inline const std::vector<real>& Pz() const { return pz; }
 
   private:
-	/// Current velocity [x, y, z, t]
-	Vec4D<vec3> current_vel;
-	/// Current acceleration [x, y, z, t]
-	Vec4D<vec3> current_acc;
+	/**
+	 * @brief Get the current kinematics at a position
+	 * @param pos The location
+	 * @param it The upper bound time index
+	 * @param ft The time interpolation factor
+	 * @param hint The x, y and z upper bound indexes of the previous call,
+	 * which are replaced by the new ones. Can be null
+	 * @param vel The output velocity, not set if null
+	 * @param acc The output acceleration, not set if null
+	 */
+	void getCurrentKin(const vec3& pos,
+	                   unsigned int it,
+	                   real ft,
+	                   unsigned int* hint,
+	                   vec3* vel,
+	                   vec3* acc) const;
+
+	/** @brief Get the time index and the interpolation factor
+	 * @param time The time
+	 * @param it The upper bound time index
+	 * @param ft The time interpolation factor
+	 */
+	void timeIndex(real time, unsigned int& it, real& ft) const;
+
+	/// The upper bound indexes of the positions on the last batch call
+	std::vector<unsigned int> hints;
+
+	/// The components of the kinematics on each grid point
+	enum
+	{
+		/// Velocity
+		KIN_VEL = 0,
+		/// Acceleration
+		KIN_ACC = 3,
+	};
+
+	/// velocity and acceleration [x, y, z, t]
+	Grid4D<8> kin;
 };
 
 /** @class Waves Waves.hpp
@@ -423,9 +988,35 @@ class Waves : public LogUser
 	/**
 	 * @brief Recalculates any wave and current kinematics for all the nodes
 	 *
+	 * Depending on waves::WaterKinOptions::cacheMode, the kinematics might be
+	 * reused from a previous call at the same time, or interpolated from the
+	 * ones evaluated at the coupling time step boundaries
 	 */
 	void updateWaves();
 
+	/**
+	 * @brief Notify that a new coupling time step is starting
+	 *
+	 * If the kinematics are interpolated in time, see
+	 * waves::WaterKinOptions::cacheMode, they are evaluated here at the
+	 * boundaries of the time step, using the current positions of the nodes.
+	 * The evaluations at the times already sampled on the previous coupling
+	 * time step are reused
+	 * @param t0 The coupling time step start
+	 * @param t1 The coupling time step end
+	 */
+	void setCouplingStep(real t0, real t1);
+
+	/**
+	 * @brief Get the number of evaluations of the wave and current
+	 * kinematics for all the nodes carried out so far
+	 *
+	 * It is meant to check the reuse of the kinematics, see
+	 * waves::WaterKinOptions::cacheMode
+	 * @return The number of evaluations
+	 */
+	inline unsigned long getEvaluations() const { return nEvaluations; }
+
 	/**
 	 * @brief Adds a line to the list of structures we calculate water
 	 * kinematics for
@@ -605,6 +1196,78 @@ class Waves : public LogUser
 	template<typename F>
 	void kinematicsForAllNodes(AllNodesKin& nodeKinematics, F f);
 
+	/**
+	 * @brief Gather the positions of all the nodes on
+	 * moordyn::Waves::batchPos, following the order of kinematicsForAllNodes()
+	 *
+	 * The rest of the batch* members are resized accordingly
+	 */
+	void gatherPositions();
+
+	/**
+	 * @brief Evaluate the wave and current kinematics for all the nodes
+	 * @param t The time
+	 */
+	void evaluateWaves(real t);
+
+	/**
+	 * @brief The water kinematics of all the nodes at a time instant, in the
+	 * order of kinematicsForAllNodes()
+	 */
+	typedef struct _kinSample
+	{
+		/// The time
+		real t;
+		/// The velocities
+		Eigen::Matrix3Xr U;
+		/// The accelerations
+		Eigen::Matrix3Xr Ud;
+		/// The wave heights
+		Eigen::ArrayXr zeta;
+		/// The dynamic pressures
+		Eigen::ArrayXr pdyn;
+	} kinSample;
+
+	/**
+	 * @brief Evaluate the water kinematics at a time instant and store them
+	 * @param sample The storage
+	 * @param t The time
+	 */
+	void sampleWaves(kinSample& sample, real t);
+
+	/**
+	 * @brief Interpolate the water kinematics from the samples taken in
+	 * setCouplingStep()
+	 * @param t The time
+	 * @return true if the kinematics were interpolated, false if @p t is out
+	 * of the sampled coupling time step
+	 */
+	bool interpolateWaves(real t);
+
+	/// The samples to interpolate the kinematics, sorted in time
+	std::vector<kinSample> samples;
+	/// Number of valid samples, 0 until setCouplingStep() is called
+	unsigned int nSamples = 0;
+	/// Number of evaluations of the kinematics, see getEvaluations()
+	unsigned long nEvaluations = 0;
+	/// The time of the last update, for waves::WAVES_CACHE_TIME
+	real cacheTime = std::numeric_limits<real>::quiet_NaN();
+
+	/// The node positions gathered by gatherPositions()
+	Eigen::Matrix3Xr batchPos;
+	/// The wave velocities on the nodes
+	Eigen::Matrix3Xr batchU;
+	/// The wave accelerations on the nodes
+	Eigen::Matrix3Xr batchUd;
+	/// The wave heights on the nodes
+	Eigen::ArrayXr batchZeta;
+	/// The dynamic pressures on the nodes
+	Eigen::ArrayXr batchPdyn;
+	/// The current velocities on the nodes
+	Eigen::Matrix3Xr batchCU;
+	/// The current accelerations on the nodes
+	Eigen::Matrix3Xr batchCUd;
+
 	/// The generic wave kinematics provider object
 	std::unique_ptr<AbstractWaveKin> waveKinematics{};
 	/// The generic current kinematics provider object
@@ -2,7 +2,9 @@
 #include "Waves.h"
 #include "Waves.hpp"
 #include "Waves/SpectrumKin.hpp"
+#include "Util/ThreadPool.hpp"
 #include <complex>
+#include <limits>
 
 namespace moordyn {
 
@@ -34,36 +36,110 @@ SpectrumKin::setup(const std::vector<FrequencyComponent>& freqComps,
 		               env->g,
 		               seafloor ? -seafloor->getAverageDepth() : env->WtrDpth);
 	}
+
+	const Eigen::ArrayX<real> betas_x = betas.cos();
+	const Eigen::ArrayX<real> betas_y = betas.sin();
+	kx = kValues * betas_x;
+	ky = kValues * betas_y;
+	wx = omegas * betas_x;
+	wy = omegas * betas_y;
+	w2 = omegas * omegas;
+	w2x = w2 * betas_x;
+	w2y = w2 * betas_y;
+	kAbs = kValues.abs();
+
+	// The depth factors are computed on demand, see prepare()
+	depth = std::numeric_limits<real>::quiet_NaN();
+	sinhFactor.resize(num_freqs);
+	sinhFactorAbs.resize(num_freqs);
+
+	// Allocate the workspace, so nothing is allocated afterwards
+	wtPhase.resize(num_freqs);
+	workspaces.clear();
+	allocateWorkspaces(1);
+
+	// The phasors are computed on the first batch evaluation
+	phasorTol = env->waterKinOptions.phasorTol;
+	phasorSync = env->waterKinOptions.phasorSync;
+	phasors.resize(num_freqs, 0);
+	phasorPos.resize(Eigen::NoChange, 0);
+	phasorTime = 0.0;
+	phasorAdvances = 0;
+	rotationDt = std::numeric_limits<real>::quiet_NaN();
+	rotation.resize(num_freqs);
 }
 
 void
-SpectrumKin::getWaveKin(vec3 pos,
-                        real t,
-                        real avgDepth,
-                        real actualDepth,
-                        real* zeta,
-                        vec3* vel,
-                        vec3* acc) const
+SpectrumKin::allocateWorkspaces(unsigned int n)
 {
-	// const real beta = 0.0;
+	const auto num_freqs = omegas.size();
+	while (workspaces.size() < n) {
+		workspace ws;
+		ws.sinWaves.resize(num_freqs);
+		ws.cosWaves.resize(num_freqs);
+		ws.coshOvrSinh.resize(num_freqs);
+		ws.sinhOvrSinh.resize(num_freqs);
+		workspaces.push_back(std::move(ws));
+	}
+}
 
-	const auto& x = pos.x();
-	const auto& y = pos.y();
+void
+SpectrumKin::prepare(real t, real avgDepth)
+{
+	wtPhase = omegas * t + phases;
+	if (avgDepth == depth)
+		return;
+	// The depth attenuation factors are written in terms of decaying
+	// exponentials, which are valid both in shallow and deep water, i.e.
+	// sinh(k (z + h)) / sinh(k h) = (e^{k z} - e^{-k (z + 2 h)}) /
+	//                               (1 - e^{-2 k h})
+	depth = avgDepth;
+	for (unsigned int i = 0; i < kValues.size(); i++) {
+		const real k = kValues[i];
+		if (k == 0.0) {
+			// The waves with null wave number are not contributing at all
+			sinhFactorAbs[i] = sinhFactor[i] = 0.0;
+			continue;
+		}
+		sinhFactorAbs[i] = 1.0 / (1.0 - exp(2.0 * kAbs[i] * avgDepth));
+		sinhFactor[i] = (k > 0.0) ? sinhFactorAbs[i] : -sinhFactorAbs[i];
+	}
+}
 
-	const Eigen::ArrayX<real> betas_x = betas.cos();
-	const Eigen::ArrayX<real> betas_y = betas.sin();
-	const Eigen::ArrayX<real> distances = betas_x * x + betas_y * y;
-	const Eigen::ArrayX<real> sin_waves =
-	    amplitudes * (omegas * t - kValues * distances + phases).sin();
-	const Eigen::ArrayX<real> cos_waves =
-	    amplitudes * (omegas * t - kValues * distances + phases).cos();
+void
+SpectrumKin::nodeKin(workspace& ws,
+                     real x,
+                     real y,
+                     real z,
+                     real actualDepth,
+                     real* zeta,
+                     vec3* vel,
+                     vec3* acc)
+{
+	// sin and cos share the same argument, which is computed just once
+	ws.cosWaves = wtPhase - kx * x - ky * y;
+	ws.sinWaves = amplitudes * ws.cosWaves.sin();
+	ws.cosWaves = amplitudes * ws.cosWaves.cos();
+	depthKin(ws, z, actualDepth, zeta, vel, acc);
+}
 
-	const real surface_height = sin_waves.sum();
+void
+SpectrumKin::depthKin(workspace& ws,
+                      real z,
+                      real actualDepth,
+                      real* zeta,
+                      vec3* vel,
+                      vec3* acc)
+{
+	const auto& sinWaves = ws.sinWaves;
+	const auto& cosWaves = ws.cosWaves;
+	auto& coshOvrSinh = ws.coshOvrSinh;
+	auto& sinhOvrSinh = ws.sinhOvrSinh;
+	const real surface_height = sinWaves.sum();
 	const real bottom = actualDepth;
 	const real actual_depth = surface_height - bottom;
 
-	real stretched_z =
-	    (-avgDepth * (pos.z() - bottom)) / actual_depth + avgDepth;
+	real stretched_z = (-depth * (z - bottom)) / actual_depth + depth;
 
 	// If the point is above the water surface, return the values at the water
 	// surface. This is important for situations where a point is out of the
@@ -76,65 +152,124 @@ SpectrumKin::getWaveKin(vec3 pos,
 	if (zeta) {
 		*zeta = surface_height;
 	}
-	if (vel || acc) {
-		vec3 vel_sum = vec3::Zero();
-		vec3 acc_sum = vec3::Zero();
-
-		for (unsigned int I = 0; I < omegas.size(); I++) {
-			real SINHNumOvrSIHNDen;
-			real COSHNumOvrSIHNDen;
-			real COSHNumOvrCOSHDen;
-			auto k = kValues[I];
-			real w = omegas[I];
-			if (k == 0.0) {
-				// The shallow water formulation is ill-conditioned;
-				// thus, the known value of unity is returned.
-				SINHNumOvrSIHNDen = 1.0;
-				COSHNumOvrSIHNDen = 99999.0;
-				COSHNumOvrCOSHDen = 1.0;
-			} else if (k * -avgDepth > 89.4) {
-				// The shallow water formulation will trigger a
-				// floating point overflow error; however, for h
-				// > 14.23 * wavelength (since k = 2 * Pi /
-				// wavelength) we can use the numerically-stable
-				// deep water formulation instead.
-				SINHNumOvrSIHNDen = exp(k * stretched_z);
-				COSHNumOvrSIHNDen = exp(k * stretched_z);
-				COSHNumOvrCOSHDen = exp(k * stretched_z) +
-				                    exp(-k * (stretched_z + 2.0 * -avgDepth));
-			} else if (-k * -avgDepth > 89.4) {
-				// @mth: added negative k case
-				// NOTE: CHECK CORRECTNESS
-				SINHNumOvrSIHNDen = -exp(-k * stretched_z);
-				COSHNumOvrSIHNDen = -exp(-k * stretched_z);
-				COSHNumOvrCOSHDen = -exp(-k * stretched_z) +
-				                    exp(-k * (stretched_z + 2.0 * -avgDepth));
+	if (!vel && !acc)
+		return;
+
+	sinhOvrSinh = (kAbs * stretched_z).exp();
+	coshOvrSinh = (-kAbs * (stretched_z - 2.0 * depth)).exp();
+	coshOvrSinh += sinhOvrSinh;
+	sinhOvrSinh = sinhFactorAbs * (2.0 * sinhOvrSinh - coshOvrSinh);
+	coshOvrSinh *= sinhFactor;
+
+	// TODO Waves - calculate the dynamic pressure (rods use it)
+	if (vel) {
+		const real u_x = (wx * sinWaves * coshOvrSinh).sum();
+		const real u_y = (wy * sinWaves * coshOvrSinh).sum();
+		const real u_z = (omegas * cosWaves * sinhOvrSinh).sum();
+		*vel = vec3(u_x, u_y, u_z);
+	}
+	if (acc) {
+		const real a_x = (w2x * cosWaves * coshOvrSinh).sum();
+		const real a_y = (w2y * cosWaves * coshOvrSinh).sum();
+		const real a_z = -(w2 * sinWaves * sinhOvrSinh).sum();
+		*acc = vec3(a_x, a_y, a_z);
+	}
+}
+
+void
+SpectrumKin::getWaveKin(vec3 pos,
+                        real t,
+                        real avgDepth,
+                        real actualDepth,
+                        real* zeta,
+                        vec3* vel,
+                        vec3* acc)
+{
+	prepare(t, avgDepth);
+	nodeKin(
+	    workspaces[0], pos.x(), pos.y(), pos.z(), actualDepth, zeta, vel, acc);
+}
+
+void
+SpectrumKin::getWaveKin(const Eigen::Ref<const Eigen::Matrix3Xr>& pos,
+                        real t,
+                        real avgDepth,
+                        const Eigen::Ref<const Eigen::ArrayXr>& actualDepth,
+                        Eigen::Ref<Eigen::ArrayXr> zeta,
+                        Eigen::Ref<Eigen::Matrix3Xr> vel,
+                        Eigen::Ref<Eigen::Matrix3Xr> acc,
+                        ThreadPool* pool)
+{
+	prepare(t, avgDepth);
+	if (phasorTol > 0.0)
+		advancePhasors(pos, t);
+	allocateWorkspaces(pool ? pool->GetThreads() : 1);
+
+	// The points are independent, so they can be computed in parallel
+	auto task = [&](unsigned int i0, unsigned int i1) {
+		workspace& ws = workspaces[pool ? ThreadPool::GetThreadIndex() : 0];
+		for (unsigned int i = i0; i < i1; i++) {
+			vec3 u, ud;
+			if (phasorTol > 0.0) {
+				ws.sinWaves = phasors.col(i).imag();
+				ws.cosWaves = phasors.col(i).real();
+				depthKin(ws, pos(2, i), actualDepth[i], &zeta[i], &u, &ud);
 			} else {
-				// shallow water formulation
-				SINHNumOvrSIHNDen =
-				    sinh(k * (stretched_z + -avgDepth)) / sinh(k * -avgDepth);
-				COSHNumOvrSIHNDen =
-				    cosh(k * (stretched_z + -avgDepth)) / sinh(k * -avgDepth);
-				COSHNumOvrCOSHDen =
-				    cosh(k * (stretched_z + -avgDepth)) / cosh(k * -avgDepth);
+				nodeKin(ws,
+				        pos(0, i),
+				        pos(1, i),
+				        pos(2, i),
+				        actualDepth[i],
+				        &zeta[i],
+				        &u,
+				        &ud);
 			}
-			real u_xy = w * sin_waves[I] * COSHNumOvrSIHNDen;
-			real ux = u_xy * betas_x[I];
-			real uy = u_xy * betas_y[I];
-			real uz = w * cos_waves[I] * SINHNumOvrSIHNDen;
-			vel_sum += vec3(ux, uy, uz);
-			real a_xy = w * w * cos_waves[I] * COSHNumOvrSIHNDen;
-			real ax = a_xy * betas_x[I];
-			real ay = a_xy * betas_y[I];
-			real az = -w * w * sin_waves[I] * SINHNumOvrSIHNDen;
-			acc_sum += vec3(ax, ay, az);
-			// TODO Waves - calculate the dynamic pressure (rods use it)
+			vel.col(i) = u;
+			acc.col(i) = ud;
 		}
+	};
+	const unsigned int n = (unsigned int)pos.cols();
+	if (pool)
+		pool->RunChunks(n, task);
+	else
+		task(0, n);
+}
+
+void
+SpectrumKin::advancePhasors(const Eigen::Ref<const Eigen::Matrix3Xr>& pos,
+                            real t)
+{
+	const bool sync =
+	    (phasors.cols() != pos.cols()) || (phasorAdvances >= phasorSync);
+	if (sync) {
+		if (phasors.cols() != pos.cols()) {
+			phasors.resize(omegas.size(), pos.cols());
+			phasorPos.resize(Eigen::NoChange, pos.cols());
+		}
+		phasorAdvances = 0;
+	} else if (t != phasorTime) {
+		// Rotate the phasors. The time step is usually repeated along the
+		// simulation, so the rotation is just recomputed if it changes
+		const real dt = t - phasorTime;
+		if (dt != rotationDt) {
+			rotationDt = dt;
+			rotation.real() = (omegas * dt).cos();
+			rotation.imag() = (omegas * dt).sin();
+		}
+		phasors.colwise() *= rotation;
+		phasorAdvances++;
+	}
+	phasorTime = t;
 
-		if (vel)
-			*vel = vel_sum;
-		if (acc)
-			*acc = acc_sum;
+	for (unsigned int i = 0; i < pos.cols(); i++) {
+		if (!sync && ((pos.block<2, 1>(0, i) - phasorPos.col(i)).norm() <=
+		              phasorTol))
+			continue;
+		phasorPos.col(i) = pos.block<2, 1>(0, i);
+		auto& cosWaves = workspaces[0].cosWaves;
+		cosWaves = wtPhase - kx * pos(0, i) - ky * pos(1, i);
+		phasors.col(i).real() = amplitudes * cosWaves.cos();
+		phasors.col(i).imag() = amplitudes * cosWaves.sin();
 	}
 }
 }
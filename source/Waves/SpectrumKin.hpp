@@ -7,6 +7,8 @@
 
 namespace moordyn {
 
+class ThreadPool;
+
 namespace waves {
 
 /**
@@ -51,9 +53,112 @@ class SpectrumKin
 	                real actualDepth,
 	                real* zeta,
 	                vec3* vel,
-	                vec3* acc) const;
+	                vec3* acc);
+
+	/**
+	 * @brief Get the Wave kinematics at a set of points at time t
+	 *
+	 * This is way faster than calling getWaveKin() for each point, since the
+	 * time dependent part of the phases is computed just once, and no memory
+	 * is allocated
+	 *
+	 * @param pos The (x, y, z) coordinates of the points, one per column
+	 * @param t The time to calculate the waves at
+	 * @param avgDepth A negative number representing the average seafloor depth
+	 * (used for calculating wave numbers)
+	 * @param actualDepth Negative numbers representing the actual seafloor
+	 * depth at each point (used in wave stretching)
+	 * @param zeta surface height at each point
+	 * @param vel water velocity at each point, one per column
+	 * @param acc water acceleration at each point, one per column
+	 * @param pool The threads pool to split the points among, null to
+	 * compute them serially
+	 */
+	void getWaveKin(const Eigen::Ref<const Eigen::Matrix3Xr>& pos,
+	                real t,
+	                real avgDepth,
+	                const Eigen::Ref<const Eigen::ArrayXr>& actualDepth,
+	                Eigen::Ref<Eigen::ArrayXr> zeta,
+	                Eigen::Ref<Eigen::Matrix3Xr> vel,
+	                Eigen::Ref<Eigen::Matrix3Xr> acc,
+	                ThreadPool* pool = nullptr);
 
   private:
+	/** @brief The per point workspace
+	 *
+	 * Each thread needs its own one to compute points in parallel
+	 */
+	typedef struct _workspace
+	{
+		/// \f$ a \sin \theta \f$
+		Eigen::ArrayX<real> sinWaves;
+		/// \f$ a \cos \theta \f$
+		Eigen::ArrayX<real> cosWaves;
+		/// Depth attenuation of the horizontal components
+		Eigen::ArrayX<real> coshOvrSinh;
+		/// Depth attenuation of the vertical components
+		Eigen::ArrayX<real> sinhOvrSinh;
+	} workspace;
+
+	/** @brief Make sure there are enough workspaces
+	 * @param n The number of required workspaces
+	 */
+	void allocateWorkspaces(unsigned int n);
+
+	/**
+	 * @brief Compute the time dependent part of the phases, as well as the
+	 * depth attenuation factors if the average depth has changed
+	 * @param t The time
+	 * @param avgDepth The average seafloor depth (negative)
+	 */
+	void prepare(real t, real avgDepth);
+
+	/**
+	 * @brief Advance the phasors to the time t, recomputing them exactly on
+	 * the nodes that moved too far, or everywhere if a resynchronization is
+	 * due
+	 * @param pos The (x, y, z) coordinates of the points, one per column
+	 * @param t The time, after calling prepare()
+	 */
+	void advancePhasors(const Eigen::Ref<const Eigen::Matrix3Xr>& pos, real t);
+
+	/**
+	 * @brief Get the wave kinematics at a point, after calling prepare()
+	 * @param ws The workspace
+	 * @param x The x coordinate
+	 * @param y The y coordinate
+	 * @param z The z coordinate
+	 * @param actualDepth The actual seafloor depth at the point (negative)
+	 * @param zeta surface height, only set if not null
+	 * @param vel water velocity, only set if not null
+	 * @param acc water acceleration, only set if not null
+	 */
+	void nodeKin(workspace& ws,
+	             real x,
+	             real y,
+	             real z,
+	             real actualDepth,
+	             real* zeta,
+	             vec3* vel,
+	             vec3* acc);
+
+	/**
+	 * @brief Get the wave kinematics at a point, from the wave components
+	 * already stored in the sinWaves and cosWaves of the workspace
+	 * @param ws The workspace
+	 * @param z The z coordinate
+	 * @param actualDepth The actual seafloor depth at the point (negative)
+	 * @param zeta surface height, only set if not null
+	 * @param vel water velocity, only set if not null
+	 * @param acc water acceleration, only set if not null
+	 */
+	void depthKin(workspace& ws,
+	              real z,
+	              real actualDepth,
+	              real* zeta,
+	              vec3* vel,
+	              vec3* acc);
+
 	/// Angular velocities of the spectrum components
 	Eigen::ArrayX<real> omegas;
 	/// Real amplitudes of spectrum components
@@ -64,6 +169,75 @@ class SpectrumKin
 	Eigen::ArrayX<real> phases;
 	/// Wave numbers of spectrum components
 	Eigen::ArrayX<real> kValues;
+
+	/** Precomputed factors of the spectrum components
+	 * @{
+	 */
+
+	/// \f$ k \cos \beta \f$
+	Eigen::ArrayX<real> kx;
+	/// \f$ k \sin \beta \f$
+	Eigen::ArrayX<real> ky;
+	/// \f$ \omega \cos \beta \f$
+	Eigen::ArrayX<real> wx;
+	/// \f$ \omega \sin \beta \f$
+	Eigen::ArrayX<real> wy;
+	/// \f$ \omega^2 \cos \beta \f$
+	Eigen::ArrayX<real> w2x;
+	/// \f$ \omega^2 \sin \beta \f$
+	Eigen::ArrayX<real> w2y;
+	/// \f$ \omega^2 \f$
+	Eigen::ArrayX<real> w2;
+	/// \f$ \vert k \vert \f$
+	Eigen::ArrayX<real> kAbs;
+	/// The average depth the depth factors were computed for
+	real depth;
+	/// \f$ 1 / (1 - e^{-2 \vert k \vert h}) \f$, with the sign of k
+	Eigen::ArrayX<real> sinhFactor;
+	/// \f$ 1 / (1 - e^{-2 \vert k \vert h}) \f$
+	Eigen::ArrayX<real> sinhFactorAbs;
+
+	/**
+	 * @}
+	 */
+
+	/** Workspace
+	 * @{
+	 */
+
+	/// The time dependent part of the phases, \f$ \omega t + \phi \f$
+	Eigen::ArrayX<real> wtPhase;
+	/// The per point workspaces, one per thread
+	std::vector<workspace> workspaces;
+
+	/**
+	 * @}
+	 */
+
+	/** Incremental phasors, see waves::WaterKinOptions::phasorTol
+	 * @{
+	 */
+
+	/// Distance the nodes can move before recomputing their phasors
+	real phasorTol;
+	/// Number of time advances before recomputing all the phasors
+	unsigned int phasorSync;
+	/// \f$ a e^{i (\omega t + \phi - k \cdot x)} \f$ per component and node
+	Eigen::Array<moordyn::complex, Eigen::Dynamic, Eigen::Dynamic> phasors;
+	/// The (x, y) position each node phasors were computed at
+	Eigen::Matrix<real, 2, Eigen::Dynamic> phasorPos;
+	/// The time the phasors were computed at
+	real phasorTime;
+	/// Number of time advances since the last resynchronization
+	unsigned int phasorAdvances;
+	/// The time step of moordyn::waves::SpectrumKin::rotation
+	real rotationDt;
+	/// \f$ e^{i \omega \Delta t} \f$
+	Eigen::ArrayX<moordyn::complex> rotation;
+
+	/**
+	 * @}
+	 */
 };
 
 }
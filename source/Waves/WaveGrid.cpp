@@ -3,10 +3,13 @@
 #include "../Waves.hpp"
 #include "MoorDyn2.hpp"
 #include "Util/Interp.hpp"
+#include "Util/ThreadPool.hpp"
 #include "WaveOptions.hpp"
 #include "kiss_fftr.h"
 #include <exception>
 #include <memory>
+#include <filesystem>
+#include <random>
 
 #if defined WIN32 && defined max
 // We must avoid max messes up with std::numeric_limits<>::max()
@@ -18,52 +21,122 @@
 namespace moordyn {
 namespace waves {
 
-/** @brief Carry out the inverse Fourier transform
- * @param cfg KISS FFT instance
- * @param nFFT Number of Fourier components
- * @param cx_w_in KISS FFT frequency-domain data
- * @param cx_t_out KISS FFT time-domain output
- * @param inputs Input FFT values
- * @param outputs Output time-domain values
+/** @brief Number of quantities transformed on each grid point
+ *
+ * Wave elevation, dynamic pressure, 3 velocity components and 3
+ * acceleration components
  */
-void
-doIFFT(kiss_fftr_cfg cfg,
-       unsigned int nFFT,
-       std::vector<kiss_fft_cpx>& cx_w_in,
-       std::vector<kiss_fft_scalar>& cx_t_out,
-       const std::vector<moordyn::complex>& inputs,
-       std::vector<real>& outputs)
-{
-	unsigned int nw = nFFT / 2 + 1;
+static const unsigned int FILL_NQ = 8;
 
-	// copy frequency-domain data into input vector
-	// NOTE: (simpler way to do this, or bypass altogether?)
-	for (unsigned int i = 0; i < nw; i++) {
-		cx_w_in[i].r = std::real(inputs[i]);
-		cx_w_in[i].i = std::imag(inputs[i]);
+/** @brief Workspace of a thread filling the wave grid
+ *
+ * The KISS FFT plans are not thread-safe, since they hold a scratch buffer,
+ * so each thread needs its own one. The buffers are reused for all the grid
+ * points processed by the thread
+ */
+class FillWorkspace
+{
+  public:
+	/** @brief Constructor
+	 * @param nFFT Number of time samples
+	 * @param nw Number of frequency components
+	 * @throws moordyn::mem_error If the FFT plan cannot be allocated
+	 */
+	FillWorkspace(unsigned int nFFT, unsigned int nw)
+	  : cfg(kiss_fftr_alloc(nFFT, 1, NULL, NULL))
+	  , zetaC(nw)
+	  , in(FILL_NQ * nw)
+	  , out(FILL_NQ * nFFT)
+	{
+		if (!cfg)
+			throw moordyn::mem_error("Failure allocating the FFT plan");
 	}
 
-	// input freqdata has nfft/2 + 1 complex points
-	// output timedata has nfft scalar points
-
-	kiss_fftri(cfg, cx_w_in.data(), cx_t_out.data());
+	/// Destructor
+	~FillWorkspace() { free(cfg); }
+
+	FillWorkspace(const FillWorkspace&) = delete;
+	FillWorkspace& operator=(const FillWorkspace&) = delete;
+
+	/// The inverse real FFT plan
+	kiss_fftr_cfg cfg;
+	/// The wave elevation spectrum shifted to the grid point
+	std::vector<moordyn::complex> zetaC;
+	/// The spectra of all the quantities, one after the other
+	std::vector<kiss_fft_cpx> in;
+	/// The time series of all the quantities, one after the other
+	std::vector<kiss_fft_scalar> out;
+};
+
+/** @brief Set a frequency component of a spectrum on the KISS FFT buffer
+ * @param dst The KISS FFT frequency component
+ * @param src The value
+ */
+static inline void
+setSpectrum(kiss_fft_cpx& dst, const moordyn::complex& src)
+{
+	dst.r = std::real(src);
+	dst.i = std::imag(src);
+}
 
-	// copy out the IFFT data to the time series
-	for (unsigned int i = 0; i < nFFT; i++) {
-		// NOTE: is dividing by nFFT correct? (previously was nw)
-		outputs[i] = cx_t_out[i] / (real)nFFT;
+/** @brief Compute the depth dependent factors of a wave component
+ * @param k The wave number
+ * @param h The water depth
+ * @param z The vertical coordinate
+ * @param SINHNumOvrSIHNDen Output SINH( k*( z + h ) )/SINH( k*h )
+ * @param COSHNumOvrSIHNDen Output COSH( k*( z + h ) )/SINH( k*h )
+ * @param COSHNumOvrCOSHDen Output COSH( k*( z + h ) )/COSH( k*h )
+ */
+static void
+depthFactors(real k,
+             real h,
+             real z,
+             real& SINHNumOvrSIHNDen,
+             real& COSHNumOvrSIHNDen,
+             real& COSHNumOvrCOSHDen)
+{
+	if (k == 0.0) {
+		// The shallow water formulation is ill-conditioned;
+		// thus, the known value of unity is returned.
+		SINHNumOvrSIHNDen = 1.0;
+		COSHNumOvrSIHNDen = 99999.0;
+		COSHNumOvrCOSHDen = 1.0;
+	} else if (k * h > 89.4) {
+		// The shallow water formulation will trigger a floating
+		// point overflow error; however, for
+		// h > 14.23 * wavelength (since k = 2 * Pi /
+		// wavelength) we can use the numerically-stable deep
+		// water formulation instead.
+		SINHNumOvrSIHNDen = exp(k * z);
+		COSHNumOvrSIHNDen = exp(k * z);
+		COSHNumOvrCOSHDen = exp(k * z) + exp(-k * (z + 2.0 * h));
+	} else if (-k * h > 89.4) {
+		// @mth: added negative k case
+		// NOTE: CHECK CORRECTNESS
+		SINHNumOvrSIHNDen = -exp(-k * z);
+		COSHNumOvrSIHNDen = -exp(-k * z);
+		COSHNumOvrCOSHDen = -exp(-k * z) + exp(-k * (z + 2.0 * h));
+	} else {
+		// shallow water formulation
+		SINHNumOvrSIHNDen = sinh(k * (z + h)) / sinh(k * h);
+		COSHNumOvrSIHNDen = cosh(k * (z + h)) / sinh(k * h);
+		COSHNumOvrCOSHDen = cosh(k * (z + h)) / cosh(k * h);
 	}
-
-	return;
 }
 
 /** @brief Fill the wave grid using time series data from the based on the fft
  * data (MORE RECENT)
+ *
+ * Each grid point is an independent task, so if a threads pool is provided
+ * the grid points are distributed among the threads. All the quantities of
+ * a grid point are computed in a single pass over the frequencies, and then
+ * inverse transformed one after the other on the thread workspace
  * @param zetaC0 Amplitude of each frequency component
  * @param nw Number of wave components
  * @param dw The difference in frequency between consecutive modes
  * @param g Gravity accelerations
  * @param h Water depth
+ * @param pool The threads pool, null to fill the grid serially
  * @throws moordyn::mem_error If there were problems allocating memory
  */
 std::unique_ptr<WaveGrid>
@@ -74,7 +147,8 @@ fillWaveGrid(std::unique_ptr<WaveGrid> waveGrid,
              const std::vector<real>& betas,
              real dw,
              EnvCondRef env,
-             moordyn::Log* _log)
+             moordyn::Log* _log,
+             ThreadPool* pool)
 {
 	// NOTE: should enable wave spreading at some point!
 	// real beta = 0.0; // WaveDir_in;
@@ -82,19 +156,8 @@ fillWaveGrid(std::unique_ptr<WaveGrid> waveGrid,
 	// initialize some frequency-domain wave calc vectors
 	vector<real> w(nw, 0.);
 	vector<real> k(nw, 0.);
-
-	// Fourier transform of wave elevation
-	std::vector<moordyn::complex> zetaC(nw);
-	// Fourier transform of dynamic pressure
-	std::vector<moordyn::complex> PDynC(nw);
-	// Fourier transform of wave velocities
-	std::vector<moordyn::complex> UCx(nw);
-	std::vector<moordyn::complex> UCy(nw);
-	std::vector<moordyn::complex> UCz(nw);
-	// Fourier transform of wave accelerations
-	std::vector<moordyn::complex> UdCx(nw);
-	std::vector<moordyn::complex> UdCy(nw);
-	std::vector<moordyn::complex> UdCz(nw);
+	vector<real> cosBeta(nw, 0.);
+	vector<real> sinBeta(nw, 0.);
 
 	// The number of wave time steps to be calculated
 	// nt = 2 * (nw - 1);
@@ -102,7 +165,7 @@ fillWaveGrid(std::unique_ptr<WaveGrid> waveGrid,
 	// This computes the time distance between samples returned by the ifft
 	// We entirely ignore the env->dtWave value in this case for now
 	waveGrid->dtWave = ((2 * pi) / dw) / nt;
-	LOGMSG << "in new fillWaveGrid, setting waveGrid->dtWave to be "
+	LOGDBG << "in new fillWaveGrid, setting waveGrid->dtWave to be "
 	       << waveGrid->dtWave << endl;
 	auto h = env->WtrDpth;
 	auto g = env->g;
@@ -112,12 +175,14 @@ fillWaveGrid(std::unique_ptr<WaveGrid> waveGrid,
 	for (unsigned int i = 0; i < nw; i++)
 		w[i] = (real)i * dw;
 
-	LOGMSG << "Wave frequencies from " << w[0] << " rad/s to " << w[nw - 1]
+	LOGDBG << "Wave frequencies from " << w[0] << " rad/s to " << w[nw - 1]
 	       << " rad/s in increments of " << dw << " rad/s" << endl;
 
 	LOGDBG << "Wave numbers in rad/m are ";
 	for (unsigned int I = 0; I < nw; I++) {
 		k[I] = WaveNumber(w[I], env->g, h);
+		cosBeta[I] = cos(betas[I]);
+		sinBeta[I] = sin(betas[I]);
 		LOGDBG << k[I] << ", ";
 	}
 	LOGDBG << endl;
@@ -129,150 +194,274 @@ fillWaveGrid(std::unique_ptr<WaveGrid> waveGrid,
 	LOGDBG << "Making wave Kinematics (iFFT)..." << endl;
 
 	// start the FFT stuff using kiss_fft
-	unsigned int nFFT = nt;
-	const int is_inverse_fft = 1;
-
-	// allocate memory for kiss_fftr
-	kiss_fftr_cfg cfg = kiss_fftr_alloc(nFFT, is_inverse_fft, NULL, NULL);
+	const unsigned int nFFT = nt;
+	const unsigned int nThreads = pool ? pool->GetThreads() : 1;
+	std::vector<std::unique_ptr<FillWorkspace>> workspaces;
+	for (unsigned int i = 0; i < nThreads; i++)
+		workspaces.push_back(std::make_unique<FillWorkspace>(nFFT, nw));
 
-	// allocate input and output arrays for kiss_fftr  (note that
-	// kiss_fft_scalar is set to double)
-	std::vector<kiss_fft_cpx> cx_w_in(nw);
-	std::vector<kiss_fft_scalar> cx_t_out(nFFT);
-
-	// calculating wave kinematics for each grid point
 	const auto& px = waveGrid->Px();
 	const auto& py = waveGrid->Py();
 	const auto& pz = waveGrid->Pz();
-	for (unsigned int ix = 0; ix < waveGrid->nx; ix++) {
-		real x = px[ix];
-		for (unsigned int iy = 0; iy < waveGrid->ny; iy++) {
-			real y = py[iy];
-			// wave elevation
-			// handle all (not just positive-frequency half?) of spectrum?
-			for (unsigned int I = 0; I < nw; I++) {
-				// shift each zetaC to account for location
-				const real l = cos(betas[I]) * x + sin(betas[I]) * y;
-				// NOTE: check minus sign in exponent!
-				zetaC[I] = zetaC0[I] * exp(-i1 * (k[I] * l));
-			}
+	const unsigned int nx = waveGrid->nx;
+	const unsigned int ny = waveGrid->ny;
+	const unsigned int nz = waveGrid->nz;
+	WaveGrid* grid = waveGrid.get();
 
-			// IFFT the wave elevation spectrum
-			doIFFT(
-			    cfg, nFFT, cx_w_in, cx_t_out, zetaC, waveGrid->Zetas()[ix][iy]);
+	// calculating wave kinematics for each grid point
+	auto task = [&](unsigned int task_id) {
+		FillWorkspace& ws =
+		    *workspaces[pool ? ThreadPool::GetThreadIndex() : 0];
+		const unsigned int iz = task_id % nz;
+		const unsigned int iy = (task_id / nz) % ny;
+		const unsigned int ix = task_id / (nz * ny);
+		const real x = px[ix];
+		const real y = py[iy];
+		const real z = pz[iz];
+
+		// wave elevation
+		// handle all (not just positive-frequency half?) of spectrum?
+		for (unsigned int I = 0; I < nw; I++) {
+			// shift each zetaC to account for location
+			const real l = cosBeta[I] * x + sinBeta[I] * y;
+			// NOTE: check minus sign in exponent!
+			ws.zetaC[I] = zetaC0[I] * exp(-i1 * (k[I] * l));
+		}
 
-			// wave velocities and accelerations
-			for (unsigned int iz = 0; iz < waveGrid->nz; iz++) {
-				real z = pz[iz];
+		// Loop through the positive frequency components (including zero) of
+		// the Fourier transforms
+		kiss_fft_cpx* in = ws.in.data();
+		for (unsigned int I = 0; I < nw; I++) {
+			const moordyn::complex& zetaC = ws.zetaC[I];
+			real SINHNumOvrSIHNDen;
+			real COSHNumOvrSIHNDen;
+			real COSHNumOvrCOSHDen;
+			depthFactors(k[I],
+			             h,
+			             z,
+			             SINHNumOvrSIHNDen,
+			             COSHNumOvrSIHNDen,
+			             COSHNumOvrCOSHDen);
+
+			// Fourier transform of wave velocities
+			// (note: need to multiply by abs(w) to avoid inverting
+			//  negative half of spectrum) <<< ???
+			const moordyn::complex UCx =
+			    w[I] * zetaC * COSHNumOvrSIHNDen * cosBeta[I];
+			const moordyn::complex UCy =
+			    w[I] * zetaC * COSHNumOvrSIHNDen * sinBeta[I];
+			const moordyn::complex UCz = i1 * w[I] * zetaC * SINHNumOvrSIHNDen;
 
-				// Loop through the positive frequency components (including
-				// zero) of the Fourier transforms
-				for (unsigned int I = 0; I < nw; I++) {
-					// Calculate
-					//     SINH( k*( z + h ) )/SINH( k*h )
-					//     COSH( k*( z + h ) )/SINH( k*h )
-					//     COSH( k*( z + h ) )/COSH( k*h )
-					real SINHNumOvrSIHNDen;
-					real COSHNumOvrSIHNDen;
-					real COSHNumOvrCOSHDen;
-
-					if (k[I] == 0.0) {
-						// The shallow water formulation is ill-conditioned;
-						// thus, the known value of unity is returned.
-						SINHNumOvrSIHNDen = 1.0;
-						COSHNumOvrSIHNDen = 99999.0;
-						COSHNumOvrCOSHDen = 1.0;
-					} else if (k[I] * h > 89.4) {
-						// The shallow water formulation will trigger a floating
-						// point overflow error; however, for
-						// h > 14.23 * wavelength (since k = 2 * Pi /
-						// wavelength) we can use the numerically-stable deep
-						// water formulation instead.
-						SINHNumOvrSIHNDen = exp(k[I] * z);
-						COSHNumOvrSIHNDen = exp(k[I] * z);
-						COSHNumOvrCOSHDen =
-						    exp(k[I] * z) + exp(-k[I] * (z + 2.0 * h));
-					} else if (-k[I] * h > 89.4) {
-						// @mth: added negative k case
-						// NOTE: CHECK CORRECTNESS
-						SINHNumOvrSIHNDen = -exp(-k[I] * z);
-						COSHNumOvrSIHNDen = -exp(-k[I] * z);
-						COSHNumOvrCOSHDen =
-						    -exp(-k[I] * z) + exp(-k[I] * (z + 2.0 * h));
-					} else {
-						// shallow water formulation
-						SINHNumOvrSIHNDen =
-						    sinh(k[I] * (z + h)) / sinh(k[I] * h);
-						COSHNumOvrSIHNDen =
-						    cosh(k[I] * (z + h)) / sinh(k[I] * h);
-						COSHNumOvrCOSHDen =
-						    cosh(k[I] * (z + h)) / cosh(k[I] * h);
-					}
+			// wave elevation
+			setSpectrum(in[I], zetaC);
+			// Fourier transform of dynamic pressure
+			setSpectrum(in[nw + I], rho_w * g * zetaC * COSHNumOvrCOSHDen);
+			setSpectrum(in[2 * nw + I], UCx);
+			setSpectrum(in[3 * nw + I], UCy);
+			setSpectrum(in[4 * nw + I], UCz);
+			// Fourier transform of wave accelerations
+			// NOTE: should confirm correct signs of +/- halves of
+			// spectrum here
+			setSpectrum(in[5 * nw + I], i1 * w[I] * UCx);
+			setSpectrum(in[6 * nw + I], i1 * w[I] * UCy);
+			setSpectrum(in[7 * nw + I], i1 * w[I] * UCz);
+		}
 
-					// Fourier transform of dynamic pressure
-					PDynC[I] = rho_w * g * zetaC[I] * COSHNumOvrCOSHDen;
-
-					// Fourier transform of wave velocities
-					// (note: need to multiply by abs(w) to avoid inverting
-					//  negative half of spectrum) <<< ???
-					UCx[I] =
-					    w[I] * zetaC[I] * COSHNumOvrSIHNDen * cos(betas[I]);
-					UCy[I] =
-					    w[I] * zetaC[I] * COSHNumOvrSIHNDen * sin(betas[I]);
-					UCz[I] = i1 * w[I] * zetaC[I] * SINHNumOvrSIHNDen;
-
-					// Fourier transform of wave accelerations
-					// NOTE: should confirm correct signs of +/- halves of
-					// spectrum here
-					UdCx[I] = i1 * w[I] * UCx[I];
-					UdCy[I] = i1 * w[I] * UCy[I];
-					UdCz[I] = i1 * w[I] * UCz[I];
-				}
+		// NOTE: could handle negative-frequency half of spectrum with
+		// for (int I=nw/2+1; I<nw; I++) <<<
 
-				// NOTE: could handle negative-frequency half of spectrum with
-				// for (int I=nw/2+1; I<nw; I++) <<<
-
-				// IFFT the dynamic pressure
-				doIFFT(cfg,
-				       nFFT,
-				       cx_w_in,
-				       cx_t_out,
-				       PDynC,
-				       waveGrid->PDyn()[ix][iy][iz]);
-				// IFFT the wave velocities
-				std::vector<real> x_vel(nt);
-				std::vector<real> y_vel(nt);
-				std::vector<real> z_vel(nt);
-				doIFFT(cfg, nFFT, cx_w_in, cx_t_out, UCx, x_vel);
-				doIFFT(cfg, nFFT, cx_w_in, cx_t_out, UCy, y_vel);
-				doIFFT(cfg, nFFT, cx_w_in, cx_t_out, UCz, z_vel);
-				for (unsigned int i = 0; i < nt; i++) {
-					waveGrid->WaveVel()[ix][iy][iz][i] =
-					    vec3(x_vel[i], y_vel[i], z_vel[i]);
-				}
+		// IFFT all the quantities. The wave elevation is just required on
+		// the first point of each vertical
+		const kiss_fft_scalar* out = ws.out.data();
+		for (unsigned int q = iz ? 1 : 0; q < FILL_NQ; q++)
+			kiss_fftri(ws.cfg, in + q * nw, ws.out.data() + q * nFFT);
 
-				// IFFT the wave accelerations
-				std::vector<real> x_acc(nt);
-				std::vector<real> y_acc(nt);
-				std::vector<real> z_acc(nt);
-				doIFFT(cfg, nFFT, cx_w_in, cx_t_out, UdCx, x_acc);
-				doIFFT(cfg, nFFT, cx_w_in, cx_t_out, UdCy, y_acc);
-				doIFFT(cfg, nFFT, cx_w_in, cx_t_out, UdCz, z_acc);
-				for (unsigned int i = 0; i < nt; i++) {
-					waveGrid->WaveAcc()[ix][iy][iz][i] =
-					    vec3(x_acc[i], y_acc[i], z_acc[i]);
-				}
-				// NOTE: wave stretching stuff would maybe go here?? <<<
-			}
+		// NOTE: is dividing by nFFT correct? (previously was nw)
+		for (unsigned int i = 0; i < nt; i++) {
+			if (!iz)
+				grid->setZeta(ix, iy, i, out[i] / (real)nFFT);
+			grid->setPDyn(ix, iy, iz, i, out[nFFT + i] / (real)nFFT);
+			grid->setVel(ix,
+			             iy,
+			             iz,
+			             i,
+			             vec3(out[2 * nFFT + i] / (real)nFFT,
+			                  out[3 * nFFT + i] / (real)nFFT,
+			                  out[4 * nFFT + i] / (real)nFFT));
+			grid->setAcc(ix,
+			             iy,
+			             iz,
+			             i,
+			             vec3(out[5 * nFFT + i] / (real)nFFT,
+			                  out[6 * nFFT + i] / (real)nFFT,
+			                  out[7 * nFFT + i] / (real)nFFT));
 		}
+		// NOTE: wave stretching stuff would maybe go here?? <<<
+	};
+
+	const unsigned int n = nx * ny * nz;
+	if (pool) {
+		pool->Run(std::vector<real>(n, 1.0), task);
+	} else {
+		for (unsigned int i = 0; i < n; i++)
+			task(i);
 	}
 
-	free(cfg);
-
 	LOGDBG << "Done!" << endl;
 	return waveGrid;
 }
 
+/** @brief Generator of the time slices of a wave grid sliding window
+ *
+ * Each slice is computed by directly summing the frequency components at the
+ * slice time, which is giving the same values than the inverse FFT of
+ * fillWaveGrid() at the sampled instants. The depth dependent factors are
+ * precomputed, so each slice costs just a complex exponential per horizontal
+ * grid point and frequency component, and a few multiply-adds per grid point
+ * and frequency component
+ * @see WaveGrid::setupWindow()
+ */
+class SliceSynthesizer
+{
+  public:
+	/** @brief Constructor
+	 * @param grid The wave grid
+	 * @param zetaC0 Amplitude of each frequency component
+	 * @param betas The direction of each frequency component
+	 * @param dw The difference in frequency between consecutive modes
+	 * @param env The environment options
+	 */
+	SliceSynthesizer(const WaveGrid& grid,
+	                 const std::vector<moordyn::complex>& zetaC0,
+	                 const std::vector<real>& betas,
+	                 real dw,
+	                 EnvCondRef env)
+	  : nw(static_cast<unsigned int>(zetaC0.size()))
+	  , nFFT(grid.nt)
+	  , zetaC(nw)
+	  , k(nw)
+	  , cosBeta(nw)
+	  , sinBeta(nw)
+	  , phase(nw)
+	  , br(nw)
+	  , bi(nw)
+	{
+		const auto h = env->WtrDpth;
+		const auto& pz = grid.Pz();
+		const unsigned int nz = grid.nz;
+		for (auto f : { &P, &Ux, &Uy, &Uz, &Ax, &Ay, &Az })
+			f->resize(nz * nw);
+		for (unsigned int I = 0; I < nw; I++) {
+			const real w = I * dw;
+			k[I] = WaveNumber(w, env->g, h);
+			cosBeta[I] = cos(betas[I]);
+			sinBeta[I] = sin(betas[I]);
+			// The real inverse FFT is counting twice all the components but
+			// the mean and the Nyquist ones
+			const real c = (!I || (2 * I == nFFT)) ? 1.0 : 2.0;
+			zetaC[I] = c * zetaC0[I] / (real)nFFT;
+			for (unsigned int iz = 0; iz < nz; iz++) {
+				real SINHNumOvrSIHNDen;
+				real COSHNumOvrSIHNDen;
+				real COSHNumOvrCOSHDen;
+				depthFactors(k[I],
+				             h,
+				             pz[iz],
+				             SINHNumOvrSIHNDen,
+				             COSHNumOvrSIHNDen,
+				             COSHNumOvrCOSHDen);
+				const unsigned int j = iz * nw + I;
+				P[j] = env->rho_w * env->g * COSHNumOvrCOSHDen;
+				Ux[j] = w * COSHNumOvrSIHNDen * cosBeta[I];
+				Uy[j] = w * COSHNumOvrSIHNDen * sinBeta[I];
+				Uz[j] = w * SINHNumOvrSIHNDen;
+				Ax[j] = w * Ux[j];
+				Ay[j] = w * Uy[j];
+				Az[j] = w * Uz[j];
+			}
+		}
+	}
+
+	/** @brief Fill a time slice
+	 * @param grid The wave grid
+	 * @param it The time step index
+	 * @param slot The slot of the window
+	 */
+	void operator()(WaveGrid& grid, unsigned long it, unsigned int slot)
+	{
+		// The phases are computed from the integer index to avoid any drift
+		// on long simulations
+		for (unsigned int I = 0; I < nw; I++) {
+			const unsigned long long n =
+			    ((unsigned long long)I * it) % (unsigned long long)nFFT;
+			phase[I] = 2.0 * pi * (real)n / (real)nFFT;
+		}
+
+		const auto& px = grid.Px();
+		const auto& py = grid.Py();
+		for (unsigned int ix = 0; ix < grid.nx; ix++) {
+			for (unsigned int iy = 0; iy < grid.ny; iy++) {
+				// Each component shifted to account for the location
+				real zeta = 0.0;
+				for (unsigned int I = 0; I < nw; I++) {
+					const real l = cosBeta[I] * px[ix] + sinBeta[I] * py[iy];
+					const moordyn::complex b =
+					    zetaC[I] * exp(i1 * (phase[I] - k[I] * l));
+					br[I] = std::real(b);
+					bi[I] = std::imag(b);
+					zeta += br[I];
+				}
+				grid.setZeta(ix, iy, slot, zeta);
+
+				for (unsigned int iz = 0; iz < grid.nz; iz++) {
+					const unsigned int j0 = iz * nw;
+					real pdyn = 0.0;
+					vec3 u = vec3::Zero(), a = vec3::Zero();
+					for (unsigned int I = 0; I < nw; I++) {
+						const unsigned int j = j0 + I;
+						pdyn += br[I] * P[j];
+						u[0] += br[I] * Ux[j];
+						u[1] += br[I] * Uy[j];
+						u[2] -= bi[I] * Uz[j];
+						a[0] -= bi[I] * Ax[j];
+						a[1] -= bi[I] * Ay[j];
+						a[2] -= br[I] * Az[j];
+					}
+					grid.setPDyn(ix, iy, iz, slot, pdyn);
+					grid.setVel(ix, iy, iz, slot, u);
+					grid.setAcc(ix, iy, iz, slot, a);
+				}
+			}
+		}
+	}
+
+  private:
+	/// Number of frequency components
+	unsigned int nw;
+	/// Number of time samples of the period
+	unsigned int nFFT;
+	/// The weighted amplitude of each frequency component
+	std::vector<moordyn::complex> zetaC;
+	/// The wave numbers
+	std::vector<real> k;
+	/// The cosine of the direction of each component
+	std::vector<real> cosBeta;
+	/// The sine of the direction of each component
+	std::vector<real> sinBeta;
+	/// The dynamic pressure factors, [iz * nw + I]
+	std::vector<real> P;
+	/// The velocity factors, [iz * nw + I]
+	std::vector<real> Ux, Uy, Uz;
+	/// The acceleration factors, [iz * nw + I]
+	std::vector<real> Ax, Ay, Az;
+	/// The phase of each component at the slice time
+	std::vector<real> phase;
+	/// The real part of the shifted components
+	std::vector<real> br;
+	/// The imaginary part of the shifted components
+	std::vector<real> bi;
+};
+
 /** @brief Read the grid file and return the three axes
  *
  * The grid is defined in a tabulated file (separator=' '). That file has 3
@@ -350,10 +539,177 @@ rectilinearGridFromFile(std::filesystem::path filepath, moordyn::Log* _log)
 	return { px, py, pz };
 }
 
+/** @brief Accumulate some data on a 64 bits FNV-1a hash
+ * @param hash The hash so far
+ * @param data The data
+ * @param n The data size, in bytes
+ * @return The updated hash
+ */
+static uint64_t
+hashData(uint64_t hash, const void* data, size_t n)
+{
+	const unsigned char* bytes = (const unsigned char*)data;
+	for (size_t i = 0; i < n; i++) {
+		hash ^= bytes[i];
+		hash *= 1099511628211ULL;
+	}
+	return hash;
+}
+
+/** @brief Create the wave grid and fill it, or map it from the cache file
+ *
+ * If the WaveGridFile option is set, the file is mapped when it was
+ * generated with the same inputs. Otherwise the grid is computed and saved
+ * on the file, for the next runs. If the WaveGridTile or the WaveGridWindow
+ * options are set, the grid is instead generated on the fly, either tile by
+ * tile or on a sliding time window.
+ * @param folder The folder of the input files
+ * @param px The grid x coordinates
+ * @param py The grid y coordinates
+ * @param pz The grid z coordinates
+ * @param nt The number of time steps
+ * @param zetaC0 Amplitude of each frequency component
+ * @param betas The direction of each frequency component
+ * @param dw The difference in frequency between consecutive modes
+ * @param env The environment options
+ * @param _log The log handler
+ * @param pool The threads pool, null to compute the grid serially
+ * @return The wave grid
+ */
+std::unique_ptr<WaveGrid>
+makeWaveGrid(const std::string& folder,
+             const std::vector<real>& px,
+             const std::vector<real>& py,
+             const std::vector<real>& pz,
+             unsigned int nt,
+             const std::vector<moordyn::complex>& zetaC0,
+             const std::vector<real>& betas,
+             real dw,
+             EnvCondRef env,
+             moordyn::Log* _log,
+             ThreadPool* pool)
+{
+	const auto& opts = env->waterKinOptions;
+	const auto nw = static_cast<unsigned int>(zetaC0.size());
+	// The time distance between samples returned by the ifft
+	const real dt = ((2 * pi) / dw) / nt;
+	LOGMSG << "Wave frequencies from 0 rad/s to " << (nw - 1) * dw
+	       << " rad/s in increments of " << dw << " rad/s, dtWave = " << dt
+	       << " s" << endl;
+
+	if (opts.gridTile) {
+		if (opts.gridWindow)
+			LOGWRN << "The sliding time window is ignored, since the wave "
+			       << "grid is split in tiles" << endl;
+		if (!opts.gridFile.empty())
+			LOGWRN << "The wave grid file is ignored, since the wave grid is "
+			       << "split in tiles" << endl;
+		auto waveGrid = make_unique<WaveGrid>(_log, px, py, pz, nt, dt);
+		// The tiles are filled during the time integration, when the threads
+		// pool might have been replaced, so they are filled serially
+		auto generator = [zetaC0, betas, nw, dw, env, _log](
+		                     std::unique_ptr<WaveGrid> tile) {
+			return fillWaveGrid(std::move(tile),
+			                    zetaC0.data(),
+			                    nw,
+			                    betas,
+			                    dw,
+			                    env,
+			                    _log,
+			                    nullptr);
+		};
+		waveGrid->setupTiles(
+		    opts.gridTile, opts.gridTileLife, generator, opts.singleGrid);
+		return waveGrid;
+	}
+
+	if (opts.gridWindow) {
+		if (!opts.gridFile.empty())
+			LOGWRN << "The wave grid file is ignored, since a sliding time "
+			       << "window is used" << endl;
+		auto waveGrid = make_unique<WaveGrid>(_log, px, py, pz, nt, dt);
+		waveGrid->setupWindow(opts.gridWindow,
+		                      SliceSynthesizer(*waveGrid, zetaC0, betas, dw, env),
+		                      opts.singleGrid);
+		return waveGrid;
+	}
+	auto make = [&]() {
+		auto waveGrid =
+		    make_unique<WaveGrid>(_log, px, py, pz, nt, opts.dtWave);
+		waveGrid->allocateKinematicArrays(opts.singleGrid);
+		return fillWaveGrid(std::move(waveGrid),
+		                    zetaC0.data(),
+		                    nw,
+		                    betas,
+		                    dw,
+		                    env,
+		                    _log,
+		                    pool);
+	};
+	if (opts.gridFile.empty())
+		return make();
+
+	std::filesystem::path path(opts.gridFile);
+	if (path.is_relative())
+		path = std::filesystem::path(folder) / path;
+
+	// Everything affecting the grid contents
+	uint64_t hash = 14695981039346656037ULL;
+	const uint64_t sizes[5] = { px.size(), py.size(), pz.size(), nt, nw };
+	const double params[4] = { env->WtrDpth, env->g, env->rho_w, dw };
+	const uint8_t single = opts.singleGrid ? 1 : 0;
+	hash = hashData(hash, sizes, sizeof(sizes));
+	hash = hashData(hash, params, sizeof(params));
+	hash = hashData(hash, &single, sizeof(single));
+	hash = hashData(hash, px.data(), px.size() * sizeof(real));
+	hash = hashData(hash, py.data(), py.size() * sizeof(real));
+	hash = hashData(hash, pz.data(), pz.size() * sizeof(real));
+	hash = hashData(hash, zetaC0.data(), nw * sizeof(moordyn::complex));
+	hash = hashData(hash, betas.data(), betas.size() * sizeof(real));
+
+	auto waveGrid = WaveGrid::load(_log, path.string(), hash);
+	if (waveGrid)
+		return waveGrid;
+
+	waveGrid = make();
+
+	// Several processes might be generating the same file at the same time,
+	// so each one writes its own temporary file, which is atomically moved
+	LOGMSG << "Saving the wave grid on '" << path.string() << "'..." << endl;
+	std::random_device rd;
+	std::filesystem::path tmp = path;
+	tmp += "." + std::to_string(rd()) + ".tmp";
+	try {
+		waveGrid->save(tmp.string(), hash);
+	} catch (const moordyn::output_file_error&) {
+		std::error_code ec;
+		std::filesystem::remove(tmp, ec);
+		LOGWRN << "The wave grid cannot be saved on '" << path.string() << "'"
+		       << endl;
+		return waveGrid;
+	}
+	std::error_code ec;
+	std::filesystem::rename(tmp, path, ec);
+	if (ec) {
+		std::filesystem::remove(tmp, ec);
+		LOGWRN << "The wave grid cannot be saved on '" << path.string()
+		       << "': " << ec.message() << endl;
+		return waveGrid;
+	}
+
+	// Map the file we just wrote, so the memory is shared with the rest of
+	// processes
+	auto mapped = WaveGrid::load(_log, path.string(), hash);
+	if (mapped)
+		return mapped;
+	return waveGrid;
+}
+
 std::unique_ptr<WaveGrid>
 constructWaveGridSpectrumData(const std::string& folder,
                               const EnvCondRef env,
-                              moordyn::Log* _log)
+                              moordyn::Log* _log,
+                              ThreadPool* pool)
 {
 
 	const string WaveFilename = folder + "wave_frequencies.txt";
@@ -393,23 +749,15 @@ constructWaveGridSpectrumData(const std::string& folder,
 	auto [px, py, pz] =
 	    rectilinearGridFromFile(folder + "water_grid.txt", _log);
 
-	auto waveGrid = make_unique<WaveGrid>(
-	    _log, px, py, pz, nt, env->waterKinOptions.dtWave);
-	waveGrid->allocateKinematicArrays();
-
 	// calculate wave kinematics throughout the grid
-	return fillWaveGrid(std::move(waveGrid),
-	                    zetaC0.data(),
-	                    static_cast<unsigned int>(zetaC0.size()),
-	                    betas,
-	                    dw,
-	                    env,
-	                    _log);
+	return makeWaveGrid(
+	    folder, px, py, pz, nt, zetaC0, betas, dw, env, _log, pool);
 }
 std::unique_ptr<WaveGrid>
 constructWaveGridElevationData(const std::string& folder,
                                const EnvCondRef env,
-                               moordyn::Log* _log)
+                               moordyn::Log* _log,
+                               ThreadPool* pool)
 {
 
 	// load wave elevation time series from file (similar to what's done in
@@ -524,19 +872,15 @@ constructWaveGridElevationData(const std::string& folder,
 		if (i * dw > 0.5 * 2 * pi)
 			zetaC0[i] = 0.0;
 
-	std::unique_ptr<WaveGrid> waveGrid{};
 	// calculate wave kinematics throughout the grid
 	// make a grid for wave kinematics based on settings in
 	// water_grid.txt
 	auto [px, py, pz] =
 	    rectilinearGridFromFile(folder + "water_grid.txt", _log);
 
-	waveGrid = make_unique<WaveGrid>(_log, px, py, pz, nt, dtWave);
-	waveGrid->allocateKinematicArrays();
-	// makeGrid(((string)folder + "water_grid.txt").c_str());
 	std::vector<real> betas(nw, 0);
-	return fillWaveGrid(
-	    std::move(waveGrid), zetaC0.data(), nw, betas, dw, env, _log);
+	return makeWaveGrid(
+	    folder, px, py, pz, nt, zetaC0, betas, dw, env, _log, pool);
 }
 
 std::unique_ptr<CurrentGrid>
@@ -606,12 +950,12 @@ constructSteadyCurrentGrid(const std::string& folder,
 
 	auto currentGrid =
 	    make_unique<CurrentGrid>(_log, px, py, UProfileZ, nt, dtWave);
-	currentGrid->allocateKinematicArrays();
+	currentGrid->allocateKinematicArrays(env->waterKinOptions.singleGrid);
 
 	// fill in output arrays
 	for (unsigned int i = 0; i < currentGrid->nz; i++) {
-		currentGrid->CurrentVel()[0][0][i][0] =
-		    vec3(UProfileUx[i], UProfileUy[i], UProfileUz[i]);
+		currentGrid->setVel(
+		    0, 0, i, 0, vec3(UProfileUx[i], UProfileUy[i], UProfileUz[i]));
 	}
 	return currentGrid;
 }
@@ -709,7 +1053,7 @@ constructDynamicCurrentGrid(const std::string& folder,
 
 	auto currentGrid =
 	    make_unique<CurrentGrid>(_log, px, py, UProfileZ, nt, dtWave);
-	currentGrid->allocateKinematicArrays();
+	currentGrid->allocateKinematicArrays(env->waterKinOptions.singleGrid);
 
 	// fill in output arrays
 	real ft;
@@ -721,10 +1065,10 @@ constructDynamicCurrentGrid(const std::string& folder,
 			auto x = lerp(UProfileUx[iz][iti - 1], UProfileUx[iz][iti], ft);
 			auto y = lerp(UProfileUy[iz][iti - 1], UProfileUy[iz][iti], ft);
 			auto z = lerp(UProfileUz[iz][iti - 1], UProfileUz[iz][iti], ft);
-			currentGrid->CurrentVel()[0][0][iz][it] = vec3(x, y, z);
+			currentGrid->setVel(0, 0, iz, it, vec3(x, y, z));
 			// TODO: approximate fluid accelerations using finite
 			//       differences
-			currentGrid->CurrentAcc()[0][0][iz][it] = vec3::Zero();
+			currentGrid->setAcc(0, 0, iz, it, vec3::Zero());
 		}
 	}
 
@@ -855,7 +1199,7 @@ construct4DCurrentGrid(const std::string& folder,
 
 	auto currentGrid = make_unique<CurrentGrid>(
 	    _log, UProfileX, UProfileY, UProfileZ, nt, dtWave);
-	currentGrid->allocateKinematicArrays();
+	currentGrid->allocateKinematicArrays(env->waterKinOptions.singleGrid);
 
 	// fill in output arrays
 	real ft;
@@ -875,10 +1219,10 @@ construct4DCurrentGrid(const std::string& folder,
 					auto z = lerp(currentGridUz[ix][iy][iz][iti - 1],
 					              currentGridUz[ix][iy][iz][iti],
 					              ft);
-					currentGrid->CurrentVel()[ix][iy][iz][it] = vec3(x, y, z);
+					currentGrid->setVel(ix, iy, iz, it, vec3(x, y, z));
 					// TODO: approximate fluid accelerations using finite
 					//       differences
-					currentGrid->CurrentAcc()[ix][iy][iz][it] = vec3::Zero();
+					currentGrid->setAcc(ix, iy, iz, it, vec3::Zero());
 				}
 			}
 		}
@@ -8,6 +8,7 @@ typedef std::shared_ptr<EnvCond> EnvCondRef;
 namespace moordyn {
 class WaveGrid;
 class CurrentGrid;
+class ThreadPool;
 
 class Log;
 
@@ -20,13 +21,16 @@ namespace waves {
  * @param folder The folder to look for the wave_frequencies.txt file in
  * @param env The environment options
  * @param _log Log pointer to allow logging from this function
+ * @param pool The threads pool to compute the grid, null to compute it
+ * serially
  * @return std::unique_ptr<WaveGrid> A wave grid object containing the
  * precalculated wave data
  */
 std::unique_ptr<WaveGrid>
 constructWaveGridSpectrumData(const std::string& folder,
                               const EnvCondRef env,
-                              moordyn::Log* _log);
+                              moordyn::Log* _log,
+                              ThreadPool* pool = nullptr);
 /**
  * @brief Does the setup for the WAVE_GRID wave mode
  *
@@ -35,13 +39,16 @@ constructWaveGridSpectrumData(const std::string& folder,
  * water_grid.txt files in
  * @param env The environment options
  * @param _log Log pointer to allow logging from this function
+ * @param pool The threads pool to compute the grid, null to compute it
+ * serially
  * @return std::unique_ptr<WaveGrid> A wave grid object containing the
  * precalculated wave data
  */
 std::unique_ptr<WaveGrid>
 constructWaveGridElevationData(const std::string& folder,
                                const EnvCondRef env,
-                               moordyn::Log* _log);
+                               moordyn::Log* _log,
+                               ThreadPool* pool = nullptr);
 
 /**
  * @brief Does the setup for the CURRENTS_STEADY_GRID mode
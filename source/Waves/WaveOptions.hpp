@@ -1,6 +1,8 @@
 
 #pragma once
 
+#include <string>
+
 namespace moordyn {
 namespace waves {
 
@@ -59,6 +61,23 @@ typedef enum
 	CURRENTS_4D = 5
 } currents_settings;
 
+/** @brief Available settings to reuse the water kinematics along the time
+ * integration substeps
+ */
+typedef enum
+{
+	/// Evaluate the water kinematics on every derivative computation
+	WAVES_CACHE_NONE = 0,
+	/// Evaluate the water kinematics just once per time instant
+	WAVES_CACHE_TIME = 1,
+	/// Linearly interpolate the water kinematics evaluated at the coupling
+	/// time steps boundaries
+	WAVES_CACHE_LINEAR = 2,
+	/// Cubic interpolation of the water kinematics evaluated at the coupling
+	/// time steps boundaries and their neighbours
+	WAVES_CACHE_CUBIC = 3
+} cache_settings;
+
 /**
  * @brief Container for all the wave and current options
  *
@@ -80,6 +99,65 @@ struct WaterKinOptions
 	bool unifyCurrentGrid;
 	/// dtWaveOption
 	double dtWave;
+	/// WaveKinCache Option
+	cache_settings cacheMode;
+	/**
+	 * WavePhasorTol Option
+	 *
+	 * When positive, the summed frequency components (WAVES_SUM_COMPONENTS_NODE)
+	 * are incrementally advanced in time by rotating a phasor per node and
+	 * component. The phasors are exactly recomputed if the node moved more
+	 * than this distance
+	 */
+	double phasorTol;
+	/**
+	 * WavePhasorSync Option
+	 *
+	 * Number of incremental phasor advances before they are exactly
+	 * recomputed, to bound the round off drift
+	 */
+	unsigned int phasorSync;
+	/**
+	 * WaterGridSingle Option
+	 *
+	 * Store the wave and current grids kinematics in single precision, to
+	 * halve the memory footprint
+	 */
+	bool singleGrid;
+	/**
+	 * WaveGridFile Option
+	 *
+	 * File where the precomputed wave grid (WAVES_FFT_GRID and WAVES_GRID) is
+	 * saved and memory-mapped from on the next runs. Empty to always compute
+	 * the grid
+	 */
+	std::string gridFile;
+	/**
+	 * WaveGridWindow Option
+	 *
+	 * Number of time slices kept in memory for the WAVES_FFT_GRID and
+	 * WAVES_GRID modes. The slices are generated ahead on a background
+	 * thread as the simulation advances, so the memory footprint does not
+	 * depend on the length of the time series. 0 to store the whole time
+	 * series
+	 */
+	unsigned int gridWindow;
+	/**
+	 * WaveGridTile Option
+	 *
+	 * Number of horizontal cells on each side of the tiles of the
+	 * WAVES_FFT_GRID and WAVES_GRID modes. The tiles are generated on demand,
+	 * when a node enters them, so the regions of the grid never visited do
+	 * not take memory. 0 to compute the whole grid at the start
+	 */
+	unsigned int gridTile;
+	/**
+	 * WaveGridTileLife Option
+	 *
+	 * Time, in seconds, without being visited before a tile is dropped. 0
+	 * to never drop the tiles
+	 */
+	double gridTileLife;
 
 	/**
 	 * @brief Construct a new Water Kin Options object with default values
@@ -93,6 +171,13 @@ struct WaterKinOptions
 	  , currentMode(CURRENTS_NONE)
 	  , unifyCurrentGrid(true)
 	  , dtWave(0.25)
+	  , cacheMode(WAVES_CACHE_NONE)
+	  , phasorTol(0.0)
+	  , phasorSync(1000)
+	  , singleGrid(false)
+	  , gridWindow(0)
+	  , gridTile(0)
+	  , gridTileLife(0.0)
 	{
 	}
 };
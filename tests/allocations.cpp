@@ -0,0 +1,226 @@
+/*
+ * Copyright (c) 2023, Jose Luis Cercos-Pita & Matt Hall
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ * 1. Redistributions of source code must retain the above copyright notice,
+ *    this list of conditions and the following disclaimer.
+ *
+ * 2. Redistributions in binary form must reproduce the above copyright notice,
+ *    this list of conditions and the following disclaimer in the documentation
+ *    and/or other materials provided with the distribution.
+ *
+ * 3. Neither the name of the copyright holder nor the names of its
+ *    contributors may be used to endorse or promote products derived from
+ *    this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE
+ * LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ * INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+ * CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ */
+
+/** @file allocations.cpp
+ * Check that the time integration is not allocating memory once the
+ * simulation is running
+ *
+ * Both the C++ operator new and, where possible, the C malloc family are
+ * counted, since Eigen dynamic arrays are allocated with the latter
+ */
+
+#include <atomic>
+#include <cerrno>
+#include <cstdlib>
+#include <new>
+#include <string>
+#include "MoorDyn2.h"
+#include <catch2/catch_test_macros.hpp>
+#include <catch2/generators/catch_generators.hpp>
+
+/// Number of heap allocations carried out so far
+static std::atomic<unsigned long> n_allocs(0);
+
+#if defined(__GLIBC__)
+// On glibc the malloc family can be interposed from the executable, so the
+// allocations carried out inside the MoorDyn library, e.g. by Eigen, are
+// also counted. The actual allocations are delegated to the glibc
+// implementation
+extern "C"
+{
+	void* __libc_malloc(std::size_t size);
+	void* __libc_calloc(std::size_t n, std::size_t size);
+	void* __libc_realloc(void* ptr, std::size_t size);
+	void* __libc_memalign(std::size_t alignment, std::size_t size);
+
+	void*
+	malloc(std::size_t size)
+	{
+		n_allocs++;
+		return __libc_malloc(size);
+	}
+
+	void*
+	calloc(std::size_t n, std::size_t size)
+	{
+		n_allocs++;
+		return __libc_calloc(n, size);
+	}
+
+	void*
+	realloc(void* ptr, std::size_t size)
+	{
+		n_allocs++;
+		return __libc_realloc(ptr, size);
+	}
+
+	void*
+	aligned_alloc(std::size_t alignment, std::size_t size)
+	{
+		n_allocs++;
+		return __libc_memalign(alignment, size);
+	}
+
+	int
+	posix_memalign(void** ptr, std::size_t alignment, std::size_t size)
+	{
+		n_allocs++;
+		*ptr = __libc_memalign(alignment, size);
+		return *ptr ? 0 : ENOMEM;
+	}
+}
+#endif
+
+void*
+operator new(std::size_t size)
+{
+	n_allocs++;
+	if (void* ptr = std::malloc(size ? size : 1))
+		return ptr;
+	throw std::bad_alloc();
+}
+
+void*
+operator new[](std::size_t size)
+{
+	n_allocs++;
+	if (void* ptr = std::malloc(size ? size : 1))
+		return ptr;
+	throw std::bad_alloc();
+}
+
+void
+operator delete(void* ptr) noexcept
+{
+	std::free(ptr);
+}
+
+void
+operator delete[](void* ptr) noexcept
+{
+	std::free(ptr);
+}
+
+void
+operator delete(void* ptr, std::size_t) noexcept
+{
+	std::free(ptr);
+}
+
+void
+operator delete[](void* ptr, std::size_t) noexcept
+{
+	std::free(ptr);
+}
+
+TEST_CASE("No allocations on the time steps")
+{
+	const std::string scheme = GENERATE("Euler",
+	                                    "Heun",
+	                                    "RK2",
+	                                    "RK4",
+	                                    "RK23",
+	                                    "RK45",
+	                                    "MRK2",
+	                                    "AB4",
+	                                    "LAB4",
+	                                    "BEuler5",
+	                                    "Midpoint5",
+	                                    "Newton5",
+	                                    "Anderson5",
+	                                    "ACA5",
+	                                    "Wilson5");
+	INFO("Time scheme: " << scheme);
+
+	MoorDyn system = MoorDyn_Create("Mooring/lines.txt");
+	REQUIRE(system);
+	REQUIRE(MoorDyn_SetTimeScheme(system, scheme.c_str()) == MOORDYN_SUCCESS);
+
+	unsigned int n_dof;
+	REQUIRE(MoorDyn_NCoupledDOF(system, &n_dof) == MOORDYN_SUCCESS);
+	REQUIRE(n_dof == 9);
+	double x[9], dx[9], f[9];
+	for (unsigned int i = 0; i < 3; i++) {
+		auto point = MoorDyn_GetPoint(system, i + 4);
+		REQUIRE(point);
+		REQUIRE(MoorDyn_GetPointPos(point, x + 3 * i) == MOORDYN_SUCCESS);
+	}
+	std::fill(dx, dx + 9, 0.0);
+	REQUIRE(MoorDyn_Init_NoIC(system, x, dx) == MOORDYN_SUCCESS);
+
+	// Some steps to let the time scheme allocate whatever it needs
+	double t = 0.0, dt = 0.01;
+	for (unsigned int i = 0; i < 10; i++)
+		REQUIRE(MoorDyn_Step(system, x, dx, f, &t, &dt) == MOORDYN_SUCCESS);
+
+	// Now the allocations are just counted, to avoid the ones triggered by
+	// Catch2 itself
+	int err = MOORDYN_SUCCESS;
+	const unsigned long n0 = n_allocs;
+	for (unsigned int i = 0; (i < 10) && (err == MOORDYN_SUCCESS); i++)
+		err = MoorDyn_Step(system, x, dx, f, &t, &dt);
+	const unsigned long n1 = n_allocs;
+	REQUIRE(err == MOORDYN_SUCCESS);
+	REQUIRE(n1 == n0);
+
+	REQUIRE(MoorDyn_Close(system) == MOORDYN_SUCCESS);
+}
+
+TEST_CASE("No allocations on the threaded time steps")
+{
+	// Lines and rods, so the pool is alternating different sets of tasks
+	MoorDyn system = MoorDyn_Create("Mooring/local_euler/complex_system.txt");
+	REQUIRE(system);
+	REQUIRE(MoorDyn_SetThreads(system, 4) == MOORDYN_SUCCESS);
+	// The local Euler scheme is masking different entities on each step, so
+	// a fixed set of entities is considered instead
+	REQUIRE(MoorDyn_SetTimeScheme(system, "RK2") == MOORDYN_SUCCESS);
+
+	double x[3], dx[3], f[3];
+	auto point = MoorDyn_GetPoint(system, 4);
+	REQUIRE(point);
+	REQUIRE(MoorDyn_GetPointPos(point, x) == MOORDYN_SUCCESS);
+	std::fill(dx, dx + 3, 0.0);
+	REQUIRE(MoorDyn_Init(system, x, dx) == MOORDYN_SUCCESS);
+
+	double t = 0.0, dt = 0.01;
+	for (unsigned int i = 0; i < 10; i++)
+		REQUIRE(MoorDyn_Step(system, x, dx, f, &t, &dt) == MOORDYN_SUCCESS);
+
+	int err = MOORDYN_SUCCESS;
+	const unsigned long n0 = n_allocs;
+	for (unsigned int i = 0; (i < 10) && (err == MOORDYN_SUCCESS); i++)
+		err = MoorDyn_Step(system, x, dx, f, &t, &dt);
+	const unsigned long n1 = n_allocs;
+	REQUIRE(err == MOORDYN_SUCCESS);
+	REQUIRE(n1 == n0);
+
+	REQUIRE(MoorDyn_Close(system) == MOORDYN_SUCCESS);
+}
@@ -414,6 +414,21 @@ main(int narg, char** arg)
 		printf("MoorDyn_GetLineMaxTen() test failed...");
 		return 255;
 	}
+	ret_code = MoorDyn_GetLineFatigueBins(NULL, &un);
+	if (ret_code != MOORDYN_INVALID_VALUE) {
+		printf("MoorDyn_GetLineFatigueBins() test failed...");
+		return 255;
+	}
+	ret_code = MoorDyn_GetLineSegFatigueHist(NULL, 0, &d, &d);
+	if (ret_code != MOORDYN_INVALID_VALUE) {
+		printf("MoorDyn_GetLineSegFatigueHist() test failed...");
+		return 255;
+	}
+	ret_code = MoorDyn_GetLineSegFatigueDamage(NULL, 0, &d, &d);
+	if (ret_code != MOORDYN_INVALID_VALUE) {
+		printf("MoorDyn_GetLineSegFatigueDamage() test failed...");
+		return 255;
+	}
 	ret_code = MoorDyn_SaveLineVTK(NULL, "nofile");
 	if (ret_code != MOORDYN_INVALID_VALUE && ret_code != MOORDYN_NON_IMPLEMENTED) {
 		printf("MoorDyn_SaveLineVTK() test failed...");
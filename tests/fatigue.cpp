@@ -0,0 +1,204 @@
+/*
+ * Copyright (c) 2023, Jose Luis Cercos-Pita & Matt Hall
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ * 1. Redistributions of source code must retain the above copyright notice,
+ *    this list of conditions and the following disclaimer.
+ *
+ * 2. Redistributions in binary form must reproduce the above copyright notice,
+ *    this list of conditions and the following disclaimer in the documentation
+ *    and/or other materials provided with the distribution.
+ *
+ * 3. Neither the name of the copyright holder nor the names of its
+ *    contributors may be used to endorse or promote products derived from
+ *    this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE
+ * LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ * INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+ * CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ */
+
+
+/** @file fatigue.cpp
+ * Tests on the streaming rainflow counting of the lines tensions
+ */
+
+#define _USE_MATH_DEFINES
+#include <cmath>
+#include <fstream>
+#include <filesystem>
+#include <numeric>
+#include <vector>
+#include "MoorDyn2.h"
+#include "Util/Rainflow.hpp"
+#include <catch2/catch_test_macros.hpp>
+
+namespace fs = std::filesystem;
+
+TEST_CASE("Rainflow counting of the ASTM E1049 example")
+{
+	// The reversals of the ASTM E1049 example, shifted to get a positive
+	// signal, i.e. -2, 1, -3, 5, -1, 3, -4, 4, -2
+	const std::vector<double> reversals = { 3, 6, 2, 10, 4, 8, 1, 9, 3 };
+	moordyn::Rainflow rf(16, 3.0, 1.0, 1.0);
+	// Some samples in between, which are not reversals
+	for (unsigned int i = 0; i + 1 < reversals.size(); i++)
+		for (unsigned int j = 0; j < 4; j++)
+			rf.add(reversals[i] + 0.25 * j * (reversals[i + 1] - reversals[i]));
+	rf.add(reversals.back());
+
+	// Ranges of 3 (0.5 cycles), 4 (1.5 cycles), 6 (0.5 cycles), 8 (1 cycle)
+	// and 9 (0.5 cycles)
+	REQUIRE(rf.cycles() == 4.0);
+	REQUIRE(std::abs(rf.damage() - 1094.0) < 1e-9);
+
+	// The bin width is the smallest power of 2 fitting the maximum value
+	REQUIRE(rf.binWidth() == 1.0);
+	std::vector<double> hist(16 * 16);
+	rf.histogram(hist.data());
+	REQUIRE(std::accumulate(hist.begin(), hist.end(), 0.0) == 4.0);
+	// The full cycle 4-8, and the half cycle 6-2
+	REQUIRE(hist[4 * 16 + 6] == 1.0);
+	REQUIRE(hist[4 * 16 + 4] == 0.5);
+	// The half cycles 3-6, 10-1 and 9-3
+	REQUIRE(hist[3 * 16 + 4] == 0.5);
+	REQUIRE(hist[9 * 16 + 5] == 0.5);
+	REQUIRE(hist[6 * 16 + 6] == 0.5);
+
+	// Querying the results is not modifying the counting
+	REQUIRE(rf.cycles() == 4.0);
+	rf.add(11.0);
+	REQUIRE(rf.binWidth() == 1.0);
+	rf.add(16.0);
+	REQUIRE(rf.binWidth() == 2.0);
+	rf.histogram(hist.data());
+	REQUIRE(std::accumulate(hist.begin(), hist.end(), 0.0) == rf.cycles());
+}
+
+TEST_CASE("Rainflow counting of the segment tensions")
+{
+	MoorDyn system = MoorDyn_Create("Mooring/output/output_fatigue.txt");
+	REQUIRE(system);
+	double x[9], dx[9], f[9];
+	for (unsigned int i = 0; i < 3; i++) {
+		auto point = MoorDyn_GetPoint(system, i + 4);
+		REQUIRE(point);
+		REQUIRE(MoorDyn_GetPointPos(point, x + 3 * i) == MOORDYN_SUCCESS);
+	}
+	std::fill(dx, dx + 9, 0.0);
+	REQUIRE(MoorDyn_Init_NoIC(system, x, dx) == MOORDYN_SUCCESS);
+
+	// Some oscillations of the fairlead
+	const double x0 = x[0], T = 1.0, A = 0.5;
+	double t = 0.0, dt = 0.05;
+	for (unsigned int i = 0; i < 60; i++) {
+		const double w = 2.0 * M_PI / T;
+		x[0] = x0 + A * sin(w * (t + dt));
+		dx[0] = A * w * cos(w * (t + dt));
+		REQUIRE(MoorDyn_Step(system, x, dx, f, &t, &dt) == MOORDYN_SUCCESS);
+	}
+
+	unsigned int bins;
+	REQUIRE(MoorDyn_GetLineFatigueBins(MoorDyn_GetLine(system, 2), &bins) ==
+	        MOORDYN_SUCCESS);
+	REQUIRE(bins == 0);
+	MoorDynLine line = MoorDyn_GetLine(system, 1);
+	REQUIRE(MoorDyn_GetLineFatigueBins(line, &bins) == MOORDYN_SUCCESS);
+	REQUIRE(bins == 16);
+	unsigned int n;
+	REQUIRE(MoorDyn_GetLineN(line, &n) == MOORDYN_SUCCESS);
+	std::vector<double> hist(bins * bins);
+	double w, cycles, damage;
+	for (unsigned int i = 0; i < n; i++) {
+		INFO("Segment " << i);
+		REQUIRE(MoorDyn_GetLineSegFatigueHist(line, i, &w, hist.data()) ==
+		        MOORDYN_SUCCESS);
+		REQUIRE(MoorDyn_GetLineSegFatigueDamage(line, i, &cycles, &damage) ==
+		        MOORDYN_SUCCESS);
+		// At least the imposed oscillations
+		REQUIRE(cycles >= 3.0);
+		REQUIRE(damage > 0.0);
+		REQUIRE(w > 0.0);
+		REQUIRE(std::abs(std::accumulate(hist.begin(), hist.end(), 0.0) -
+		                 cycles) < 1e-9);
+	}
+	REQUIRE(MoorDyn_GetLineSegFatigueHist(line, n, &w, hist.data()) ==
+	        MOORDYN_INVALID_VALUE);
+
+	// The histograms are saved when MoorDyn is closed
+	REQUIRE(MoorDyn_Close(system) == MOORDYN_SUCCESS);
+	std::ifstream file("Mooring/output/output_fatigue_Line1.fatigue");
+	REQUIRE(file.is_open());
+	REQUIRE(!std::ifstream("Mooring/output/output_fatigue_Line2.fatigue"));
+	// "F" is the only output flag of the line, so there is no output file
+	REQUIRE(!std::ifstream("Mooring/output/output_fatigue_Line1.out"));
+}
+
+TEST_CASE("Rainflow counting resumed after saving and loading")
+{
+	MoorDyn system = MoorDyn_Create("Mooring/output/output_fatigue.txt");
+	REQUIRE(system);
+	double x[9], dx[9], f[9];
+	for (unsigned int i = 0; i < 3; i++) {
+		auto point = MoorDyn_GetPoint(system, i + 4);
+		REQUIRE(point);
+		REQUIRE(MoorDyn_GetPointPos(point, x + 3 * i) == MOORDYN_SUCCESS);
+	}
+	std::fill(dx, dx + 9, 0.0);
+	REQUIRE(MoorDyn_Init_NoIC(system, x, dx) == MOORDYN_SUCCESS);
+
+	const double x0 = x[0], T = 1.0, A = 0.5;
+	double t = 0.0, dt = 0.05;
+	for (unsigned int i = 0; i < 30; i++) {
+		const double w = 2.0 * M_PI / T;
+		x[0] = x0 + A * sin(w * (t + dt));
+		dx[0] = A * w * cos(w * (t + dt));
+		REQUIRE(MoorDyn_Step(system, x, dx, f, &t, &dt) == MOORDYN_SUCCESS);
+	}
+
+	const std::string filepath =
+	    (fs::temp_directory_path() / "fatigue.moordyn").string();
+	REQUIRE(MoorDyn_Save(system, filepath.c_str()) == MOORDYN_SUCCESS);
+
+	MoorDyn system2 = MoorDyn_Create("Mooring/output/output_fatigue.txt");
+	REQUIRE(system2);
+	REQUIRE(MoorDyn_Init_NoIC(system2, x, dx) == MOORDYN_SUCCESS);
+	REQUIRE(MoorDyn_Load(system2, filepath.c_str()) == MOORDYN_SUCCESS);
+
+	MoorDynLine line = MoorDyn_GetLine(system, 1);
+	MoorDynLine line2 = MoorDyn_GetLine(system2, 1);
+	unsigned int n, bins;
+	REQUIRE(MoorDyn_GetLineN(line, &n) == MOORDYN_SUCCESS);
+	REQUIRE(MoorDyn_GetLineFatigueBins(line, &bins) == MOORDYN_SUCCESS);
+	std::vector<double> hist(bins * bins), hist2(bins * bins);
+	double w, w2, cycles, cycles2, damage, damage2;
+	for (unsigned int i = 0; i < n; i++) {
+		INFO("Segment " << i);
+		REQUIRE(MoorDyn_GetLineSegFatigueDamage(line, i, &cycles, &damage) ==
+		        MOORDYN_SUCCESS);
+		REQUIRE(MoorDyn_GetLineSegFatigueDamage(
+		            line2, i, &cycles2, &damage2) == MOORDYN_SUCCESS);
+		REQUIRE(cycles > 0.0);
+		REQUIRE(cycles2 == cycles);
+		REQUIRE(damage2 == damage);
+		REQUIRE(MoorDyn_GetLineSegFatigueHist(line, i, &w, hist.data()) ==
+		        MOORDYN_SUCCESS);
+		REQUIRE(MoorDyn_GetLineSegFatigueHist(line2, i, &w2, hist2.data()) ==
+		        MOORDYN_SUCCESS);
+		REQUIRE(w2 == w);
+		REQUIRE(hist2 == hist);
+	}
+
+	REQUIRE(MoorDyn_Close(system) == MOORDYN_SUCCESS);
+	REQUIRE(MoorDyn_Close(system2) == MOORDYN_SUCCESS);
+}
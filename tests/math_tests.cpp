@@ -2,6 +2,10 @@
 #include <sstream>
 
 #include "Misc.hpp"
+#include "MoorDyn2.h"
+#include "Line.hpp"
+#include "Util/Interp.hpp"
+#include "Util/Grid4D.hpp"
 #include <catch2/catch_test_macros.hpp>
 #include "catch2/catch_tostring.hpp"
 #include "catch2/matchers/catch_matchers_templated.hpp"
@@ -211,3 +215,175 @@ TEST_CASE("rotateMass simple")
 
 	REQUIRE_THAT(acc, IsClose(expectedAcc));
 }
+
+TEST_CASE("solveNodeMass matches the 3x3 inverse")
+{
+	const md::real rho_w = 1025.0;
+	const md::real Can = 0.865;
+	const md::real Cat = 0.269;
+	const mat I = mat::Identity();
+
+	std::srand(42);
+	for (unsigned int i = 0; i < 100; i++) {
+		vec q = vec::Random();
+		if (i % 10)
+			q.normalize();
+		else if (i == 0)
+			q = vec::Zero(); // A line node without tangent yet
+		const md::real m = 1.0 + std::rand() * 100.0 / RAND_MAX;
+		const md::real v = std::rand() * 0.1 / RAND_MAX;
+		const vec f = 1000.0 * vec::Random();
+
+		// The mass matrix as it was built originally on Line
+		const mat Q = q * q.transpose();
+		const mat M = m * I + rho_w * v * (Can * (I - Q) + Cat * Q);
+
+		const md::real a = m + rho_w * v * Can;
+		const md::real b = rho_w * v * (Cat - Can);
+		REQUIRE_THAT(nodeMassMatrix(a, b, q), IsClose(M));
+		REQUIRE_THAT(solveNodeMass(a, b, q, f), IsClose(vec(M.inverse() * f)));
+	}
+}
+
+TEST_CASE("Line node accelerations match the 3x3 inverse")
+{
+	// Properties of Mooring/node_mass.txt
+	const md::real rho_w = 1025.0;
+	const md::real depth = 50.0;
+	const md::real d = 0.1;
+	const md::real mass_l = 20.0;
+	const md::real Can = 1.0;
+	const md::real Cat = 0.5;
+	const md::real len = 150.0 / 30;
+	const md::real A = 0.25 * md::pi * d * d;
+	const mat I = mat::Identity();
+
+	MoorDyn system = MoorDyn_Create("Mooring/node_mass.txt");
+	REQUIRE(system);
+	REQUIRE(MoorDyn_Init_NoIC(system, NULL, NULL) == MOORDYN_SUCCESS);
+	// Let the line lie down on the seabed
+	double t = 0.0, dt = 0.5;
+	REQUIRE(MoorDyn_Step(system, NULL, NULL, NULL, &t, &dt) ==
+	        MOORDYN_SUCCESS);
+
+	auto l = MoorDyn_GetLine(system, 1);
+	REQUIRE(l);
+	// The C API handlers are the actual instances
+	auto line = (md::Line*)l;
+	const unsigned int N = line->getN();
+	Eigen::Matrix3Xr vel(3, N - 1), acc(3, N - 1);
+	line->getStateDeriv(vel, acc);
+
+	unsigned int n_dry = 0, n_wet = 0, n_seabed = 0;
+	for (unsigned int i = 1; i < N; i++) {
+		const vec r = line->getNodePos(i);
+		const md::real z_a = line->getNodePos(i - 1)[2];
+		const md::real z_b = line->getNodePos(i + 1)[2];
+		// Build the mass matrix as it was built originally on Line, just on
+		// the nodes whose adjacent segments are completely dry or wet
+		md::real v;
+		if ((z_a > 0.0) && (r[2] > 0.0) && (z_b > 0.0)) {
+			v = 0.0;
+			n_dry++;
+		} else if ((z_a < -d) && (r[2] < -d) && (z_b < -d)) {
+			v = A * len;
+			n_wet++;
+			if (r[2] < -depth) {
+				REQUIRE(line->getNodeSeabedForce(i)[2] > 0.0);
+				n_seabed++;
+			}
+		} else
+			continue;
+		const vec q = (line->getNodePos(i + 1) - line->getNodePos(i - 1))
+		                  .normalized();
+		const mat Q = q * q.transpose();
+		const mat M =
+		    mass_l * len * I + rho_w * v * (Can * (I - Q) + Cat * Q);
+		REQUIRE_THAT(line->getNodeM(i), IsClose(M));
+		// And compare the accelerations computed by the kernel
+		const vec f = line->getNodeForce(i);
+		REQUIRE_THAT(vec(acc.col(i - 1)), IsClose(vec(M.inverse() * f)));
+	}
+	REQUIRE(n_dry > 0);
+	REQUIRE(n_wet > 0);
+	REQUIRE(n_seabed > 0);
+
+	REQUIRE(MoorDyn_Close(system) == MOORDYN_SUCCESS);
+}
+
+TEST_CASE("InterpAxis matches the linear search")
+{
+	const std::vector<md::real> uniform = { -2.0, -1.0, 0.0, 1.0, 2.0, 3.0 };
+	const std::vector<md::real> stretched = { -50.0, -20.0, -8.0, -3.0,
+		                                      -1.0,  0.0,   0.5 };
+	const std::vector<md::real> single = { 1.0 };
+
+	std::srand(42);
+	for (const auto& xp : { uniform, stretched, single }) {
+		const InterpAxis axis(xp);
+		if (xp.size() > 1)
+			REQUIRE(axis.uniform() == (xp == uniform));
+		unsigned int hint = 0;
+		for (unsigned int i = 0; i < 1000; i++) {
+			// Include points out of bounds and on top of the grid points
+			md::real x = xp.front() - 1.0 +
+			             (xp.back() - xp.front() + 2.0) * std::rand() /
+			                 RAND_MAX;
+			if (i % 10 == 0)
+				x = xp[i % xp.size()];
+			md::real f_ref, f, f_hint;
+			const auto j_ref = interp_factor(xp, 1, x, f_ref);
+			REQUIRE(axis.factor(x, f) == j_ref);
+			REQUIRE(f == f_ref);
+			REQUIRE(axis.factor(x, hint, f_hint) == j_ref);
+			REQUIRE(hint == j_ref);
+			REQUIRE(f_hint == f_ref);
+		}
+	}
+}
+
+TEST_CASE("Grid4D interpolation matches interp4")
+{
+	const unsigned int nx = 3, ny = 4, nz = 5, nt = 6;
+	std::vector<std::vector<std::vector<std::vector<md::real>>>> ref(
+	    nx,
+	    std::vector<std::vector<std::vector<md::real>>>(
+	        ny,
+	        std::vector<std::vector<md::real>>(nz,
+	                                           std::vector<md::real>(nt))));
+	Grid4D<4> grid, grid_single;
+	grid.resize(nx, ny, nz, nt);
+	grid_single.resize(nx, ny, nz, nt, true);
+	REQUIRE(grid.bytes() == 2 * grid_single.bytes());
+
+	std::srand(42);
+	for (unsigned int i = 0; i < nx; i++)
+		for (unsigned int j = 0; j < ny; j++)
+			for (unsigned int k = 0; k < nz; k++)
+				for (unsigned int w = 0; w < nt; w++) {
+					const md::real v = std::rand() * 1.0 / RAND_MAX;
+					ref[i][j][k][w] = v;
+					// The rest of components shall not leak into the tested one
+					grid.set(i, j, k, w, 2, v);
+					grid.set(i, j, k, w, 1, 10.0);
+					grid.set(i, j, k, w, 3, -10.0);
+					grid_single.set(i, j, k, w, 2, v);
+					REQUIRE(grid.get(i, j, k, w, 2) == v);
+				}
+
+	for (unsigned int n = 0; n < 100; n++) {
+		const unsigned int i = std::rand() % nx, j = std::rand() % ny;
+		const unsigned int k = std::rand() % nz, w = std::rand() % nt;
+		const md::real fx = std::rand() * 1.0 / RAND_MAX;
+		const md::real fy = std::rand() * 1.0 / RAND_MAX;
+		const md::real fz = std::rand() * 1.0 / RAND_MAX;
+		const md::real fw = std::rand() * 1.0 / RAND_MAX;
+		const md::real v = interp4(ref, i, j, k, w, fx, fy, fz, fw);
+		md::real out[4], out_single[4];
+		grid.interp(i, j, k, w, fx, fy, fz, fw, out);
+		grid_single.interp(i, j, k, w, fx, fy, fz, fw, out_single);
+		REQUIRE(fabs(out[2] - v) < 1e-12);
+		REQUIRE(fabs(out[1] - 10.0) < 1e-12);
+		REQUIRE(fabs(out_single[2] - v) < 1e-6);
+	}
+}
@@ -0,0 +1,123 @@
+/*
+ * Copyright (c) 2023, Jose Luis Cercos-Pita & Matt Hall
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ * 1. Redistributions of source code must retain the above copyright notice,
+ *    this list of conditions and the following disclaimer.
+ *
+ * 2. Redistributions in binary form must reproduce the above copyright notice,
+ *    this list of conditions and the following disclaimer in the documentation
+ *    and/or other materials provided with the distribution.
+ *
+ * 3. Neither the name of the copyright holder nor the names of its
+ *    contributors may be used to endorse or promote products derived from
+ *    this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE
+ * LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ * INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+ * CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ */
+
+/** @file multirate.cpp
+ * Check that the multirate scheme integrates each line with its own number of
+ * substeps, and that the results match the single rate scheme
+ */
+
+#include <cmath>
+#include <vector>
+#include "MoorDyn2.h"
+#include "MoorDyn2.hpp"
+#include "Time.hpp"
+#include <catch2/catch_test_macros.hpp>
+
+/// Relative tolerance on the node positions, with respect to the line length
+#define MULTIRATE_TOL 1e-5
+
+/// Number of lines on Mooring/multirate.txt
+#define N_LINES 3
+
+/** @brief Move the vessel for a while
+ * @param tscheme The time scheme
+ * @param substeps If not NULL, the number of substeps of each line on each
+ * time step is checked
+ * @return The nodes positions of each line
+ */
+std::vector<std::vector<double>>
+run(const char* tscheme, const unsigned int* substeps = NULL)
+{
+	MoorDyn system = MoorDyn_Create("Mooring/multirate.txt");
+	REQUIRE(system);
+	REQUIRE(MoorDyn_SetTimeScheme(system, tscheme) == MOORDYN_SUCCESS);
+
+	double x[3], dx[3], f[3];
+	auto point = MoorDyn_GetPoint(system, 4);
+	REQUIRE(point);
+	REQUIRE(MoorDyn_GetPointPos(point, x) == MOORDYN_SUCCESS);
+	std::fill(dx, dx + 3, 0.0);
+	REQUIRE(MoorDyn_Init_NoIC(system, x, dx) == MOORDYN_SUCCESS);
+
+	// The coupling time step is smaller than the natural time step of the
+	// coarser line, so it is also the time step of the multirate scheme
+	double t = 0.0, dt = 0.0025;
+	dx[0] = 1.0;
+	for (unsigned int i = 0; i < 400; i++) {
+		x[0] += dx[0] * dt;
+		REQUIRE(MoorDyn_Step(system, x, dx, f, &t, &dt) == MOORDYN_SUCCESS);
+		if (!substeps)
+			continue;
+		auto tscheme = dynamic_cast<moordyn::MultirateRK2Scheme*>(
+		    ((moordyn::MoorDyn*)system)->GetTimeScheme());
+		REQUIRE(tscheme);
+		for (unsigned int j = 0; j < N_LINES; j++)
+			REQUIRE(tscheme->GetLineSubsteps(j) == substeps[j]);
+	}
+
+	std::vector<std::vector<double>> pos;
+	for (unsigned int i = 0; i < N_LINES; i++) {
+		auto line = MoorDyn_GetLine(system, i + 1);
+		REQUIRE(line);
+		unsigned int n;
+		REQUIRE(MoorDyn_GetLineNumberNodes(line, &n) == MOORDYN_SUCCESS);
+		pos.push_back(std::vector<double>(3 * n));
+		for (unsigned int j = 0; j < n; j++) {
+			REQUIRE(MoorDyn_GetLineNodePos(line, j, pos.back().data() + 3 * j) ==
+			        MOORDYN_SUCCESS);
+		}
+	}
+
+	REQUIRE(MoorDyn_Close(system) == MOORDYN_SUCCESS);
+	return pos;
+}
+
+TEST_CASE("Multirate matches RK2 at the finest time step")
+{
+	// The time step of the lines is proportional to their segments length,
+	// so the lines with 20, 35 and 70 segments take 1, 2 and 4 substeps
+	const unsigned int substeps[N_LINES] = { 1, 2, 4 };
+	const auto pos_mrk2 = run("MRK2", substeps);
+	const auto pos_rk2 = run("RK2");
+
+	const double l = 350.0;
+	for (unsigned int i = 0; i < N_LINES; i++) {
+		REQUIRE(pos_mrk2[i].size() == pos_rk2[i].size());
+		double error = 0.0;
+		for (unsigned int j = 0; j < pos_rk2[i].size(); j += 3) {
+			const double e_x = pos_mrk2[i][j] - pos_rk2[i][j];
+			const double e_y = pos_mrk2[i][j + 1] - pos_rk2[i][j + 1];
+			const double e_z = pos_mrk2[i][j + 2] - pos_rk2[i][j + 2];
+			error = (std::max)(error, sqrt(e_x * e_x + e_y * e_y + e_z * e_z));
+		}
+		INFO("Line " << i + 1 << ": error = " << error);
+		REQUIRE(error / l <= MULTIRATE_TOL);
+	}
+}
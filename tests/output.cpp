@@ -0,0 +1,430 @@
+/*
+ * Copyright (c) 2023, Jose Luis Cercos-Pita & Matt Hall
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ * 1. Redistributions of source code must retain the above copyright notice,
+ *    this list of conditions and the following disclaimer.
+ *
+ * 2. Redistributions in binary form must reproduce the above copyright notice,
+ *    this list of conditions and the following disclaimer in the documentation
+ *    and/or other materials provided with the distribution.
+ *
+ * 3. Neither the name of the copyright holder nor the names of its
+ *    contributors may be used to endorse or promote products derived from
+ *    this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE
+ * LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ * INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+ * CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ */
+
+
+/** @file output.cpp
+ * Tests on the output files formats
+ */
+
+#include <algorithm>
+#include <cmath>
+#include <cstdint>
+#include <cstring>
+#include <fstream>
+#include <sstream>
+#include <string>
+#include <vector>
+#include "MoorDyn2.h"
+#include "Util/OutputStats.hpp"
+#include <catch2/catch_test_macros.hpp>
+
+/// The contents of an output file
+typedef struct _output_data
+{
+	/// The channel names
+	std::vector<std::string> names;
+	/// The channel units
+	std::vector<std::string> units;
+	/// The records
+	std::vector<std::vector<double>> records;
+} output_data;
+
+/** @brief Run a short simulation
+ * @param filepath The input file
+ */
+void
+run(const char* filepath)
+{
+	MoorDyn system = MoorDyn_Create(filepath);
+	REQUIRE(system);
+	double x[9], dx[9], f[9];
+	for (unsigned int i = 0; i < 3; i++) {
+		auto point = MoorDyn_GetPoint(system, i + 4);
+		REQUIRE(point);
+		REQUIRE(MoorDyn_GetPointPos(point, x + 3 * i) == MOORDYN_SUCCESS);
+	}
+	std::fill(dx, dx + 9, 0.0);
+	REQUIRE(MoorDyn_Init_NoIC(system, x, dx) == MOORDYN_SUCCESS);
+	double t = 0.0, dt = 0.01;
+	for (unsigned int i = 0; i < 10; i++) {
+		x[0] += 0.01;
+		REQUIRE(MoorDyn_Step(system, x, dx, f, &t, &dt) == MOORDYN_SUCCESS);
+	}
+	REQUIRE(MoorDyn_Close(system) == MOORDYN_SUCCESS);
+}
+
+/** @brief Read a text output file
+ * @param filepath The output file
+ * @return The file contents
+ */
+output_data
+read_text(const std::string& filepath)
+{
+	output_data data;
+	std::ifstream f(filepath);
+	REQUIRE(f.is_open());
+	std::string line, word;
+	std::getline(f, line);
+	std::istringstream names(line);
+	while (names >> word)
+		data.names.push_back(word);
+	std::getline(f, line);
+	std::istringstream units(line);
+	while (units >> word)
+		data.units.push_back(word);
+	while (std::getline(f, line)) {
+		std::istringstream values(line);
+		std::vector<double> record;
+		double value;
+		while (values >> value)
+			record.push_back(value);
+		if (record.size())
+			data.records.push_back(record);
+	}
+	return data;
+}
+
+/** @brief Read a binary output file
+ * @param filepath The output file
+ * @param precision The expected number of bytes per value
+ * @return The file contents
+ */
+output_data
+read_binary(const std::string& filepath, uint32_t precision)
+{
+	output_data data;
+	std::ifstream f(filepath, std::ios::binary);
+	REQUIRE(f.is_open());
+	char magic[8];
+	uint32_t version, endian, bytes, n;
+	uint64_t offset;
+	f.read(magic, sizeof(magic));
+	REQUIRE(std::string(magic) == "MDOUT");
+	f.read((char*)&version, sizeof(version));
+	f.read((char*)&endian, sizeof(endian));
+	f.read((char*)&bytes, sizeof(bytes));
+	f.read((char*)&n, sizeof(n));
+	f.read((char*)&offset, sizeof(offset));
+	REQUIRE(version == 1);
+	REQUIRE(endian == 0x01020304);
+	REQUIRE(bytes == precision);
+	REQUIRE(offset % 64 == 0);
+	for (uint32_t i = 0; i < n; i++) {
+		int32_t ids[3];
+		uint32_t lengths[2];
+		f.read((char*)ids, sizeof(ids));
+		f.read((char*)lengths, sizeof(lengths));
+		std::string name(lengths[0], ' '), units(lengths[1], ' ');
+		f.read(name.data(), lengths[0]);
+		f.read(units.data(), lengths[1]);
+		data.names.push_back(name);
+		data.units.push_back(units);
+	}
+	REQUIRE((uint64_t)f.tellg() <= offset);
+	f.seekg(0, std::ios::end);
+	const uint64_t size = f.tellg();
+	REQUIRE((size - offset) % (n * bytes) == 0);
+	f.seekg(offset);
+	for (uint64_t i = 0; i < (size - offset) / (n * bytes); i++) {
+		std::vector<double> record(n);
+		for (uint32_t j = 0; j < n; j++) {
+			if (bytes == sizeof(float)) {
+				float v;
+				f.read((char*)&v, sizeof(v));
+				record[j] = v;
+			} else
+				f.read((char*)&record[j], sizeof(double));
+		}
+		data.records.push_back(record);
+	}
+	return data;
+}
+
+/** @brief Check that two output files have the same contents
+ * @param a The first file contents
+ * @param b The second file contents
+ * @param tol The relative tolerance
+ */
+void
+compare(const output_data& a, const output_data& b, double tol)
+{
+	REQUIRE(a.names == b.names);
+	REQUIRE(a.units == b.units);
+	REQUIRE(a.records.size() == b.records.size());
+	for (unsigned int i = 0; i < a.records.size(); i++) {
+		REQUIRE(a.records[i].size() == a.names.size());
+		REQUIRE(b.records[i].size() == b.names.size());
+		for (unsigned int j = 0; j < a.names.size(); j++) {
+			const double va = a.records[i][j], vb = b.records[i][j];
+			INFO(a.names[j] << " at record " << i << ": " << va << " vs. "
+			                << vb);
+			REQUIRE(std::abs(va - vb) <=
+			        tol * std::max(std::abs(va), 1.0));
+		}
+	}
+}
+
+TEST_CASE("Binary output files match the text ones")
+{
+	run("Mooring/output/output_text.txt");
+	run("Mooring/output/output_float32.txt");
+	run("Mooring/output/output_float64.txt");
+
+	for (auto name : { "", "_Line1" }) {
+		INFO("Output file: output_*" << name);
+		const std::string base = "Mooring/output/output_";
+		auto text = read_text(base + "text" + name + ".out");
+		REQUIRE(text.names.size() > 1);
+		REQUIRE(text.records.size() == 11);
+		// The text files have 6 significant digits
+		compare(text, read_binary(base + "float64" + name + ".bin", 8), 1e-5);
+		compare(text, read_binary(base + "float32" + name + ".bin", 4), 1e-5);
+	}
+}
+
+/** @brief Read a whole file
+ * @param filepath The file path
+ * @return The file contents
+ */
+std::string
+read_file(const std::string& filepath)
+{
+	std::ifstream f(filepath, std::ios::binary);
+	REQUIRE(f.is_open());
+	std::stringstream contents;
+	contents << f.rdbuf();
+	return contents.str();
+}
+
+TEST_CASE("The writer thread writes the same output files")
+{
+	run("Mooring/output/output_text.txt");
+	run("Mooring/output/output_async.txt");
+
+	for (auto name : { "", "_Line1" }) {
+		INFO("Output file: output_*" << name);
+		const std::string base = "Mooring/output/output_";
+		const std::string text = read_file(base + "text" + name + ".out");
+		REQUIRE(text.size());
+		REQUIRE(text == read_file(base + "async" + name + ".out"));
+	}
+}
+
+TEST_CASE("The compiled output channels match the API")
+{
+	MoorDyn system = MoorDyn_Create("Mooring/output/output_channels.txt");
+	REQUIRE(system);
+	double x[9], dx[9], f[9];
+	for (unsigned int i = 0; i < 3; i++) {
+		auto point = MoorDyn_GetPoint(system, i + 4);
+		REQUIRE(point);
+		REQUIRE(MoorDyn_GetPointPos(point, x + 3 * i) == MOORDYN_SUCCESS);
+	}
+	std::fill(dx, dx + 9, 0.0);
+	REQUIRE(MoorDyn_Init_NoIC(system, x, dx) == MOORDYN_SUCCESS);
+	double t = 0.0, dt = 0.01;
+	for (unsigned int i = 0; i < 10; i++) {
+		x[0] += 0.01;
+		dx[0] = 1.0;
+		REQUIRE(MoorDyn_Step(system, x, dx, f, &t, &dt) == MOORDYN_SUCCESS);
+	}
+
+	// The main output file is flushed on each time step
+	auto out = read_text("Mooring/output/output_channels.out");
+	REQUIRE(out.records.size() == 11);
+	const std::vector<double>& record = out.records.back();
+	REQUIRE(record.size() == 9);
+
+	auto norm = [](const double v[3]) {
+		return std::sqrt(v[0] * v[0] + v[1] * v[1] + v[2] * v[2]);
+	};
+	double v[3];
+	std::vector<double> expected = { t };
+	REQUIRE(MoorDyn_GetLineNodeForce(MoorDyn_GetLine(system, 1), 20, v) ==
+	        MOORDYN_SUCCESS);
+	expected.push_back(norm(v));
+	REQUIRE(MoorDyn_GetLineNodeForce(MoorDyn_GetLine(system, 2), 0, v) ==
+	        MOORDYN_SUCCESS);
+	expected.push_back(norm(v));
+	REQUIRE(MoorDyn_GetLineNodeTen(MoorDyn_GetLine(system, 1), 10, v) ==
+	        MOORDYN_SUCCESS);
+	expected.push_back(norm(v));
+	REQUIRE(MoorDyn_GetLineNodePos(MoorDyn_GetLine(system, 1), 5, v) ==
+	        MOORDYN_SUCCESS);
+	expected.push_back(v[0]);
+	REQUIRE(MoorDyn_GetLineNodeVel(MoorDyn_GetLine(system, 2), 20, v) ==
+	        MOORDYN_SUCCESS);
+	expected.push_back(v[2]);
+	REQUIRE(MoorDyn_GetLineNodeForce(MoorDyn_GetLine(system, 3), 0, v) ==
+	        MOORDYN_SUCCESS);
+	expected.push_back(v[1]);
+	REQUIRE(MoorDyn_GetPointForce(MoorDyn_GetPoint(system, 4), v) ==
+	        MOORDYN_SUCCESS);
+	expected.push_back(v[2]);
+	REQUIRE(MoorDyn_GetPointVel(MoorDyn_GetPoint(system, 5), v) ==
+	        MOORDYN_SUCCESS);
+	expected.push_back(v[0]);
+
+	for (unsigned int i = 0; i < record.size(); i++) {
+		INFO(out.names[i] << ": " << record[i] << " vs. " << expected[i]);
+		// The text files have 6 significant digits
+		REQUIRE(std::abs(record[i] - expected[i]) <=
+		        1e-5 * std::max(std::abs(expected[i]), 1.0));
+	}
+
+	REQUIRE(MoorDyn_Close(system) == MOORDYN_SUCCESS);
+}
+
+TEST_CASE("P2 quantiles estimation")
+{
+	moordyn::P2Quantile median(0.5), p95(0.95);
+	REQUIRE(std::isnan(median.get()));
+	// A deterministic, well spread, sequence on [0, 1)
+	for (unsigned int i = 0; i < 10000; i++) {
+		const double x = std::fmod(i * 0.6180339887498949, 1.0);
+		median.add(x);
+		p95.add(x);
+	}
+	REQUIRE(std::abs(median.get() - 0.5) < 0.01);
+	REQUIRE(std::abs(p95.get() - 0.95) < 0.01);
+}
+
+/// The contents of a statistics summary file
+typedef struct _stats_data
+{
+	/// The columns names
+	std::vector<std::string> columns;
+	/// The channel names
+	std::vector<std::string> names;
+	/// The numeric fields of each channel, from the object type onwards
+	std::vector<std::vector<double>> values;
+} stats_data;
+
+/** @brief Read a statistics summary file
+ * @param filepath The summary file
+ * @return The file contents
+ */
+stats_data
+read_stats(const std::string& filepath)
+{
+	stats_data data;
+	std::ifstream f(filepath);
+	REQUIRE(f.is_open());
+	std::string line, word;
+	std::getline(f, line);
+	std::istringstream columns(line);
+	while (columns >> word)
+		data.columns.push_back(word);
+	while (std::getline(f, line)) {
+		std::istringstream fields(line);
+		std::string name, units;
+		if (!(fields >> name >> units))
+			continue;
+		std::vector<double> values;
+		double value;
+		while (fields >> value)
+			values.push_back(value);
+		REQUIRE(values.size() + 2 == data.columns.size());
+		data.names.push_back(name);
+		data.values.push_back(values);
+	}
+	return data;
+}
+
+TEST_CASE("Statistics and decimated output files")
+{
+	run("Mooring/output/output_text.txt");
+	run("Mooring/output/output_stats.txt");
+	run("Mooring/output/output_stats_only.txt");
+
+	for (auto name : { "", "_Line1" }) {
+		INFO("Output file: output_*" << name);
+		const std::string base = "Mooring/output/output_";
+		auto text = read_text(base + "text" + name + ".out");
+		REQUIRE(text.records.size() == 11);
+
+		// The decimated time series just keeps one of every 5 records
+		auto decimated = read_text(base + "stats" + name + ".out");
+		REQUIRE(decimated.names == text.names);
+		REQUIRE(decimated.records.size() == 3);
+		for (unsigned int i = 0; i < decimated.records.size(); i++)
+			REQUIRE(decimated.records[i] == text.records[5 * i]);
+
+		// The time series is not even written on demand
+		REQUIRE(!std::ifstream(base + "stats_only" + name + ".out"));
+
+		// While the statistics are computed with all the records
+		for (auto suffix : { "stats", "stats_only" }) {
+			INFO("Statistics file: output_" << suffix << name);
+			auto stats = read_stats(base + suffix + name + ".stats");
+			REQUIRE(stats.names.size() + 1 == text.names.size());
+			for (unsigned int i = 0; i < stats.names.size(); i++) {
+				INFO("Channel " << stats.names[i]);
+				REQUIRE(stats.names[i] == text.names[i + 1]);
+				double mean = 0.0, m2 = 0.0;
+				double vmin = text.records[0][i + 1], vmax = vmin;
+				for (auto record : text.records) {
+					mean += record[i + 1] / text.records.size();
+					vmin = std::min(vmin, record[i + 1]);
+					vmax = std::max(vmax, record[i + 1]);
+				}
+				for (auto record : text.records)
+					m2 += (record[i + 1] - mean) * (record[i + 1] - mean);
+				const double std = std::sqrt(m2 / (text.records.size() - 1));
+
+				const std::vector<double>& v = stats.values[i];
+				const double scale =
+				    std::max({ std::abs(vmin), std::abs(vmax), 1.0 });
+				// The text files have 6 significant digits
+				REQUIRE(v[3] == text.records.size());
+				REQUIRE(std::abs(v[4] - mean) <= 1e-5 * scale);
+				REQUIRE(std::abs(v[5] - std) <= 1e-5 * scale);
+				REQUIRE(std::abs(v[6] - vmin) <= 1e-5 * scale);
+				REQUIRE(std::abs(v[8] - vmax) <= 1e-5 * scale);
+				// The text files may not tell apart the instants of the
+				// extreme values, so we just check the values at such instants
+				const unsigned int rmin = std::lround(v[7] / 0.01);
+				const unsigned int rmax = std::lround(v[9] / 0.01);
+				REQUIRE(rmin < text.records.size());
+				REQUIRE(rmax < text.records.size());
+				REQUIRE(std::abs(text.records[rmin][i + 1] - vmin) <=
+				        1e-5 * scale);
+				REQUIRE(std::abs(text.records[rmax][i + 1] - vmax) <=
+				        1e-5 * scale);
+				// The quantiles shall be sorted, between the extreme values
+				for (unsigned int j = 10; j < v.size(); j++) {
+					const double prev = (j == 10) ? v[6] : v[j - 1];
+					REQUIRE(v[j] >= prev - 1e-5 * scale);
+					REQUIRE(v[j] <= v[8] + 1e-5 * scale);
+				}
+			}
+		}
+	}
+}
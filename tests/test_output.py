@@ -0,0 +1,122 @@
+from unittest import TestCase, main as unittest_main
+import os
+import shutil
+import tempfile
+import numpy as np
+import moordyn
+
+
+def setup_case(names):
+    """Setup the output cases in a temporal folder
+
+    Parameters:
+    names (list): The input files in the "Mooring/output" subfolder
+
+    Returns:
+    str: The folder where the cases have been generated
+    """
+    tmp_folder = tempfile.mkdtemp()
+    # The inputs are loading the "Mooring/lines.txt.ic" initial condition
+    in_folder = os.path.join(os.path.dirname(__file__), "Mooring")
+    out_folder = os.path.join(tmp_folder, "Mooring")
+    os.makedirs(os.path.join(out_folder, "output"))
+    shutil.copy(os.path.join(in_folder, "lines.txt.ic"), out_folder)
+    for name in names:
+        shutil.copy(os.path.join(in_folder, "output", name),
+                    os.path.join(out_folder, "output"))
+    return tmp_folder
+
+
+def run(filepath):
+    """Run the same short simulation than tests/output.cpp
+
+    Parameters:
+    filepath (str): The input file
+    """
+    system = moordyn.Create(filepath)
+    x = []
+    for i in range(4, 7):
+        point = moordyn.GetPoint(system, i)
+        x = x + list(moordyn.GetPointPos(point))
+    v = [0, ] * 9
+    moordyn.Init_NoIC(system, x, v)
+    t, dt = 0.0, 0.01
+    for i in range(10):
+        x[0] += 0.01
+        moordyn.Step(system, x, v, t, dt)
+        t += dt
+    moordyn.Close(system)
+
+
+def read_text(filepath):
+    """Read a text output file
+
+    Parameters:
+    filepath (str): The output file
+
+    Returns:
+    list: The channel names
+    numpy.ndarray: The records
+    """
+    with open(filepath, "r") as f:
+        names = f.readline().split()
+    return names, np.loadtxt(filepath, skiprows=2, ndmin=2)
+
+
+class OutputTests(TestCase):
+    def setUp(self):
+        self.folder = setup_case(["output_text.txt",
+                                  "output_float32.txt",
+                                  "output_float64.txt",
+                                  "output_stats.txt"])
+        self.cwd = os.getcwd()
+        os.chdir(self.folder)
+
+    def tearDown(self):
+        os.chdir(self.cwd)
+        shutil.rmtree(self.folder)
+
+    def test_read_output(self):
+        run("Mooring/output/output_text.txt")
+        run("Mooring/output/output_float32.txt")
+        run("Mooring/output/output_float64.txt")
+        for name in ("", "_Line1"):
+            base = "Mooring/output/output_"
+            names, text = read_text(base + "text" + name + ".out")
+            self.assertEqual(text.shape[0], 11)
+            for fmt, dtype in (("float32", np.float32),
+                               ("float64", np.float64)):
+                data, channels = moordyn.read_output(
+                    base + fmt + name + ".bin")
+                self.assertEqual(data.dtype, dtype)
+                self.assertEqual([c["name"] for c in channels], names)
+                self.assertEqual(data.shape, text.shape)
+                # The text files have 6 significant digits
+                scale = np.maximum(np.abs(text), 1.0)
+                self.assertTrue(np.all(np.abs(data - text) <= 1e-5 * scale))
+                del data
+
+    def test_read_stats(self):
+        run("Mooring/output/output_text.txt")
+        run("Mooring/output/output_stats.txt")
+        for name in ("", "_Line1"):
+            base = "Mooring/output/output_"
+            names, text = read_text(base + "text" + name + ".out")
+            stats = moordyn.read_stats(base + "stats" + name + ".stats")
+            self.assertEqual([s["name"] for s in stats], names[1:])
+            for i, s in enumerate(stats):
+                values = text[:, i + 1]
+                scale = max(np.max(np.abs(values)), 1.0)
+                self.assertEqual(s["samples"], len(values))
+                self.assertLessEqual(abs(s["mean"] - np.mean(values)),
+                                     1e-5 * scale)
+                self.assertLessEqual(abs(s["std"] - np.std(values, ddof=1)),
+                                     1e-5 * scale)
+                self.assertLessEqual(abs(s["min"] - np.min(values)),
+                                     1e-5 * scale)
+                self.assertLessEqual(abs(s["max"] - np.max(values)),
+                                     1e-5 * scale)
+
+
+if __name__ == '__main__':
+    unittest_main()
@@ -0,0 +1,185 @@
+#include <cmath>
+#include <atomic>
+#include <fstream>
+#include <algorithm>
+#include <string>
+#include <thread>
+#include <stdexcept>
+#include <vector>
+#include "MoorDyn2.h"
+#include "Util/ThreadPool.hpp"
+#include <catch2/catch_test_macros.hpp>
+
+TEST_CASE("ThreadPool runs every task once")
+{
+	moordyn::ThreadPool pool(4);
+	REQUIRE(pool.GetThreads() == 4);
+
+	// Very unbalanced tasks
+	std::vector<moordyn::real> costs;
+	for (unsigned int i = 0; i < 300; i++)
+		costs.push_back((i % 10) ? 10.0 : 1000.0);
+	std::vector<std::atomic<unsigned int>> counter(costs.size());
+	for (unsigned int run = 0; run < 10; run++) {
+		pool.Run(costs, [&counter](unsigned int i) { counter[i]++; });
+	}
+	for (unsigned int i = 0; i < costs.size(); i++)
+		REQUIRE(counter[i] == 10);
+}
+
+TEST_CASE("ThreadPool forwards the exceptions")
+{
+	moordyn::ThreadPool pool(3);
+	std::vector<moordyn::real> costs(20, 1.0);
+	std::atomic<unsigned int> done(0);
+	REQUIRE_THROWS_AS(pool.Run(costs,
+	                           [&done](unsigned int i) {
+		                           if (i == 7)
+			                           throw moordyn::nan_error("task 7");
+		                           done++;
+	                           }),
+	                  moordyn::nan_error);
+	// The rest of the tasks shall be done anyway
+	REQUIRE(done == 19);
+	// And the pool shall be still usable
+	done = 0;
+	pool.Run(costs, [&done](unsigned int) { done++; });
+	REQUIRE(done == 20);
+}
+
+/** @brief Run the complex system, with lines and rods of very different sizes
+ * @param threads The number of threads
+ * @param f The output forces on the coupled point
+ */
+void
+run_complex_system(unsigned int threads, double f[3])
+{
+	MoorDyn system = MoorDyn_Create("Mooring/local_euler/complex_system.txt");
+	REQUIRE(system);
+	REQUIRE(MoorDyn_SetThreads(system, threads) == MOORDYN_SUCCESS);
+	unsigned int n;
+	REQUIRE(MoorDyn_GetThreads(system, &n) == MOORDYN_SUCCESS);
+	REQUIRE(n == threads);
+
+	double x[3], dx[3];
+	auto point = MoorDyn_GetPoint(system, 4);
+	REQUIRE(point);
+	REQUIRE(MoorDyn_GetPointPos(point, x) == MOORDYN_SUCCESS);
+	std::fill(dx, dx + 3, 0.0);
+	REQUIRE(MoorDyn_Init(system, x, dx) == MOORDYN_SUCCESS);
+
+	double t = 0.0, dt = 0.5;
+	dx[0] = 0.5;
+	for (unsigned int i = 0; i < 4; i++) {
+		x[0] += dx[0] * dt;
+		REQUIRE(MoorDyn_Step(system, x, dx, f, &t, &dt) == MOORDYN_SUCCESS);
+	}
+
+	REQUIRE(MoorDyn_Close(system) == MOORDYN_SUCCESS);
+}
+
+TEST_CASE("Threaded derivatives match the serial ones")
+{
+	double f_serial[3], f_threads[3];
+	run_complex_system(1, f_serial);
+	run_complex_system(4, f_threads);
+	// Each entity is computed by a single thread in the very same way, so
+	// the results shall be exactly the same
+	for (unsigned int i = 0; i < 3; i++)
+		REQUIRE(f_serial[i] == f_threads[i]);
+}
+
+/** @brief Run a short simulation on a FFT wave grid
+ * @param threads The number of threads
+ * @return The fairlead tension
+ */
+double
+run_wave_grid(unsigned int threads)
+{
+	MoorDyn system = MoorDyn_Create("Mooring/wavegrid_file/wavegrid.txt");
+	REQUIRE(system);
+	REQUIRE(MoorDyn_SetThreads(system, threads) == MOORDYN_SUCCESS);
+	REQUIRE(MoorDyn_Init(system, NULL, NULL) == MOORDYN_SUCCESS);
+	double t = 0.0, dt = 0.5;
+	REQUIRE(MoorDyn_Step(system, NULL, NULL, NULL, &t, &dt) ==
+	        MOORDYN_SUCCESS);
+	double ten;
+	REQUIRE(MoorDyn_GetLineFairTen(MoorDyn_GetLine(system, 1), &ten) ==
+	        MOORDYN_SUCCESS);
+	REQUIRE(MoorDyn_Close(system) == MOORDYN_SUCCESS);
+	return ten;
+}
+
+TEST_CASE("Threaded wave grid matches the serial one")
+{
+	// Each grid point is computed by a single thread in the very same way,
+	// so the results shall be exactly the same
+	REQUIRE(run_wave_grid(1) == run_wave_grid(4));
+}
+
+/** @brief Run a short simulation with component summing waves
+ * @param threads The number of threads
+ * @param f The output forces on the coupled point
+ */
+void
+run_wave_spectrum(unsigned int threads, double f[3])
+{
+	MoorDyn system = MoorDyn_Create("Mooring/wavekin_7/wavekin_7.txt");
+	REQUIRE(system);
+	REQUIRE(MoorDyn_SetThreads(system, threads) == MOORDYN_SUCCESS);
+	double x[3], dx[3];
+	std::fill(x, x + 3, 0.0);
+	std::fill(dx, dx + 3, 0.0);
+	REQUIRE(MoorDyn_Init(system, x, dx) == MOORDYN_SUCCESS);
+	double t = 0.0, dt = 0.5;
+	for (unsigned int i = 0; i < 4; i++)
+		REQUIRE(MoorDyn_Step(system, x, dx, f, &t, &dt) == MOORDYN_SUCCESS);
+	REQUIRE(MoorDyn_Close(system) == MOORDYN_SUCCESS);
+}
+
+TEST_CASE("Threaded wave kinematics match the serial ones")
+{
+	double f_serial[3], f_threads[3];
+	run_wave_spectrum(1, f_serial);
+	run_wave_spectrum(4, f_threads);
+	// Each node is computed by a single thread in the very same way, so the
+	// results shall be exactly the same
+	for (unsigned int i = 0; i < 3; i++)
+		REQUIRE(f_serial[i] == f_threads[i]);
+}
+
+/** @brief Create an input file from Mooring/lines.txt, with a Threads option
+ * @param filepath The new input file path
+ * @param threads The value of the Threads option
+ */
+void
+write_threads_input(const char* filepath, const std::string& threads)
+{
+	std::ifstream in("Mooring/lines.txt");
+	REQUIRE(in.is_open());
+	std::ofstream out(filepath);
+	std::string line;
+	while (std::getline(in, line)) {
+		out << line << std::endl;
+		if (line.find("OPTIONS") != std::string::npos)
+			out << threads << "  Threads  number of threads (-)" << std::endl;
+	}
+}
+
+TEST_CASE("Threads option validation")
+{
+	// Negative values are rejected
+	write_threads_input("Mooring/lines_threads.txt", "-1");
+	REQUIRE(!MoorDyn_Create("Mooring/lines_threads.txt"));
+	// Too many threads are capped to the hardware ones
+	const unsigned int n_hw =
+	    (std::max)(std::thread::hardware_concurrency(), 1u);
+	write_threads_input("Mooring/lines_threads.txt",
+	                    std::to_string(n_hw + 1000));
+	MoorDyn system = MoorDyn_Create("Mooring/lines_threads.txt");
+	REQUIRE(system);
+	unsigned int n;
+	REQUIRE(MoorDyn_GetThreads(system, &n) == MOORDYN_SUCCESS);
+	REQUIRE(n == n_hw);
+	REQUIRE(MoorDyn_Close(system) == MOORDYN_SUCCESS);
+}
@@ -54,6 +54,8 @@ static std::vector<std::string> schemes({ "Euler",
                                           "Heun",
                                           "RK2",
                                           "RK4",
+                                          "RK23",
+                                          "RK45",
                                           "AB2",
                                           "AB3",
                                           "AB4",
@@ -65,6 +67,8 @@ static std::vector<std::string> schemes({ "Euler",
                                           "Midpoint10",
                                           "Midpoint15",
                                           "Midpoint20",
+                                          "Newton10",
+                                          "Anderson10",
                                           "ACA5",
                                           "ACA10",
                                           "ACA15",
@@ -74,6 +78,8 @@ static std::vector<std::string> dts({ "1.5E-4",   // Euler
                                       "1.8E-4",   // Heun
                                       "2.6E-4",   // RK2
                                       "4.9E-4",   // RK4
+                                      "1.0E-2",   // RK23
+                                      "1.0E-2",   // RK45
                                       "1.4E-4",   // AB2
                                       "1.1E-4",   // AB3
                                       "1.0E-4",   // AB5
@@ -85,6 +91,8 @@ static std::vector<std::string> dts({ "1.5E-4",   // Euler
                                       "1.9E-3",   // Midpoint10
                                       "2.5E-3",   // Midpoint15
                                       "3.0E-3",   // Midpoint20
+                                      "8.0E-3",   // Newton10
+                                      "1.9E-3",   // Anderson10
                                       "9.4E-4",   // ACA5
                                       "1.5E-3",   // ACA10
                                       "1.5E-3",   // ACA15
@@ -40,6 +40,7 @@
 #include <math.h>
 #include <iostream>
 #include <algorithm>
+#include <filesystem>
 
 using namespace std;
 
@@ -243,6 +244,115 @@ tabulated(const char* input_file)
 	return true;
 }
 
+/** @brief Runs a short simulation and get the fairlead tension
+ * @param input_file The input file
+ * @param ten The output fairlead tension
+ * @return true if the simulation ran, false otherwise
+ */
+bool
+fairlead_tension(const char* input_file, double& ten)
+{
+	MoorDyn system = MoorDyn_Create(input_file);
+	if (!system) {
+		cerr << "Failure Creating the Mooring system" << endl;
+		return false;
+	}
+	int err = MoorDyn_Init(system, NULL, NULL);
+	if (err != MOORDYN_SUCCESS) {
+		MoorDyn_Close(system);
+		cerr << "Failure during the mooring initialization: " << err << endl;
+		return false;
+	}
+	double t = 0.0, dt = 0.1;
+	while (t < 2.0) {
+		err = MoorDyn_Step(system, NULL, NULL, NULL, &t, &dt);
+		if (err != MOORDYN_SUCCESS) {
+			MoorDyn_Close(system);
+			cerr << "Failure during the mooring step: " << err << endl;
+			return false;
+		}
+	}
+	err = MoorDyn_GetLineFairTen(MoorDyn_GetLine(system, 1), &ten);
+	MoorDyn_Close(system);
+	return err == MOORDYN_SUCCESS;
+}
+
+/** @brief Check that the wave grid mapped from the WaveGridFile gives the
+ * same results than the freshly computed one
+ * @return true if the test is passed, false if problems are detected
+ */
+bool
+grid_file()
+{
+	const char* input = "Mooring/wavegrid_file/wavegrid_file.txt";
+	const std::filesystem::path path("Mooring/wavegrid_file/wavegrid_file.grid");
+	std::filesystem::remove(path);
+	double ten_computed, ten_mapped;
+	// The first run is computing and saving the grid
+	if (!fairlead_tension(input, ten_computed))
+		return false;
+	if (!std::filesystem::exists(path)) {
+		cerr << "The wave grid file was not saved" << endl;
+		return false;
+	}
+	// And the second one is mapping it
+	if (!fairlead_tension(input, ten_mapped))
+		return false;
+	std::filesystem::remove(path);
+	if (ten_computed != ten_mapped) {
+		cerr << "The fairlead tension with the mapped grid, " << ten_mapped
+		     << ", does not match the computed one, " << ten_computed << endl;
+		return false;
+	}
+	return true;
+}
+
+/** @brief Check that the wave grid generated on a sliding time window gives
+ * the same results than the whole grid
+ * @return true if the test is passed, false if problems are detected
+ */
+bool
+grid_window()
+{
+	double ten_whole, ten_window;
+	if (!fairlead_tension("Mooring/wavegrid_file/wavegrid.txt", ten_whole))
+		return false;
+	if (!fairlead_tension("Mooring/wavegrid_file/wavegrid_window.txt",
+	                      ten_window))
+		return false;
+	// The slices are not computed with the FFT, so some round off differences
+	// are expected
+	if (std::abs(ten_window - ten_whole) > 1e-6 * std::abs(ten_whole)) {
+		cerr << "The fairlead tension with the sliding window, " << ten_window
+		     << ", does not match the whole grid one, " << ten_whole << endl;
+		return false;
+	}
+	return true;
+}
+
+/** @brief Check that the sparse wave grid, split in tiles generated on
+ * demand, gives the same results than the whole grid
+ * @return true if the test is passed, false if problems are detected
+ */
+bool
+grid_tiles()
+{
+	double ten_whole, ten_tiles;
+	if (!fairlead_tension("Mooring/wavegrid_file/wavegrid.txt", ten_whole))
+		return false;
+	if (!fairlead_tension("Mooring/wavegrid_file/wavegrid_tiles.txt",
+	                      ten_tiles))
+		return false;
+	// Each grid point is computed in the very same way, so the results shall
+	// be exactly the same
+	if (ten_tiles != ten_whole) {
+		cerr << "The fairlead tension with the tiles, " << ten_tiles
+		     << ", does not match the whole grid one, " << ten_whole << endl;
+		return false;
+	}
+	return true;
+}
+
 /** @brief Runs all the test
  * @return 0 if the tests have ran just fine, 1 otherwise
  */
@@ -280,5 +390,14 @@ main(int, char**)
 	if (!tabulated("Mooring/wavekin_3/test_dynamic_currents.txt"))
 		return 2;
 
+	if (!grid_file())
+		return 3;
+
+	if (!grid_window())
+		return 4;
+
+	if (!grid_tiles())
+		return 5;
+
 	return 0;
 }
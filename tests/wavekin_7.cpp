@@ -2,10 +2,12 @@
  * A test case with component summing wave generation based on a
  * wave_frequencies.txt file
  */
+#define _USE_MATH_DEFINES
 #include "MoorDyn2.hpp"
 #include "MoorDynAPI.h"
 #include <iostream>
 #include <algorithm>
+#include <cmath>
 #include "util.h"
 using namespace std;
 
@@ -53,6 +55,117 @@ api()
 	return true;
 }
 
+/** @brief Get the fairlead force after some simulation time
+ *
+ * The fairlead is oscillating in surge, so the nodes close to it are moving
+ * more than the tolerances used to reuse the wave kinematics
+ * @param filepath The input file
+ * @param f The output force
+ * @return true if the simulation ran fine, false otherwise
+ */
+bool
+fairlead_force(const char* filepath, double f[3])
+{
+	moordyn::MoorDyn system(filepath);
+
+	double x[3], dx[3];
+	std::fill(x, x + 3, 0.0);
+	std::fill(dx, dx + 3, 0.0);
+	if (system.Init(x, dx) != MOORDYN_SUCCESS) {
+		cerr << "failed to init " << filepath << endl;
+		return false;
+	}
+
+	const double t_max = 35;
+	const double amplitude = 2.0, omega = 2.0 * M_PI / 10.0;
+	double t = 0.0, dt = 0.1;
+	while (t < t_max) {
+		x[0] = amplitude * sin(omega * (t + dt));
+		dx[0] = amplitude * omega * cos(omega * (t + dt));
+		if (system.Step(x, dx, f, t, dt) != MOORDYN_SUCCESS) {
+			cerr << "failed to step " << filepath << endl;
+			return false;
+		}
+	}
+
+	return true;
+}
+
+/** @brief Check that an alternative way of computing the wave kinematics
+ * gives the same fairlead force than the reference one
+ * @param ref The reference input file
+ * @param alt The alternative input file
+ * @param tol The tolerance, relative to the reference force magnitude
+ * @return true if the test is passed, false if problems are detected
+ */
+bool
+compare_fairlead_force(const char* ref, const char* alt, double tol)
+{
+	double f_ref[3], f[3];
+	if (!fairlead_force(ref, f_ref))
+		return false;
+	if (!fairlead_force(alt, f))
+		return false;
+
+	const double f_mag = sqrt(f_ref[0] * f_ref[0] + f_ref[1] * f_ref[1] +
+	                          f_ref[2] * f_ref[2]);
+	for (unsigned int i = 0; i < 3; i++) {
+		cout << "f[" << i << "] = " << f[i] << " (" << f_ref[i] << ")" << endl;
+		if (fabs(f[i] - f_ref[i]) > tol * f_mag) {
+			cerr << "The force " << f[i] << " computed with '" << alt
+			     << "' does not match the one computed with '" << ref
+			     << "', " << f_ref[i] << endl;
+			return false;
+		}
+	}
+
+	return true;
+}
+
+/** @brief Check the number of evaluations of the wave kinematics per
+ * coupling time step, once the simulation is running
+ * @param filepath The input file
+ * @param expected The expected number of evaluations per coupling step
+ * @return true if the test is passed, false if problems are detected
+ */
+bool
+count_evaluations(const char* filepath, unsigned long expected)
+{
+	moordyn::MoorDyn system(filepath);
+
+	double x[3], dx[3], f[3];
+	std::fill(x, x + 3, 0.0);
+	std::fill(dx, dx + 3, 0.0);
+	if (system.Init(x, dx) != MOORDYN_SUCCESS) {
+		cerr << "failed to init " << filepath << endl;
+		return false;
+	}
+
+	const double amplitude = 2.0, omega = 2.0 * M_PI / 10.0;
+	double t = 0.0, dt = 0.1;
+	unsigned long n0 = 0;
+	for (unsigned int i = 0; i < 20; i++) {
+		// The first coupling step has no samples to reuse
+		if (i == 2)
+			n0 = system.GetWaves()->getEvaluations();
+		x[0] = amplitude * sin(omega * (t + dt));
+		dx[0] = amplitude * omega * cos(omega * (t + dt));
+		if (system.Step(x, dx, f, t, dt) != MOORDYN_SUCCESS) {
+			cerr << "failed to step " << filepath << endl;
+			return false;
+		}
+	}
+	const unsigned long n = system.GetWaves()->getEvaluations() - n0;
+	if (n != 18 * expected) {
+		cerr << n << " wave kinematics evaluations were carried out with '"
+		     << filepath << "', but " << 18 * expected << " were expected"
+		     << endl;
+		return false;
+	}
+
+	return true;
+}
+
 /** @brief Runs all the test
  * @return 0 if the tests have ran just fine, 1 otherwise
  */
@@ -61,6 +174,29 @@ main(int, char**)
 {
 	if (!api())
 		return 1;
+	// The incrementally rotated phasors shall give the same results than the
+	// exact summation
+	if (!compare_fairlead_force("Mooring/wavekin_7/wavekin_7.txt",
+	                            "Mooring/wavekin_7/wavekin_7_phasors.txt",
+	                            1e-3))
+		return 1;
+	// The kinematics interpolated along the coupling time steps shall give
+	// the same results than the ones evaluated on every substep
+	if (!compare_fairlead_force("Mooring/wavekin_7/wavekin_7.txt",
+	                            "Mooring/wavekin_7/wavekin_7_cache_linear.txt",
+	                            1e-3))
+		return 1;
+	// The slopes of the cubic interpolation mix samples evaluated at the
+	// node positions of several coupling steps, so the error is larger
+	if (!compare_fairlead_force("Mooring/wavekin_7/wavekin_7.txt",
+	                            "Mooring/wavekin_7/wavekin_7_cache.txt",
+	                            2.5e-3))
+		return 1;
+	// Both interpolations shall reuse all the samples but the last one
+	if (!count_evaluations("Mooring/wavekin_7/wavekin_7_cache_linear.txt", 1))
+		return 1;
+	if (!count_evaluations("Mooring/wavekin_7/wavekin_7_cache.txt", 1))
+		return 1;
 
 	return 0;
 }
@@ -968,6 +968,59 @@ set_cfl(PyObject*, PyObject* args)
 	return Py_None;
 }
 
+/** @brief Wrapper to MoorDyn_GetThreads() function
+ * @param args Python passed arguments
+ * @return The number of threads
+ */
+static PyObject*
+get_threads(PyObject*, PyObject* args)
+{
+	PyObject* capsule;
+
+	if (!PyArg_ParseTuple(args, "O", &capsule))
+		return NULL;
+
+	MoorDyn system =
+	    (MoorDyn)PyCapsule_GetPointer(capsule, moordyn_capsule_name);
+	if (!system)
+		return NULL;
+
+	int err;
+	unsigned int n;
+	err = MoorDyn_GetThreads(system, &n);
+	if (err != 0) {
+		PyErr_SetString(PyExc_RuntimeError, "MoorDyn reported an error");
+		return NULL;
+	}
+	return PyLong_FromLong(n);
+}
+
+/** @brief Wrapper to MoorDyn_SetThreads() function
+ * @param args Python passed arguments
+ * @return None
+ */
+static PyObject*
+set_threads(PyObject*, PyObject* args)
+{
+	PyObject* capsule;
+	unsigned int n;
+
+	if (!PyArg_ParseTuple(args, "OI", &capsule, &n))
+		return NULL;
+
+	MoorDyn system =
+	    (MoorDyn)PyCapsule_GetPointer(capsule, moordyn_capsule_name);
+	if (!system)
+		return NULL;
+
+	const int err = MoorDyn_SetThreads(system, n);
+	if (err != 0) {
+		PyErr_SetString(PyExc_RuntimeError, "MoorDyn reported an error");
+		return NULL;
+	}
+	return Py_None;
+}
+
 /** @brief Wrapper to MoorDyn_GetTimeScheme() function
  * @param args Python passed arguments
  * @return The time step
@@ -2937,6 +2990,114 @@ line_get_max_tension(PyObject*, PyObject* args)
 	return PyFloat_FromDouble(t);
 }
 
+/** @brief Wrapper to MoorDyn_GetLineFatigueBins() function
+ * @param args Python passed arguments
+ * @return The number of bins
+ */
+static PyObject*
+line_get_fatigue_bins(PyObject*, PyObject* args)
+{
+	PyObject* capsule;
+
+	if (!PyArg_ParseTuple(args, "O", &capsule))
+		return NULL;
+
+	MoorDynLine instance =
+	    (MoorDynLine)PyCapsule_GetPointer(capsule, line_capsule_name);
+	if (!instance)
+		return NULL;
+
+	unsigned int n;
+	const int err = MoorDyn_GetLineFatigueBins(instance, &n);
+	if (err != 0) {
+		PyErr_SetString(PyExc_RuntimeError, "MoorDyn reported an error");
+		return NULL;
+	}
+
+	return PyLong_FromLong(n);
+}
+
+/** @brief Wrapper to MoorDyn_GetLineSegFatigueHist() function
+ * @param args Python passed arguments
+ * @return The bin width and the histogram
+ */
+static PyObject*
+line_get_seg_fatigue_hist(PyObject*, PyObject* args)
+{
+	PyObject* capsule;
+	int seg;
+
+	if (!PyArg_ParseTuple(args, "Oi", &capsule, &seg))
+		return NULL;
+
+	MoorDynLine instance =
+	    (MoorDynLine)PyCapsule_GetPointer(capsule, line_capsule_name);
+	if (!instance)
+		return NULL;
+
+	unsigned int n;
+	int err = MoorDyn_GetLineFatigueBins(instance, &n);
+	if (err != 0) {
+		PyErr_SetString(PyExc_RuntimeError, "MoorDyn reported an error");
+		return NULL;
+	}
+	double w;
+	double* hist = new double[n * n];
+	err = MoorDyn_GetLineSegFatigueHist(instance, seg, &w, hist);
+	if (err != 0) {
+		delete[] hist;
+		PyErr_SetString(PyExc_RuntimeError, "MoorDyn reported an error");
+		return NULL;
+	}
+
+	PyObject* lst = PyTuple_New(n);
+	for (unsigned int i = 0; i < n; i++) {
+		PyObject* sub = PyTuple_New(n);
+		for (unsigned int j = 0; j < n; j++) {
+			PyTuple_SET_ITEM(sub, j, PyFloat_FromDouble(hist[i * n + j]));
+		}
+		PyTuple_SET_ITEM(lst, i, sub);
+	}
+	delete[] hist;
+
+	PyObject* pyr = PyTuple_New(2);
+	PyTuple_SET_ITEM(pyr, 0, PyFloat_FromDouble(w));
+	PyTuple_SET_ITEM(pyr, 1, lst);
+	return pyr;
+}
+
+/** @brief Wrapper to MoorDyn_GetLineSegFatigueDamage() function
+ * @param args Python passed arguments
+ * @return The number of cycles and the damage
+ */
+static PyObject*
+line_get_seg_fatigue_damage(PyObject*, PyObject* args)
+{
+	PyObject* capsule;
+	int seg;
+
+	if (!PyArg_ParseTuple(args, "Oi", &capsule, &seg))
+		return NULL;
+
+	MoorDynLine instance =
+	    (MoorDynLine)PyCapsule_GetPointer(capsule, line_capsule_name);
+	if (!instance)
+		return NULL;
+
+	double cycles, damage;
+	const int err =
+	    MoorDyn_GetLineSegFatigueDamage(instance, seg, &cycles, &damage);
+	if (err != 0) {
+		PyErr_SetString(PyExc_RuntimeError, "MoorDyn reported an error");
+		return NULL;
+	}
+
+	PyObject* pyr = PyTuple_New(2);
+	PyTuple_SET_ITEM(pyr, 0, PyFloat_FromDouble(cycles));
+	PyTuple_SET_ITEM(pyr, 1, PyFloat_FromDouble(damage));
+	return pyr;
+}
+
 /** @brief Wrapper to MoorDyn_SaveLineVTK() function
  * @param args Python passed arguments
  * @return 0 in case of success, an error code otherwise
@@ -3037,6 +3198,8 @@ static PyMethodDef moordyn_methods[] = {
 	{ "set_dt", set_dt, METH_VARARGS, "Set the inner time step" },
 	{ "get_cfl", get_cfl, METH_VARARGS, "Get the CFL factor" },
 	{ "set_cfl", set_cfl, METH_VARARGS, "Set the CFL factor" },
+	{ "get_threads", get_threads, METH_VARARGS, "Get the number of threads" },
+	{ "set_threads", set_threads, METH_VARARGS, "Set the number of threads" },
 	{ "get_tscheme", get_tscheme, METH_VARARGS, "Get the time scheme" },
 	{ "set_tscheme", set_tscheme, METH_VARARGS, "Set the time scheme" },
 	{ "save_state", save_state, METH_VARARGS, "Save the system state" },
@@ -3222,6 +3385,18 @@ static PyMethodDef moordyn_methods[] = {
 	  line_get_max_tension,
 	  METH_VARARGS,
 	  "Get the line maximum tension magnitude" },
+	{ "line_get_fatigue_bins",
+	  line_get_fatigue_bins,
+	  METH_VARARGS,
+	  "Get the number of bins of the line rainflow histograms" },
+	{ "line_get_seg_fatigue_hist",
+	  line_get_seg_fatigue_hist,
+	  METH_VARARGS,
+	  "Get the rainflow histogram of a line segment tension" },
+	{ "line_get_seg_fatigue_damage",
+	  line_get_seg_fatigue_damage,
+	  METH_VARARGS,
+	  "Get the tension cycles and fatigue damage of a line segment" },
 	{ "line_save_vtk",
 	  line_save_vtk,
 	  METH_VARARGS,
@@ -25,4 +25,5 @@ MoorDyn v2 C API is doing
 
 from .moordyn import *
 from .moorpyic import *
+from .output import *
 from . import Generator
@@ -581,6 +581,34 @@ def SetCFL(instance, cfl):
     cmoordyn.set_cfl(instance, cfl)
 
 
+def GetThreads(instance):
+    """Get the number of threads used to compute the derivatives
+
+    Parameters:
+    instance (cmoordyn.MoorDyn): The MoorDyn instance
+
+    Returns:
+    n (int): The number of threads
+    """
+    import cmoordyn
+    return cmoordyn.get_threads(instance)
+
+
+def SetThreads(instance, n):
+    """Set the number of threads used to compute the derivatives
+
+    Parameters:
+    instance (cmoordyn.MoorDyn): The MoorDyn instance
+    n (int): The number of threads. 1 to run serially, 0 to use all the
+             hardware threads
+
+    Returns:
+    None
+    """
+    import cmoordyn
+    cmoordyn.set_threads(instance, n)
+
+
 def GetTimeScheme(instance):
     """Get the current time scheme name
 
@@ -1529,6 +1557,52 @@ def GetLineMaxTen(instance):
     return cmoordyn.line_get_max_tension(instance)
 
 
+def GetLineFatigueBins(instance):
+    """ Get the number of bins of each axis of the segments rainflow
+    histograms
+
+    Parameters:
+    instance (cmoordyn.MoorDynLine): The line instance
+
+    Returns:
+    n: The number of bins, 0 if the fatigue is not computed
+    """
+    import cmoordyn
+    return cmoordyn.line_get_fatigue_bins(instance)
+
+
+def GetLineSegFatigueHist(instance, i):
+    """ Get the rainflow histogram of a segment tension, with the ranges on
+    the rows and the means on the columns
+
+    Parameters:
+    instance (cmoordyn.MoorDynLine): The line instance
+    i (int): The segment index
+
+    Returns:
+    w: The bin width
+    hist: The histogram, as a tuple of rows
+    """
+    import cmoordyn
+    return cmoordyn.line_get_seg_fatigue_hist(instance, i)
+
+
+def GetLineSegFatigueDamage(instance, i):
+    """ Get the number of tension cycles of a segment, and the accumulated
+    fatigue damage
+
+    Parameters:
+    instance (cmoordyn.MoorDynLine): The line instance
+    i (int): The segment index
+
+    Returns:
+    cycles: The number of cycles
+    damage: The damage, 0 if no S-N curve was set on the line type
+    """
+    import cmoordyn
+    return cmoordyn.line_get_seg_fatigue_damage(instance, i)
+
+
 def SaveLineVTK(instance, filename):
     """ Save the line to a VTK (.vtp) file
 
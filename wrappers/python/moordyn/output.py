@@ -0,0 +1,118 @@
+"""
+Copyright (c) 2024, Jose Luis Cercos-Pita <jlc@core-marine.com>
+
+Redistribution and use in source and binary forms, with or without
+modification, are permitted provided that the following conditions are met:
+
+1. Redistributions of source code must retain the above copyright notice, this
+   list of conditions and the following disclaimer.
+
+2. Redistributions in binary form must reproduce the above copyright notice,
+   this list of conditions and the following disclaimer in the documentation
+   and/or other materials provided with the distribution.
+
+3. Neither the name of the copyright holder nor the names of its
+   contributors may be used to endorse or promote products derived from
+   this software without specific prior written permission.
+
+THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE
+FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+"""
+
+import struct
+
+
+def read_output(filepath):
+    """Read a binary output file, written with the OutputFormat option set to
+    1 or 2. The records are mapped in memory, so they are not actually read
+    until they are accessed
+
+    Parameters
+    ----------
+    filepath (str): The output file path
+
+    Returns
+    -------
+    data (numpy.memmap): The records, with a row per output instant and a
+                         column per channel. The first column is the time
+    channels (list): The channels descriptors, as dictionaries with the
+                     "name", "units", "otype" (1 = line, 2 = point,
+                     3 = rod, 4 = body, 0 = none), "objid" (the object
+                     number, 0 = none) and "node" (the node or segment
+                     index, -1 = none) keys
+
+    Raises
+    ------
+    ValueError: If the file is not a MoorDyn binary output file
+    """
+    import numpy as np
+    with open(filepath, 'rb') as f:
+        magic = f.read(8)
+        if magic != b'MDOUT\0\0\0':
+            raise ValueError(f"'{filepath}' is not a MoorDyn binary output")
+        version, endian, precision, n, offset = struct.unpack(
+            '=IIIIQ', f.read(24))
+        if version != 1 or endian != 0x01020304:
+            raise ValueError(f"'{filepath}' version or endianness mismatch")
+        channels = []
+        for i in range(n):
+            otype, objid, node, lname, lunits = struct.unpack(
+                '=iiiII', f.read(20))
+            name = f.read(lname).decode()
+            units = f.read(lunits).decode()
+            channels.append({"name": name, "units": units, "otype": otype,
+                             "objid": objid, "node": node})
+        f.seek(0, 2)
+        size = f.tell()
+    dtype = np.float32 if precision == 4 else np.float64
+    # A simulation still running might have written just a part of the last
+    # record
+    nrecords = (size - offset) // (n * precision)
+    if nrecords == 0:
+        return np.zeros((0, n), dtype=dtype), channels
+    data = np.memmap(filepath, dtype=dtype, mode='r', offset=offset,
+                     shape=(nrecords, n))
+    return data, channels
+
+
+def read_stats(filepath):
+    """Read a statistics summary file, written with the OutputStats option
+    set to 1
+
+    Parameters
+    ----------
+    filepath (str): The summary file path, with the ".stats" extension
+
+    Returns
+    -------
+    stats (list): The statistics of each channel, as dictionaries with the
+                  "name" and "units" strings, the "otype", "objid", "node" and
+                  "samples" integers, and the "mean", "std", "min",
+                  "timemin", "max", "timemax" and quantiles (e.g. "p50")
+                  floats
+    """
+    stats = []
+    with open(filepath, 'r') as f:
+        columns = [c.lower() for c in f.readline().split()]
+        for line in f:
+            fields = line.split()
+            if len(fields) != len(columns):
+                continue
+            channel = {}
+            for column, field in zip(columns, fields):
+                if column in ("channel", "units"):
+                    channel["name" if column == "channel" else column] = field
+                elif column in ("otype", "objid", "node", "samples"):
+                    channel[column] = int(field)
+                else:
+                    channel[column] = float(field)
+            stats.append(channel)
+    return stats